@@ -62,7 +62,7 @@
 #define configTICK_RATE_HZ                      1024
 #define configMAX_PRIORITIES                    (3)
 #define configMINIMAL_STACK_SIZE                (120)
-#define configTOTAL_HEAP_SIZE                   (1024 * 17)
+#define configTOTAL_HEAP_SIZE                   (1024 * 20) /* Shared with LVGL and newlib, see memory/Heap.h */
 #define configMAX_TASK_NAME_LEN                 (4)
 #define configUSE_16_BIT_TICKS                  0
 #define configIDLE_SHOULD_YIELD                 1
@@ -76,6 +76,12 @@
 #define configUSE_NEWLIB_REENTRANT              0
 #define configENABLE_BACKWARD_COMPATIBILITY     1
 
+/* Memory allocation related definitions. The tasks, queues, semaphores and timers are created with their static
+variant, their storage is sized at compile time (see memory/KernelObjects.h). The dynamic variants are disabled so that
+they can't be used by mistake. */
+#define configSUPPORT_STATIC_ALLOCATION  1
+#define configSUPPORT_DYNAMIC_ALLOCATION 0
+
 /* Hook function related definitions. */
 #define configUSE_IDLE_HOOK            0
 #define configUSE_TICK_HOOK            0
@@ -83,7 +89,10 @@
 #define configUSE_MALLOC_FAILED_HOOK   0
 
 /* Run time and task stats gathering related definitions. */
-#define configGENERATE_RUN_TIME_STATS        0
+/* The run time counter is RTC2 (see SystemMonitor.cpp), it is started by RtcCounter::Init() before the scheduler. */
+#define configGENERATE_RUN_TIME_STATS        1
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()     SystemMonitorRunTimeCounter()
 #define configUSE_TRACE_FACILITY             1
 #define configUSE_STATS_FORMATTING_FUNCTIONS 0
 
@@ -101,6 +110,22 @@
 #define configEXPECTED_IDLE_TIME_BEFORE_SLEEP 2
 
 /* Tickless idle/low power functionality. */
+/* Measures the time spent asleep (see SystemMonitor.cpp) */
+#define configPRE_SLEEP_PROCESSING(x)  SystemMonitorEnterSleep()
+#define configPOST_SLEEP_PROCESSING(x) SystemMonitorExitSleep()
+
+/* Event trace (see trace/Trace.cpp), the event codes are those of Pinetime::Trace::Events. The semaphores and the
+mutexes are queues, their operations are recorded as queue operations. */
+#define traceTASK_SWITCHED_IN()                    TraceTaskSwitchedIn(pxCurrentTCB->uxTCBNumber)
+#define traceQUEUE_SEND(pxQueue)                   TraceQueueEvent(1, pxQueue, pxQueue->uxMessagesWaiting)
+#define traceQUEUE_SEND_FROM_ISR(pxQueue)          TraceQueueEvent(1, pxQueue, pxQueue->uxMessagesWaiting)
+#define traceQUEUE_SEND_FAILED(pxQueue)            TraceQueueEvent(2, pxQueue, pxQueue->uxMessagesWaiting)
+#define traceQUEUE_SEND_FROM_ISR_FAILED(pxQueue)   TraceQueueEvent(2, pxQueue, pxQueue->uxMessagesWaiting)
+#define traceQUEUE_RECEIVE(pxQueue)                TraceQueueEvent(3, pxQueue, pxQueue->uxMessagesWaiting)
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue)       TraceQueueEvent(3, pxQueue, pxQueue->uxMessagesWaiting)
+#define traceQUEUE_RECEIVE_FAILED(pxQueue)         TraceQueueEvent(4, pxQueue, pxQueue->uxMessagesWaiting)
+#define traceBLOCKING_ON_QUEUE_SEND(pxQueue)       TraceQueueEvent(5, pxQueue, pxQueue->uxMessagesWaiting)
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue)    TraceQueueEvent(5, pxQueue, pxQueue->uxMessagesWaiting)
 
 /* Define to trap errors during development. */
 #if defined(DEBUG_NRF) || defined(DEBUG_NRF_USER)
@@ -180,6 +205,19 @@ standard names - or at least those used in the unmodified vector table. */
     #error "This port requires __NVIC_PRIO_BITS to be defined"
   #endif
 
+  #include <stdint.h>
+  #ifdef __cplusplus
+extern "C" {
+  #endif
+uint32_t SystemMonitorRunTimeCounter(void);
+void SystemMonitorEnterSleep(void);
+void SystemMonitorExitSleep(void);
+void TraceTaskSwitchedIn(uint32_t taskNumber);
+void TraceQueueEvent(uint8_t event, const void* queue, uint32_t nbMessages);
+  #ifdef __cplusplus
+}
+  #endif
+
   /* Access to current system core clock is required only if we are ticking the system by systimer */
   #if (configTICK_SOURCE == FREERTOS_USE_SYSTICK)
     #include <stdint.h>
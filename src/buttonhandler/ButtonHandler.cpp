@@ -2,19 +2,26 @@
 
 using namespace Pinetime::Controllers;
 
-void ButtonTimerCallback(TimerHandle_t xTimer) {
-  auto* sysTask = static_cast<Pinetime::System::SystemTask*>(pvTimerGetTimerID(xTimer));
-  sysTask->PushMessage(Pinetime::System::Messages::HandleButtonTimerEvent);
+void ButtonTimerCallback(void* context) {
+  auto* buttonHandler = static_cast<ButtonHandler*>(context);
+  buttonHandler->OnTimer();
+}
+
+ButtonHandler::ButtonHandler() : buttonTimer {"button", Pinetime::System::Timer::Modes::SingleShot, ButtonTimerCallback, this} {
 }
 
 void ButtonHandler::Init(Pinetime::System::SystemTask* systemTask) {
-  buttonTimer = xTimerCreate("buttonTimer", pdMS_TO_TICKS(200), pdFALSE, systemTask, ButtonTimerCallback);
+  this->systemTask = systemTask;
+}
+
+void ButtonHandler::OnTimer() {
+  systemTask->PushMessage(Pinetime::System::Messages::HandleButtonTimerEvent);
 }
 
 ButtonActions ButtonHandler::HandleEvent(Events event) {
-  static constexpr TickType_t doubleClickTime = pdMS_TO_TICKS(200);
-  static constexpr TickType_t longPressTime = pdMS_TO_TICKS(400);
-  static constexpr TickType_t longerPressTime = pdMS_TO_TICKS(2000);
+  static constexpr uint32_t doubleClickTime = 200;
+  static constexpr uint32_t longPressTime = 400;
+  static constexpr uint32_t longerPressTime = 2000;
 
   if (event == Events::Press) {
     buttonPressed = true;
@@ -26,25 +33,22 @@ ButtonActions ButtonHandler::HandleEvent(Events event) {
   switch (state) {
     case States::Idle:
       if (event == Events::Press) {
-        xTimerChangePeriod(buttonTimer, doubleClickTime, 0);
-        xTimerStart(buttonTimer, 0);
+        buttonTimer.Start(doubleClickTime);
         state = States::Pressed;
       }
       break;
     case States::Pressed:
       if (event == Events::Press) {
-        if (xTaskGetTickCount() - releaseTime < doubleClickTime) {
-          xTimerStop(buttonTimer, 0);
+        if (xTaskGetTickCount() - releaseTime < pdMS_TO_TICKS(doubleClickTime)) {
+          buttonTimer.Stop();
           state = States::Idle;
           return ButtonActions::DoubleClick;
         }
       } else if (event == Events::Release) {
-        xTimerChangePeriod(buttonTimer, doubleClickTime, 0);
-        xTimerStart(buttonTimer, 0);
+        buttonTimer.Start(doubleClickTime);
       } else if (event == Events::Timer) {
         if (buttonPressed) {
-          xTimerChangePeriod(buttonTimer, longPressTime - doubleClickTime, 0);
-          xTimerStart(buttonTimer, 0);
+          buttonTimer.Start(longPressTime - doubleClickTime);
           state = States::Holding;
         } else {
           state = States::Idle;
@@ -54,19 +58,18 @@ ButtonActions ButtonHandler::HandleEvent(Events event) {
       break;
     case States::Holding:
       if (event == Events::Release) {
-        xTimerStop(buttonTimer, 0);
+        buttonTimer.Stop();
         state = States::Idle;
         return ButtonActions::Click;
       } else if (event == Events::Timer) {
-        xTimerChangePeriod(buttonTimer, longerPressTime - longPressTime - doubleClickTime, 0);
-        xTimerStart(buttonTimer, 0);
+        buttonTimer.Start(longerPressTime - longPressTime - doubleClickTime);
         state = States::LongHeld;
         return ButtonActions::LongPress;
       }
       break;
     case States::LongHeld:
       if (event == Events::Release) {
-        xTimerStop(buttonTimer, 0);
+        buttonTimer.Stop();
         state = States::Idle;
       } else if (event == Events::Timer) {
         state = States::Idle;
@@ -2,21 +2,24 @@
 
 #include "buttonhandler/ButtonActions.h"
 #include "systemtask/SystemTask.h"
+#include "systemtask/TimerService.h"
 #include <FreeRTOS.h>
-#include <timers.h>
 
 namespace Pinetime {
   namespace Controllers {
     class ButtonHandler {
     public:
       enum class Events : uint8_t { Press, Release, Timer };
+      ButtonHandler();
       void Init(Pinetime::System::SystemTask* systemTask);
       ButtonActions HandleEvent(Events event);
+      void OnTimer();
 
     private:
       enum class States : uint8_t { Idle, Pressed, Holding, LongHeld };
       TickType_t releaseTime = 0;
-      TimerHandle_t buttonTimer;
+      Pinetime::System::SystemTask* systemTask = nullptr;
+      Pinetime::System::Timer buttonTimer;
       bool buttonPressed = false;
       States state = States::Idle;
     };
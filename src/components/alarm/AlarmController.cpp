@@ -17,18 +17,12 @@
 */
 #include "components/alarm/AlarmController.h"
 #include "systemtask/SystemTask.h"
-#include "app_timer.h"
 #include "task.h"
 #include <chrono>
 
 using namespace Pinetime::Controllers;
 using namespace std::chrono_literals;
 
-AlarmController::AlarmController(Controllers::DateTime& dateTimeController) : dateTimeController {dateTimeController} {
-}
-
-APP_TIMER_DEF(alarmAppTimer);
-
 namespace {
   void SetOffAlarm(void* p_context) {
     auto* controller = static_cast<Pinetime::Controllers::AlarmController*>(p_context);
@@ -38,8 +32,11 @@ namespace {
   }
 }
 
+AlarmController::AlarmController(Controllers::DateTime& dateTimeController)
+  : dateTimeController {dateTimeController}, alarmTimer {"alarm", System::Timer::Modes::SingleShot, SetOffAlarm, this, 1000} {
+}
+
 void AlarmController::Init(System::SystemTask* systemTask) {
-  app_timer_create(&alarmAppTimer, APP_TIMER_MODE_SINGLE_SHOT, SetOffAlarm);
   this->systemTask = systemTask;
 }
 
@@ -49,8 +46,8 @@ void AlarmController::SetAlarmTime(uint8_t alarmHr, uint8_t alarmMin) {
 }
 
 void AlarmController::ScheduleAlarm() {
-  // Determine the next time the alarm needs to go off and set the app_timer
-  app_timer_stop(alarmAppTimer);
+  // Determine the next time the alarm needs to go off and set the timer
+  alarmTimer.Stop();
 
   auto now = dateTimeController.CurrentDateTime();
   alarmTime = now;
@@ -82,7 +79,7 @@ void AlarmController::ScheduleAlarm() {
   // now can convert back to a time_point
   alarmTime = std::chrono::system_clock::from_time_t(std::mktime(tmAlarmTime));
   auto mSecToAlarm = std::chrono::duration_cast<std::chrono::milliseconds>(alarmTime - now).count();
-  app_timer_start(alarmAppTimer, APP_TIMER_TICKS(mSecToAlarm), this);
+  alarmTimer.Start(mSecToAlarm);
 
   state = AlarmState::Set;
 }
@@ -92,7 +89,7 @@ uint32_t AlarmController::SecondsToAlarm() {
 }
 
 void AlarmController::DisableAlarm() {
-  app_timer_stop(alarmAppTimer);
+  alarmTimer.Stop();
   state = AlarmState::Not_Set;
 }
 
@@ -19,6 +19,7 @@
 
 #include <cstdint>
 #include "components/datetime/DateTimeController.h"
+#include "systemtask/TimerService.h"
 
 namespace Pinetime {
   namespace System {
@@ -62,6 +63,7 @@ namespace Pinetime {
       std::chrono::time_point<std::chrono::system_clock, std::chrono::nanoseconds> alarmTime;
       AlarmState state = AlarmState::Not_Set;
       RecurType recurrence = RecurType::None;
+      System::Timer alarmTimer;
     };
   }
 }
@@ -86,7 +86,7 @@ void Battery::SaadcEventHandler(nrfx_saadc_evt_t const* p_event) {
     if ((isPowerPresent && newPercent > percentRemaining) || (!isPowerPresent && newPercent < percentRemaining) || firstMeasurement) {
       firstMeasurement = false;
       percentRemaining = newPercent;
-      systemTask->PushMessage(System::Messages::BatteryPercentageUpdated);
+      systemTask->PushMessage(System::Messages::BatteryPercentageUpdated, percentRemaining);
     }
 
     nrfx_saadc_uninit();
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include "components/ble/NotificationManager.h"
 #include "systemtask/SystemTask.h"
+#include "profiling/Profiler.h"
 
 using namespace Pinetime::Controllers;
 
@@ -12,6 +13,7 @@ constexpr ble_uuid16_t AlertNotificationService::ansCharUuid;
 constexpr ble_uuid128_t AlertNotificationService::notificationEventUuid;
 
 int AlertNotificationCallback(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt* ctxt, void* arg) {
+  Pinetime::Profiling::Zone zone(Pinetime::Profiling::Zones::GattAlertNotification);
   auto anService = static_cast<AlertNotificationService*>(arg);
   return anService->OnAlert(conn_handle, attr_handle, ctxt);
 }
@@ -1,6 +1,7 @@
 #include "components/ble/BatteryInformationService.h"
 #include <nrf_log.h>
 #include "components/battery/BatteryController.h"
+#include "profiling/Profiler.h"
 
 using namespace Pinetime::Controllers;
 
@@ -8,6 +9,7 @@ constexpr ble_uuid16_t BatteryInformationService::batteryInformationServiceUuid;
 constexpr ble_uuid16_t BatteryInformationService::batteryLevelUuid;
 
 int BatteryInformationServiceCallback(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt* ctxt, void* arg) {
+  Pinetime::Profiling::Zone zone(Pinetime::Profiling::Zones::GattBattery);
   auto* batteryInformationService = static_cast<BatteryInformationService*>(arg);
   return batteryInformationService->OnBatteryServiceRequested(conn_handle, attr_handle, ctxt);
 }
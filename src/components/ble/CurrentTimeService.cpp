@@ -1,6 +1,7 @@
 #include "components/ble/CurrentTimeService.h"
 #include <hal/nrf_rtc.h>
 #include <nrf_log.h>
+#include "profiling/Profiler.h"
 
 using namespace Pinetime::Controllers;
 
@@ -8,6 +9,7 @@ constexpr ble_uuid16_t CurrentTimeService::ctsUuid;
 constexpr ble_uuid16_t CurrentTimeService::ctChrUuid;
 
 int CTSCallback(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt* ctxt, void* arg) {
+  Pinetime::Profiling::Zone zone(Pinetime::Profiling::Zones::GattCurrentTime);
   auto cts = static_cast<CurrentTimeService*>(arg);
   return cts->OnTimeAccessed(conn_handle, attr_handle, ctxt);
 }
@@ -1,4 +1,5 @@
 #include "components/ble/DeviceInformationService.h"
+#include "profiling/Profiler.h"
 
 using namespace Pinetime::Controllers;
 
@@ -11,6 +12,7 @@ constexpr ble_uuid16_t DeviceInformationService::hwRevisionUuid;
 constexpr ble_uuid16_t DeviceInformationService::swRevisionUuid;
 
 int DeviceInformationCallback(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt* ctxt, void* arg) {
+  Pinetime::Profiling::Zone zone(Pinetime::Profiling::Zones::GattDeviceInformation);
   auto deviceInformationService = static_cast<DeviceInformationService*>(arg);
   return deviceInformationService->OnDeviceInfoRequested(conn_handle, attr_handle, ctxt);
 }
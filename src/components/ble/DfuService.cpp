@@ -3,7 +3,8 @@
 #include "components/ble/BleController.h"
 #include "drivers/SpiNorFlash.h"
 #include "systemtask/SystemTask.h"
-#include <nrf_log.h>
+#include "logging/BinaryLog.h"
+#include "profiling/Profiler.h"
 
 using namespace Pinetime::Controllers;
 
@@ -13,17 +14,23 @@ constexpr ble_uuid128_t DfuService::revisionCharacteristicUuid;
 constexpr ble_uuid128_t DfuService::packetCharacteristicUuid;
 
 int DfuServiceCallback(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt* ctxt, void* arg) {
+  Pinetime::Profiling::Zone zone(Pinetime::Profiling::Zones::GattDfu);
   auto dfuService = static_cast<DfuService*>(arg);
   return dfuService->OnServiceData(conn_handle, attr_handle, ctxt);
 }
 
-void NotificationTimerCallback(TimerHandle_t xTimer) {
-  auto notificationManager = static_cast<DfuService::NotificationManager*>(pvTimerGetTimerID(xTimer));
+namespace {
+  constexpr uint32_t timeoutPeriodMs = 10000;
+  constexpr uint32_t notificationDelayMs = 1000;
+}
+
+void NotificationTimerCallback(void* context) {
+  auto notificationManager = static_cast<DfuService::NotificationManager*>(context);
   notificationManager->OnNotificationTimer();
 }
 
-void TimeoutTimerCallback(TimerHandle_t xTimer) {
-  auto dfuService = static_cast<DfuService*>(pvTimerGetTimerID(xTimer));
+void TimeoutTimerCallback(void* context) {
+  auto dfuService = static_cast<DfuService*>(context);
   dfuService->OnTimeout();
 }
 
@@ -64,8 +71,8 @@ DfuService::DfuService(Pinetime::System::SystemTask& systemTask,
        .uuid = &serviceUuid.u,
        .characteristics = characteristicDefinition},
       {0},
-    } {
-  timeoutTimer = xTimerCreate("notificationTimer", 10000, pdFALSE, this, TimeoutTimerCallback);
+    },
+    timeoutTimer {"dfuTimeout", Pinetime::System::Timer::Modes::SingleShot, TimeoutTimerCallback, this, 1000} {
 }
 
 void DfuService::Init() {
@@ -79,7 +86,7 @@ void DfuService::Init() {
 
 int DfuService::OnServiceData(uint16_t connectionHandle, uint16_t attributeHandle, ble_gatt_access_ctxt* context) {
   if (bleController.IsFirmwareUpdating()) {
-    xTimerStart(timeoutTimer, 0);
+    timeoutTimer.Start(timeoutPeriodMs);
   }
 
   ble_gatts_find_chr(&serviceUuid.u, &packetCharacteristicUuid.u, nullptr, &packetCharacteristicHandle);
@@ -102,7 +109,7 @@ int DfuService::OnServiceData(uint16_t connectionHandle, uint16_t attributeHandl
     else
       return 0;
   } else {
-    NRF_LOG_INFO("[DFU] Unknown Characteristic : %d", attributeHandle);
+    BINLOG("[DFU] Unknown Characteristic : %d", attributeHandle);
     return 0;
   }
 }
@@ -119,7 +126,7 @@ int DfuService::WritePacketHandler(uint16_t connectionHandle, os_mbuf* om) {
       bootloaderSize = om->om_data[4] + (om->om_data[5] << 8) + (om->om_data[6] << 16) + (om->om_data[7] << 24);
       applicationSize = om->om_data[8] + (om->om_data[9] << 8) + (om->om_data[10] << 16) + (om->om_data[11] << 24);
       bleController.FirmwareUpdateTotalBytes(applicationSize);
-      NRF_LOG_INFO(
+      BINLOG(
         "[DFU] -> Start data received : SD size : %d, BT size : %d, app size : %d", softdeviceSize, bootloaderSize, applicationSize);
 
       // wait until SystemTask has finished waking up all devices
@@ -145,7 +152,7 @@ int DfuService::WritePacketHandler(uint16_t connectionHandle, os_mbuf* om) {
       }
       expectedCrc = om->om_data[10 + (softdeviceArrayLength * 2)] + (om->om_data[10 + (softdeviceArrayLength * 2) + 1] << 8);
 
-      NRF_LOG_INFO(
+      BINLOG(
         "[DFU] -> Init data received : deviceType = %d, deviceRevision = %d, applicationVersion = %d, nb SD = %d, First SD = %d, CRC = %u",
         deviceType,
         deviceRevision,
@@ -169,14 +176,14 @@ int DfuService::WritePacketHandler(uint16_t connectionHandle, os_mbuf* om) {
                          (uint8_t)(bytesReceived >> 8u),
                          (uint8_t)(bytesReceived >> 16u),
                          (uint8_t)(bytesReceived >> 24u)};
-        NRF_LOG_INFO("[DFU] -> Send packet notification: %d bytes received", bytesReceived);
+        BINLOG("[DFU] -> Send packet notification: %d bytes received", bytesReceived);
         notificationManager.Send(connectionHandle, controlPointCharacteristicHandle, data, 5);
       }
       if (dfuImage.IsComplete()) {
         uint8_t data[3] {static_cast<uint8_t>(Opcodes::Response),
                          static_cast<uint8_t>(Opcodes::ReceiveFirmwareImage),
                          static_cast<uint8_t>(ErrorCodes::NoError)};
-        NRF_LOG_INFO("[DFU] -> Send packet notification : all bytes received!");
+        BINLOG("[DFU] -> Send packet notification : all bytes received!");
         notificationManager.Send(connectionHandle, controlPointCharacteristicHandle, data, 3);
         state = States::Validate;
       }
@@ -191,21 +198,21 @@ int DfuService::WritePacketHandler(uint16_t connectionHandle, os_mbuf* om) {
 
 int DfuService::ControlPointHandler(uint16_t connectionHandle, os_mbuf* om) {
   auto opcode = static_cast<Opcodes>(om->om_data[0]);
-  NRF_LOG_INFO("[DFU] -> ControlPointHandler");
+  BINLOG("[DFU] -> ControlPointHandler");
 
   switch (opcode) {
     case Opcodes::StartDFU: {
       if (state != States::Idle && state != States::Start) {
-        NRF_LOG_INFO("[DFU] -> Start DFU requested, but we are not in Idle state");
+        BINLOG("[DFU] -> Start DFU requested, but we are not in Idle state");
         return 0;
       }
       if (state == States::Start) {
-        NRF_LOG_INFO("[DFU] -> Start DFU requested, but we are already in Start state");
+        BINLOG("[DFU] -> Start DFU requested, but we are already in Start state");
         return 0;
       }
       auto imageType = static_cast<ImageTypes>(om->om_data[1]);
       if (imageType == ImageTypes::Application) {
-        NRF_LOG_INFO("[DFU] -> Start DFU, mode = Application");
+        BINLOG("[DFU] -> Start DFU, mode = Application");
         state = States::Start;
         bleController.StartFirmwareUpdate();
         bleController.State(Pinetime::Controllers::Ble::FirmwareUpdateStates::Running);
@@ -214,17 +221,17 @@ int DfuService::ControlPointHandler(uint16_t connectionHandle, os_mbuf* om) {
         systemTask.PushMessage(Pinetime::System::Messages::BleFirmwareUpdateStarted);
         return 0;
       } else {
-        NRF_LOG_INFO("[DFU] -> Start DFU, mode %d not supported!", imageType);
+        BINLOG("[DFU] -> Start DFU, mode %d not supported!", imageType);
         return 0;
       }
     } break;
     case Opcodes::InitDFUParameters: {
       if (state != States::Init) {
-        NRF_LOG_INFO("[DFU] -> Init DFU requested, but we are not in Init state");
+        BINLOG("[DFU] -> Init DFU requested, but we are not in Init state");
         return 0;
       }
       bool isInitComplete = (om->om_data[1] != 0);
-      NRF_LOG_INFO("[DFU] -> Init DFU parameters %s", isInitComplete ? " complete" : " not complete");
+      BINLOG("[DFU] -> Init DFU parameters, complete = %d", isInitComplete);
 
       if (isInitComplete) {
         uint8_t data[3] {static_cast<uint8_t>(Opcodes::Response),
@@ -237,37 +244,37 @@ int DfuService::ControlPointHandler(uint16_t connectionHandle, os_mbuf* om) {
       return 0;
     case Opcodes::PacketReceiptNotificationRequest:
       nbPacketsToNotify = om->om_data[1];
-      NRF_LOG_INFO("[DFU] -> Receive Packet Notification Request, nb packet = %d", nbPacketsToNotify);
+      BINLOG("[DFU] -> Receive Packet Notification Request, nb packet = %d", nbPacketsToNotify);
       return 0;
     case Opcodes::ReceiveFirmwareImage:
       if (state != States::Init) {
-        NRF_LOG_INFO("[DFU] -> Receive firmware image requested, but we are not in Start Init");
+        BINLOG("[DFU] -> Receive firmware image requested, but we are not in Start Init");
         return 0;
       }
       // TODO the chunk size is dependant of the implementation of the host application...
       dfuImage.Init(20, applicationSize, expectedCrc);
-      NRF_LOG_INFO("[DFU] -> Starting receive firmware");
+      BINLOG("[DFU] -> Starting receive firmware");
       state = States::Data;
       return 0;
     case Opcodes::ValidateFirmware: {
       if (state != States::Validate) {
-        NRF_LOG_INFO("[DFU] -> Validate firmware image requested, but we are not in Data state %d", state);
+        BINLOG("[DFU] -> Validate firmware image requested, but we are not in Data state %d", state);
         return 0;
       }
 
-      NRF_LOG_INFO("[DFU] -> Validate firmware image requested -- %d", connectionHandle);
+      BINLOG("[DFU] -> Validate firmware image requested -- %d", connectionHandle);
 
       if (dfuImage.Validate()) {
         state = States::Validated;
         bleController.State(Pinetime::Controllers::Ble::FirmwareUpdateStates::Validated);
-        NRF_LOG_INFO("Image OK");
+        BINLOG("Image OK");
 
         uint8_t data[3] {static_cast<uint8_t>(Opcodes::Response),
                          static_cast<uint8_t>(Opcodes::ValidateFirmware),
                          static_cast<uint8_t>(ErrorCodes::NoError)};
         notificationManager.AsyncSend(connectionHandle, controlPointCharacteristicHandle, data, 3);
       } else {
-        NRF_LOG_INFO("Image Error : bad CRC");
+        BINLOG("Image Error : bad CRC");
 
         uint8_t data[3] {static_cast<uint8_t>(Opcodes::Response),
                          static_cast<uint8_t>(Opcodes::ValidateFirmware),
@@ -281,10 +288,10 @@ int DfuService::ControlPointHandler(uint16_t connectionHandle, os_mbuf* om) {
     }
     case Opcodes::ActivateImageAndReset:
       if (state != States::Validated) {
-        NRF_LOG_INFO("[DFU] -> Activate image and reset requested, but we are not in Validated state");
+        BINLOG("[DFU] -> Activate image and reset requested, but we are not in Validated state");
         return 0;
       }
-      NRF_LOG_INFO("[DFU] -> Activate image and reset!");
+      BINLOG("[DFU] -> Activate image and reset!");
       bleController.State(Pinetime::Controllers::Ble::FirmwareUpdateStates::Validated);
       Reset();
       return 0;
@@ -312,8 +319,8 @@ void DfuService::Reset() {
   systemTask.PushMessage(Pinetime::System::Messages::BleFirmwareUpdateFinished);
 }
 
-DfuService::NotificationManager::NotificationManager() {
-  timer = xTimerCreate("notificationTimer", 1000, pdFALSE, this, NotificationTimerCallback);
+DfuService::NotificationManager::NotificationManager()
+  : timer {"dfuNotification", Pinetime::System::Timer::Modes::SingleShot, NotificationTimerCallback, this, 100} {
 }
 
 bool DfuService::NotificationManager::AsyncSend(uint16_t connection, uint16_t charactHandle, uint8_t* data, size_t s) {
@@ -324,7 +331,7 @@ bool DfuService::NotificationManager::AsyncSend(uint16_t connection, uint16_t ch
   characteristicHandle = charactHandle;
   size = s;
   std::memcpy(buffer, data, size);
-  xTimerStart(timer, 0);
+  timer.Start(notificationDelayMs);
   return true;
 }
 
@@ -345,7 +352,7 @@ void DfuService::NotificationManager::Reset() {
   connectionHandle = 0;
   characteristicHandle = 0;
   size = 0;
-  xTimerStop(timer, 0);
+  timer.Stop();
 }
 
 void DfuService::DfuImage::Init(size_t chunkSize, size_t totalSize, uint16_t expectedCrc) {
@@ -0,0 +1,743 @@
+#include "components/ble/DiagnosticsService.h"
+#include <cstddef>
+#include <cstring>
+#include "drivers/RtcCounter.h"
+#include "drivers/TwiMaster.h"
+#include "touchhandler/TouchHandler.h"
+#include "systemtask/SystemTask.h"
+#include "systemtask/TimerService.h"
+#include "systemtask/MessageBus.h"
+#include "trace/Trace.h"
+#include "profiling/Profiler.h"
+#include "profiling/PcSampler.h"
+#include "logging/BinaryLog.h"
+#include "memory/Heap.h"
+
+using namespace Pinetime::Controllers;
+
+namespace {
+  // 0005yyxx-78fc-48fe-8e23-433b3a1942d0
+  constexpr ble_uuid128_t CharUuid(uint8_t x, uint8_t y) {
+    return ble_uuid128_t {.u = {.type = BLE_UUID_TYPE_128},
+                          .value = {0xd0, 0x42, 0x19, 0x3a, 0x3b, 0x43, 0x23, 0x8e, 0xfe, 0x48, 0xfc, 0x78, x, y, 0x05, 0x00}};
+  }
+
+  // 00050000-78fc-48fe-8e23-433b3a1942d0
+  constexpr ble_uuid128_t BaseUuid() {
+    return CharUuid(0x00, 0x00);
+  }
+
+  constexpr ble_uuid128_t diagnosticsServiceUuid {BaseUuid()};
+  constexpr ble_uuid128_t twiStatisticsCharUuid {CharUuid(0x01, 0x00)};
+  constexpr ble_uuid128_t touchLatencyCharUuid {CharUuid(0x02, 0x00)};
+  constexpr ble_uuid128_t wakeupsCharUuid {CharUuid(0x03, 0x00)};
+  constexpr ble_uuid128_t timersCharUuid {CharUuid(0x04, 0x00)};
+  constexpr ble_uuid128_t messageQueuesCharUuid {CharUuid(0x05, 0x00)};
+  constexpr ble_uuid128_t cpuLoadCharUuid {CharUuid(0x06, 0x00)};
+  constexpr ble_uuid128_t traceCharUuid {CharUuid(0x07, 0x00)};
+  constexpr ble_uuid128_t profilingCharUuid {CharUuid(0x08, 0x00)};
+  constexpr ble_uuid128_t pcSamplesCharUuid {CharUuid(0x09, 0x00)};
+  constexpr ble_uuid128_t binaryLogCharUuid {CharUuid(0x0a, 0x00)};
+  constexpr ble_uuid128_t heapCharUuid {CharUuid(0x0b, 0x00)};
+
+  int DiagnosticsServiceCallback(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt* ctxt, void* arg) {
+    Pinetime::Profiling::Zone zone(Pinetime::Profiling::Zones::GattDiagnostics);
+    auto* diagnosticsService = static_cast<DiagnosticsService*>(arg);
+    return diagnosticsService->OnRead(conn_handle, attr_handle, ctxt);
+  }
+
+  struct __attribute__((packed)) TwiBusRecord {
+    uint32_t transactions;
+    uint32_t failures;
+    uint32_t freezes;
+    uint32_t wakeups;
+    uint32_t mergedTransactions;
+    uint32_t busyTimeMs;
+    uint32_t cpuTimeUs;
+    uint16_t utilisationPermille;
+    uint8_t nbDevices;
+  };
+
+  struct __attribute__((packed)) TwiDeviceRecord {
+    uint8_t address;
+    uint8_t priority;
+    uint32_t transactions;
+    uint32_t failures;
+    uint32_t averageLatencyUs;
+    uint32_t maxLatencyUs;
+    uint32_t busyTimeMs;
+    uint32_t cpuTimeUs;
+  };
+
+  struct __attribute__((packed)) TouchLatencyRecord {
+    uint32_t samples;
+    uint32_t overruns;
+    uint32_t averageReadLatencyUs;
+    uint32_t maxReadLatencyUs;
+    uint32_t frames;
+    uint32_t averagePixelLatencyUs;
+    uint32_t maxPixelLatencyUs;
+    uint32_t lastPixelLatencyUs;
+  };
+
+  struct __attribute__((packed)) WakeupsRecord {
+    uint32_t total;
+    uint32_t lastHour;
+    uint32_t currentHour;
+  };
+
+  struct __attribute__((packed)) TimerServiceRecord {
+    uint32_t wakeups;
+    uint32_t expirations;
+    uint32_t coalesced;
+    uint8_t nbTimers;
+  };
+
+  struct __attribute__((packed)) TimerRecord {
+    char name[16];
+    uint32_t expirations;
+    uint32_t wakeups;
+  };
+
+  struct __attribute__((packed)) MessageQueueRecord {
+    char name[8];
+    uint32_t sent;
+    uint32_t coalesced;
+    uint32_t dropped;
+    uint8_t laneSize;
+    uint8_t urgentHighWater;
+    uint8_t housekeepingHighWater;
+  };
+
+  struct __attribute__((packed)) CpuLoadRecord {
+    uint32_t windowMs;
+    uint16_t idlePermille;
+    uint16_t sleepPermille;
+    uint8_t nbTasks;
+  };
+
+  struct __attribute__((packed)) TaskLoadRecord {
+    char name[configMAX_TASK_NAME_LEN];
+    uint16_t permille;
+  };
+
+  struct __attribute__((packed)) HeapRecord {
+    uint32_t size;
+    uint32_t freeBytes;
+    uint32_t minimumFreeBytes;
+    uint32_t largestFreeBlock;
+    uint16_t nbFreeBlocks;
+    uint8_t fragmentationPercent;
+    uint8_t nbOwners;
+  };
+
+  struct __attribute__((packed)) HeapOwnerRecord {
+    char name[8];
+    uint32_t usedBytes;
+    uint32_t peakBytes;
+    uint32_t nbBlocks;
+    uint32_t failures;
+  };
+
+  enum class TraceCommands : uint8_t { Freeze = 0x01, Start = 0x02, Select = 0x03 };
+
+  struct __attribute__((packed)) TraceHeader {
+    char magic[4];
+    uint8_t version;
+    uint8_t categories;
+    uint32_t frequency;
+    uint32_t nbRecorded;
+    uint16_t nbRecords;
+    uint16_t firstRecord;
+    uint8_t nbPageRecords;
+    uint8_t nbTasks;
+  };
+
+  struct __attribute__((packed)) TraceTaskRecord {
+    uint8_t number;
+    char name[configMAX_TASK_NAME_LEN];
+  };
+
+  constexpr uint8_t traceVersion = 1;
+  // Keeps a page (header, SystemMonitor::maxTasks tasks and records) under the 512 bytes of a long read
+  constexpr uint16_t tracePageSize = 48;
+
+  enum class ProfilingCommands : uint8_t { Reset = 0x01, Select = 0x02 };
+
+  struct __attribute__((packed)) ProfilingHeader {
+    uint8_t enabled;
+    uint8_t nbZones;
+    uint8_t firstZone;
+    uint8_t nbPageZones;
+    uint8_t nbBuckets;
+    uint8_t firstBucketLog2;
+    uint32_t cyclesPerSecond;
+  };
+
+  struct __attribute__((packed)) ProfilingZoneRecord {
+    char name[12];
+    uint32_t count;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+    uint16_t histogram[Pinetime::Profiling::Profiler::nbBuckets];
+  };
+
+  constexpr uint8_t profilingPageSize = 7;
+
+  enum class PcSamplesCommands : uint8_t { Start = 0x01, Stop = 0x02, Clear = 0x03, Select = 0x04 };
+
+  struct __attribute__((packed)) PcSamplesHeader {
+    uint8_t running;
+    uint8_t bucketShift;
+    uint16_t periodUs;
+    uint32_t samples;
+    uint32_t outside;
+    uint32_t lost;
+    uint32_t halvings;
+    uint16_t nbEntries;
+    uint16_t firstEntry;
+    uint8_t nbPageEntries;
+  };
+
+  constexpr uint16_t pcSamplesPageSize = 112;
+
+  enum class BinaryLogCommands : uint8_t { Select = 0x01, Release = 0x02 };
+
+  struct __attribute__((packed)) BinaryLogHeader {
+    uint32_t frequency;
+    uint32_t tail;
+    uint32_t head;
+    uint32_t written;
+    uint32_t dropped;
+    uint32_t pageStart;
+    uint16_t nbPageWords;
+  };
+
+  struct __attribute__((packed)) BinaryLogNotification {
+    uint32_t tail;
+    uint32_t head;
+  };
+
+  // In words
+  constexpr uint32_t binaryLogPageSize = 112;
+}
+
+DiagnosticsService::DiagnosticsService(Pinetime::System::SystemTask& systemTask,
+                                       Pinetime::Drivers::TwiMaster& twiMaster,
+                                       TouchHandler& touchHandler)
+  : systemTask {systemTask},
+    twiMaster {twiMaster},
+    touchHandler {touchHandler},
+    characteristicDefinition {{.uuid = &twiStatisticsCharUuid.u,
+                               .access_cb = DiagnosticsServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ,
+                               .val_handle = &twiStatisticsHandle},
+                              {.uuid = &touchLatencyCharUuid.u,
+                               .access_cb = DiagnosticsServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ,
+                               .val_handle = &touchLatencyHandle},
+                              {.uuid = &wakeupsCharUuid.u,
+                               .access_cb = DiagnosticsServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ,
+                               .val_handle = &wakeupsHandle},
+                              {.uuid = &timersCharUuid.u,
+                               .access_cb = DiagnosticsServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ,
+                               .val_handle = &timersHandle},
+                              {.uuid = &messageQueuesCharUuid.u,
+                               .access_cb = DiagnosticsServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ,
+                               .val_handle = &messageQueuesHandle},
+                              {.uuid = &cpuLoadCharUuid.u,
+                               .access_cb = DiagnosticsServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ,
+                               .val_handle = &cpuLoadHandle},
+                              {.uuid = &traceCharUuid.u,
+                               .access_cb = DiagnosticsServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+                               .val_handle = &traceHandle},
+                              {.uuid = &profilingCharUuid.u,
+                               .access_cb = DiagnosticsServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+                               .val_handle = &profilingHandle},
+                              {.uuid = &pcSamplesCharUuid.u,
+                               .access_cb = DiagnosticsServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+                               .val_handle = &pcSamplesHandle},
+                              {.uuid = &binaryLogCharUuid.u,
+                               .access_cb = DiagnosticsServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_NOTIFY,
+                               .val_handle = &binaryLogHandle},
+                              {.uuid = &heapCharUuid.u,
+                               .access_cb = DiagnosticsServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ,
+                               .val_handle = &heapHandle},
+                              {0}},
+    serviceDefinition {
+      {.type = BLE_GATT_SVC_TYPE_PRIMARY, .uuid = &diagnosticsServiceUuid.u, .characteristics = characteristicDefinition},
+      {0},
+    } {
+}
+
+void DiagnosticsService::Init() {
+  int res = 0;
+  res = ble_gatts_count_cfg(serviceDefinition);
+  ASSERT(res == 0);
+
+  res = ble_gatts_add_svcs(serviceDefinition);
+  ASSERT(res == 0);
+}
+
+int DiagnosticsService::OnRead(uint16_t /*connectionHandle*/, uint16_t attributeHandle, ble_gatt_access_ctxt* context) {
+  if (attributeHandle == traceHandle) {
+    return OnTraceRequested(context);
+  }
+  if (attributeHandle == profilingHandle) {
+    return OnProfilingRequested(context);
+  }
+  if (attributeHandle == pcSamplesHandle) {
+    return OnPcSamplesRequested(context);
+  }
+  if (attributeHandle == binaryLogHandle) {
+    return OnBinaryLogRequested(context);
+  }
+  if (context->op != BLE_GATT_ACCESS_OP_READ_CHR) {
+    return BLE_ATT_ERR_UNLIKELY;
+  }
+  if (attributeHandle == twiStatisticsHandle) {
+    return ReadTwiStatistics(context);
+  }
+  if (attributeHandle == touchLatencyHandle) {
+    return ReadTouchLatency(context);
+  }
+  if (attributeHandle == wakeupsHandle) {
+    return ReadWakeups(context);
+  }
+  if (attributeHandle == timersHandle) {
+    return ReadTimers(context);
+  }
+  if (attributeHandle == messageQueuesHandle) {
+    return ReadMessageQueues(context);
+  }
+  if (attributeHandle == cpuLoadHandle) {
+    return ReadCpuLoad(context);
+  }
+  if (attributeHandle == heapHandle) {
+    return ReadHeap(context);
+  }
+  return BLE_ATT_ERR_UNLIKELY;
+}
+
+int DiagnosticsService::ReadTwiStatistics(ble_gatt_access_ctxt* context) {
+  using Pinetime::Drivers::TwiMaster;
+  const auto& bus = twiMaster.GetStatistics();
+  TwiBusRecord busRecord {bus.transactions,
+                          bus.failures,
+                          bus.freezes,
+                          bus.wakeups,
+                          bus.mergedTransactions,
+                          static_cast<uint32_t>(bus.busyTimeUs / 1000),
+                          TwiMaster::CyclesToUs(bus.totalCpuCycles),
+                          bus.utilisationPermille,
+                          twiMaster.NbDevices()};
+  int res = os_mbuf_append(context->om, &busRecord, sizeof(busRecord));
+
+  for (uint8_t i = 0; i < twiMaster.NbDevices() && res == 0; i++) {
+    const auto& device = twiMaster.GetDeviceStatistics(i);
+    TwiDeviceRecord deviceRecord {device.address,
+                                  static_cast<uint8_t>(device.priority),
+                                  device.transactions,
+                                  device.failures,
+                                  (device.transactions > 0) ? static_cast<uint32_t>(device.totalLatencyUs / device.transactions) : 0,
+                                  device.maxLatencyUs,
+                                  static_cast<uint32_t>(device.busyTimeUs / 1000),
+                                  TwiMaster::CyclesToUs(device.cpuCycles)};
+    res = os_mbuf_append(context->om, &deviceRecord, sizeof(deviceRecord));
+  }
+  return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+int DiagnosticsService::ReadTouchLatency(ble_gatt_access_ctxt* context) {
+  const auto& touch = touchHandler.GetLatencyStatistics();
+  TouchLatencyRecord record {touch.samples,
+                             touch.overruns,
+                             (touch.samples > 0) ? static_cast<uint32_t>(touch.totalReadLatencyUs / touch.samples) : 0,
+                             touch.maxReadLatencyUs,
+                             touch.frames,
+                             (touch.frames > 0) ? static_cast<uint32_t>(touch.totalPixelLatencyUs / touch.frames) : 0,
+                             touch.maxPixelLatencyUs,
+                             touch.lastPixelLatencyUs};
+  int res = os_mbuf_append(context->om, &record, sizeof(record));
+  return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+int DiagnosticsService::ReadWakeups(ble_gatt_access_ctxt* context) {
+  const auto& wakeups = systemTask.GetWakeupStatistics();
+  WakeupsRecord record {wakeups.total, wakeups.lastHour, wakeups.currentHour};
+  int res = os_mbuf_append(context->om, &record, sizeof(record));
+  return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+int DiagnosticsService::ReadTimers(ble_gatt_access_ctxt* context) {
+  using Pinetime::System::TimerService;
+  uint8_t nbTimers = 0;
+  for (auto* timer = TimerService::FirstRegistered(); timer != nullptr; timer = timer->NextRegistered()) {
+    nbTimers++;
+  }
+  const auto& service = TimerService::GetStatistics();
+  TimerServiceRecord serviceRecord {service.wakeups, service.expirations, service.coalesced, nbTimers};
+  int res = os_mbuf_append(context->om, &serviceRecord, sizeof(serviceRecord));
+
+  for (auto* timer = TimerService::FirstRegistered(); timer != nullptr && res == 0; timer = timer->NextRegistered()) {
+    TimerRecord timerRecord {};
+    std::strncpy(timerRecord.name, timer->Name(), sizeof(timerRecord.name));
+    timerRecord.expirations = timer->Expirations();
+    timerRecord.wakeups = timer->Wakeups();
+    res = os_mbuf_append(context->om, &timerRecord, sizeof(timerRecord));
+  }
+  return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+int DiagnosticsService::ReadMessageQueues(ble_gatt_access_ctxt* context) {
+  using Pinetime::System::MessageBusBase;
+  uint8_t nbQueues = 0;
+  for (auto* bus = MessageBusBase::FirstRegistered(); bus != nullptr; bus = bus->NextRegistered()) {
+    nbQueues++;
+  }
+  int res = os_mbuf_append(context->om, &nbQueues, sizeof(nbQueues));
+
+  for (auto* bus = MessageBusBase::FirstRegistered(); bus != nullptr && res == 0; bus = bus->NextRegistered()) {
+    const auto& statistics = bus->GetStatistics();
+    MessageQueueRecord record {};
+    std::strncpy(record.name, bus->Name(), sizeof(record.name));
+    record.sent = statistics.sent;
+    record.coalesced = statistics.coalesced;
+    record.dropped = statistics.dropped;
+    record.laneSize = bus->LaneSize();
+    record.urgentHighWater = statistics.highWater[0];
+    record.housekeepingHighWater = statistics.highWater[1];
+    res = os_mbuf_append(context->om, &record, sizeof(record));
+  }
+  return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+int DiagnosticsService::ReadCpuLoad(ble_gatt_access_ctxt* context) {
+  const auto load = systemTask.GetCpuLoad();
+  CpuLoadRecord loadRecord {load.windowMs, load.idlePermille, load.sleepPermille, load.nbTasks};
+  int res = os_mbuf_append(context->om, &loadRecord, sizeof(loadRecord));
+
+  for (uint8_t i = 0; i < load.nbTasks && res == 0; i++) {
+    TaskLoadRecord taskRecord {};
+    std::strncpy(taskRecord.name, load.tasks[i].name, sizeof(taskRecord.name));
+    taskRecord.permille = load.tasks[i].permille;
+    res = os_mbuf_append(context->om, &taskRecord, sizeof(taskRecord));
+  }
+  return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+int DiagnosticsService::ReadHeap(ble_gatt_access_ctxt* context) {
+  using Pinetime::Memory::Heap;
+  using Pinetime::Memory::Owners;
+  const auto heap = Heap::GetStatistics();
+  HeapRecord heapRecord {Heap::size,
+                         heap.freeBytes,
+                         heap.minimumFreeBytes,
+                         heap.largestFreeBlock,
+                         heap.nbFreeBlocks,
+                         heap.fragmentationPercent,
+                         Heap::nbOwners};
+  int res = os_mbuf_append(context->om, &heapRecord, sizeof(heapRecord));
+
+  for (uint8_t i = 0; i < Heap::nbOwners && res == 0; i++) {
+    const auto owner = static_cast<Owners>(i);
+    const auto statistics = Heap::GetOwnerStatistics(owner);
+    HeapOwnerRecord ownerRecord {};
+    std::strncpy(ownerRecord.name, Heap::Name(owner), sizeof(ownerRecord.name));
+    ownerRecord.usedBytes = statistics.usedBytes;
+    ownerRecord.peakBytes = statistics.peakBytes;
+    ownerRecord.nbBlocks = statistics.nbBlocks;
+    ownerRecord.failures = statistics.failures;
+    res = os_mbuf_append(context->om, &ownerRecord, sizeof(ownerRecord));
+  }
+  return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+/// The client freezes the trace, then reads it page by page : it selects the first record of each page, and reads the
+/// page (long read). The content of a page doesn't change while the trace is frozen, the partial reads of a long read
+/// all see the same data.
+int DiagnosticsService::OnTraceRequested(ble_gatt_access_ctxt* context) {
+  using namespace Pinetime::Trace;
+  if (context->op == BLE_GATT_ACCESS_OP_WRITE_CHR) {
+    const auto size = OS_MBUF_PKTLEN(context->om);
+    uint8_t command[3] = {};
+    if (size < 1 || size > sizeof(command)) {
+      return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+    os_mbuf_copydata(context->om, 0, size, command);
+    switch (static_cast<TraceCommands>(command[0])) {
+      case TraceCommands::Freeze:
+        Recorder::Freeze();
+        traceFirstRecord = 0;
+        return 0;
+      case TraceCommands::Start:
+        Recorder::Start((size > 1) ? command[1] : Categories::All);
+        return 0;
+      case TraceCommands::Select:
+        if (size != 3) {
+          return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        }
+        traceFirstRecord = static_cast<uint16_t>(command[1] | (command[2] << 8));
+        return 0;
+      default:
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+  }
+  if (context->op != BLE_GATT_ACCESS_OP_READ_CHR) {
+    return BLE_ATT_ERR_UNLIKELY;
+  }
+
+  // The records are only stable while the recording is frozen
+  const bool frozen = Recorder::RecordedCategories() == 0;
+  const auto nbRecords = frozen ? static_cast<uint16_t>(Recorder::NbRecords()) : 0;
+  const uint16_t first = (traceFirstRecord < nbRecords) ? traceFirstRecord : nbRecords;
+  const uint16_t nbPageRecords = ((nbRecords - first) < tracePageSize) ? (nbRecords - first) : tracePageSize;
+
+  TraceHeader header {{'P', 'T', 'T', 'R'},
+                      traceVersion,
+                      Recorder::RecordedCategories(),
+                      Pinetime::Drivers::RtcCounter::frequency,
+                      Recorder::NbRecorded(),
+                      nbRecords,
+                      first,
+                      static_cast<uint8_t>(nbPageRecords),
+                      0};
+  const auto headerOffset = OS_MBUF_PKTLEN(context->om);
+  int res = os_mbuf_append(context->om, &header, sizeof(header));
+
+  // The task numbers of the records are resolved with the names of the tasks, read in the buffer of the system
+  // monitor : the number of tasks is known once they are appended
+  const auto nbTasks = systemTask.Monitor().VisitTasks([context, &res](const TaskStatus_t& task) {
+    TraceTaskRecord taskRecord {};
+    taskRecord.number = static_cast<uint8_t>(task.xTaskNumber);
+    std::strncpy(taskRecord.name, task.pcTaskName, sizeof(taskRecord.name));
+    if (res == 0) {
+      res = os_mbuf_append(context->om, &taskRecord, sizeof(taskRecord));
+    }
+  });
+  if (res == 0) {
+    res = os_mbuf_copyinto(context->om, headerOffset + offsetof(TraceHeader, nbTasks), &nbTasks, sizeof(nbTasks));
+  }
+  for (uint16_t i = 0; i < nbPageRecords && res == 0; i++) {
+    const Record& record = Recorder::GetRecord(first + i);
+    res = os_mbuf_append(context->om, &record, sizeof(record));
+  }
+  return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+/// Same paging as the trace : the client selects the first zone of the page, then reads it (long read)
+int DiagnosticsService::OnProfilingRequested(ble_gatt_access_ctxt* context) {
+  using Pinetime::Profiling::Profiler;
+  using Pinetime::Profiling::Zones;
+  if (context->op == BLE_GATT_ACCESS_OP_WRITE_CHR) {
+    const auto size = OS_MBUF_PKTLEN(context->om);
+    uint8_t command[2] = {};
+    if (size < 1 || size > sizeof(command)) {
+      return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+    os_mbuf_copydata(context->om, 0, size, command);
+    switch (static_cast<ProfilingCommands>(command[0])) {
+      case ProfilingCommands::Reset:
+        Profiler::Reset();
+        profilingFirstZone = 0;
+        return 0;
+      case ProfilingCommands::Select:
+        if (size != 2) {
+          return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        }
+        profilingFirstZone = command[1];
+        return 0;
+      default:
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+  }
+  if (context->op != BLE_GATT_ACCESS_OP_READ_CHR) {
+    return BLE_ATT_ERR_UNLIKELY;
+  }
+
+  const uint8_t first = (profilingFirstZone < Profiler::nbZones) ? profilingFirstZone : Profiler::nbZones;
+  const uint8_t nbPageZones = ((Profiler::nbZones - first) < profilingPageSize) ? (Profiler::nbZones - first) : profilingPageSize;
+  ProfilingHeader header {Profiler::enabled,
+                          Profiler::nbZones,
+                          first,
+                          nbPageZones,
+                          Profiler::nbBuckets,
+                          Profiler::firstBucketLog2,
+                          Profiler::cyclesPerUs * 1000000};
+  int res = os_mbuf_append(context->om, &header, sizeof(header));
+
+  for (uint8_t i = first; i < first + nbPageZones && res == 0; i++) {
+    const auto zone = static_cast<Zones>(i);
+    const auto statistics = Profiler::GetStatistics(zone);
+    ProfilingZoneRecord record {};
+    std::strncpy(record.name, Profiler::Name(zone), sizeof(record.name));
+    record.count = statistics.count;
+    record.minCycles = statistics.minCycles;
+    record.maxCycles = statistics.maxCycles;
+    record.totalCycles = statistics.totalCycles;
+    std::memcpy(record.histogram, statistics.histogram, sizeof(record.histogram));
+    res = os_mbuf_append(context->om, &record, sizeof(record));
+  }
+  return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+/// Same paging as the trace : the client selects the first entry of the page, then reads it (long read). The page
+/// contains the empty entries of the hash table too.
+int DiagnosticsService::OnPcSamplesRequested(ble_gatt_access_ctxt* context) {
+  using Pinetime::Profiling::PcSampler;
+  if (context->op == BLE_GATT_ACCESS_OP_WRITE_CHR) {
+    const auto size = OS_MBUF_PKTLEN(context->om);
+    uint8_t command[3] = {};
+    if (size < 1 || size > sizeof(command)) {
+      return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+    os_mbuf_copydata(context->om, 0, size, command);
+    const auto argument = static_cast<uint16_t>(command[1] | (command[2] << 8));
+    switch (static_cast<PcSamplesCommands>(command[0])) {
+      case PcSamplesCommands::Start:
+        PcSampler::Start((size == 3) ? argument : PcSampler::defaultPeriodUs);
+        return 0;
+      case PcSamplesCommands::Stop:
+        PcSampler::Stop();
+        return 0;
+      case PcSamplesCommands::Clear:
+        PcSampler::Clear();
+        pcSamplesFirstEntry = 0;
+        return 0;
+      case PcSamplesCommands::Select:
+        if (size != 3) {
+          return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        }
+        pcSamplesFirstEntry = argument;
+        return 0;
+      default:
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+  }
+  if (context->op != BLE_GATT_ACCESS_OP_READ_CHR) {
+    return BLE_ATT_ERR_UNLIKELY;
+  }
+
+  constexpr auto nbEntries = static_cast<uint16_t>(PcSampler::capacity);
+  const uint16_t first = (pcSamplesFirstEntry < nbEntries) ? pcSamplesFirstEntry : nbEntries;
+  const uint16_t nbPageEntries = ((nbEntries - first) < pcSamplesPageSize) ? (nbEntries - first) : pcSamplesPageSize;
+  const auto statistics = PcSampler::GetStatistics();
+  PcSamplesHeader header {PcSampler::IsRunning(),
+                          PcSampler::bucketShift,
+                          PcSampler::PeriodUs(),
+                          statistics.samples,
+                          statistics.outside,
+                          statistics.lost,
+                          statistics.halvings,
+                          nbEntries,
+                          first,
+                          static_cast<uint8_t>(nbPageEntries)};
+  int res = os_mbuf_append(context->om, &header, sizeof(header));
+
+  for (uint16_t i = first; i < first + nbPageEntries && res == 0; i++) {
+    const PcSampler::Entry entry = PcSampler::GetEntry(i);
+    res = os_mbuf_append(context->om, &entry, sizeof(entry));
+  }
+  return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+/// The client selects the position of the page, reads it (long read), then releases the records of the page. The end
+/// of the page is fixed by the selection : the partial reads of a long read all see the same records.
+int DiagnosticsService::OnBinaryLogRequested(ble_gatt_access_ctxt* context) {
+  using Pinetime::Logging::BinaryLog;
+  if (context->op == BLE_GATT_ACCESS_OP_WRITE_CHR) {
+    const auto size = OS_MBUF_PKTLEN(context->om);
+    uint8_t command[5] = {};
+    if (size != sizeof(command)) {
+      return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+    os_mbuf_copydata(context->om, 0, size, command);
+    const uint32_t position = command[1] | (command[2] << 8) | (command[3] << 16) | (static_cast<uint32_t>(command[4]) << 24);
+    switch (static_cast<BinaryLogCommands>(command[0])) {
+      case BinaryLogCommands::Select: {
+        const uint32_t tail = BinaryLog::Tail();
+        binaryLogPageStart = (position - tail <= BinaryLog::Head() - tail) ? position : tail;
+        binaryLogPageEnd = binaryLogPageStart;
+        size_t recordSize;
+        while ((recordSize = BinaryLog::RecordSize(binaryLogPageEnd)) != 0 &&
+               binaryLogPageEnd + recordSize - binaryLogPageStart <= binaryLogPageSize) {
+          binaryLogPageEnd += recordSize;
+        }
+        return 0;
+      }
+      case BinaryLogCommands::Release:
+        binaryLogPageStart = binaryLogPageEnd = position;
+        return BinaryLog::Release(position) ? 0 : BLE_ATT_ERR_UNLIKELY;
+      default:
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+  }
+  if (context->op != BLE_GATT_ACCESS_OP_READ_CHR) {
+    return BLE_ATT_ERR_UNLIKELY;
+  }
+
+  // A page that was released (by another client) is empty
+  const uint32_t tail = BinaryLog::Tail();
+  const bool valid = binaryLogPageStart - tail <= BinaryLog::Head() - tail;
+  const auto nbPageWords = static_cast<uint16_t>(valid ? (binaryLogPageEnd - binaryLogPageStart) : 0);
+  const auto statistics = BinaryLog::GetStatistics();
+  BinaryLogHeader header {Pinetime::Drivers::RtcCounter::frequency,
+                          tail,
+                          BinaryLog::Head(),
+                          statistics.written,
+                          statistics.dropped,
+                          binaryLogPageStart,
+                          nbPageWords};
+  int res = os_mbuf_append(context->om, &header, sizeof(header));
+
+  for (uint16_t i = 0; i < nbPageWords && res == 0; i++) {
+    const uint32_t word = BinaryLog::Word(binaryLogPageStart + i);
+    res = os_mbuf_append(context->om, &word, sizeof(word));
+  }
+  return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+void DiagnosticsService::SubscribeNotification(uint16_t /*connectionHandle*/, uint16_t attributeHandle) {
+  if (attributeHandle == binaryLogHandle) {
+    binaryLogNotificationEnabled = true;
+  }
+}
+
+void DiagnosticsService::UnsubscribeNotification(uint16_t /*connectionHandle*/, uint16_t attributeHandle) {
+  if (attributeHandle == binaryLogHandle) {
+    binaryLogNotificationEnabled = false;
+  }
+}
+
+void DiagnosticsService::NotifyBinaryLog(uint16_t connectionHandle) {
+  using Pinetime::Logging::BinaryLog;
+  if (!binaryLogNotificationEnabled) {
+    return;
+  }
+  BinaryLogNotification notification {BinaryLog::Tail(), BinaryLog::Head()};
+  auto* om = ble_hs_mbuf_from_flat(&notification, sizeof(notification));
+  if (om != nullptr) {
+    ble_gattc_notify_custom(connectionHandle, binaryLogHandle, om);
+  }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#define min // workaround: nimble's min/max macros conflict with libstdc++
+#define max
+#include <host/ble_gap.h>
+#undef max
+#undef min
+#include <atomic>
+
+namespace Pinetime {
+  namespace Drivers {
+    class TwiMaster;
+  }
+  namespace System {
+    class SystemTask;
+  }
+  namespace Controllers {
+    class TouchHandler;
+
+    /// Access to the internal performance counters and to the profilers of the firmware
+    class DiagnosticsService {
+    public:
+      DiagnosticsService(Pinetime::System::SystemTask& systemTask, Pinetime::Drivers::TwiMaster& twiMaster, TouchHandler& touchHandler);
+      void Init();
+      int OnRead(uint16_t connectionHandle, uint16_t attributeHandle, ble_gatt_access_ctxt* context);
+      void SubscribeNotification(uint16_t connectionHandle, uint16_t attributeHandle);
+      void UnsubscribeNotification(uint16_t connectionHandle, uint16_t attributeHandle);
+      /// Tells the subscribed client that the binary log has records to retrieve
+      void NotifyBinaryLog(uint16_t connectionHandle);
+
+    private:
+      int ReadTwiStatistics(ble_gatt_access_ctxt* context);
+      int ReadTouchLatency(ble_gatt_access_ctxt* context);
+      int ReadWakeups(ble_gatt_access_ctxt* context);
+      int ReadTimers(ble_gatt_access_ctxt* context);
+      int ReadMessageQueues(ble_gatt_access_ctxt* context);
+      int ReadCpuLoad(ble_gatt_access_ctxt* context);
+      int ReadHeap(ble_gatt_access_ctxt* context);
+      int OnTraceRequested(ble_gatt_access_ctxt* context);
+      int OnProfilingRequested(ble_gatt_access_ctxt* context);
+      int OnPcSamplesRequested(ble_gatt_access_ctxt* context);
+      int OnBinaryLogRequested(ble_gatt_access_ctxt* context);
+
+      Pinetime::System::SystemTask& systemTask;
+      Pinetime::Drivers::TwiMaster& twiMaster;
+      TouchHandler& touchHandler;
+
+      struct ble_gatt_chr_def characteristicDefinition[12];
+      struct ble_gatt_svc_def serviceDefinition[2];
+
+      uint16_t twiStatisticsHandle;
+      uint16_t touchLatencyHandle;
+      uint16_t wakeupsHandle;
+      uint16_t timersHandle;
+      uint16_t messageQueuesHandle;
+      uint16_t cpuLoadHandle;
+      uint16_t traceHandle;
+      uint16_t profilingHandle;
+      uint16_t pcSamplesHandle;
+      uint16_t binaryLogHandle;
+      uint16_t heapHandle;
+
+      uint16_t traceFirstRecord = 0;
+      uint8_t profilingFirstZone = 0;
+      uint16_t pcSamplesFirstEntry = 0;
+      uint32_t binaryLogPageStart = 0;
+      uint32_t binaryLogPageEnd = 0;
+      std::atomic_bool binaryLogNotificationEnabled {false};
+    };
+  }
+}
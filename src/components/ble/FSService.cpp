@@ -1,7 +1,8 @@
-#include <nrf_log.h>
+#include "logging/BinaryLog.h"
 #include "FSService.h"
 #include "components/ble/BleController.h"
 #include "systemtask/SystemTask.h"
+#include "profiling/Profiler.h"
 
 using namespace Pinetime::Controllers;
 
@@ -10,6 +11,7 @@ constexpr ble_uuid128_t FSService::fsVersionUuid;
 constexpr ble_uuid128_t FSService::fsTransferUuid;
 
 int FSServiceCallback(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt* ctxt, void* arg) {
+  Pinetime::Profiling::Zone zone(Pinetime::Profiling::Zones::GattFs);
   auto* fsService = static_cast<FSService*>(arg);
   return fsService->OnFSServiceRequested(conn_handle, attr_handle, ctxt);
 }
@@ -50,7 +52,7 @@ void FSService::Init() {
 
 int FSService::OnFSServiceRequested(uint16_t connectionHandle, uint16_t attributeHandle, ble_gatt_access_ctxt* context) {
   if (attributeHandle == versionCharacteristicHandle) {
-    NRF_LOG_INFO("FS_S : handle = %d", versionCharacteristicHandle);
+    BINLOG("FS_S : handle = %d", versionCharacteristicHandle);
     int res = os_mbuf_append(context->om, &fsVersion, sizeof(fsVersion));
     return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
   }
@@ -62,7 +64,7 @@ int FSService::OnFSServiceRequested(uint16_t connectionHandle, uint16_t attribut
 
 int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
   auto command = static_cast<commands>(om->om_data[0]);
-  NRF_LOG_INFO("[FS_S] -> FSCommandHandler Command %d", command);
+  BINLOG("[FS_S] -> FSCommandHandler Command %d", command);
   // Just always make sure we are awake...
   systemTask.PushMessage(Pinetime::System::Messages::StartFileTransfer);
   vTaskDelay(10);
@@ -74,7 +76,7 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
   lfs_file f = {0};
   switch (command) {
     case commands::READ: {
-      NRF_LOG_INFO("[FS_S] -> Read");
+      BINLOG("[FS_S] -> Read");
       auto* header = (ReadHeader*) om->om_data;
       uint16_t plen = header->pathlen;
       if (plen > maxpathlen) { //> counts for null term
@@ -109,7 +111,7 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
       break;
     }
     case commands::READ_PACING: {
-      NRF_LOG_INFO("[FS_S] -> Readpacing");
+      BINLOG("[FS_S] -> Readpacing");
       auto* header = (ReadHeader*) om->om_data;
       ReadResponse resp;
       resp.command = commands::READ_DATA;
@@ -141,7 +143,7 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
       break;
     }
     case commands::WRITE: {
-      NRF_LOG_INFO("[FS_S] -> Write");
+      BINLOG("[FS_S] -> Write");
       auto* header = (WriteHeader*) om->om_data;
       uint16_t plen = header->pathlen;
       if (plen > maxpathlen) { //> counts for null term
@@ -166,7 +168,7 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
       break;
     }
     case commands::WRITE_DATA: {
-      NRF_LOG_INFO("[FS_S] -> WriteData");
+      BINLOG("[FS_S] -> WriteData");
       auto* header = (WritePacing*) om->om_data;
       WriteResponse resp;
       resp.command = commands::WRITE_PACING;
@@ -188,7 +190,7 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
       break;
     }
     case commands::DELETE: {
-      NRF_LOG_INFO("[FS_S] -> Delete");
+      BINLOG("[FS_S] -> Delete");
       auto* header = (DelHeader*) om->om_data;
       uint16_t plen = header->pathlen;
       char path[plen + 1] = {0};
@@ -203,7 +205,7 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
       break;
     }
     case commands::MKDIR: {
-      NRF_LOG_INFO("[FS_S] -> MKDir");
+      BINLOG("[FS_S] -> MKDir");
       auto* header = (MKDirHeader*) om->om_data;
       uint16_t plen = header->pathlen;
       char path[plen + 1] = {0};
@@ -219,7 +221,7 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
       break;
     }
     case commands::LISTDIR: {
-      NRF_LOG_INFO("[FS_S] -> ListDir");
+      BINLOG("[FS_S] -> ListDir");
       ListDirHeader* header = (ListDirHeader*) om->om_data;
       uint16_t plen = header->pathlen;
       char path[plen + 1] = {0};
@@ -283,7 +285,7 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
       break;
     }
     case commands::MOVE: {
-      NRF_LOG_INFO("[FS_S] -> Move");
+      BINLOG("[FS_S] -> Move");
       MoveHeader* header = (MoveHeader*) om->om_data;
       uint16_t plen = header->OldPathLength;
       // Null Terminate string
@@ -301,7 +303,7 @@ int FSService::FSCommandHandler(uint16_t connectionHandle, os_mbuf* om) {
     default:
       break;
   }
-  NRF_LOG_INFO("[FS_S] -> done ");
+  BINLOG("[FS_S] -> done ");
   systemTask.PushMessage(Pinetime::System::Messages::StopFileTransfer);
   return 0;
 }
@@ -2,6 +2,7 @@
 #include "components/heartrate/HeartRateController.h"
 #include "systemtask/SystemTask.h"
 #include <nrf_log.h>
+#include "profiling/Profiler.h"
 
 using namespace Pinetime::Controllers;
 
@@ -10,6 +11,7 @@ constexpr ble_uuid16_t HeartRateService::heartRateMeasurementUuid;
 
 namespace {
   int HeartRateServiceCallback(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt* ctxt, void* arg) {
+    Pinetime::Profiling::Zone zone(Pinetime::Profiling::Zones::GattHeartRate);
     auto* heartRateService = static_cast<HeartRateService*>(arg);
     return heartRateService->OnHeartRateRequested(conn_handle, attr_handle, ctxt);
   }
@@ -59,8 +61,19 @@ int HeartRateService::OnHeartRateRequested(uint16_t connectionHandle, uint16_t a
 void HeartRateService::OnNewHeartRateValue(uint8_t heartRateValue) {
   if(!heartRateMeasurementNotificationEnable) return;
 
-  uint8_t buffer[2] = {0, heartRateController.HeartRate()}; // [0] = flags, [1] = hr value
-  auto* om = ble_hs_mbuf_from_flat(buffer, 2);
+  // [0] = flags, [1] = hr value, [2..] = RR intervals (uint16, 1/1024s)
+  uint8_t buffer[2 + (2 * maxRrIntervals)] = {0, heartRateController.HeartRate()};
+  uint16_t rrIntervals[maxRrIntervals];
+  auto nbRrIntervals = heartRateController.TakeRrIntervals(rrIntervals, maxRrIntervals);
+  if (nbRrIntervals > 0) {
+    buffer[0] |= rrIntervalPresentFlag;
+  }
+  for (size_t i = 0; i < nbRrIntervals; i++) {
+    auto rrInterval = static_cast<uint16_t>((static_cast<uint32_t>(rrIntervals[i]) * 1024) / 1000);
+    buffer[2 + (2 * i)] = rrInterval & 0xff;
+    buffer[3 + (2 * i)] = rrInterval >> 8;
+  }
+  auto* om = ble_hs_mbuf_from_flat(buffer, 2 + (2 * nbRrIntervals));
 
   uint16_t connectionHandle = system.nimble().connHandle();
 
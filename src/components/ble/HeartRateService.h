@@ -3,6 +3,7 @@
 #define max
 #include <host/ble_gap.h>
 #include <atomic>
+#include <cstddef>
 #undef max
 #undef min
 
@@ -27,6 +28,9 @@ namespace Pinetime {
       Controllers::HeartRateController& heartRateController;
       static constexpr uint16_t heartRateServiceId {0x180D};
       static constexpr uint16_t heartRateMeasurementId {0x2A37};
+      static constexpr uint8_t rrIntervalPresentFlag = 0x10;
+      // Fits in the default ATT MTU (23 bytes)
+      static constexpr size_t maxRrIntervals = 4;
 
       static constexpr ble_uuid16_t heartRateServiceUuid {.u {.type = BLE_UUID_TYPE_16}, .value = heartRateServiceId};
 
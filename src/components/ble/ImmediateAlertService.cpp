@@ -2,6 +2,7 @@
 #include <cstring>
 #include "components/ble/NotificationManager.h"
 #include "systemtask/SystemTask.h"
+#include "profiling/Profiler.h"
 
 using namespace Pinetime::Controllers;
 
@@ -10,6 +11,7 @@ constexpr ble_uuid16_t ImmediateAlertService::alertLevelUuid;
 
 namespace {
   int AlertLevelCallback(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt* ctxt, void* arg) {
+    Pinetime::Profiling::Zone zone(Pinetime::Profiling::Zones::GattImmediateAlert);
     auto* immediateAlertService = static_cast<ImmediateAlertService*>(arg);
     return immediateAlertService->OnAlertLevelChanged(conn_handle, attr_handle, ctxt);
   }
@@ -1,7 +1,11 @@
 #include "components/ble/MotionService.h"
 #include "components/motion/MotionController.h"
+#include "components/motion/StepHistory.h"
 #include "systemtask/SystemTask.h"
+#include <algorithm>
+#include <cstring>
 #include <nrf_log.h>
+#include "profiling/Profiler.h"
 
 using namespace Pinetime::Controllers;
 
@@ -22,17 +26,60 @@ namespace {
   constexpr ble_uuid128_t motionServiceUuid {BaseUuid()};
   constexpr ble_uuid128_t stepCountCharUuid {CharUuid(0x01, 0x00)};
   constexpr ble_uuid128_t motionValuesCharUuid {CharUuid(0x02, 0x00)};
+  constexpr ble_uuid128_t stepHistoryCharUuid {CharUuid(0x03, 0x00)};
+  constexpr ble_uuid128_t streamingControlCharUuid {CharUuid(0x04, 0x00)};
+  constexpr ble_uuid128_t streamingDataCharUuid {CharUuid(0x05, 0x00)};
+
+  struct __attribute__((packed)) StepHistoryHeader {
+    uint32_t timestamp; // Start of the first bucket, in seconds since epoch
+    uint16_t bucketDuration; // In seconds
+  };
+
+  enum class StreamingCommands : uint8_t { Stop = 0, Start = 1 };
+  constexpr uint8_t deltaEncodingFlag = 0x01;
+
+  struct __attribute__((packed)) StreamingControl {
+    uint8_t command;
+    uint8_t rate; // Hz
+    uint8_t flags;
+    uint8_t samplesPerNotification; // 0 : as many as the MTU allows
+  };
+
+  struct __attribute__((packed)) StreamingStatus {
+    StreamingControl control;
+    uint32_t droppedSamples;
+  };
+
+  struct __attribute__((packed)) StreamingPacketHeader {
+    uint32_t timestamp; // Time of the first sample, in ms since boot
+    uint16_t sampleIndex; // Index of the first sample since the start of the streaming
+    uint8_t nbSamples;
+    uint8_t flags;
+  };
+
+  constexpr uint8_t maxRate = 100;
+  constexpr size_t rawSampleSize = 3 * sizeof(int16_t);
+  constexpr size_t deltaSampleSize = 3 * sizeof(int8_t);
+
+  bool FitsInDelta(int16_t value, int16_t previous) {
+    int32_t delta = value - previous;
+    return delta >= INT8_MIN && delta <= INT8_MAX;
+  }
 
   int MotionServiceCallback(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt* ctxt, void* arg) {
+    Pinetime::Profiling::Zone zone(Pinetime::Profiling::Zones::GattMotion);
     auto* motionService = static_cast<MotionService*>(arg);
     return motionService->OnStepCountRequested(conn_handle, attr_handle, ctxt);
   }
 }
 
 // TODO Refactoring - remove dependency to SystemTask
-MotionService::MotionService(Pinetime::System::SystemTask& system, Controllers::MotionController& motionController)
+MotionService::MotionService(Pinetime::System::SystemTask& system,
+                             Controllers::MotionController& motionController,
+                             Controllers::StepHistory& stepHistory)
   : system {system},
     motionController {motionController},
+    stepHistory {stepHistory},
     characteristicDefinition {{.uuid = &stepCountCharUuid.u,
                                .access_cb = MotionServiceCallback,
                                .arg = this,
@@ -43,6 +90,21 @@ MotionService::MotionService(Pinetime::System::SystemTask& system, Controllers::
                                .arg = this,
                                .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_NOTIFY,
                                .val_handle = &motionValuesHandle},
+                              {.uuid = &stepHistoryCharUuid.u,
+                               .access_cb = MotionServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+                               .val_handle = &stepHistoryHandle},
+                              {.uuid = &streamingControlCharUuid.u,
+                               .access_cb = MotionServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+                               .val_handle = &streamingControlHandle},
+                              {.uuid = &streamingDataCharUuid.u,
+                               .access_cb = MotionServiceCallback,
+                               .arg = this,
+                               .flags = BLE_GATT_CHR_F_NOTIFY,
+                               .val_handle = &streamingDataHandle},
                               {0}},
     serviceDefinition {
       {
@@ -77,10 +139,182 @@ int MotionService::OnStepCountRequested(uint16_t connectionHandle, uint16_t attr
 
     int res = os_mbuf_append(context->om, buffer, 3 * sizeof(int16_t));
     return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+  } else if (attributeHandle == stepHistoryHandle) {
+    return OnStepHistoryRequested(context);
+  } else if (attributeHandle == streamingControlHandle) {
+    return OnStreamingControlRequested(context);
   }
   return 0;
 }
 
+/// The client writes the timestamp from which it wants the history, then reads the buckets (long read).
+/// The buckets are fetched from the file on the write only, not on each of the partial reads of a long read.
+int MotionService::OnStepHistoryRequested(ble_gatt_access_ctxt* context) {
+  if (context->op == BLE_GATT_ACCESS_OP_WRITE_CHR) {
+    if (OS_MBUF_PKTLEN(context->om) != sizeof(uint32_t)) {
+      return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+    uint32_t fromTimestamp;
+    os_mbuf_copydata(context->om, 0, sizeof(uint32_t), &fromTimestamp);
+    ReadStepHistory(fromTimestamp);
+    return 0;
+  }
+
+  StepHistoryHeader header {historyTimestamp, StepHistory::bucketDuration};
+  int res = os_mbuf_append(context->om, &header, sizeof(header));
+  if (res == 0) {
+    res = os_mbuf_append(context->om, historyBuckets.data(), nbHistoryBuckets * sizeof(uint16_t));
+  }
+  return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+void MotionService::ReadStepHistory(uint32_t fromTimestamp) {
+  // The SPI NOR flash is powered down while sleeping : wake the system up, like the file transfer does
+  system.PushMessage(Pinetime::System::Messages::StartFileTransfer);
+  vTaskDelay(10);
+  while (system.IsSleeping()) {
+    vTaskDelay(100);
+  }
+  uint32_t firstHour;
+  nbHistoryBuckets = stepHistory.Read(fromTimestamp / StepHistory::bucketDuration, firstHour, historyBuckets.data(), maxHistoryBuckets);
+  historyTimestamp = firstHour * StepHistory::bucketDuration;
+  NRF_LOG_INFO("Motion-stephistory : %d buckets from %lu", nbHistoryBuckets, historyTimestamp);
+  system.PushMessage(Pinetime::System::Messages::StopFileTransfer);
+}
+
+int MotionService::OnStreamingControlRequested(ble_gatt_access_ctxt* context) {
+  if (context->op == BLE_GATT_ACCESS_OP_WRITE_CHR) {
+    if (OS_MBUF_PKTLEN(context->om) != sizeof(StreamingControl)) {
+      return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+    StreamingControl control;
+    os_mbuf_copydata(context->om, 0, sizeof(StreamingControl), &control);
+
+    // Lowest rate of the FIFO that is at least the requested one
+    uint8_t downsampling = 0;
+    while (downsampling < Drivers::Bma421::defaultFifoDownsampling && (maxRate >> (downsampling + 1)) >= control.rate) {
+      downsampling++;
+    }
+    streamingDownsampling = downsampling;
+    isDeltaEncoding = (control.flags & deltaEncodingFlag) != 0;
+    samplesPerNotification = control.samplesPerNotification;
+    bool start = control.command == static_cast<uint8_t>(StreamingCommands::Start);
+    if (start && !isStreaming) {
+      droppedSamples = 0;
+    }
+    isStreaming = start;
+    NRF_LOG_INFO("Motion-streaming : %s, %dHz", start ? "start" : "stop", maxRate >> downsampling);
+    system.PushMessage(Pinetime::System::Messages::MotionStreamingChanged);
+    return 0;
+  }
+
+  StreamingStatus status {{static_cast<uint8_t>(isStreaming ? StreamingCommands::Start : StreamingCommands::Stop),
+                           static_cast<uint8_t>(maxRate >> streamingDownsampling),
+                           static_cast<uint8_t>(isDeltaEncoding ? deltaEncodingFlag : 0),
+                           samplesPerNotification},
+                          droppedSamples};
+  int res = os_mbuf_append(context->om, &status, sizeof(status));
+  return (res == 0) ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+uint8_t MotionService::StreamingWatermark() const {
+  // Read the FIFO ~4 times per second, or each time a notification can be filled
+  uint8_t watermark = std::max(3, (maxRate >> streamingDownsampling) / 4);
+  if (samplesPerNotification != 0) {
+    watermark = samplesPerNotification;
+  }
+  return std::min<uint8_t>(watermark, Drivers::Bma421Fifo::maxSamples / 2);
+}
+
+void MotionService::OnNewMotionSamples(const Drivers::Bma421Fifo::Sample* samples,
+                                       size_t nbSamples,
+                                       uint32_t timestampMs,
+                                       uint32_t nbDropped) {
+  if (!IsStreaming()) {
+    nbPacketSamples = 0;
+    sampleIndex = 0;
+    return;
+  }
+
+  uint16_t connectionHandle = system.nimble().connHandle();
+  if (connectionHandle == 0 || connectionHandle == BLE_HS_CONN_HANDLE_NONE) {
+    return;
+  }
+
+  if (nbDropped > 0) {
+    // The timestamps of the samples of a packet are implicit : a packet does not contain a gap
+    SendPacket(connectionHandle);
+    droppedSamples += nbDropped;
+    sampleIndex += nbDropped;
+  }
+
+  uint32_t periodMs = 10 << streamingDownsampling;
+  for (size_t i = 0; i < nbSamples; i++) {
+    uint32_t timestamp = timestampMs + (i * periodMs);
+    if (!AppendSample(samples[i], timestamp, connectionHandle)) {
+      SendPacket(connectionHandle);
+      AppendSample(samples[i], timestamp, connectionHandle);
+    }
+    if (nbPacketSamples != 0 && nbPacketSamples == samplesPerNotification) {
+      SendPacket(connectionHandle);
+    }
+  }
+}
+
+/// Returns false if the sample does not fit in the current packet
+bool MotionService::AppendSample(const Drivers::Bma421Fifo::Sample& sample, uint32_t timestampMs, uint16_t connectionHandle) {
+  size_t capacity = std::min<size_t>(ble_att_mtu(connectionHandle) - 3, maxPacketSize);
+
+  if (nbPacketSamples == 0) {
+    if (sizeof(StreamingPacketHeader) + rawSampleSize > capacity) {
+      droppedSamples++;
+      sampleIndex++;
+      return true;
+    }
+    packetTimestamp = timestampMs;
+    packetSampleIndex = sampleIndex;
+    packetSize = sizeof(StreamingPacketHeader);
+  } else if (isDeltaEncoding) {
+    if (packetSize + deltaSampleSize > capacity || !FitsInDelta(sample.x, lastSample.x) ||
+        !FitsInDelta(sample.y, lastSample.y) || !FitsInDelta(sample.z, lastSample.z)) {
+      return false;
+    }
+    packet[packetSize++] = static_cast<uint8_t>(sample.x - lastSample.x);
+    packet[packetSize++] = static_cast<uint8_t>(sample.y - lastSample.y);
+    packet[packetSize++] = static_cast<uint8_t>(sample.z - lastSample.z);
+  } else if (packetSize + rawSampleSize > capacity) {
+    return false;
+  }
+
+  if (nbPacketSamples == 0 || !isDeltaEncoding) {
+    int16_t values[3] = {sample.x, sample.y, sample.z};
+    std::memcpy(packet.data() + packetSize, values, rawSampleSize);
+    packetSize += rawSampleSize;
+  }
+  lastSample = sample;
+  nbPacketSamples++;
+  sampleIndex++;
+  return true;
+}
+
+void MotionService::SendPacket(uint16_t connectionHandle) {
+  if (nbPacketSamples == 0) {
+    return;
+  }
+
+  StreamingPacketHeader header {packetTimestamp,
+                                packetSampleIndex,
+                                nbPacketSamples,
+                                static_cast<uint8_t>(isDeltaEncoding ? deltaEncodingFlag : 0)};
+  std::memcpy(packet.data(), &header, sizeof(header));
+
+  auto* om = ble_hs_mbuf_from_flat(packet.data(), packetSize);
+  if (om == nullptr || ble_gattc_notify_custom(connectionHandle, streamingDataHandle, om) != 0) {
+    droppedSamples += nbPacketSamples;
+  }
+  nbPacketSamples = 0;
+}
+
 void MotionService::OnNewStepCountValue(uint32_t stepCount) {
   if(!stepCountNoficationEnabled) return;
 
@@ -115,6 +349,10 @@ void MotionService::SubscribeNotification(uint16_t connectionHandle, uint16_t at
     stepCountNoficationEnabled = true;
   else if(attributeHandle == motionValuesHandle)
     motionValuesNoficationEnabled = true;
+  else if (attributeHandle == streamingDataHandle) {
+    streamingNotificationEnabled = true;
+    system.PushMessage(Pinetime::System::Messages::MotionStreamingChanged);
+  }
 }
 
 void MotionService::UnsubscribeNotification(uint16_t connectionHandle, uint16_t attributeHandle) {
@@ -122,4 +360,10 @@ void MotionService::UnsubscribeNotification(uint16_t connectionHandle, uint16_t
     stepCountNoficationEnabled = false;
   else if(attributeHandle == motionValuesHandle)
     motionValuesNoficationEnabled = false;
+  else if (attributeHandle == streamingDataHandle) {
+    // Also called on disconnection : the streaming is stopped until the client starts it again
+    streamingNotificationEnabled = false;
+    isStreaming = false;
+    system.PushMessage(Pinetime::System::Messages::MotionStreamingChanged);
+  }
 }
@@ -2,9 +2,12 @@
 #define min // workaround: nimble's min/max macros conflict with libstdc++
 #define max
 #include <host/ble_gap.h>
+#include <host/ble_att.h>
+#include <array>
 #include <atomic>
 #undef max
 #undef min
+#include "drivers/Bma421.h"
 
 namespace Pinetime {
   namespace System {
@@ -12,13 +15,36 @@ namespace Pinetime {
   }
   namespace Controllers {
     class MotionController;
+    class StepHistory;
     class MotionService {
     public:
-      MotionService(Pinetime::System::SystemTask& system, Controllers::MotionController& motionController);
+      MotionService(Pinetime::System::SystemTask& system,
+                    Controllers::MotionController& motionController,
+                    Controllers::StepHistory& stepHistory);
       void Init();
       int OnStepCountRequested(uint16_t connectionHandle, uint16_t attributeHandle, ble_gatt_access_ctxt* context);
       void OnNewStepCountValue(uint32_t stepCount);
       void OnNewMotionValues(int16_t x, int16_t y, int16_t z);
+      bool IsStepCountNotificationEnabled() const {
+        return stepCountNoficationEnabled;
+      }
+
+      /// Streaming of the FIFO samples, started and configured by the client through the control characteristic
+      bool IsStreaming() const {
+        return isStreaming && streamingNotificationEnabled;
+      }
+      /// Rate requested by the client (100Hz / 2^downsampling)
+      uint8_t StreamingDownsampling() const {
+        return streamingDownsampling;
+      }
+      /// Number of samples to read from the FIFO at once
+      uint8_t StreamingWatermark() const;
+      /// samples : consecutive FIFO samples, timestampMs being the time of the first one
+      /// nbDropped : number of samples lost before these ones
+      void OnNewMotionSamples(const Drivers::Bma421Fifo::Sample* samples,
+                              size_t nbSamples,
+                              uint32_t timestampMs,
+                              uint32_t nbDropped);
 
       void SubscribeNotification(uint16_t connectionHandle, uint16_t attributeHandle);
       void UnsubscribeNotification(uint16_t connectionHandle, uint16_t attributeHandle);
@@ -26,14 +52,47 @@ namespace Pinetime {
     private:
       Pinetime::System::SystemTask& system;
       Controllers::MotionController& motionController;
+      Controllers::StepHistory& stepHistory;
+
+      int OnStepHistoryRequested(ble_gatt_access_ctxt* context);
+      void ReadStepHistory(uint32_t fromTimestamp);
+      int OnStreamingControlRequested(ble_gatt_access_ctxt* context);
+      bool AppendSample(const Drivers::Bma421Fifo::Sample& sample, uint32_t timestampMs, uint16_t connectionHandle);
+      void SendPacket(uint16_t connectionHandle);
 
-      struct ble_gatt_chr_def characteristicDefinition[3];
+      struct ble_gatt_chr_def characteristicDefinition[6];
       struct ble_gatt_svc_def serviceDefinition[2];
 
       uint16_t stepCountHandle;
       uint16_t motionValuesHandle;
+      uint16_t stepHistoryHandle;
+      uint16_t streamingControlHandle;
+      uint16_t streamingDataHandle;
       std::atomic_bool stepCountNoficationEnabled {false};
       std::atomic_bool motionValuesNoficationEnabled {false};
+
+      // One week of hourly buckets per read, so that the value fits in the 512 bytes of an attribute
+      static constexpr uint16_t maxHistoryBuckets = 168;
+      uint32_t historyTimestamp = 0;
+      uint16_t nbHistoryBuckets = 0;
+      std::array<uint16_t, maxHistoryBuckets> historyBuckets;
+
+      std::atomic_bool streamingNotificationEnabled {false};
+      std::atomic_bool isStreaming {false};
+      std::atomic<uint8_t> streamingDownsampling {Drivers::Bma421::defaultFifoDownsampling};
+      std::atomic_bool isDeltaEncoding {false};
+      std::atomic<uint8_t> samplesPerNotification {0};
+      std::atomic<uint32_t> droppedSamples {0};
+      // Index of the next sample, the dropped samples included, so that the client can detect the gaps
+      uint16_t sampleIndex = 0;
+      // Packet being filled : header, first sample (raw), next samples (raw or deltas)
+      static constexpr size_t maxPacketSize = MYNEWT_VAL(BLE_ATT_PREFERRED_MTU) - 3;
+      std::array<uint8_t, maxPacketSize> packet;
+      size_t packetSize = 0;
+      uint8_t nbPacketSamples = 0;
+      uint32_t packetTimestamp = 0;
+      uint16_t packetSampleIndex = 0;
+      Drivers::Bma421Fifo::Sample lastSample;
     };
   }
 }
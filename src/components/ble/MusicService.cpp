@@ -18,6 +18,7 @@
 #include "components/ble/MusicService.h"
 #include "systemtask/SystemTask.h"
 #include <cstring>
+#include "profiling/Profiler.h"
 
 namespace {
   // 0000yyxx-78fc-48fe-8e23-433b3a1942d0
@@ -51,6 +52,7 @@ namespace {
   constexpr uint8_t MaxStringSize {40};
 
   int MusicCallback(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt* ctxt, void* arg) {
+    Pinetime::Profiling::Zone zone(Pinetime::Profiling::Zones::GattMusic);
     return static_cast<Pinetime::Controllers::MusicService*>(arg)->OnCommand(conn_handle, attr_handle, ctxt);
   }
 }
@@ -19,6 +19,7 @@
 #include "components/ble/NavigationService.h"
 
 #include "systemtask/SystemTask.h"
+#include "profiling/Profiler.h"
 
 namespace {
   // 0001yyxx-78fc-48fe-8e23-433b3a1942d0
@@ -40,6 +41,7 @@ namespace {
   constexpr ble_uuid128_t navProgressCharUuid {CharUuid(0x04, 0x00)};
 
   int NAVCallback(uint16_t conn_handle, uint16_t attr_handle, struct ble_gatt_access_ctxt* ctxt, void* arg) {
+    Pinetime::Profiling::Zone zone(Pinetime::Profiling::Zones::GattNavigation);
     auto navService = static_cast<Pinetime::Controllers::NavigationService*>(arg);
     return navService->OnCommand(conn_handle, attr_handle, ctxt);
   }
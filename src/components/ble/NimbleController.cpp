@@ -29,8 +29,11 @@ NimbleController::NimbleController(Pinetime::System::SystemTask& systemTask,
                                    NotificationManager& notificationManager,
                                    Battery& batteryController,
                                    Pinetime::Drivers::SpiNorFlash& spiNorFlash,
+                                   Pinetime::Drivers::TwiMaster& twiMaster,
+                                   TouchHandler& touchHandler,
                                    HeartRateController& heartRateController,
                                    MotionController& motionController,
+                                   StepHistory& stepHistory,
                                    FS& fs)
   : systemTask {systemTask},
     bleController {bleController},
@@ -49,8 +52,9 @@ NimbleController::NimbleController(Pinetime::System::SystemTask& systemTask,
     batteryInformationService {batteryController},
     immediateAlertService {systemTask, notificationManager},
     heartRateService {systemTask, heartRateController},
-    motionService {systemTask, motionController},
+    motionService {systemTask, motionController, stepHistory},
     fsService {systemTask, fs},
+    diagnosticsService {systemTask, twiMaster, touchHandler},
     serviceDiscovery({&currentTimeClient, &alertNotificationClient}) {
 }
 
@@ -100,6 +104,7 @@ void NimbleController::Init() {
   heartRateService.Init();
   motionService.Init();
   fsService.Init();
+  diagnosticsService.Init();
 
   int rc;
   rc = ble_hs_util_ensure_addr(0);
@@ -324,12 +329,15 @@ int NimbleController::OnGAPEvent(ble_gap_event* event) {
       if (event->subscribe.reason == BLE_GAP_SUBSCRIBE_REASON_TERM) {
         heartRateService.UnsubscribeNotification(event->subscribe.conn_handle, event->subscribe.attr_handle);
         motionService.UnsubscribeNotification(event->subscribe.conn_handle, event->subscribe.attr_handle);
+        diagnosticsService.UnsubscribeNotification(event->subscribe.conn_handle, event->subscribe.attr_handle);
       } else if (event->subscribe.prev_notify == 0 && event->subscribe.cur_notify == 1) {
         heartRateService.SubscribeNotification(event->subscribe.conn_handle, event->subscribe.attr_handle);
         motionService.SubscribeNotification(event->subscribe.conn_handle, event->subscribe.attr_handle);
+        diagnosticsService.SubscribeNotification(event->subscribe.conn_handle, event->subscribe.attr_handle);
       } else if (event->subscribe.prev_notify == 1 && event->subscribe.cur_notify == 0) {
         heartRateService.UnsubscribeNotification(event->subscribe.conn_handle, event->subscribe.attr_handle);
         motionService.UnsubscribeNotification(event->subscribe.conn_handle, event->subscribe.attr_handle);
+        diagnosticsService.UnsubscribeNotification(event->subscribe.conn_handle, event->subscribe.attr_handle);
       }
       break;
 
@@ -402,6 +410,12 @@ void NimbleController::NotifyBatteryLevel(uint8_t level) {
   }
 }
 
+void NimbleController::NotifyBinaryLog() {
+  if (connectionHandle != BLE_HS_CONN_HANDLE_NONE) {
+    diagnosticsService.NotifyBinaryLog(connectionHandle);
+  }
+}
+
 void NimbleController::EnableRadio() {
   bleController.EnableRadio();
   bleController.Disconnect();
@@ -14,6 +14,7 @@
 #include "components/ble/CurrentTimeService.h"
 #include "components/ble/DeviceInformationService.h"
 #include "components/ble/DfuService.h"
+#include "components/ble/DiagnosticsService.h"
 #include "components/ble/FSService.h"
 #include "components/ble/HeartRateService.h"
 #include "components/ble/ImmediateAlertService.h"
@@ -27,6 +28,7 @@
 namespace Pinetime {
   namespace Drivers {
     class SpiNorFlash;
+    class TwiMaster;
   }
 
   namespace System {
@@ -37,6 +39,7 @@ namespace Pinetime {
     class Ble;
     class DateTime;
     class NotificationManager;
+    class TouchHandler;
 
     class NimbleController {
 
@@ -47,8 +50,11 @@ namespace Pinetime {
                        NotificationManager& notificationManager,
                        Battery& batteryController,
                        Pinetime::Drivers::SpiNorFlash& spiNorFlash,
+                       Pinetime::Drivers::TwiMaster& twiMaster,
+                       TouchHandler& touchHandler,
                        HeartRateController& heartRateController,
                        MotionController& motionController,
+                       StepHistory& stepHistory,
                        FS& fs);
       void Init();
       void StartAdvertising();
@@ -70,6 +76,7 @@ namespace Pinetime {
 
       uint16_t connHandle();
       void NotifyBatteryLevel(uint8_t level);
+      void NotifyBinaryLog();
 
       void RestartFastAdv() {
         fastAdvCount = 0;
@@ -103,6 +110,7 @@ namespace Pinetime {
       HeartRateService heartRateService;
       MotionService motionService;
       FSService fsService;
+      DiagnosticsService diagnosticsService;
       ServiceDiscovery serviceDiscovery;
 
       uint8_t addrType;
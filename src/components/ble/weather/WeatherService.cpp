@@ -19,8 +19,11 @@
 #include "WeatherService.h"
 #include "libs/QCBOR/inc/qcbor/qcbor.h"
 #include "systemtask/SystemTask.h"
+#include "profiling/Profiler.h"
+#include "memory/Heap.h"
 
 int WeatherCallback(uint16_t connHandle, uint16_t attrHandle, struct ble_gatt_access_ctxt* ctxt, void* arg) {
+  Pinetime::Profiling::Zone zone(Pinetime::Profiling::Zones::GattWeather);
   return static_cast<Pinetime::Controllers::WeatherService*>(arg)->OnCommand(connHandle, attrHandle, ctxt);
 }
 
@@ -39,9 +42,20 @@ namespace Pinetime {
 
       res = ble_gatts_add_svcs(serviceDefinition);
       ASSERT(res == 0);
+
+      Pinetime::Memory::Heap::AddLowMemoryHandler(OnLowMemory, this);
+    }
+
+    void WeatherService::OnLowMemory(void* context) {
+      static_cast<WeatherService*>(context)->memoryLow = true;
     }
 
     int WeatherService::OnCommand(uint16_t connHandle, uint16_t attrHandle, struct ble_gatt_access_ctxt* ctxt) {
+      if (memoryLow.exchange(false)) {
+        // Gives the expired events and the spare capacity of the timeline back to the heap
+        TidyTimeline();
+        timeline.shrink_to_fit();
+      }
       if (ctxt->op == BLE_GATT_ACCESS_OP_WRITE_CHR) {
         const uint8_t packetLen = OS_MBUF_PKTLEN(ctxt->om); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
         if (packetLen <= 0) {
@@ -506,7 +520,7 @@ namespace Pinetime {
     }
 
     bool WeatherService::AddEventToTimeline(std::unique_ptr<WeatherData::TimelineHeader> event) {
-      if (timeline.size() == timeline.max_size()) {
+      if (timeline.size() == timeline.max_size() || Pinetime::Memory::Heap::IsLow()) {
         return false;
       }
 
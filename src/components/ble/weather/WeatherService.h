@@ -21,6 +21,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <atomic>
 
 #define min // workaround: nimble's min/max macros conflict with libstdc++
 #define max
@@ -138,6 +139,13 @@ namespace Pinetime {
       std::unique_ptr<WeatherData::TimelineHeader> nullTimelineheader = std::make_unique<WeatherData::TimelineHeader>();
       std::unique_ptr<WeatherData::TimelineHeader>* nullHeader;
 
+      /**
+       * Set by the heap when the free memory gets low, the timeline is trimmed on the next command
+       */
+      std::atomic_bool memoryLow {false};
+
+      static void OnLowMemory(void* context);
+
       /**
        * Cleans up the timeline of expired events
        */
@@ -108,6 +108,15 @@ void DateTime::UpdateTime(uint32_t systickCounter) {
   }
 }
 
+uint32_t DateTime::SysticksToNextBoundary(uint32_t systickCounter, std::chrono::seconds period) const {
+  // The 24-bit counter may have wrapped since the last update
+  uint32_t sinceLastSecond = (systickCounter - previousSystickCounter) & 0xffffff;
+  auto seconds = std::chrono::duration_cast<std::chrono::seconds>(currentDateTime.time_since_epoch());
+  uint32_t periodSysticks = period.count() * 1024;
+  uint32_t intoPeriod = (seconds.count() % period.count()) * 1024 + sinceLastSecond;
+  return periodSysticks - (intoPeriod % periodSysticks);
+}
+
 const char* DateTime::MonthShortToString() const {
   return MonthsString[static_cast<uint8_t>(month)];
 }
@@ -39,6 +39,9 @@ namespace Pinetime {
                    uint8_t second,
                    uint32_t systickCounter);
       void UpdateTime(uint32_t systickCounter);
+      /// Number of systicks (1024Hz) from systickCounter to the next time the local time is a multiple of the period
+      /// (1s for the displayed seconds, 30min for the chimes...). Only valid right after UpdateTime(systickCounter).
+      uint32_t SysticksToNextBoundary(uint32_t systickCounter, std::chrono::seconds period) const;
       uint16_t Year() const {
         return year;
       }
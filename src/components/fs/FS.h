@@ -18,6 +18,7 @@ namespace Pinetime {
       int FileRead(lfs_file_t* file_p, uint8_t* buff, uint32_t size);
       int FileWrite(lfs_file_t* file_p, const uint8_t* buff, uint32_t size);
       int FileSeek(lfs_file_t* file_p, uint32_t pos);
+      lfs_soff_t FileSize(lfs_file_t* file_p);
 
       int FileDelete(const char* fileName);
 
@@ -1,17 +1,44 @@
 #include "components/heartrate/HeartRateController.h"
+#include <algorithm>
 #include <heartratetask/HeartRateTask.h>
 #include <systemtask/SystemTask.h>
 
 using namespace Pinetime::Controllers;
 
-void HeartRateController::Update(HeartRateController::States newState, uint8_t heartRate) {
+void HeartRateController::Update(HeartRateController::States newState, uint8_t heartRate, uint8_t confidence) {
   this->state = newState;
+  this->confidence = confidence;
   if (this->heartRate != heartRate) {
     this->heartRate = heartRate;
     service->OnNewHeartRateValue(heartRate);
   }
 }
 
+void HeartRateController::UpdateRrInterval(uint16_t rrInterval, uint16_t rmssd, uint16_t sdnn) {
+  this->rrInterval = rrInterval;
+  this->rmssd = rmssd;
+  this->sdnn = sdnn;
+
+  if (nbPendingRrIntervals == maxPendingRrIntervals) {
+    // Nobody collected them, keep the most recent ones
+    std::copy(pendingRrIntervals.begin() + 1, pendingRrIntervals.end(), pendingRrIntervals.begin());
+    nbPendingRrIntervals--;
+  }
+  pendingRrIntervals[nbPendingRrIntervals++] = rrInterval;
+
+  // A measurement is sent for each beat, as recommended by the Heart Rate Profile
+  if (state == States::Running) {
+    service->OnNewHeartRateValue(heartRate);
+  }
+}
+
+size_t HeartRateController::TakeRrIntervals(uint16_t* buffer, size_t size) {
+  auto count = std::min(size, nbPendingRrIntervals);
+  std::copy(pendingRrIntervals.begin(), pendingRrIntervals.begin() + count, buffer);
+  nbPendingRrIntervals = 0;
+  return count;
+}
+
 void HeartRateController::Start() {
   if (task != nullptr) {
     state = States::NotEnoughData;
@@ -22,6 +49,7 @@ void HeartRateController::Start() {
 void HeartRateController::Stop() {
   if (task != nullptr) {
     state = States::Stopped;
+    confidence = 0;
     task->PushMessage(Pinetime::Applications::HeartRateTask::Messages::StopMeasurement);
   }
 }
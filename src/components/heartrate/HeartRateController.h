@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <components/ble/HeartRateService.h>
 
@@ -15,10 +17,17 @@ namespace Pinetime {
     public:
       enum class States { Stopped, NotEnoughData, NoTouch, Running };
 
+      struct BackgroundMeasurement {
+        uint8_t heartRate = 0; // 0 if no valid value could be computed
+        uint8_t confidence = 0;
+        uint16_t duration = 0;  // Time the sensor was enabled, in ms
+        uint16_t ledCharge = 0; // Charge drawn by the LED, in uAh
+      };
+
       HeartRateController() = default;
       void Start();
       void Stop();
-      void Update(States newState, uint8_t heartRate);
+      void Update(States newState, uint8_t heartRate, uint8_t confidence);
 
       void SetHeartRateTask(Applications::HeartRateTask* task);
       States State() const {
@@ -27,6 +36,41 @@ namespace Pinetime {
       uint8_t HeartRate() const {
         return heartRate;
       }
+      /// Confidence (0-100) of the current heart rate value
+      uint8_t Confidence() const {
+        return confidence;
+      }
+      /// Average LED drive current of the current (or last) measurement, in 0.1mA
+      uint16_t AverageLedCurrent() const {
+        return averageLedCurrent;
+      }
+      void SetAverageLedCurrent(uint16_t current) {
+        averageLedCurrent = current;
+      }
+
+      /// Called by the heart rate task for each new beat-to-beat interval (all values in ms)
+      void UpdateRrInterval(uint16_t rrInterval, uint16_t rmssd, uint16_t sdnn);
+      /// Last RR interval, in ms
+      uint16_t RrInterval() const {
+        return rrInterval;
+      }
+      /// HRV over the last ~30s of beats, in ms
+      uint16_t Rmssd() const {
+        return rmssd;
+      }
+      uint16_t Sdnn() const {
+        return sdnn;
+      }
+      /// Moves the RR intervals not yet sent over BLE to buffer, returns their number
+      size_t TakeRrIntervals(uint16_t* buffer, size_t size);
+
+      /// Result and energy cost of the last background measurement
+      const BackgroundMeasurement& LastBackgroundMeasurement() const {
+        return lastBackgroundMeasurement;
+      }
+      void UpdateBackgroundMeasurement(const BackgroundMeasurement& measurement) {
+        lastBackgroundMeasurement = measurement;
+      }
 
       void SetService(Pinetime::Controllers::HeartRateService* service);
 
@@ -34,6 +78,16 @@ namespace Pinetime {
       Applications::HeartRateTask* task = nullptr;
       States state = States::Stopped;
       uint8_t heartRate = 0;
+      uint8_t confidence = 0;
+      uint16_t averageLedCurrent = 0;
+      uint16_t rrInterval = 0;
+      uint16_t rmssd = 0;
+      uint16_t sdnn = 0;
+      // RR intervals waiting for the next heart rate measurement notification
+      static constexpr size_t maxPendingRrIntervals = 4;
+      std::array<uint16_t, maxPendingRrIntervals> pendingRrIntervals;
+      size_t nbPendingRrIntervals = 0;
+      BackgroundMeasurement lastBackgroundMeasurement;
       Pinetime::Controllers::HeartRateService* service = nullptr;
     };
   }
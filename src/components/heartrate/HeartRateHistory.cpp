@@ -0,0 +1,61 @@
+#include "components/heartrate/HeartRateHistory.h"
+#include <algorithm>
+#include <FreeRTOS.h>
+#include <task.h>
+#include "components/datetime/DateTimeController.h"
+
+using namespace Pinetime::Controllers;
+
+HeartRateHistory::HeartRateHistory(FS& fs, DateTime& dateTimeController, Buffer& buffer)
+  : fs {fs}, dateTimeController {dateTimeController}, buffer {buffer} {
+}
+
+void HeartRateHistory::Append(uint8_t heartRate, uint8_t confidence) {
+  auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(dateTimeController.CurrentDateTime().time_since_epoch());
+  Entry entry {static_cast<uint32_t>(timestamp.count()), heartRate, confidence};
+
+  taskENTER_CRITICAL();
+  if (buffer.nbEntries >= bufferSize) {
+    if (isFlushing) {
+      // The entries are being written to the file and can't be moved
+      taskEXIT_CRITICAL();
+      return;
+    }
+    // The watch was not woken up for a long time : keep the most recent entries
+    std::copy(buffer.entries.begin() + 1, buffer.entries.end(), buffer.entries.begin());
+    buffer.nbEntries = bufferSize - 1;
+  }
+  buffer.entries[buffer.nbEntries++] = entry;
+  taskEXIT_CRITICAL();
+}
+
+void HeartRateHistory::Flush() {
+  // While isFlushing is set, Append() only writes after the entries counted here
+  taskENTER_CRITICAL();
+  buffer.nbEntries = std::min(buffer.nbEntries, bufferSize);
+  uint8_t nbEntries = buffer.nbEntries;
+  isFlushing = true;
+  taskEXIT_CRITICAL();
+  if (nbEntries == 0) {
+    isFlushing = false;
+    return;
+  }
+
+  bool isOpen = fs.FileOpen(&file, fileName, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND) == LFS_ERR_OK;
+  if (isOpen && fs.FileSize(&file) + (nbEntries * sizeof(Entry)) > maxFileSize) {
+    fs.FileClose(&file);
+    fs.Rename(fileName, oldFileName);
+    isOpen = fs.FileOpen(&file, fileName, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND) == LFS_ERR_OK;
+  }
+  if (isOpen) {
+    fs.FileWrite(&file, reinterpret_cast<const uint8_t*>(buffer.entries.data()), nbEntries * sizeof(Entry));
+    fs.FileClose(&file);
+  }
+
+  // The entries are dropped if the file can't be written
+  taskENTER_CRITICAL();
+  std::copy(buffer.entries.begin() + nbEntries, buffer.entries.begin() + buffer.nbEntries, buffer.entries.begin());
+  buffer.nbEntries -= nbEntries;
+  isFlushing = false;
+  taskEXIT_CRITICAL();
+}
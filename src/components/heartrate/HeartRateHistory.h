@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "components/fs/FS.h"
+
+namespace Pinetime {
+  namespace Controllers {
+    class DateTime;
+
+    /// Time series of the background heart rate measurements, stored in a littlefs file.
+    /// Entries are appended by the heart rate task to a RAM buffer, which the system task writes to the file
+    /// when the SPI NOR flash is powered (the watch is awake). The buffer holds a night of measurements, and
+    /// is kept in the noinit RAM so that the entries survive a reset.
+    class HeartRateHistory {
+    public:
+      struct __attribute__((packed)) Entry {
+        uint32_t timestamp; // Seconds since epoch
+        uint8_t heartRate;
+        uint8_t confidence;
+      };
+
+      static constexpr uint8_t bufferSize = 64; // ~10h of measurements every 10 minutes
+
+      /// Entries not written to the file yet. Trivial type, so that it can be stored in the noinit RAM (main.cpp).
+      struct Buffer {
+        std::array<Entry, bufferSize> entries;
+        uint8_t nbEntries;
+      };
+
+      HeartRateHistory(FS& fs, DateTime& dateTimeController, Buffer& buffer);
+      /// Can be called from any task, the oldest entry is dropped if the buffer is full
+      void Append(uint8_t heartRate, uint8_t confidence);
+      /// Writes the buffered entries to the file. Must be called by the system task, when the SPI NOR flash is awake.
+      void Flush();
+
+      uint8_t PendingEntries() const {
+        return buffer.nbEntries;
+      }
+
+      static constexpr const char* fileName = "/hrhist.dat";
+      // Previous history file, the current one is renamed when it reaches maxFileSize
+      static constexpr const char* oldFileName = "/hrhist.old";
+
+    private:
+      // ~30 days of measurements every 10 minutes
+      static constexpr uint32_t maxFileSize = 4320 * sizeof(Entry);
+
+      FS& fs;
+      DateTime& dateTimeController;
+      Buffer& buffer;
+      bool isFlushing = false;
+      // Not allocated on the stack of the system task
+      lfs_file_t file;
+    };
+  }
+}
@@ -0,0 +1,134 @@
+#include "components/heartrate/Hrv.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+using namespace Pinetime::Controllers;
+
+bool Hrv::Step(float sample, uint32_t timestamp) {
+  // The blood absorbs the light of the LED : the systolic peak is a minimum of the PPG signal
+  auto s2 = -sample;
+  bool newInterval = false;
+
+  if (nbSamples == 2 && s1 > s0 && s1 >= s2) {
+    // s1 is a local maximum, it is a beat if it reaches half of the envelope of the previous peaks
+    if (s1 > peakEnvelope / 2) {
+      // Parabolic interpolation of the position of the peak between the 3 samples
+      float offset = 0;
+      auto denominator = s0 - 2 * s1 + s2;
+      if (denominator != 0) {
+        offset = 0.5f * (s0 - s2) / denominator;
+        offset *= static_cast<float>(offset < 0 ? t1 - t0 : timestamp - t1);
+      }
+
+      bool isBeat = true;
+      if (hasLastPeak) {
+        auto interval = static_cast<float>(t1 - lastPeakTime) + offset - lastPeakOffset;
+        // Refractory period : the next beat can not occur before 5/8 of the last rhythm, a smaller peak
+        // in this period is the dicrotic notch or noise, and a higher one replaces the last peak.
+        auto refractory = std::max(static_cast<float>(minRrInterval), rrInterval * 5.0f / 8.0f);
+        if (interval < refractory) {
+          isBeat = s1 > lastPeakHeight;
+        } else if (interval > maxRrInterval) {
+          hasLastInterval = false;
+        } else {
+          newInterval = AddInterval(static_cast<uint16_t>(interval + 0.5f));
+        }
+      }
+      if (isBeat) {
+        hasLastPeak = true;
+        lastPeakTime = t1;
+        lastPeakOffset = offset;
+        lastPeakHeight = s1;
+      }
+    }
+    peakEnvelope = std::max(peakEnvelope, s1);
+  } else {
+    peakEnvelope -= peakEnvelope / 32;
+  }
+
+  s0 = s1;
+  t0 = t1;
+  s1 = s2;
+  t1 = timestamp;
+  if (nbSamples < 2) {
+    nbSamples++;
+  }
+  return newInterval;
+}
+
+bool Hrv::AddInterval(uint16_t interval) {
+  // An interval is only accepted if it is consistent with the previous one, so that a single artifact
+  // (missed or extra beat) is dropped without locking the detection on a wrong rhythm.
+  auto deviation = static_cast<uint16_t>(std::abs(static_cast<int32_t>(interval) - static_cast<int32_t>(lastCandidate)));
+  lastCandidate = interval;
+  if (deviation > interval / maxDeviation) {
+    // Break the chain of successive differences
+    hasLastInterval = false;
+    return false;
+  }
+
+  if (hasLastInterval) {
+    auto difference = static_cast<uint16_t>(std::abs(static_cast<int32_t>(interval) - static_cast<int32_t>(rrInterval)));
+    if (nbDifferences == windowSize) {
+      sumDifferenceSquares -= differences[differenceIndex] * differences[differenceIndex];
+    } else {
+      nbDifferences++;
+    }
+    differences[differenceIndex] = difference;
+    sumDifferenceSquares += difference * difference;
+    differenceIndex = (differenceIndex + 1) % windowSize;
+  }
+
+  if (nbIntervals == windowSize) {
+    sum -= intervals[intervalIndex];
+    sumSquares -= static_cast<uint32_t>(intervals[intervalIndex]) * intervals[intervalIndex];
+  } else {
+    nbIntervals++;
+  }
+  intervals[intervalIndex] = interval;
+  sum += interval;
+  sumSquares += static_cast<uint32_t>(interval) * interval;
+  intervalIndex = (intervalIndex + 1) % windowSize;
+
+  rrInterval = interval;
+  hasLastInterval = true;
+  return true;
+}
+
+uint16_t Hrv::Rmssd() const {
+  if (nbDifferences == 0)
+    return 0;
+  return static_cast<uint16_t>(std::sqrt(static_cast<float>(sumDifferenceSquares) / nbDifferences));
+}
+
+uint16_t Hrv::Sdnn() const {
+  if (nbIntervals < 2)
+    return 0;
+  // n².variance = n.sum(x²) - sum(x)², computed on integers to avoid the cancellation of the float version
+  auto n = static_cast<uint64_t>(nbIntervals);
+  auto variance = static_cast<float>(n * sumSquares - static_cast<uint64_t>(sum) * sum) / static_cast<float>(n * n);
+  return static_cast<uint16_t>(std::sqrt(variance));
+}
+
+void Hrv::Invalidate() {
+  hasLastPeak = false;
+  hasLastInterval = false;
+  // The last samples, the envelope and the last candidate interval may come from the artifacts : restart the
+  // detection from scratch. The last rhythm is kept for the refractory period.
+  nbSamples = 0;
+  peakEnvelope = 0;
+  lastCandidate = 0;
+}
+
+void Hrv::Reset() {
+  Invalidate();
+  rrInterval = 0;
+  intervalIndex = 0;
+  nbIntervals = 0;
+  differenceIndex = 0;
+  nbDifferences = 0;
+  sum = 0;
+  sumSquares = 0;
+  sumDifferenceSquares = 0;
+}
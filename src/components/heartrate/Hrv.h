@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Pinetime {
+  namespace Controllers {
+    /// Beat-to-beat analysis of the band-passed PPG signal (Ppg::Pulse()) : detects the systolic peaks (with
+    /// sub-sample interpolation), extracts the RR intervals and computes the RMSSD and SDNN HRV metrics over a
+    /// rolling window of intervals.
+    /// All the state is stored in the object, the processing only uses a few bytes of stack.
+    class Hrv {
+    public:
+      /// Feeds a sample from Ppg::Pulse() taken at timestamp (in ms).
+      /// Returns true if a new RR interval was accepted.
+      bool Step(float sample, uint32_t timestamp);
+      /// Breaks the chain of beats (motion, gap in the samples,...)
+      void Invalidate();
+      void Reset();
+
+      /// Last RR interval, in ms
+      uint16_t RrInterval() const {
+        return rrInterval;
+      }
+      /// Root mean square of the successive differences of the RR intervals of the window, in ms
+      uint16_t Rmssd() const;
+      /// Standard deviation of the RR intervals of the window, in ms
+      uint16_t Sdnn() const;
+      size_t NbIntervals() const {
+        return nbIntervals;
+      }
+
+    private:
+      static constexpr size_t windowSize = 32; // ~30s
+      static constexpr uint16_t minRrInterval = 300;  // 200 bpm
+      static constexpr uint16_t maxRrInterval = 2000; // 30 bpm
+      // Intervals that differ by more than 1/maxDeviation from the previous one are considered as artifacts
+      static constexpr uint16_t maxDeviation = 4;
+
+      bool AddInterval(uint16_t interval);
+
+      float s0 = 0;
+      float s1 = 0;
+      uint32_t t0 = 0;
+      uint32_t t1 = 0;
+      uint8_t nbSamples = 0;
+      // Envelope of the peaks, used as adaptive detection threshold
+      float peakEnvelope = 0;
+
+      bool hasLastPeak = false;
+      // Position of the last peak : timestamp of the nearest sample + interpolated offset (ms), and its height
+      uint32_t lastPeakTime = 0;
+      float lastPeakOffset = 0;
+      float lastPeakHeight = 0;
+      bool hasLastInterval = false;
+      uint16_t rrInterval = 0;
+      uint16_t lastCandidate = 0;
+
+      std::array<uint16_t, windowSize> intervals;
+      std::array<uint16_t, windowSize> differences;
+      size_t intervalIndex = 0;
+      size_t nbIntervals = 0;
+      size_t differenceIndex = 0;
+      size_t nbDifferences = 0;
+      uint32_t sum = 0;
+      uint64_t sumSquares = 0;
+      uint32_t sumDifferenceSquares = 0;
+    };
+  }
+}
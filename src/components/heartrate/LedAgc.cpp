@@ -0,0 +1,75 @@
+#include "components/heartrate/LedAgc.h"
+
+using namespace Pinetime::Controllers;
+
+constexpr std::array<uint16_t, 4> LedAgc::currents;
+constexpr std::array<uint8_t, 5> LedAgc::gains;
+
+bool LedAgc::Update(const Ppg::RawStatistics& statistics) {
+  samplesSinceChange += statistics.count;
+  if (statistics.count == 0 || samplesSinceChange < minSamplesBetweenChanges)
+    return false;
+
+  if (statistics.peak > clipLevel || statistics.mean > highTarget) {
+    if (driveIndex == 0 && gainIndex == 0)
+      return false;
+    Decrease();
+  } else if (statistics.mean < lowTarget) {
+    if (!TryIncrease(statistics.mean))
+      return false;
+  } else {
+    return false;
+  }
+
+  samplesSinceChange = 0;
+  return true;
+}
+
+void LedAgc::Decrease() {
+  // Saving LED current first
+  if (driveIndex > 0)
+    driveIndex--;
+  else
+    gainIndex--;
+}
+
+bool LedAgc::TryIncrease(float mean) {
+  // The change is only applied if the signal is not expected to overshoot the target band,
+  // otherwise the controller would oscillate between 2 settings.
+  auto fits = [this, mean](uint8_t drive, uint8_t gain) {
+    return (mean * Exposure(drive, gain) / Exposure(driveIndex, gainIndex)) < highTarget;
+  };
+
+  if (gainIndex < maxPreferredGainIndex && fits(driveIndex, gainIndex + 1)) {
+    gainIndex++;
+    return true;
+  }
+  if (driveIndex < currents.size() - 1 && fits(driveIndex + 1, gainIndex)) {
+    driveIndex++;
+    return true;
+  }
+  if (gainIndex < gains.size() - 1 && driveIndex == currents.size() - 1 && fits(driveIndex, gainIndex + 1)) {
+    gainIndex++;
+    return true;
+  }
+  return false;
+}
+
+void LedAgc::Step() {
+  currentSum += currents[driveIndex];
+  nbSamples++;
+}
+
+void LedAgc::Reset() {
+  driveIndex = defaultDriveIndex;
+  gainIndex = defaultGainIndex;
+  samplesSinceChange = 0;
+  currentSum = 0;
+  nbSamples = 0;
+}
+
+uint16_t LedAgc::AverageCurrent() const {
+  if (nbSamples == 0)
+    return 0;
+  return currentSum / nbSamples;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "components/heartrate/Ppg.h"
+
+namespace Pinetime {
+  namespace Controllers {
+    /// Closed-loop control of the LED drive current and of the photodiode gain of the HRS3300.
+    /// It keeps the raw (DC) level of the PPG signal in a target band, reducing the LED current first
+    /// when the signal is too strong and raising the (free) gain first when it is too weak.
+    class LedAgc {
+    public:
+      LedAgc() = default;
+      /// Returns true if the drive or the gain have been changed and must be applied to the sensor
+      bool Update(const Ppg::RawStatistics& statistics);
+      /// Call on every sample to account the LED current
+      void Step();
+      void Reset();
+
+      /// Drive setting as expected by Hrs3300::SetDrive()
+      uint8_t Drive() const {
+        return driveIndex;
+      }
+      /// Gain as expected by Hrs3300::SetGain()
+      uint8_t Gain() const {
+        return gains[gainIndex];
+      }
+      /// Average LED drive current since the last Reset(), in 0.1mA
+      uint16_t AverageCurrent() const;
+
+    private:
+      static constexpr std::array<uint16_t, 4> currents {125, 200, 300, 400}; // 0.1mA
+      static constexpr std::array<uint8_t, 5> gains {1, 2, 4, 8, 64};
+      static constexpr uint8_t defaultDriveIndex = 1; // 20mA
+      static constexpr uint8_t defaultGainIndex = 3;  // 8x
+      // 64x is very noisy, it's only used when 40mA @ 8x is still not enough
+      static constexpr uint8_t maxPreferredGainIndex = 3;
+
+      // Target band of the raw (16 bits) HRS value
+      static constexpr float lowTarget = 8000.0f;
+      static constexpr float highTarget = 45000.0f;
+      static constexpr float clipLevel = 60000.0f;
+      // At most 1 change every 2s (the HRS is sampled @ 25Hz)
+      static constexpr uint32_t minSamplesBetweenChanges = 50;
+
+      bool TryIncrease(float mean);
+      void Decrease();
+      float Exposure(uint8_t drive, uint8_t gain) const {
+        return static_cast<float>(currents[drive]) * gains[gain];
+      }
+
+      uint8_t driveIndex = defaultDriveIndex;
+      uint8_t gainIndex = defaultGainIndex;
+      uint32_t samplesSinceChange = 0;
+      uint32_t currentSum = 0;
+      uint32_t nbSamples = 0;
+    };
+  }
+}
@@ -5,8 +5,9 @@
 */
 
 #include "components/heartrate/Ppg.h"
-#include <vector>
-#include <nrf_log.h>
+#include <algorithm>
+#include <cstdlib>
+#include "profiling/Profiler.h"
 using namespace Pinetime::Controllers;
 
 /** Original implementation from wasp-os : https://github.com/daniel-thompson/wasp-os/blob/master/wasp/ppg.py */
@@ -36,34 +37,83 @@ namespace {
     }
     return -1;
   }
+
+  /** Normalized autocorrelation of the signal at the given lag, in percent (0 = no periodicity, 100 = perfect) */
+  uint8_t Periodicity(int8_t* d, int shift, size_t count) {
+    int e1 = 0;
+    int e2 = 0;
+    for (size_t i = 0; i < count - shift; i++) {
+      e1 += d[i] * d[i];
+      e2 += d[i + shift] * d[i + shift];
+    }
+    if (e1 + e2 == 0)
+      return 0;
+    auto error = CompareShift(d, shift, count);
+    auto correlation = 100 - (100 * error) / (e1 + e2);
+    return static_cast<uint8_t>(std::max(0, std::min(100, correlation)));
+  }
 }
 
 Ppg::Ppg()
   : hpf {0.87033078, -1.74066156, 0.87033078, -1.72377617, 0.75754694},
     agc {20, 0.971, 2},
-    lpf {0.11595249, 0.23190498, 0.11595249, -0.72168143, 0.18549138} {
+    lpf {0.11595249, 0.23190498, 0.11595249, -0.72168143, 0.18549138},
+    pulseLpf {0.11595249, 0.23190498, 0.11595249, -0.72168143, 0.18549138} {
+}
+
+void Ppg::SetMotion(int16_t x, int16_t y, int16_t z) {
+  if (!motionInitialized) {
+    lastX = x;
+    lastY = y;
+    lastZ = z;
+    motionInitialized = true;
+  }
+  int32_t delta = std::abs(x - lastX) + std::abs(y - lastY) + std::abs(z - lastZ);
+  lastX = x;
+  lastY = y;
+  lastZ = z;
+
+  // The accelerometer is polled slower than the PPG is sampled: hold the peak activity
+  // and let it decay so that the samples between 2 accelerometer updates are flagged too.
+  activity = std::max(delta, (activity * 7) / 8);
 }
 
-int8_t Ppg::Preprocess(float spl) {
-  spl -= offset;
+int8_t Ppg::Preprocess(float hrs, float als) {
+  statistics.peak = std::max(statistics.peak, hrs);
+  statistics.mean += (hrs - statistics.mean) / ++statistics.count;
+
+  // The ALS channel is sampled with the LED off: its variations are caused by ambient light only
+  // and are removed from the HRS channel, which sees both the LED and the ambient light.
+  auto spl = hrs - offset - (als - alsOffset);
   spl = hpf.Step(spl);
+  pulse = pulseLpf.Step(spl);
   spl = agc.Step(spl);
   spl = lpf.Step(spl);
 
   auto spl_int = static_cast<int8_t>(spl);
 
-  if (dataIndex < 200)
+  if (dataIndex < dataLength) {
     data[dataIndex++] = spl_int;
+    if (activity > motionThreshold)
+      movingSamples++;
+  }
   return spl_int;
 }
 
 float Ppg::HeartRate() {
-  if (dataIndex < 200)
+  Pinetime::Profiling::Zone zone(Pinetime::Profiling::Zones::HeartRate);
+  // The confidence is the one of the returned value : it is 0 whenever no heart rate is returned
+  confidence = 0;
+  if (dataIndex < dataLength)
     return 0;
 
-  NRF_LOG_INFO("PREPROCESS, offset = %d", offset);
-  auto hr = ProcessHeartRate();
+  float hr = 0;
+  // If most of the window was recorded while the wrist was moving, the signal is
+  // probably locked on the cadence rather than the pulse.
+  if (movingSamples <= maxMovingSamples)
+    hr = ProcessHeartRate();
   dataIndex = 0;
+  movingSamples = 0;
   return hr;
 }
 float Ppg::ProcessHeartRate() {
@@ -76,6 +126,15 @@ float Ppg::ProcessHeartRate() {
   if (t1 < 0)
     return 0;
 
+  // The dicrotic wave can create a shallow trough at about half the period : if the trough at twice the lag is much
+  // deeper, it is the one of the period.
+  if (t1 <= 48 && CompareShift(data.data(), t0, dataIndex) > 2 * CompareShift(data.data(), static_cast<int>(t1), dataIndex)) {
+    t0 = static_cast<int>(t1);
+    t1 = Trough(data.data(), dataIndex, t0 * 2 - 5, t0 * 2 + 5);
+    if (t1 < 0)
+      return 0;
+  }
+
   float t2 = static_cast<int>(t1 * 3) / 2;
   t2 = Trough(data.data(), dataIndex, t2 - 5, t2 + 5);
   if (t2 < 0)
@@ -83,17 +142,32 @@ float Ppg::ProcessHeartRate() {
 
   float t3 = static_cast<int>(t2 * 4) / 3;
   t3 = Trough(data.data(), dataIndex, t3 - 4, t3 + 4);
+  auto lag = (t3 < 0) ? t2 : t3;
+
+  // Weight the periodicity of the signal by the part of the window that was not corrupted by motion
+  auto quality = Periodicity(data.data(), static_cast<int>(lag), dataIndex);
+  confidence = (quality * (dataLength - movingSamples)) / dataLength;
+
   if (t3 < 0)
-    return static_cast<int>(60 * 24 * 3) / static_cast<int>(t2);
+    return static_cast<int>(60 * sampleRate * 3) / static_cast<int>(t2);
 
-  return static_cast<int>(60 * 24 * 4) / static_cast<int>(t3);
+  return static_cast<int>(60 * sampleRate * 4) / static_cast<int>(t3);
 }
 
-void Ppg::SetOffset(uint16_t offset) {
-  this->offset = offset;
-  dataIndex = 0;
+void Ppg::ResetStatistics() {
+  statistics = {};
+}
+
+void Ppg::SetOffset(float hrsOffset, float alsOffset) {
+  this->offset = hrsOffset;
+  this->alsOffset = alsOffset;
+  Reset();
 }
 
 void Ppg::Reset() {
   dataIndex = 0;
+  confidence = 0;
+  movingSamples = 0;
+  motionInitialized = false;
+  activity = 0;
 }
@@ -10,20 +10,68 @@ namespace Pinetime {
   namespace Controllers {
     class Ppg {
     public:
+      /// Statistics of the raw HRS samples (before any filtering)
+      struct RawStatistics {
+        float mean = 0.0f;
+        float peak = 0.0f;
+        uint16_t count = 0;
+      };
+
       Ppg();
-      int8_t Preprocess(float spl);
+      int8_t Preprocess(float hrs, float als);
+      /// Band-passed signal of the last sample, before the AGC : the AGC clips the systolic peaks, so the beat
+      /// detection (Hrv) needs this signal to locate them.
+      float Pulse() const {
+        return pulse;
+      }
+      /// Feeds the latest accelerometer sample. Call once per PPG sample, before Preprocess().
+      void SetMotion(int16_t x, int16_t y, int16_t z);
       float HeartRate();
+      /// Confidence (0-100) of the last value returned by HeartRate(), 0 if it returned 0
+      uint8_t Confidence() const {
+        return confidence;
+      }
+
+      const RawStatistics& Statistics() const {
+        return statistics;
+      }
+      void ResetStatistics();
+      /// True if the last sample is corrupted by wrist movement
+      bool IsMoving() const {
+        return activity > motionThreshold;
+      }
 
-      void SetOffset(uint16_t i);
+      void SetOffset(float hrsOffset, float alsOffset);
       void Reset();
 
     private:
-      std::array<int8_t, 200> data;
+      static constexpr size_t dataLength = 200;
+      // HeartRateTask reads a sample every 40 ticks of the 1024Hz RTC (the original implementation assumed 24Hz)
+      static constexpr float sampleRate = 1024.0f / 40.0f;
+      // Accelerometer activity (sum of the absolute per-axis deltas) above which a sample is considered
+      // corrupted by wrist movement. ~0.1g on the +/-2g range.
+      static constexpr int32_t motionThreshold = 100;
+      // Windows in which more than this number of samples are corrupted by motion are discarded.
+      static constexpr size_t maxMovingSamples = dataLength / 2;
+
+      std::array<int8_t, dataLength> data;
       size_t dataIndex = 0;
       float offset;
+      float alsOffset = 0.0f;
       Biquad hpf;
       Ptagc agc;
       Biquad lpf;
+      Biquad pulseLpf;
+      float pulse = 0.0f;
+
+      int16_t lastX = 0;
+      int16_t lastY = 0;
+      int16_t lastZ = 0;
+      int32_t activity = 0;
+      bool motionInitialized = false;
+      size_t movingSamples = 0;
+      uint8_t confidence = 0;
+      RawStatistics statistics;
 
       float ProcessHeartRate();
     };
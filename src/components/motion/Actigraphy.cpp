@@ -0,0 +1,99 @@
+#include "components/motion/Actigraphy.h"
+#include <cstdlib>
+
+using namespace Pinetime::Controllers;
+
+constexpr uint32_t Actigraphy::samplePeriodMs;
+constexpr std::array<uint16_t, 7> Actigraphy::weights;
+
+void Actigraphy::Reset() {
+  counts.fill(0);
+  nbEpochs = 0;
+  nbClassified = 0;
+  activity = 0;
+  lastCount = 0;
+  hasLastSample = false;
+  summary = {};
+  sleepRun = 0;
+  wakeRun = 0;
+}
+
+void Actigraphy::AddSample(int16_t x, int16_t y, int16_t z) {
+  if (hasLastSample) {
+    uint32_t variation = std::abs(x - lastX) + std::abs(y - lastY) + std::abs(z - lastZ);
+    if (variation > noiseThreshold) {
+      activity += variation - noiseThreshold;
+    }
+  }
+  lastX = x;
+  lastY = y;
+  lastZ = z;
+  hasLastSample = true;
+}
+
+Actigraphy::States Actigraphy::EndEpoch() {
+  uint32_t count = activity / activityPerCount;
+  lastCount = static_cast<uint16_t>(count > UINT16_MAX ? UINT16_MAX : count);
+  counts[nbEpochs % counts.size()] = lastCount;
+  nbEpochs++;
+  activity = 0;
+
+  // The epoch followed by 2 epochs can be classified
+  if (nbEpochs < nbClassified + 3) {
+    return States::Unknown;
+  }
+  auto state = Classify();
+  AddState(state);
+  return state;
+}
+
+void Actigraphy::Finish() {
+  while (nbClassified < nbEpochs) {
+    AddState(Classify());
+  }
+}
+
+/// Cole-Kripke score of the epoch nbClassified, the epochs not ended yet having no activity
+Actigraphy::States Actigraphy::Classify() {
+  uint32_t score = 0;
+  for (size_t i = 0; i < weights.size(); i++) {
+    // Epoch nbClassified - 4 + i
+    if (nbClassified + i < 4 || nbClassified + i - 4 >= nbEpochs) {
+      continue;
+    }
+    score += weights[i] * counts[(nbClassified + i - 4) % counts.size()];
+  }
+  return (score < threshold) ? States::Sleep : States::Wake;
+}
+
+void Actigraphy::AddState(States state) {
+  uint32_t epoch = nbClassified++;
+  summary.nbEpochs = nbClassified;
+
+  if (state == States::Wake) {
+    sleepRun = 0;
+    wakeRun++;
+    return;
+  }
+
+  if (!summary.hasSlept) {
+    sleepRun++;
+    if (sleepRun >= minSleepRun) {
+      summary.hasSlept = true;
+      summary.sleepOnset = epoch + 1 - sleepRun;
+      summary.totalSleep = sleepRun;
+    }
+  } else {
+    // The wake epochs only count as an awakening if the sleep resumes
+    if (wakeRun >= minAwakening) {
+      summary.awakenings++;
+    }
+    summary.totalSleep++;
+  }
+  wakeRun = 0;
+
+  if (summary.hasSlept) {
+    summary.wakeUp = epoch + 1;
+    summary.wakeAfterSleepOnset = summary.wakeUp - summary.sleepOnset - summary.totalSleep;
+  }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace Pinetime {
+  namespace Controllers {
+    /// Sleep/wake classification of the wrist activity (actigraphy) by epochs of 1 minute.
+    /// The activity count of an epoch is the sum of the variations of the acceleration between consecutive samples,
+    /// above the noise of the sensor. Each epoch is classified with the Cole-Kripke algorithm, which needs the counts
+    /// of the 4 previous and the 2 next epochs : the classification is delayed by 2 epochs.
+    /// This class does not depend on the sensor nor on the OS so that it can be replayed on recordings.
+    class Actigraphy {
+    public:
+      enum class States : uint8_t { Unknown, Sleep, Wake };
+
+      /// Statistics of the epochs classified since Reset(), the times being indexes of epochs
+      struct Summary {
+        uint32_t nbEpochs = 0;
+        bool hasSlept = false;
+        // Start of the first sleep period, and epoch following the last sleep epoch
+        uint32_t sleepOnset = 0;
+        uint32_t wakeUp = 0;
+        uint16_t totalSleep = 0;
+        uint16_t wakeAfterSleepOnset = 0;
+        uint8_t awakenings = 0;
+      };
+
+      /// Rate of the samples (3.125Hz) : enough to detect the movements of the arm
+      static constexpr uint32_t samplePeriodMs = 320;
+
+      void Reset();
+      void AddSample(int16_t x, int16_t y, int16_t z);
+      /// Ends the current epoch. Returns the state of the epoch that has been classified (2 epochs earlier),
+      /// Unknown if none was.
+      States EndEpoch();
+      /// Classifies the last 2 epochs, as if the next ones had no activity
+      void Finish();
+
+      const Summary& GetSummary() const {
+        return summary;
+      }
+      /// Activity count of the last epoch ended
+      uint16_t LastCount() const {
+        return lastCount;
+      }
+
+    private:
+      // Sum of |dx| + |dy| + |dz| (1g = 1024) below which a variation is considered as noise
+      static constexpr uint16_t noiseThreshold = 24;
+      // Activity per count, so that the counts are in the range expected by the Cole-Kripke weights and an isolated
+      // twitch of the wrist is not scored as wake (see tools/actigraphy-replay)
+      static constexpr uint32_t activityPerCount = 200;
+      // Cole-Kripke weights for 1 minute epochs (A-4 ... A+2), an epoch is sleep if the sum is below threshold
+      static constexpr std::array<uint16_t, 7> weights {{106, 54, 58, 76, 230, 74, 67}};
+      static constexpr uint32_t threshold = 1000;
+      // A sleep period starts with at least minSleepRun sleep epochs
+      static constexpr uint16_t minSleepRun = 10;
+      // An awakening lasts at least minAwakening epochs
+      static constexpr uint16_t minAwakening = 3;
+
+      States Classify();
+      void AddState(States state);
+
+      // Counts of the last epochs, the most recent one at (nbEpochs - 1) % size
+      std::array<uint16_t, 7> counts {};
+      uint32_t nbEpochs = 0;
+      uint32_t nbClassified = 0;
+      uint32_t activity = 0;
+      uint16_t lastCount = 0;
+      bool hasLastSample = false;
+      int16_t lastX = 0;
+      int16_t lastY = 0;
+      int16_t lastZ = 0;
+
+      Summary summary;
+      uint16_t sleepRun = 0;
+      uint16_t wakeRun = 0;
+    };
+  }
+}
@@ -2,10 +2,8 @@
 #include "os/os_cputime.h"
 using namespace Pinetime::Controllers;
 
-void MotionController::Update(int16_t x, int16_t y, int16_t z, uint32_t nbSteps) {
-  if (this->nbSteps != nbSteps && service != nullptr) {
-    service->OnNewStepCountValue(nbSteps);
-  }
+void MotionController::Update(int16_t x, int16_t y, int16_t z, uint32_t nbSteps, TickType_t timestamp) {
+  UpdateSteps(nbSteps);
 
   if (service != nullptr && (this->x != x || this->y != y || this->z != z)) {
     service->OnNewMotionValues(x, y, z);
@@ -14,13 +12,38 @@ void MotionController::Update(int16_t x, int16_t y, int16_t z, uint32_t nbSteps)
   this->x = x;
   this->y = y;
   this->z = z;
+  this->timestamp = timestamp;
+}
+
+void MotionController::UpdateSteps(uint32_t nbSteps) {
+  if (this->nbSteps != nbSteps && service != nullptr) {
+    service->OnNewStepCountValue(nbSteps);
+  }
+
   int32_t deltaSteps = nbSteps - this->nbSteps;
   this->nbSteps = nbSteps;
   if (deltaSteps > 0) {
     currentTripSteps += deltaSteps;
+    hourSteps += deltaSteps;
   }
 }
 
+void MotionController::StreamSamples(const Pinetime::Drivers::Bma421Fifo::Sample* samples,
+                                     size_t nbSamples,
+                                     TickType_t timestamp,
+                                     uint32_t nbDropped) {
+  if (service != nullptr) {
+    auto timestampMs = static_cast<uint32_t>(static_cast<uint64_t>(timestamp) * 1000 / configTICK_RATE_HZ);
+    service->OnNewMotionSamples(samples, nbSamples, timestampMs, nbDropped);
+  }
+}
+
+uint32_t MotionController::TakeHourSteps() {
+  uint32_t steps = hourSteps;
+  hourSteps = 0;
+  return steps;
+}
+
 bool MotionController::Should_RaiseWake(bool isSleeping) {
   if ((x + 335) <= 670 && z < 0) {
     if (not isSleeping) {
@@ -46,9 +69,12 @@ bool MotionController::Should_RaiseWake(bool isSleeping) {
 
 bool MotionController::Should_ShakeWake(uint16_t thresh) {
   bool wake = false;
-  auto diff = xTaskGetTickCount() - lastShakeTime;
-  lastShakeTime = xTaskGetTickCount();
-  /* Currently Polling at 10hz, If this ever goes faster scalar and EMA might need adjusting */
+  auto diff = timestamp - lastShakeTime;
+  if (diff == 0) {
+    return false;
+  }
+  lastShakeTime = timestamp;
+  /* Sampled at 10-12.5hz, If this ever goes faster scalar and EMA might need adjusting */
   int32_t speed = std::abs(z + (y / 2) + (x / 4) - lastYForShake - lastZForShake) / diff * 100;
   //(.2 * speed) + ((1 - .2) * accumulatedspeed);
   // implemented without floats as .25Alpha
@@ -66,6 +92,10 @@ int32_t MotionController::currentShakeSpeed() {
   return accumulatedspeed;
 }
 
+bool MotionController::IsStepCountNeeded() const {
+  return (stepCountSubscribers > 0 && !areScreenSubscriptionsSuspended) || (service != nullptr && service->IsStepCountNotificationEnabled());
+}
+
 void MotionController::IsSensorOk(bool isOk) {
   isSensorOk = isOk;
 }
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <FreeRTOS.h>
 #include <drivers/Bma421.h>
 #include <components/ble/MotionService.h>
 
@@ -14,7 +16,9 @@ namespace Pinetime {
         BMA425,
       };
 
-      void Update(int16_t x, int16_t y, int16_t z, uint32_t nbSteps);
+      /// timestamp : time (in ticks) at which the sample was acquired, the samples of a FIFO batch being processed at once
+      void Update(int16_t x, int16_t y, int16_t z, uint32_t nbSteps, TickType_t timestamp);
+      void UpdateSteps(uint32_t nbSteps);
 
       int16_t X() const {
         return x;
@@ -29,6 +33,62 @@ namespace Pinetime {
         return nbSteps;
       }
 
+      /// Screens and BLE clients that display the step count subscribe to it, so that it is read from the sensor
+      /// on each update instead of once a minute
+      void SubscribeStepCount() {
+        stepCountSubscribers++;
+      }
+      void UnsubscribeStepCount() {
+        stepCountSubscribers--;
+      }
+      /// The screens keep their subscriptions while the display sleeps : the system task suspends them until it wakes up
+      void SuspendScreenSubscriptions() {
+        areScreenSubscriptionsSuspended = true;
+      }
+      void ResumeScreenSubscriptions() {
+        areScreenSubscriptionsSuspended = false;
+      }
+      bool IsStepCountNeeded() const;
+
+      /// Screens that display the raw motion values keep the sensor in its performance mode while they are opened
+      void RequestPerformanceMode() {
+        performanceModeRequests++;
+      }
+      void ReleasePerformanceMode() {
+        performanceModeRequests--;
+      }
+      bool IsPerformanceModeRequested() const {
+        return performanceModeRequests > 0;
+      }
+      /// Power mode of the sensor, set by the system task
+      Pinetime::Drivers::Bma421::PowerModes PowerMode() const {
+        return powerMode;
+      }
+      void SetPowerMode(Pinetime::Drivers::Bma421::PowerModes mode) {
+        powerMode = mode;
+      }
+
+      /// Streaming of the raw samples over BLE, see MotionService
+      bool IsStreaming() const {
+        return service != nullptr && service->IsStreaming();
+      }
+      uint8_t StreamingDownsampling() const {
+        return service->StreamingDownsampling();
+      }
+      uint8_t StreamingWatermark() const {
+        return service->StreamingWatermark();
+      }
+      /// timestamp : time (in ticks) of the first sample
+      void StreamSamples(const Pinetime::Drivers::Bma421Fifo::Sample* samples, size_t nbSamples, TickType_t timestamp, uint32_t nbDropped);
+
+      /// Time spent on the bus by the last sensor update, in us
+      uint32_t BusTime() const {
+        return busTime;
+      }
+      void SetBusTime(uint32_t time) {
+        busTime = time;
+      }
+
       void ResetTrip() {
         currentTripSteps = 0;
       }
@@ -36,6 +96,9 @@ namespace Pinetime {
         return currentTripSteps;
       }
 
+      /// Steps counted since the previous call, for the step history
+      uint32_t TakeHourSteps();
+
       bool Should_ShakeWake(uint16_t thresh);
       bool Should_RaiseWake(bool isSleeping);
       int32_t currentShakeSpeed();
@@ -54,11 +117,18 @@ namespace Pinetime {
     private:
       uint32_t nbSteps;
       uint32_t currentTripSteps = 0;
+      uint32_t hourSteps = 0;
       int16_t x;
       int16_t y;
       int16_t z;
+      TickType_t timestamp = 0;
       int16_t lastYForWakeUp = 0;
       bool isSensorOk = false;
+      std::atomic<uint8_t> stepCountSubscribers {0};
+      std::atomic<bool> areScreenSubscriptionsSuspended {false};
+      std::atomic<uint8_t> performanceModeRequests {0};
+      Pinetime::Drivers::Bma421::PowerModes powerMode = Pinetime::Drivers::Bma421::PowerModes::Normal;
+      uint32_t busTime = 0;
       DeviceTypes deviceType = DeviceTypes::Unknown;
       Pinetime::Controllers::MotionService* service = nullptr;
 
@@ -66,7 +136,7 @@ namespace Pinetime {
       int16_t lastYForShake = 0;
       int16_t lastZForShake = 0;
       int32_t accumulatedspeed = 0;
-      uint32_t lastShakeTime = 0;
+      TickType_t lastShakeTime = 0;
     };
   }
 }
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "components/motion/SleepTracker.h"
+#include "components/datetime/DateTimeController.h"
+#include <libraries/log/nrf_log.h>
+
+using namespace Pinetime::Controllers;
+
+constexpr uint8_t SleepTracker::fifoDownsampling;
+
+SleepTracker::SleepTracker(FS& fs, DateTime& dateTimeController) : fs {fs}, dateTimeController {dateTimeController} {
+}
+
+bool SleepTracker::Update() {
+  auto hour = dateTimeController.Hours();
+  bool isNight = hour >= startHour || hour < endHour;
+  if (isNight == isTracking) {
+    return false;
+  }
+
+  if (isNight) {
+    actigraphy.Reset();
+    hasEpochStart = false;
+    decimationCounter = 0;
+    isTracking = true;
+  } else {
+    Stop();
+  }
+  return true;
+}
+
+void SleepTracker::AddSamples(const Drivers::Bma421Fifo::Sample* samples,
+                              size_t nbSamples,
+                              uint8_t downsampling,
+                              TickType_t timestamp) {
+  if (!isTracking) {
+    return;
+  }
+
+  // The samples read at a higher rate (wake-up detectors, streaming) are decimated
+  uint32_t decimation = (downsampling < fifoDownsampling) ? 1U << (fifoDownsampling - downsampling) : 1U;
+  TickType_t samplePeriod = pdMS_TO_TICKS(10 << downsampling);
+  for (size_t i = 0; i < nbSamples; i++) {
+    if ((decimationCounter++ % decimation) != 0) {
+      continue;
+    }
+    auto sampleTimestamp = timestamp - ((nbSamples - 1 - i) * samplePeriod);
+    if (!hasEpochStart) {
+      epochStart = sampleTimestamp;
+      hasEpochStart = true;
+      auto now = std::chrono::duration_cast<std::chrono::seconds>(dateTimeController.CurrentDateTime().time_since_epoch());
+      startTime = static_cast<uint32_t>(now.count());
+    }
+    while (static_cast<int32_t>(sampleTimestamp - epochStart) >= static_cast<int32_t>(epochDuration)) {
+      actigraphy.EndEpoch();
+      epochStart += epochDuration;
+    }
+    const auto& sample = samples[i];
+    actigraphy.AddSample(sample.x, sample.y, sample.z);
+  }
+}
+
+void SleepTracker::Stop() {
+  isTracking = false;
+  actigraphy.Finish();
+  const auto& summary = actigraphy.GetSummary();
+  if (summary.nbEpochs < minTrackedMinutes) {
+    return;
+  }
+
+  Night night {};
+  night.start = startTime;
+  night.trackedMinutes = static_cast<uint16_t>(summary.nbEpochs);
+  if (summary.hasSlept) {
+    night.sleepOnset = startTime + summary.sleepOnset * 60;
+    night.wakeUp = startTime + summary.wakeUp * 60;
+    night.totalSleep = summary.totalSleep;
+    night.wakeAfterSleepOnset = summary.wakeAfterSleepOnset;
+    night.awakenings = summary.awakenings;
+    night.efficiency = static_cast<uint8_t>((summary.totalSleep * 100) / (summary.wakeUp - summary.sleepOnset));
+  }
+  NRF_LOG_INFO("[SleepTracker] %d min tracked, %d min of sleep", night.trackedMinutes, night.totalSleep);
+  pendingNight = night;
+  hasPendingNight = true;
+}
+
+void SleepTracker::Flush() {
+  if (!hasPendingNight) {
+    return;
+  }
+  hasPendingNight = false;
+
+  if (fs.FileOpen(&file, fileName, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND) != LFS_ERR_OK) {
+    return;
+  }
+
+  if (fs.FileSize(&file) + sizeof(Night) > maxFileSize) {
+    fs.FileClose(&file);
+    fs.Rename(fileName, oldFileName);
+    if (fs.FileOpen(&file, fileName, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND) != LFS_ERR_OK) {
+      return;
+    }
+  }
+
+  fs.FileWrite(&file, reinterpret_cast<const uint8_t*>(&pendingNight), sizeof(Night));
+  fs.FileClose(&file);
+}
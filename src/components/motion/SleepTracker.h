@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <FreeRTOS.h>
+#include "components/fs/FS.h"
+#include "components/motion/Actigraphy.h"
+#include "drivers/Bma421Fifo.h"
+
+namespace Pinetime {
+  namespace Controllers {
+    class DateTime;
+
+    /// Runs the actigraphy on the accelerometer samples during the night, and appends a summary of each night to a
+    /// littlefs file. The tracking usually ends while the watch sleeps : the summary is kept in RAM until Flush().
+    class SleepTracker {
+    public:
+      struct __attribute__((packed)) Night {
+        uint32_t start;      // Start of the tracking, seconds since epoch
+        uint32_t sleepOnset; // Seconds since epoch, 0 if no sleep was detected
+        uint32_t wakeUp;     // Seconds since epoch
+        uint16_t trackedMinutes;
+        uint16_t totalSleep; // Minutes
+        uint16_t wakeAfterSleepOnset; // Minutes
+        uint8_t awakenings;
+        uint8_t efficiency; // Percentage of the time between sleep onset and wake up spent sleeping
+      };
+
+      /// Rate of the FIFO (100Hz / 2^downsampling) when only the sleep tracker needs the samples
+      static constexpr uint8_t fifoDownsampling = 5;
+      static_assert((10 << fifoDownsampling) == Actigraphy::samplePeriodMs, "FIFO rate must match the actigraphy");
+
+      SleepTracker(FS& fs, DateTime& dateTimeController);
+      /// Starts or stops the tracking according to the time of day. Returns true if the tracking state changed.
+      bool Update();
+      bool IsTracking() const {
+        return isTracking;
+      }
+      /// samples : consecutive FIFO samples at 100Hz / 2^downsampling, timestamp being the time (in ticks) of the last one
+      void AddSamples(const Drivers::Bma421Fifo::Sample* samples, size_t nbSamples, uint8_t downsampling, TickType_t timestamp);
+      /// Writes the summary of the last night to the file. Must be called when the SPI NOR flash is awake.
+      void Flush();
+
+      static constexpr const char* fileName = "/sleep.dat";
+      // Previous file, the current one is renamed when it reaches maxFileSize
+      static constexpr const char* oldFileName = "/sleep.old";
+
+    private:
+      // Tracking window, local time
+      static constexpr uint8_t startHour = 21;
+      static constexpr uint8_t endHour = 11;
+      static constexpr TickType_t epochDuration = configTICK_RATE_HZ * 60;
+      // Nights shorter than this are not saved (watch off, tracking started late...)
+      static constexpr uint16_t minTrackedMinutes = 60;
+      static constexpr uint32_t maxFileSize = 60 * sizeof(Night);
+
+      void Stop();
+
+      FS& fs;
+      DateTime& dateTimeController;
+      Actigraphy actigraphy;
+      bool isTracking = false;
+      uint32_t startTime = 0;
+      bool hasEpochStart = false;
+      TickType_t epochStart = 0;
+      uint32_t decimationCounter = 0;
+      Night pendingNight;
+      bool hasPendingNight = false;
+      lfs_file_t file;
+    };
+  }
+}
@@ -0,0 +1,189 @@
+#include "components/motion/StepHistory.h"
+#include <algorithm>
+#include <cstring>
+#include "components/datetime/DateTimeController.h"
+
+using namespace Pinetime::Controllers;
+
+constexpr uint32_t StepHistory::bucketDuration;
+constexpr uint32_t StepHistory::maxFileBuckets;
+
+StepHistory::StepHistory(FS& fs, DateTime& dateTimeController)
+  : fs {fs}, dateTimeController {dateTimeController}, mutex {mutexStorage.Create()} {
+}
+
+uint32_t StepHistory::CurrentHour() const {
+  auto hours = std::chrono::duration_cast<std::chrono::hours>(dateTimeController.CurrentDateTime().time_since_epoch());
+  return static_cast<uint32_t>(hours.count());
+}
+
+void StepHistory::Append(uint32_t nbSteps) {
+  uint32_t hour = CurrentHour() - 1;
+  uint16_t value = static_cast<uint16_t>(std::min<uint32_t>(nbSteps, UINT16_MAX));
+
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  if (nbBuffered > 0) {
+    uint32_t nextHour = bufferFirstHour + nbBuffered;
+    if (hour < nextHour) {
+      // The time was set backward : the steps are added to the last bucket rather than lost
+      auto& last = buffer[nbBuffered - 1];
+      last = static_cast<uint16_t>(std::min<uint32_t>(last + value, UINT16_MAX));
+      xSemaphoreGive(mutex);
+      return;
+    }
+    // Hours during which no bucket was recorded (time set forward) : if they fill the buffer, they would push out all
+    // the buffered buckets.
+    if (hour - nextHour >= bufferSize) {
+      nbBuffered = 0;
+    }
+    while (nbBuffered > 0 && bufferFirstHour + nbBuffered < hour) {
+      Push(0);
+    }
+  }
+
+  if (nbBuffered == 0) {
+    bufferFirstHour = hour;
+  }
+  Push(value);
+  xSemaphoreGive(mutex);
+}
+
+void StepHistory::Push(uint16_t value) {
+  if (nbBuffered == bufferSize) {
+    // Not flushed for a day (the watch was not woken up) : keep the most recent buckets
+    std::copy(buffer.begin() + 1, buffer.end(), buffer.begin());
+    bufferFirstHour++;
+    nbBuffered--;
+  }
+  buffer[nbBuffered++] = value;
+}
+
+bool StepHistory::OpenFile(lfs_file_t* file, const char* name, int flags, Source& source) {
+  if (fs.FileOpen(file, name, flags) != LFS_ERR_OK) {
+    return false;
+  }
+  int size = fs.FileSize(file);
+  if (size < static_cast<int>(headerSize) ||
+      fs.FileRead(file, reinterpret_cast<uint8_t*>(&source.firstHour), headerSize) != static_cast<int>(headerSize)) {
+    fs.FileClose(file);
+    return false;
+  }
+  source.nbBuckets = (size - headerSize) / sizeof(uint16_t);
+  return true;
+}
+
+bool StepHistory::CreateFile(uint32_t firstHour) {
+  if (fs.FileOpen(&file, fileName, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) != LFS_ERR_OK) {
+    return false;
+  }
+  fs.FileWrite(&file, reinterpret_cast<const uint8_t*>(&firstHour), headerSize);
+  return true;
+}
+
+void StepHistory::Flush() {
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  FlushLocked();
+  xSemaphoreGive(mutex);
+}
+
+void StepHistory::FlushLocked() {
+  if (nbBuffered == 0) {
+    return;
+  }
+
+  Source current;
+  bool isOpen = OpenFile(&file, fileName, LFS_O_RDWR, current);
+  uint32_t gap = 0;
+  if (isOpen) {
+    uint32_t fileEnd = current.firstHour + current.nbBuckets;
+    gap = bufferFirstHour - fileEnd;
+    if (bufferFirstHour < fileEnd || current.nbBuckets + gap + nbBuffered > maxFileBuckets) {
+      // Full file, or time set backward : the buckets of a file must stay consecutive
+      fs.FileClose(&file);
+      fs.Rename(fileName, oldFileName);
+      isOpen = false;
+    }
+  }
+  if (!isOpen) {
+    gap = 0;
+    if (!CreateFile(bufferFirstHour)) {
+      nbBuffered = 0;
+      return;
+    }
+  } else {
+    fs.FileSeek(&file, headerSize + current.nbBuckets * sizeof(uint16_t));
+  }
+
+  // Hours during which no bucket was recorded (watch off, time set forward)
+  static constexpr std::array<uint16_t, bufferSize> zeros {};
+  while (gap > 0) {
+    uint32_t n = std::min<uint32_t>(gap, zeros.size());
+    fs.FileWrite(&file, reinterpret_cast<const uint8_t*>(zeros.data()), n * sizeof(uint16_t));
+    gap -= n;
+  }
+
+  fs.FileWrite(&file, reinterpret_cast<const uint8_t*>(buffer.data()), nbBuffered * sizeof(uint16_t));
+  fs.FileClose(&file);
+  nbBuffered = 0;
+}
+
+uint16_t StepHistory::Read(uint32_t fromHour, uint32_t& firstHour, uint16_t* buckets, uint16_t maxBuckets) {
+  uint16_t nbBuckets = 0;
+  firstHour = fromHour;
+  xSemaphoreTake(mutex, portMAX_DELAY);
+
+  Source source;
+  if (OpenFile(&readFile, oldFileName, LFS_O_RDONLY, source)) {
+    Collect(source, true, fromHour, firstHour, buckets, maxBuckets, nbBuckets);
+  }
+  if (OpenFile(&readFile, fileName, LFS_O_RDONLY, source)) {
+    Collect(source, true, fromHour, firstHour, buckets, maxBuckets, nbBuckets);
+  }
+  Collect({bufferFirstHour, nbBuffered}, false, fromHour, firstHour, buckets, maxBuckets, nbBuckets);
+  xSemaphoreGive(mutex);
+  return nbBuckets;
+}
+
+/// Appends the buckets of a source (readFile if fromFile, otherwise the RAM buffer) to the result,
+/// the hours missing between two sources being filled with zeros.
+void StepHistory::Collect(const Source& source,
+                          bool fromFile,
+                          uint32_t fromHour,
+                          uint32_t& firstHour,
+                          uint16_t* buckets,
+                          uint16_t maxBuckets,
+                          uint16_t& nbBuckets) {
+  uint32_t begin = std::max(source.firstHour, fromHour);
+  uint32_t end = source.firstHour + source.nbBuckets;
+  if (nbBuckets > 0) {
+    uint32_t nextHour = firstHour + nbBuckets;
+    begin = std::max(begin, nextHour);
+    if (begin < end) {
+      uint16_t nbZeros = static_cast<uint16_t>(std::min<uint32_t>(begin - nextHour, maxBuckets - nbBuckets));
+      std::fill_n(buckets + nbBuckets, nbZeros, 0);
+      nbBuckets += nbZeros;
+    }
+  }
+
+  if (begin < end && nbBuckets < maxBuckets) {
+    if (nbBuckets == 0) {
+      firstHour = begin;
+    }
+    uint16_t count = static_cast<uint16_t>(std::min<uint32_t>(end - begin, maxBuckets - nbBuckets));
+    uint32_t index = begin - source.firstHour;
+    if (!fromFile) {
+      std::memcpy(buckets + nbBuckets, buffer.data() + index, count * sizeof(uint16_t));
+      nbBuckets += count;
+    } else {
+      fs.FileSeek(&readFile, headerSize + index * sizeof(uint16_t));
+      int size = fs.FileRead(&readFile, reinterpret_cast<uint8_t*>(buckets + nbBuckets), count * sizeof(uint16_t));
+      if (size > 0) {
+        nbBuckets += size / sizeof(uint16_t);
+      }
+    }
+  }
+
+  if (fromFile) {
+    fs.FileClose(&readFile);
+  }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "components/fs/FS.h"
+#include "memory/KernelObjects.h"
+
+namespace Pinetime {
+  namespace Controllers {
+    class DateTime;
+
+    /// Number of steps per hour, stored in a littlefs file.
+    /// The file starts with the hour (since epoch) of its first bucket, followed by one uint16_t per hour,
+    /// so that the hour of a bucket is given by its position. The buckets are buffered in RAM, and appended
+    /// to the file by the system task when the SPI NOR flash is powered (the watch is awake).
+    /// The system task (Append, Flush) and the BLE host (Read) are serialized by a mutex.
+    class StepHistory {
+    public:
+      StepHistory(FS& fs, DateTime& dateTimeController);
+      /// Records the number of steps of the hour that just ended. The oldest buckets are dropped if the buffer is full.
+      void Append(uint32_t nbSteps);
+      /// Writes the buffered buckets to the file. Must be called when the SPI NOR flash is awake.
+      void Flush();
+
+      /// Copies the consecutive buckets starting at fromHour (or at the oldest bucket available after it).
+      /// Returns the number of buckets copied, firstHour being set to the hour of the first one.
+      /// Must be called when the SPI NOR flash is awake.
+      uint16_t Read(uint32_t fromHour, uint32_t& firstHour, uint16_t* buckets, uint16_t maxBuckets);
+
+      static constexpr uint32_t bucketDuration = 3600; // seconds
+      static constexpr const char* fileName = "/stephist.dat";
+      // Previous history file, the current one is renamed when it reaches maxFileBuckets
+      static constexpr const char* oldFileName = "/stephist.old";
+
+    private:
+      struct Source {
+        uint32_t firstHour;
+        uint32_t nbBuckets;
+      };
+
+      // A day : the buckets of a night wait in RAM until the watch is woken up
+      static constexpr uint8_t bufferSize = 24;
+      // 31 days per file, the previous file being kept
+      static constexpr uint32_t maxFileBuckets = 31 * 24;
+      static constexpr uint32_t headerSize = sizeof(uint32_t);
+
+      uint32_t CurrentHour() const;
+      void Push(uint16_t value);
+      void FlushLocked();
+      bool OpenFile(lfs_file_t* file, const char* name, int flags, Source& source);
+      bool CreateFile(uint32_t firstHour);
+      void Collect(const Source& source, bool fromFile, uint32_t fromHour, uint32_t& firstHour,
+                   uint16_t* buckets, uint16_t maxBuckets, uint16_t& nbBuckets);
+
+      FS& fs;
+      DateTime& dateTimeController;
+      std::array<uint16_t, bufferSize> buffer;
+      uint32_t bufferFirstHour = 0;
+      uint8_t nbBuffered = 0;
+      // Not allocated on the stack of the callers (system task and BLE host)
+      lfs_file_t file;
+      lfs_file_t readFile;
+      Memory::StaticMutex mutexStorage;
+      SemaphoreHandle_t mutex;
+    };
+  }
+}
@@ -1,21 +1,18 @@
 #include "components/motor/MotorController.h"
 #include <hal/nrf_gpio.h>
 #include "systemtask/SystemTask.h"
-#include "app_timer.h"
 #include "drivers/PinMap.h"
 
-APP_TIMER_DEF(shortVibTimer);
-APP_TIMER_DEF(longVibTimer);
-
 using namespace Pinetime::Controllers;
 
+MotorController::MotorController()
+  : shortVibTimer {"motorShort", Pinetime::System::Timer::Modes::SingleShot, StopMotor, this},
+    longVibTimer {"motorRing", Pinetime::System::Timer::Modes::Repeated, Ring, this, 50} {
+}
+
 void MotorController::Init() {
   nrf_gpio_cfg_output(PinMap::Motor);
   nrf_gpio_pin_set(PinMap::Motor);
-  app_timer_init();
-
-  app_timer_create(&shortVibTimer, APP_TIMER_MODE_SINGLE_SHOT, StopMotor);
-  app_timer_create(&longVibTimer, APP_TIMER_MODE_REPEATED, Ring);
 }
 
 void MotorController::Ring(void* p_context) {
@@ -25,16 +22,16 @@ void MotorController::Ring(void* p_context) {
 
 void MotorController::RunForDuration(uint8_t motorDuration) {
   nrf_gpio_pin_clear(PinMap::Motor);
-  app_timer_start(shortVibTimer, APP_TIMER_TICKS(motorDuration), nullptr);
+  shortVibTimer.Start(motorDuration);
 }
 
 void MotorController::StartRinging() {
   Ring(this);
-  app_timer_start(longVibTimer, APP_TIMER_TICKS(1000), this);
+  longVibTimer.Start(1000);
 }
 
 void MotorController::StopRinging() {
-  app_timer_stop(longVibTimer);
+  longVibTimer.Stop();
   nrf_gpio_pin_set(PinMap::Motor);
 }
 
@@ -1,13 +1,14 @@
 #pragma once
 
 #include <cstdint>
+#include "systemtask/TimerService.h"
 
 namespace Pinetime {
   namespace Controllers {
 
     class MotorController {
     public:
-      MotorController() = default;
+      MotorController();
 
       void Init();
       void RunForDuration(uint8_t motorDuration);
@@ -17,6 +18,9 @@ namespace Pinetime {
     private:
       static void Ring(void* p_context);
       static void StopMotor(void* p_context);
+
+      Pinetime::System::Timer shortVibTimer;
+      Pinetime::System::Timer longVibTimer;
     };
   }
 }
@@ -202,6 +202,18 @@ namespace Pinetime {
         return settings.stepsGoal;
       };
 
+      void SetHeartRateBackgroundPeriod(uint16_t minutes) {
+        if (minutes != settings.heartRateBackgroundPeriod) {
+          settingsChanged = true;
+        }
+        settings.heartRateBackgroundPeriod = minutes;
+      };
+
+      /// Period (in minutes) of the background heart rate measurements, 0 when disabled
+      uint16_t GetHeartRateBackgroundPeriod() const {
+        return settings.heartRateBackgroundPeriod;
+      };
+
      void SetBleRadioEnabled(bool enabled) {
        bleRadioEnabled = enabled;
      };
@@ -213,7 +225,7 @@ namespace Pinetime {
     private:
       Pinetime::Controllers::FS& fs;
 
-      static constexpr uint32_t settingsVersion = 0x0003;
+      static constexpr uint32_t settingsVersion = 0x0004;
       struct SettingsData {
         uint32_t version = settingsVersion;
         uint32_t stepsGoal = 10000;
@@ -230,6 +242,7 @@ namespace Pinetime {
         std::bitset<4> wakeUpMode {0};
         uint16_t shakeWakeThreshold = 150;
         Controllers::BrightnessController::Levels brightLevel = Controllers::BrightnessController::Levels::Medium;
+        uint16_t heartRateBackgroundPeriod = 0;
       };
 
       SettingsData settings;
@@ -3,35 +3,32 @@
 
 using namespace Pinetime::Controllers;
 
-void TimerCallback(TimerHandle_t xTimer) {
-  auto* controller = static_cast<TimerController*>(pvTimerGetTimerID(xTimer));
+void TimerCallback(void* context) {
+  auto* controller = static_cast<TimerController*>(context);
   controller->OnTimerEnd();
 }
 
+TimerController::TimerController() : timer {"timerApp", Pinetime::System::Timer::Modes::SingleShot, TimerCallback, this, 50} {
+}
+
 void TimerController::Init(Pinetime::System::SystemTask* systemTask) {
   this->systemTask = systemTask;
-  timer = xTimerCreate("Timer", 0, pdFALSE, this, TimerCallback);
 }
 
 void TimerController::StartTimer(uint32_t duration) {
-  xTimerChangePeriod(timer, pdMS_TO_TICKS(duration), 0);
-  xTimerStart(timer, 0);
+  timer.Start(duration);
 }
 
 uint32_t TimerController::GetTimeRemaining() {
-  if (IsRunning()) {
-    TickType_t remainingTime = xTimerGetExpiryTime(timer) - xTaskGetTickCount();
-    return (remainingTime * 1000 / configTICK_RATE_HZ);
-  }
-  return 0;
+  return timer.RemainingMs();
 }
 
 void TimerController::StopTimer() {
-  xTimerStop(timer, 0);
+  timer.Stop();
 }
 
 bool TimerController::IsRunning() {
-  return (xTimerIsTimerActive(timer) == pdTRUE);
+  return timer.IsRunning();
 }
 
 void TimerController::OnTimerEnd() {
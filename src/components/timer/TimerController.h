@@ -1,7 +1,7 @@
 #pragma once
 
-#include <FreeRTOS.h>
-#include <timers.h>
+#include <cstdint>
+#include "systemtask/TimerService.h"
 
 namespace Pinetime {
   namespace System {
@@ -11,7 +11,7 @@ namespace Pinetime {
 
     class TimerController {
     public:
-      TimerController() = default;
+      TimerController();
 
       void Init(System::SystemTask* systemTask);
 
@@ -27,7 +27,7 @@ namespace Pinetime {
 
     private:
       System::SystemTask* systemTask = nullptr;
-      TimerHandle_t timer;
+      Pinetime::System::Timer timer;
     };
   }
 }
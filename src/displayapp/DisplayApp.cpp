@@ -37,6 +37,8 @@
 #include "drivers/Watchdog.h"
 #include "systemtask/SystemTask.h"
 #include "systemtask/Messages.h"
+#include "trace/Trace.h"
+#include "profiling/Profiler.h"
 
 #include "displayapp/screens/settings/QuickSettings.h"
 #include "displayapp/screens/settings/Settings.h"
@@ -50,21 +52,17 @@
 #include "displayapp/screens/settings/SettingChimes.h"
 #include "displayapp/screens/settings/SettingShakeThreshold.h"
 #include "displayapp/screens/settings/SettingBluetooth.h"
+#include "displayapp/screens/settings/SettingHeartRate.h"
 
 #include "libs/lv_conf.h"
 
 using namespace Pinetime::Applications;
 using namespace Pinetime::Applications::Display;
 
-namespace {
-  static inline bool in_isr(void) {
-    return (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) != 0;
-  }
-}
-
 DisplayApp::DisplayApp(Drivers::St7789& lcd,
                        Components::LittleVgl& lvgl,
                        Drivers::Cst816S& touchPanel,
+                       Drivers::TwiMaster& twiMaster,
                        Controllers::Battery& batteryController,
                        Controllers::Ble& bleController,
                        Controllers::DateTime& dateTimeController,
@@ -81,6 +79,7 @@ DisplayApp::DisplayApp(Drivers::St7789& lcd,
   : lcd {lcd},
     lvgl {lvgl},
     touchPanel {touchPanel},
+    twiMaster {twiMaster},
     batteryController {batteryController},
     bleController {bleController},
     dateTimeController {dateTimeController},
@@ -93,11 +92,12 @@ DisplayApp::DisplayApp(Drivers::St7789& lcd,
     timerController {timerController},
     alarmController {alarmController},
     brightnessController {brightnessController},
-    touchHandler {touchHandler} {
+    touchHandler {touchHandler},
+    messageBus {"display"} {
 }
 
 void DisplayApp::Start(System::BootErrors error) {
-  msgQueue = xQueueCreate(queueSize, itemSize);
+  messageBus.Init();
 
   bootError = error;
 
@@ -107,9 +107,7 @@ void DisplayApp::Start(System::BootErrors error) {
     LoadApp(Apps::Clock, DisplayApp::FullRefreshDirections::None);
   }
 
-  if (pdPASS != xTaskCreate(DisplayApp::Process, "displayapp", 800, this, 0, &taskHandle)) {
-    APP_ERROR_HANDLER(NRF_ERROR_NO_MEM);
-  }
+  taskHandle = task.Create(DisplayApp::Process, "displayapp", 0, this);
 }
 
 void DisplayApp::Process(void* instance) {
@@ -140,16 +138,21 @@ void DisplayApp::Refresh() {
       if (!currentScreen->IsRunning()) {
         LoadApp(returnToApp, returnDirection);
       }
-      queueTimeout = lv_task_handler();
+      {
+        Pinetime::Trace::Span span(Pinetime::Trace::UserEvents::LvglTaskHandler);
+        Pinetime::Profiling::Zone zone(Pinetime::Profiling::Zones::LvglTaskHandler);
+        queueTimeout = lv_task_handler();
+      }
       break;
     default:
       queueTimeout = portMAX_DELAY;
       break;
   }
 
-  Messages msg;
-  if (xQueueReceive(msgQueue, &msg, queueTimeout)) {
-    switch (msg) {
+  decltype(messageBus)::Envelope envelope;
+  if (messageBus.Receive(envelope, queueTimeout)) {
+    Pinetime::Trace::Mark(Pinetime::Trace::UserEvents::DisplayAppMessage, static_cast<uint16_t>(envelope.message));
+    switch (envelope.message) {
       case Messages::DimScreen:
         // Backup brightness is the brightness to return to after dimming or sleeping
         brightnessController.Backup();
@@ -205,10 +208,7 @@ void DisplayApp::Refresh() {
         if (state != States::Running) {
           break;
         }
-        auto gesture = touchHandler.GestureGet();
-        if (gesture == TouchEvents::None) {
-          break;
-        }
+        auto gesture = static_cast<TouchEvents>(envelope.payload);
         if (!currentScreen->OnTouchEvent(gesture)) {
           if (currentApp == Apps::Clock) {
             switch (gesture) {
@@ -284,8 +284,9 @@ void DisplayApp::Refresh() {
     }
   }
 
-  if (touchHandler.IsTouching()) {
-    currentScreen->OnTouchEvent(touchHandler.GetX(), touchHandler.GetY());
+  uint8_t touchX, touchY;
+  if (touchHandler.GetTouchPoint(touchX, touchY)) {
+    currentScreen->OnTouchEvent(touchX, touchY);
   }
 
   if (nextApp != Apps::None) {
@@ -416,13 +417,26 @@ void DisplayApp::LoadApp(Apps app, DisplayApp::FullRefreshDirections direction)
       currentScreen = std::make_unique<Screens::SettingBluetooth>(this, settingsController);
       ReturnApp(Apps::Settings, FullRefreshDirections::Down, TouchEvents::SwipeDown);
       break;
+    case Apps::SettingHeartRate:
+      currentScreen = std::make_unique<Screens::SettingHeartRate>(this, settingsController);
+      ReturnApp(Apps::Settings, FullRefreshDirections::Down, TouchEvents::SwipeDown);
+      break;
     case Apps::BatteryInfo:
       currentScreen = std::make_unique<Screens::BatteryInfo>(this, batteryController);
       ReturnApp(Apps::Settings, FullRefreshDirections::Down, TouchEvents::SwipeDown);
       break;
     case Apps::SysInfo:
-      currentScreen = std::make_unique<Screens::SystemInfo>(
-        this, dateTimeController, batteryController, brightnessController, bleController, watchdog, motionController, touchPanel);
+      currentScreen = std::make_unique<Screens::SystemInfo>(this,
+                                                            dateTimeController,
+                                                            batteryController,
+                                                            brightnessController,
+                                                            bleController,
+                                                            watchdog,
+                                                            motionController,
+                                                            touchPanel,
+                                                            twiMaster,
+                                                            touchHandler,
+                                                            *systemTask);
       ReturnApp(Apps::Settings, FullRefreshDirections::Down, TouchEvents::SwipeDown);
       break;
     case Apps::FlashLight:
@@ -464,17 +478,8 @@ void DisplayApp::LoadApp(Apps app, DisplayApp::FullRefreshDirections direction)
   currentApp = app;
 }
 
-void DisplayApp::PushMessage(Messages msg) {
-  if (in_isr()) {
-    BaseType_t xHigherPriorityTaskWoken;
-    xHigherPriorityTaskWoken = pdFALSE;
-    xQueueSendFromISR(msgQueue, &msg, &xHigherPriorityTaskWoken);
-    if (xHigherPriorityTaskWoken) {
-      portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
-    }
-  } else {
-    xQueueSend(msgQueue, &msg, portMAX_DELAY);
-  }
+void DisplayApp::PushMessage(Messages msg, uint32_t payload) {
+  messageBus.Push(msg, payload);
 }
 
 void DisplayApp::SetFullRefresh(DisplayApp::FullRefreshDirections direction) {
@@ -18,6 +18,8 @@
 #include "touchhandler/TouchHandler.h"
 
 #include "displayapp/Messages.h"
+#include "systemtask/MessageBus.h"
+#include "memory/KernelObjects.h"
 #include "BootErrors.h"
 
 namespace Pinetime {
@@ -25,6 +27,7 @@ namespace Pinetime {
   namespace Drivers {
     class St7789;
     class Cst816S;
+    class TwiMaster;
     class WatchdogView;
   }
   namespace Controllers {
@@ -50,6 +53,7 @@ namespace Pinetime {
       DisplayApp(Drivers::St7789& lcd,
                  Components::LittleVgl& lvgl,
                  Drivers::Cst816S&,
+                 Drivers::TwiMaster& twiMaster,
                  Controllers::Battery& batteryController,
                  Controllers::Ble& bleController,
                  Controllers::DateTime& dateTimeController,
@@ -64,7 +68,7 @@ namespace Pinetime {
                  Pinetime::Controllers::BrightnessController& brightnessController,
                  Pinetime::Controllers::TouchHandler& touchHandler);
       void Start(System::BootErrors error);
-      void PushMessage(Display::Messages msg);
+      void PushMessage(Display::Messages msg, uint32_t payload = 0);
 
       void StartApp(Apps app, DisplayApp::FullRefreshDirections direction);
 
@@ -76,6 +80,7 @@ namespace Pinetime {
       Pinetime::Drivers::St7789& lcd;
       Pinetime::Components::LittleVgl& lvgl;
       Pinetime::Drivers::Cst816S& touchPanel;
+      Pinetime::Drivers::TwiMaster& twiMaster;
       Pinetime::Controllers::Battery& batteryController;
       Pinetime::Controllers::Ble& bleController;
       Pinetime::Controllers::DateTime& dateTimeController;
@@ -94,12 +99,10 @@ namespace Pinetime {
       Pinetime::Controllers::FirmwareValidator validator;
 
       TaskHandle_t taskHandle;
+      Memory::StaticTask<800> task;
 
       States state = States::Running;
-      QueueHandle_t msgQueue;
-
-      static constexpr uint8_t queueSize = 10;
-      static constexpr uint8_t itemSize = 1;
+      Pinetime::System::MessageBus<Display::Messages, 6> messageBus;
 
       std::unique_ptr<Screens::Screen> currentScreen;
 
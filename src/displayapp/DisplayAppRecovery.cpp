@@ -12,6 +12,7 @@ using namespace Pinetime::Applications;
 DisplayApp::DisplayApp(Drivers::St7789& lcd,
                        Components::LittleVgl& lvgl,
                        Drivers::Cst816S& touchPanel,
+                       Drivers::TwiMaster& twiMaster,
                        Controllers::Battery& batteryController,
                        Controllers::Ble& bleController,
                        Controllers::DateTime& dateTimeController,
@@ -25,14 +26,13 @@ DisplayApp::DisplayApp(Drivers::St7789& lcd,
                        Pinetime::Controllers::AlarmController& alarmController,
                        Pinetime::Controllers::BrightnessController& brightnessController,
                        Pinetime::Controllers::TouchHandler& touchHandler)
-  : lcd {lcd}, bleController {bleController} {
+  : lcd {lcd}, bleController {bleController}, messageBus {"display"} {
 
 }
 
 void DisplayApp::Start() {
-  msgQueue = xQueueCreate(queueSize, itemSize);
-  if (pdPASS != xTaskCreate(DisplayApp::Process, "displayapp", 512, this, 0, &taskHandle))
-    APP_ERROR_HANDLER(NRF_ERROR_NO_MEM);
+  messageBus.Init();
+  taskHandle = task.Create(DisplayApp::Process, "displayapp", 0, this);
 }
 
 void DisplayApp::Process(void* instance) {
@@ -53,9 +53,9 @@ void DisplayApp::InitHw() {
 }
 
 void DisplayApp::Refresh() {
-  Display::Messages msg;
-  if (xQueueReceive(msgQueue, &msg, 200)) {
-    switch (msg) {
+  decltype(messageBus)::Envelope envelope;
+  if (messageBus.Receive(envelope, 200)) {
+    switch (envelope.message) {
       case Display::Messages::UpdateBleConnection:
         if (bleController.IsConnected()) {
           DisplayLogo(colorBlue);
@@ -110,14 +110,8 @@ void DisplayApp::DisplayOtaProgress(uint8_t percent, uint16_t color) {
   }
 }
 
-void DisplayApp::PushMessage(Display::Messages msg) {
-  BaseType_t xHigherPriorityTaskWoken;
-  xHigherPriorityTaskWoken = pdFALSE;
-  xQueueSendFromISR(msgQueue, &msg, &xHigherPriorityTaskWoken);
-  if (xHigherPriorityTaskWoken) {
-    /* Actual macro used here is port specific. */
-    // TODO : should I do something here?
-  }
+void DisplayApp::PushMessage(Display::Messages msg, uint32_t payload) {
+  messageBus.Push(msg, payload);
 }
 
 void DisplayApp::Register(Pinetime::System::SystemTask* systemTask) {
@@ -15,11 +15,14 @@
 #include "displayapp/Apps.h"
 #include "displayapp/Messages.h"
 #include "displayapp/DummyLittleVgl.h"
+#include "systemtask/MessageBus.h"
+#include "memory/KernelObjects.h"
 
 namespace Pinetime {
   namespace Drivers {
     class St7789;
     class Cst816S;
+    class TwiMaster;
     class WatchdogView;
   }
   namespace Controllers {
@@ -47,6 +50,7 @@ namespace Pinetime {
       DisplayApp(Drivers::St7789& lcd,
                  Components::LittleVgl& lvgl,
                  Drivers::Cst816S&,
+                 Drivers::TwiMaster& twiMaster,
                  Controllers::Battery& batteryController,
                  Controllers::Ble& bleController,
                  Controllers::DateTime& dateTimeController,
@@ -62,11 +66,12 @@ namespace Pinetime {
                  Pinetime::Controllers::TouchHandler& touchHandler);
       void Start();
       void Start(Pinetime::System::BootErrors){ Start(); };
-      void PushMessage(Pinetime::Applications::Display::Messages msg);
+      void PushMessage(Pinetime::Applications::Display::Messages msg, uint32_t payload = 0);
       void Register(Pinetime::System::SystemTask* systemTask);
 
     private:
       TaskHandle_t taskHandle;
+      Memory::StaticTask<512> task;
       static void Process(void* instance);
       void DisplayLogo(uint16_t color);
       void DisplayOtaProgress(uint8_t percent, uint16_t color);
@@ -75,9 +80,7 @@ namespace Pinetime {
       Pinetime::Drivers::St7789& lcd;
       Controllers::Ble& bleController;
 
-      static constexpr uint8_t queueSize = 10;
-      static constexpr uint8_t itemSize = 1;
-      QueueHandle_t msgQueue;
+      Pinetime::System::MessageBus<Pinetime::Applications::Display::Messages, 4> messageBus;
       static constexpr uint8_t displayWidth = 240;
       static constexpr uint8_t displayHeight = 240;
       static constexpr uint8_t bytesPerPixel = 2;
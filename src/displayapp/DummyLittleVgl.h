@@ -4,14 +4,14 @@
 #include <lvgl/src/lv_themes/lv_theme.h>
 #include <lvgl/src/lv_hal/lv_hal.h>
 #include <drivers/St7789.h>
-#include <drivers/Cst816s.h>
+#include "touchhandler/TouchHandler.h"
 
 namespace Pinetime {
   namespace Components {
     class LittleVgl {
     public:
       enum class FullRefreshDirections { None, Up, Down };
-      LittleVgl(Pinetime::Drivers::St7789& lcd, Pinetime::Drivers::Cst816S& touchPanel) {
+      LittleVgl(Pinetime::Drivers::St7789& lcd, Pinetime::Controllers::TouchHandler& touchHandler) {
       }
 
       LittleVgl(const LittleVgl&) = delete;
@@ -30,11 +30,6 @@ namespace Pinetime {
       }
       void SetFullRefresh(FullRefreshDirections direction) {
       }
-      void SetNewTapEvent(uint16_t x, uint16_t y) {
-      }
-      void SetNewTouchPoint(uint16_t x, uint16_t y, bool contact) {
-
-      }
     };
   }
 }
@@ -4,8 +4,10 @@
 #include <FreeRTOS.h>
 #include <task.h>
 //#include <projdefs.h>
-#include "drivers/Cst816s.h"
 #include "drivers/St7789.h"
+#include "touchhandler/TouchHandler.h"
+#include "trace/Trace.h"
+#include "profiling/Profiler.h"
 
 using namespace Pinetime::Components;
 
@@ -21,8 +23,8 @@ bool touchpad_read(lv_indev_drv_t* indev_drv, lv_indev_data_t* data) {
   return lvgl->GetTouchPadInfo(data);
 }
 
-LittleVgl::LittleVgl(Pinetime::Drivers::St7789& lcd, Pinetime::Drivers::Cst816S& touchPanel)
-  : lcd {lcd}, touchPanel {touchPanel}, previousClick {0, 0} {
+LittleVgl::LittleVgl(Pinetime::Drivers::St7789& lcd, Pinetime::Controllers::TouchHandler& touchHandler)
+  : lcd {lcd}, touchHandler {touchHandler}, previousClick {0, 0} {
 
 }
 
@@ -82,6 +84,8 @@ void LittleVgl::SetFullRefresh(FullRefreshDirections direction) {
 
 void LittleVgl::FlushDisplay(const lv_area_t* area, lv_color_t* color_p) {
   uint16_t y1, y2, width, height = 0;
+  Pinetime::Trace::Span span(Pinetime::Trace::UserEvents::DisplayFlush, (area->y2 - area->y1) + 1);
+  Pinetime::Profiling::Zone zone(Pinetime::Profiling::Zones::DisplayFlush);
 
   ulTaskNotifyTake(pdTRUE, 200);
   // NOtification is still needed (even if there is a mutex on SPI) because of the DataCommand pin
@@ -161,18 +165,24 @@ void LittleVgl::FlushDisplay(const lv_area_t* area, lv_color_t* color_p) {
     lcd.DrawBuffer(area->x1, y1, width, height, reinterpret_cast<const uint8_t*>(color_p), width * height * 2);
   }
 
+  if (lv_disp_flush_is_last(&disp_drv)) {
+    touchHandler.OnDisplayFlushed();
+  }
+
   // IMPORTANT!!!
   // Inform the graphics library that you are ready with the flushing
   lv_disp_flush_ready(&disp_drv);
 }
 
-void LittleVgl::SetNewTouchPoint(uint16_t x, uint16_t y, bool contact) {
-  tap_x = x;
-  tap_y = y;
-  tapped = contact;
-}
-
+/// Consumes the points sampled by the touch task. All the buffered points are fed to LVGL in a row (returning true
+/// makes LVGL call this function again), so that short taps are not lost.
 bool LittleVgl::GetTouchPadInfo(lv_indev_data_t* ptr) {
+  Pinetime::Controllers::TouchHandler::Point point;
+  if (touchHandler.PopPoint(point)) {
+    tap_x = point.x;
+    tap_y = point.y;
+    tapped = point.touching;
+  }
   ptr->point.x = tap_x;
   ptr->point.y = tap_y;
   if (tapped) {
@@ -180,7 +190,7 @@ bool LittleVgl::GetTouchPadInfo(lv_indev_data_t* ptr) {
   } else {
     ptr->state = LV_INDEV_STATE_REL;
   }
-  return false;
+  return touchHandler.HasPoints();
 }
 
 void LittleVgl::InitTheme() {
@@ -4,15 +4,17 @@
 
 namespace Pinetime {
   namespace Drivers {
-    class Cst816S;
     class St7789;
   }
+  namespace Controllers {
+    class TouchHandler;
+  }
 
   namespace Components {
     class LittleVgl {
     public:
       enum class FullRefreshDirections { None, Up, Down, Left, Right, LeftAnim, RightAnim };
-      LittleVgl(Pinetime::Drivers::St7789& lcd, Pinetime::Drivers::Cst816S& touchPanel);
+      LittleVgl(Pinetime::Drivers::St7789& lcd, Pinetime::Controllers::TouchHandler& touchHandler);
 
       LittleVgl(const LittleVgl&) = delete;
       LittleVgl& operator=(const LittleVgl&) = delete;
@@ -24,7 +26,6 @@ namespace Pinetime {
       void FlushDisplay(const lv_area_t* area, lv_color_t* color_p);
       bool GetTouchPadInfo(lv_indev_data_t* ptr);
       void SetFullRefresh(FullRefreshDirections direction);
-      void SetNewTouchPoint(uint16_t x, uint16_t y, bool contact);
 
     private:
       void InitDisplay();
@@ -32,7 +33,7 @@ namespace Pinetime {
       void InitTheme();
 
       Pinetime::Drivers::St7789& lcd;
-      Pinetime::Drivers::Cst816S& touchPanel;
+      Pinetime::Controllers::TouchHandler& touchHandler;
 
       lv_disp_buf_t disp_buf_2;
       lv_color_t buf2_1[LV_HOR_RES_MAX * 4];
@@ -52,8 +53,8 @@ namespace Pinetime {
       uint16_t writeOffset = 0;
       uint16_t scrollOffset = 0;
 
-      uint16_t tap_x = 0;
-      uint16_t tap_y = 0;
+      int16_t tap_x = 0;
+      int16_t tap_y = 0;
       bool tapped = false;
     };
   }
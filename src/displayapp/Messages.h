@@ -24,6 +24,36 @@ namespace Pinetime {
         Clock,
         BleRadioEnableToggle
       };
+
+      /// Input and alerts, handled before the housekeeping messages
+      inline bool IsUrgent(Messages message) {
+        switch (message) {
+          case Messages::UpdateDateTime:
+          case Messages::UpdateBleConnection:
+          case Messages::UpdateTimeOut:
+          case Messages::BleRadioEnableToggle:
+            return false;
+          default:
+            return true;
+        }
+      }
+
+      /// Messages that only ask to refresh a state : an identical message still pending is enough
+      inline bool IsCoalescable(Messages message) {
+        switch (message) {
+          case Messages::UpdateDateTime:
+          case Messages::UpdateBleConnection:
+          case Messages::TouchEvent:
+            return true;
+          default:
+            return false;
+        }
+      }
+
+      /// Coalescable messages whose payload is a value : the pending message takes the payload of the latest one
+      inline bool CarriesValue(Messages /*message*/) {
+        return false;
+      }
     }
   }
 }
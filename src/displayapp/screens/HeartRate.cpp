@@ -87,7 +87,16 @@ void HeartRate::Refresh() {
       lv_label_set_text_fmt(label_hr, "%03d", heartRateController.HeartRate());
   }
 
-  lv_label_set_text_static(label_status, ToString(state));
+  if (state == Controllers::HeartRateController::States::Running) {
+    auto ledCurrent = heartRateController.AverageLedCurrent();
+    lv_label_set_text_fmt(label_status,
+                          "Confidence %d%%\nLED %d.%dmA",
+                          heartRateController.Confidence(),
+                          ledCurrent / 10,
+                          ledCurrent % 10);
+  } else {
+    lv_label_set_text_static(label_status, ToString(state));
+  }
   lv_obj_align(label_status, label_hr, LV_ALIGN_OUT_BOTTOM_MID, 0, 10);
 }
 
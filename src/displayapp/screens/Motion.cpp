@@ -6,6 +6,8 @@ using namespace Pinetime::Applications::Screens;
 
 Motion::Motion(Pinetime::Applications::DisplayApp* app, Controllers::MotionController& motionController)
   : Screen(app), motionController {motionController} {
+  motionController.SubscribeStepCount();
+  motionController.RequestPerformanceMode();
   chart = lv_chart_create(lv_scr_act(), NULL);
   lv_obj_set_size(chart, 240, 240);
   lv_obj_align(chart, NULL, LV_ALIGN_IN_TOP_MID, 0, 0);
@@ -41,6 +43,8 @@ Motion::Motion(Pinetime::Applications::DisplayApp* app, Controllers::MotionContr
 }
 
 Motion::~Motion() {
+  motionController.UnsubscribeStepCount();
+  motionController.ReleasePerformanceMode();
   lv_task_del(taskRefresh);
   lv_obj_clean(lv_scr_act());
 }
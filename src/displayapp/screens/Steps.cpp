@@ -14,6 +14,8 @@ Steps::Steps(Pinetime::Applications::DisplayApp* app,
              Controllers::MotionController& motionController,
              Controllers::Settings& settingsController)
   : Screen(app), motionController {motionController}, settingsController {settingsController} {
+  motionController.SubscribeStepCount();
+  motionController.RequestPerformanceMode();
 
   stepsArc = lv_arc_create(lv_scr_act(), nullptr);
 
@@ -74,6 +76,8 @@ Steps::Steps(Pinetime::Applications::DisplayApp* app,
 }
 
 Steps::~Steps() {
+  motionController.UnsubscribeStepCount();
+  motionController.ReleasePerformanceMode();
   lv_task_del(taskRefresh);
   lv_obj_clean(lv_scr_act());
 }
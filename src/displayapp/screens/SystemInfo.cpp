@@ -1,5 +1,6 @@
 #include <FreeRTOS.h>
 #include <task.h>
+#include <algorithm>
 #include "displayapp/screens/SystemInfo.h"
 #include <lvgl/lvgl.h>
 #include "displayapp/DisplayApp.h"
@@ -12,6 +13,13 @@
 #include "components/datetime/DateTimeController.h"
 #include "components/motion/MotionController.h"
 #include "drivers/Watchdog.h"
+#include "drivers/TwiMaster.h"
+#include "touchhandler/TouchHandler.h"
+#include "systemtask/SystemTask.h"
+#include "systemtask/TimerService.h"
+#include "systemtask/MessageBus.h"
+#include "profiling/Profiler.h"
+#include "memory/Heap.h"
 
 using namespace Pinetime::Applications::Screens;
 
@@ -27,6 +35,18 @@ namespace {
     }
     return "???";
   }
+
+  const char* ToString(Pinetime::Drivers::Bma421::PowerModes powerMode) {
+    switch (powerMode) {
+      case Pinetime::Drivers::Bma421::PowerModes::LowPower:
+        return "low";
+      case Pinetime::Drivers::Bma421::PowerModes::Normal:
+        return "norm";
+      case Pinetime::Drivers::Bma421::PowerModes::Performance:
+        return "perf";
+    }
+    return "???";
+  }
 }
 
 SystemInfo::SystemInfo(Pinetime::Applications::DisplayApp* app,
@@ -36,7 +56,10 @@ SystemInfo::SystemInfo(Pinetime::Applications::DisplayApp* app,
                        Pinetime::Controllers::Ble& bleController,
                        Pinetime::Drivers::WatchdogView& watchdog,
                        Pinetime::Controllers::MotionController& motionController,
-                       Pinetime::Drivers::Cst816S& touchPanel)
+                       Pinetime::Drivers::Cst816S& touchPanel,
+                       Pinetime::Drivers::TwiMaster& twiMaster,
+                       Pinetime::Controllers::TouchHandler& touchHandler,
+                       Pinetime::System::SystemTask& systemTask)
   : Screen(app),
     dateTimeController {dateTimeController},
     batteryController {batteryController},
@@ -45,6 +68,9 @@ SystemInfo::SystemInfo(Pinetime::Applications::DisplayApp* app,
     watchdog {watchdog},
     motionController {motionController},
     touchPanel {touchPanel},
+    twiMaster {twiMaster},
+    touchHandler {touchHandler},
+    systemTask {systemTask},
     screens {app,
              0,
              {[this]() -> std::unique_ptr<Screen> {
@@ -61,6 +87,24 @@ SystemInfo::SystemInfo(Pinetime::Applications::DisplayApp* app,
               },
               [this]() -> std::unique_ptr<Screen> {
                 return CreateScreen5();
+              },
+              [this]() -> std::unique_ptr<Screen> {
+                return CreateScreen6();
+              },
+              [this]() -> std::unique_ptr<Screen> {
+                return CreateScreen7();
+              },
+              [this]() -> std::unique_ptr<Screen> {
+                return CreateScreen8();
+              },
+              [this]() -> std::unique_ptr<Screen> {
+                return CreateScreen9();
+              },
+              [this]() -> std::unique_ptr<Screen> {
+                return CreateScreen10();
+              },
+              [this]() -> std::unique_ptr<Screen> {
+                return CreateScreen11();
               }},
              Screens::ScreenListModes::UpDown} {
 }
@@ -93,7 +137,7 @@ std::unique_ptr<Screen> SystemInfo::CreateScreen1() {
                         BootloaderVersion::VersionString());
   lv_label_set_align(label, LV_LABEL_ALIGN_CENTER);
   lv_obj_align(label, lv_scr_act(), LV_ALIGN_CENTER, 0, 0);
-  return std::make_unique<Screens::Label>(0, 5, app, label);
+  return std::make_unique<Screens::Label>(0, 11, app, label);
 }
 
 std::unique_ptr<Screen> SystemInfo::CreateScreen2() {
@@ -145,8 +189,9 @@ std::unique_ptr<Screen> SystemInfo::CreateScreen2() {
                         "#808080 Battery# %d%%/%03imV\n"
                         "#808080 Backlight# %s\n"
                         "#808080 Last reset# %s\n"
-                        "#808080 Accel.# %s\n"
-                        "#808080 Touch.# %x.%x.%x\n",
+                        "#808080 Accel.# %s %s %luus\n"
+                        "#808080 Touch.# %x.%x.%x\n"
+                        "#808080 Wakeups/h# %lu (%lu)\n",
                         dateTimeController.Day(),
                         static_cast<uint8_t>(dateTimeController.Month()),
                         dateTimeController.Year(),
@@ -162,16 +207,24 @@ std::unique_ptr<Screen> SystemInfo::CreateScreen2() {
                         brightnessController.ToString(),
                         resetReason,
                         ToString(motionController.DeviceType()),
+                        ToString(motionController.PowerMode()),
+                        motionController.BusTime(),
                         touchPanel.GetChipId(),
                         touchPanel.GetVendorId(),
-                        touchPanel.GetFwVersion());
+                        touchPanel.GetFwVersion(),
+                        systemTask.GetWakeupStatistics().lastHour,
+                        systemTask.GetWakeupStatistics().currentHour);
   lv_obj_align(label, lv_scr_act(), LV_ALIGN_CENTER, 0, 0);
-  return std::make_unique<Screens::Label>(1, 5, app, label);
+  return std::make_unique<Screens::Label>(1, 11, app, label);
 }
 
 std::unique_ptr<Screen> SystemInfo::CreateScreen3() {
-  lv_mem_monitor_t mon;
-  lv_mem_monitor(&mon);
+  using Pinetime::Memory::Heap;
+  using Pinetime::Memory::Owners;
+  const auto heap = Heap::GetStatistics();
+  const auto kernel = Heap::GetOwnerStatistics(Owners::Kernel);
+  const auto lvgl = Heap::GetOwnerStatistics(Owners::Lvgl);
+  const auto libc = Heap::GetOwnerStatistics(Owners::Libc);
 
   lv_obj_t* label = lv_label_create(lv_scr_act(), nullptr);
   lv_label_set_recolor(label, true);
@@ -180,24 +233,29 @@ std::unique_ptr<Screen> SystemInfo::CreateScreen3() {
                         "#808080 BLE MAC#\n"
                         " %02x:%02x:%02x:%02x:%02x:%02x"
                         "\n"
-                        "#808080 LVGL Memory#\n"
-                        " #808080 used# %d (%d%%)\n"
-                        " #808080 max used# %lu\n"
+                        "#808080 Heap#\n"
+                        " #808080 free# %lu (min %lu)\n"
+                        " #808080 largest# %lu\n"
                         " #808080 frag# %d%%\n"
-                        " #808080 free# %d",
+                        " #808080 kernel# %lu\n"
+                        " #808080 lvgl# %lu (max %lu)\n"
+                        " #808080 libc# %lu",
                         bleAddr[5],
                         bleAddr[4],
                         bleAddr[3],
                         bleAddr[2],
                         bleAddr[1],
                         bleAddr[0],
-                        static_cast<int>(mon.total_size - mon.free_size),
-                        mon.used_pct,
-                        mon.max_used,
-                        mon.frag_pct,
-                        static_cast<int>(mon.free_biggest_size));
+                        heap.freeBytes,
+                        heap.minimumFreeBytes,
+                        heap.largestFreeBlock,
+                        heap.fragmentationPercent,
+                        kernel.usedBytes,
+                        lvgl.usedBytes,
+                        lvgl.peakBytes,
+                        libc.usedBytes);
   lv_obj_align(label, lv_scr_act(), LV_ALIGN_CENTER, 0, 0);
-  return std::make_unique<Screens::Label>(2, 5, app, label);
+  return std::make_unique<Screens::Label>(2, 11, app, label);
 }
 
 bool SystemInfo::sortById(const TaskStatus_t& lhs, const TaskStatus_t& rhs) {
@@ -258,10 +316,222 @@ std::unique_ptr<Screen> SystemInfo::CreateScreen4() {
     }
     lv_table_set_cell_value(infoTask, i + 1, 3, buffer);
   }
-  return std::make_unique<Screens::Label>(3, 5, app, infoTask);
+  return std::make_unique<Screens::Label>(3, 11, app, infoTask);
 }
 
 std::unique_ptr<Screen> SystemInfo::CreateScreen5() {
+  const auto& bus = twiMaster.GetStatistics();
+  const uint64_t uptimeUs = std::max<uint64_t>(1, static_cast<uint64_t>(dateTimeController.Uptime().count()) * 1000000);
+  const uint32_t cpuPerTransaction =
+    (bus.transactions > 0) ? Pinetime::Drivers::TwiMaster::CyclesToUs(bus.totalCpuCycles / bus.transactions) : 0;
+
+  char text[256];
+  int length = snprintf(text,
+                        sizeof(text),
+                        "#FFFF00 TWI bus#\n"
+                        "#808080 Util# %u.%u%%\n"
+                        "#808080 Wake/merged# %lu/%lu\n"
+                        "#808080 CPU/txn# %luus\n"
+                        "#808080 Fail/freeze# %lu/%lu\n"
+                        "#808080 Dev lat avg/max busy#",
+                        bus.utilisationPermille / 10,
+                        bus.utilisationPermille % 10,
+                        bus.wakeups,
+                        bus.mergedTransactions,
+                        cpuPerTransaction,
+                        bus.failures,
+                        bus.freezes);
+  for (uint8_t i = 0; i < twiMaster.NbDevices() && length > 0 && static_cast<size_t>(length) < sizeof(text); i++) {
+    const auto& device = twiMaster.GetDeviceStatistics(i);
+    const uint32_t averageLatency = (device.transactions > 0) ? device.totalLatencyUs / device.transactions : 0;
+    const uint32_t busyPermille = (device.busyTimeUs * 1000) / uptimeUs;
+    length += snprintf(text + length,
+                       sizeof(text) - length,
+                       "\n %s %lu/%luus %lu.%lu%%",
+                       device.name,
+                       averageLatency,
+                       device.maxLatencyUs,
+                       busyPermille / 10,
+                       busyPermille % 10);
+  }
+
+  lv_obj_t* label = lv_label_create(lv_scr_act(), nullptr);
+  lv_label_set_recolor(label, true);
+  lv_label_set_text(label, text);
+  lv_obj_align(label, lv_scr_act(), LV_ALIGN_CENTER, 0, 0);
+  return std::make_unique<Screens::Label>(4, 11, app, label);
+}
+
+std::unique_ptr<Screen> SystemInfo::CreateScreen6() {
+  const auto& touch = touchHandler.GetLatencyStatistics();
+  const uint32_t averageRead = (touch.samples > 0) ? touch.totalReadLatencyUs / touch.samples : 0;
+  const uint32_t averagePixel = (touch.frames > 0) ? touch.totalPixelLatencyUs / touch.frames : 0;
+
+  lv_obj_t* label = lv_label_create(lv_scr_act(), nullptr);
+  lv_label_set_recolor(label, true);
+  lv_label_set_text_fmt(label,
+                        "#FFFF00 Touch latency#\n\n"
+                        "#808080 Points# %lu\n"
+                        "#808080 Overruns# %lu\n"
+                        "#808080 Read avg/max#\n"
+                        " %lu/%luus\n"
+                        "#808080 Pixel avg/max#\n"
+                        " %lu/%luus\n"
+                        "#808080 Pixel last# %luus",
+                        touch.samples,
+                        touch.overruns,
+                        averageRead,
+                        touch.maxReadLatencyUs,
+                        averagePixel,
+                        touch.maxPixelLatencyUs,
+                        touch.lastPixelLatencyUs);
+  lv_obj_align(label, lv_scr_act(), LV_ALIGN_CENTER, 0, 0);
+  return std::make_unique<Screens::Label>(5, 11, app, label);
+}
+
+std::unique_ptr<Screen> SystemInfo::CreateScreen7() {
+  static constexpr uint8_t maxTimerCount = 7;
+  const Pinetime::System::Timer* timers[maxTimerCount];
+  uint8_t nbTimers = 0;
+  // Keep the timers that woke the CPU up the most often
+  for (auto* timer = Pinetime::System::TimerService::FirstRegistered(); timer != nullptr; timer = timer->NextRegistered()) {
+    if (nbTimers < maxTimerCount) {
+      timers[nbTimers++] = timer;
+    } else if (timer->Wakeups() > timers[maxTimerCount - 1]->Wakeups()) {
+      timers[maxTimerCount - 1] = timer;
+    } else {
+      continue;
+    }
+    std::sort(timers, timers + nbTimers, [](const Pinetime::System::Timer* lhs, const Pinetime::System::Timer* rhs) {
+      return lhs->Wakeups() > rhs->Wakeups();
+    });
+  }
+
+  const auto& service = Pinetime::System::TimerService::GetStatistics();
+  char text[256];
+  int length = snprintf(text,
+                        sizeof(text),
+                        "#FFFF00 Timers#\n"
+                        "#808080 Wake/merged# %lu/%lu\n"
+                        "#808080 Name wake/exp#",
+                        service.wakeups,
+                        service.coalesced);
+  for (uint8_t i = 0; i < nbTimers && length > 0 && static_cast<size_t>(length) < sizeof(text); i++) {
+    length += snprintf(
+      text + length, sizeof(text) - length, "\n %s %lu/%lu", timers[i]->Name(), timers[i]->Wakeups(), timers[i]->Expirations());
+  }
+
+  lv_obj_t* label = lv_label_create(lv_scr_act(), nullptr);
+  lv_label_set_recolor(label, true);
+  lv_label_set_text(label, text);
+  lv_obj_align(label, lv_scr_act(), LV_ALIGN_CENTER, 0, 0);
+  return std::make_unique<Screens::Label>(6, 11, app, label);
+}
+
+std::unique_ptr<Screen> SystemInfo::CreateScreen8() {
+  char text[256];
+  int length = snprintf(text, sizeof(text), "#FFFF00 Message queues#");
+  for (auto* bus = Pinetime::System::MessageBusBase::FirstRegistered();
+       bus != nullptr && length > 0 && static_cast<size_t>(length) < sizeof(text);
+       bus = bus->NextRegistered()) {
+    const auto& statistics = bus->GetStatistics();
+    length += snprintf(text + length,
+                       sizeof(text) - length,
+                       "\n#808080 %s#\n"
+                       " sent %lu merged %lu\n"
+                       " drop %lu peak %u/%u of %u",
+                       bus->Name(),
+                       statistics.sent,
+                       statistics.coalesced,
+                       statistics.dropped,
+                       statistics.highWater[0],
+                       statistics.highWater[1],
+                       bus->LaneSize());
+  }
+
+  lv_obj_t* label = lv_label_create(lv_scr_act(), nullptr);
+  lv_label_set_recolor(label, true);
+  lv_label_set_text(label, text);
+  lv_obj_align(label, lv_scr_act(), LV_ALIGN_CENTER, 0, 0);
+  return std::make_unique<Screens::Label>(7, 11, app, label);
+}
+
+std::unique_ptr<Screen> SystemInfo::CreateScreen9() {
+  static constexpr uint8_t maxTaskCount = 6;
+  const auto load = systemTask.GetCpuLoad();
+
+  char text[256];
+  int length = snprintf(text,
+                        sizeof(text),
+                        "#FFFF00 CPU# (last %lus)\n"
+                        "#808080 Awake# %u.%u%%\n"
+                        "#808080 Idle# %u.%u%%\n"
+                        "#808080 Tasks#",
+                        load.windowMs / 1000,
+                        (1000 - load.sleepPermille) / 10,
+                        (1000 - load.sleepPermille) % 10,
+                        load.idlePermille / 10,
+                        load.idlePermille % 10);
+  for (uint8_t i = 0; i < load.nbTasks && i < maxTaskCount && length > 0 && static_cast<size_t>(length) < sizeof(text); i++) {
+    length += snprintf(text + length,
+                       sizeof(text) - length,
+                       "\n %s %u.%u%%",
+                       load.tasks[i].name,
+                       load.tasks[i].permille / 10,
+                       load.tasks[i].permille % 10);
+  }
+
+  lv_obj_t* label = lv_label_create(lv_scr_act(), nullptr);
+  lv_label_set_recolor(label, true);
+  lv_label_set_text(label, text);
+  lv_obj_align(label, lv_scr_act(), LV_ALIGN_CENTER, 0, 0);
+  return std::make_unique<Screens::Label>(8, 11, app, label);
+}
+
+std::unique_ptr<Screen> SystemInfo::CreateScreen10() {
+  using Pinetime::Profiling::Profiler;
+  using Pinetime::Profiling::Zones;
+  static constexpr uint8_t maxZoneCount = 7;
+
+  char text[256];
+  int length;
+  if (!Profiler::enabled) {
+    length = snprintf(text, sizeof(text), "#FFFF00 Zones#\n\nNot built, see\nENABLE_PROFILING");
+  } else {
+    // The zones that took the most CPU time first (the full statistics would not fit in the stack)
+    Zones zones[Profiler::nbZones];
+    uint64_t totalCycles[Profiler::nbZones];
+    for (uint8_t i = 0; i < Profiler::nbZones; i++) {
+      zones[i] = static_cast<Zones>(i);
+      totalCycles[i] = Profiler::GetStatistics(zones[i]).totalCycles;
+    }
+    std::sort(zones, zones + Profiler::nbZones, [&totalCycles](Zones lhs, Zones rhs) {
+      return totalCycles[static_cast<uint8_t>(lhs)] > totalCycles[static_cast<uint8_t>(rhs)];
+    });
+
+    length = snprintf(text, sizeof(text), "#FFFF00 Zones# avg/max us");
+    for (uint8_t i = 0; i < maxZoneCount && length > 0 && static_cast<size_t>(length) < sizeof(text); i++) {
+      const auto zone = Profiler::GetStatistics(zones[i]);
+      if (zone.count == 0) {
+        break;
+      }
+      length += snprintf(text + length,
+                         sizeof(text) - length,
+                         "\n#808080 %s# %lu/%lu",
+                         Profiler::Name(zones[i]),
+                         static_cast<uint32_t>(zone.totalCycles / zone.count / Profiler::cyclesPerUs),
+                         zone.maxCycles / Profiler::cyclesPerUs);
+    }
+  }
+
+  lv_obj_t* label = lv_label_create(lv_scr_act(), nullptr);
+  lv_label_set_recolor(label, true);
+  lv_label_set_text(label, text);
+  lv_obj_align(label, lv_scr_act(), LV_ALIGN_CENTER, 0, 0);
+  return std::make_unique<Screens::Label>(9, 11, app, label);
+}
+
+std::unique_ptr<Screen> SystemInfo::CreateScreen11() {
   lv_obj_t* label = lv_label_create(lv_scr_act(), nullptr);
   lv_label_set_recolor(label, true);
   lv_label_set_text_static(label,
@@ -275,5 +545,5 @@ std::unique_ptr<Screen> SystemInfo::CreateScreen5() {
                            "#FFFF00 InfiniTime#");
   lv_label_set_align(label, LV_LABEL_ALIGN_CENTER);
   lv_obj_align(label, lv_scr_act(), LV_ALIGN_CENTER, 0, 0);
-  return std::make_unique<Screens::Label>(4, 5, app, label);
+  return std::make_unique<Screens::Label>(10, 11, app, label);
 }
@@ -10,10 +10,16 @@ namespace Pinetime {
     class Battery;
     class BrightnessController;
     class Ble;
+    class TouchHandler;
+  }
+
+  namespace System {
+    class SystemTask;
   }
 
   namespace Drivers {
     class WatchdogView;
+    class TwiMaster;
   }
 
   namespace Applications {
@@ -29,7 +35,10 @@ namespace Pinetime {
                             Pinetime::Controllers::Ble& bleController,
                             Pinetime::Drivers::WatchdogView& watchdog,
                             Pinetime::Controllers::MotionController& motionController,
-                            Pinetime::Drivers::Cst816S& touchPanel);
+                            Pinetime::Drivers::Cst816S& touchPanel,
+                            Pinetime::Drivers::TwiMaster& twiMaster,
+                            Pinetime::Controllers::TouchHandler& touchHandler,
+                            Pinetime::System::SystemTask& systemTask);
         ~SystemInfo() override;
         bool OnTouchEvent(TouchEvents event) override;
 
@@ -41,8 +50,11 @@ namespace Pinetime {
         Pinetime::Drivers::WatchdogView& watchdog;
         Pinetime::Controllers::MotionController& motionController;
         Pinetime::Drivers::Cst816S& touchPanel;
+        Pinetime::Drivers::TwiMaster& twiMaster;
+        Pinetime::Controllers::TouchHandler& touchHandler;
+        Pinetime::System::SystemTask& systemTask;
 
-        ScreenList<5> screens;
+        ScreenList<11> screens;
 
         static bool sortById(const TaskStatus_t& lhs, const TaskStatus_t& rhs);
 
@@ -51,6 +63,12 @@ namespace Pinetime {
         std::unique_ptr<Screen> CreateScreen3();
         std::unique_ptr<Screen> CreateScreen4();
         std::unique_ptr<Screen> CreateScreen5();
+        std::unique_ptr<Screen> CreateScreen6();
+        std::unique_ptr<Screen> CreateScreen7();
+        std::unique_ptr<Screen> CreateScreen8();
+        std::unique_ptr<Screen> CreateScreen9();
+        std::unique_ptr<Screen> CreateScreen10();
+        std::unique_ptr<Screen> CreateScreen11();
       };
     }
   }
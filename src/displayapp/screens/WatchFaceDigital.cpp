@@ -32,6 +32,7 @@ WatchFaceDigital::WatchFaceDigital(DisplayApp* app,
     settingsController {settingsController},
     heartRateController {heartRateController},
     motionController {motionController} {
+  motionController.SubscribeStepCount();
 
   batteryIcon.Create(lv_scr_act());
   lv_obj_align(batteryIcon.GetObject(), lv_scr_act(), LV_ALIGN_IN_TOP_RIGHT, 0, 0);
@@ -96,6 +97,7 @@ WatchFaceDigital::WatchFaceDigital(DisplayApp* app,
 }
 
 WatchFaceDigital::~WatchFaceDigital() {
+  motionController.UnsubscribeStepCount();
   lv_task_del(taskRefresh);
   lv_obj_clean(lv_scr_act());
 }
@@ -66,6 +66,7 @@ WatchFacePineTimeStyle::WatchFacePineTimeStyle(DisplayApp* app,
     notificatioManager {notificatioManager},
     settingsController {settingsController},
     motionController {motionController} {
+  motionController.SubscribeStepCount();
 
   // Create a 200px wide background rectangle
   timebar = lv_obj_create(lv_scr_act(), nullptr);
@@ -304,6 +305,7 @@ WatchFacePineTimeStyle::WatchFacePineTimeStyle(DisplayApp* app,
 }
 
 WatchFacePineTimeStyle::~WatchFacePineTimeStyle() {
+  motionController.UnsubscribeStepCount();
   lv_task_del(taskRefresh);
   lv_obj_clean(lv_scr_act());
 }
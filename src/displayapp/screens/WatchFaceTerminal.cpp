@@ -30,6 +30,7 @@ WatchFaceTerminal::WatchFaceTerminal(DisplayApp* app,
     settingsController {settingsController},
     heartRateController {heartRateController},
     motionController {motionController} {
+  motionController.SubscribeStepCount();
   settingsController.SetClockFace(3);
 
   batteryValue = lv_label_create(lv_scr_act(), nullptr);
@@ -79,6 +80,7 @@ WatchFaceTerminal::WatchFaceTerminal(DisplayApp* app,
 }
 
 WatchFaceTerminal::~WatchFaceTerminal() {
+  motionController.UnsubscribeStepCount();
   lv_task_del(taskRefresh);
   lv_obj_clean(lv_scr_act());
 }
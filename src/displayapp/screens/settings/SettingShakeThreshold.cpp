@@ -18,6 +18,7 @@ SettingShakeThreshold::SettingShakeThreshold(DisplayApp* app,
                                              Controllers::MotionController& motionController,
                                              System::SystemTask& systemTask)
   : Screen(app), settingsController {settingsController}, motionController {motionController}, systemTask {systemTask} {
+  motionController.RequestPerformanceMode();
 
   lv_obj_t* title = lv_label_create(lv_scr_act(), nullptr);
   lv_label_set_text_static(title, "Wake Sensitivity");
@@ -72,6 +73,7 @@ SettingShakeThreshold::SettingShakeThreshold(DisplayApp* app,
 }
 
 SettingShakeThreshold::~SettingShakeThreshold() {
+  motionController.ReleasePerformanceMode();
   settingsController.SetShakeThreshold(lv_arc_get_value(positionArc));
 
   if(EnableForCal){
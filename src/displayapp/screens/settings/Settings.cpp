@@ -74,7 +74,7 @@ std::unique_ptr<Screen> Settings::CreateScreen4() {
 
   std::array<Screens::List::Applications, 4> applications {{
     {Symbols::list, "About", Apps::SysInfo},
-    {Symbols::none, "None", Apps::None},
+    {Symbols::heartBeat, "Heart rate", Apps::SettingHeartRate},
     {Symbols::none, "None", Apps::None},
     {Symbols::none, "None", Apps::None}
   }};
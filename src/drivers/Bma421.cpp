@@ -1,11 +1,18 @@
 #include "drivers/Bma421.h"
+#include <utility>
 #include <libraries/delay/nrf_delay.h>
 #include <libraries/log/nrf_log.h>
 #include "drivers/TwiMaster.h"
+#include "drivers/RtcCounter.h"
+#include "profiling/Profiler.h"
 #include <drivers/Bma421_C/bma423.h>
+#include <task.h>
 
 using namespace Pinetime::Drivers;
 
+constexpr uint8_t Bma421::defaultFifoDownsampling;
+constexpr uint8_t Bma421::maxFifoDownsampling;
+
 namespace {
   int8_t user_i2c_read(uint8_t reg_addr, uint8_t* reg_data, uint32_t length, void* intf_ptr) {
     auto bma421 = static_cast<Bma421*>(intf_ptr);
@@ -19,12 +26,17 @@ namespace {
     return 0;
   }
 
+  void fifo_read(uint8_t registerAddress, uint8_t* buffer, size_t size, void* context) {
+    static_cast<Bma421*>(context)->Read(registerAddress, buffer, size);
+  }
+
   void user_delay(uint32_t period_us, void* intf_ptr) {
     nrf_delay_us(period_us);
   }
 }
 
-Bma421::Bma421(TwiMaster& twiMaster, uint8_t twiAddress) : twiMaster {twiMaster}, deviceAddress {twiAddress} {
+Bma421::Bma421(TwiMaster& twiMaster, uint8_t twiAddress)
+  : twiMaster {twiMaster}, deviceAddress {twiAddress}, fifo {fifo_read, this} {
   bma.intf = BMA4_I2C_INTF;
   bma.bus_read = user_i2c_read;
   bma.bus_write = user_i2c_write;
@@ -35,6 +47,7 @@ Bma421::Bma421(TwiMaster& twiMaster, uint8_t twiAddress) : twiMaster {twiMaster}
 }
 
 void Bma421::Init() {
+  twiMaster.RegisterDevice(deviceAddress, TwiMaster::Priorities::Normal, "accel");
   if (not isResetOk)
     return; // Call SoftReset (and reset TWI device) first!
 
@@ -68,16 +81,162 @@ void Bma421::Init() {
   if (ret != BMA4_OK)
     return;
 
+  if (!ApplyAccelConfig())
+    return;
+
+  isOk = true;
+  isFifoOk = InitFifo();
+  NRF_LOG_INFO("[Bma421] FIFO %s", isFifoOk ? "enabled" : "not available, polling");
+  isWakeUpFeaturesOk = isFifoOk && InitWakeUpFeatures();
+  NRF_LOG_INFO("[Bma421] Wake-up features %s", isWakeUpFeaturesOk ? "enabled" : "not available");
+}
+
+bool Bma421::InitFifo() {
+  // Headerless mode, accelerometer only : 6 bytes per frame
+  if (bma4_set_fifo_config(BMA4_FIFO_ACCEL, 1, &bma) != BMA4_OK)
+    return false;
+  if (bma4_set_fifo_config(BMA4_FIFO_HEADER, 0, &bma) != BMA4_OK)
+    return false;
+
+  // Downsampling is only available on filtered data
+  if (bma4_set_accel_fifo_filter_data(1, &bma) != BMA4_OK)
+    return false;
+  if (bma4_set_fifo_down_accel(fifoDownsampling - std::min(fifoDownsampling, OdrShift()), &bma) != BMA4_OK)
+    return false;
+
+  struct bma4_int_pin_config pinConfig;
+  pinConfig.edge_ctrl = BMA4_LEVEL_TRIGGER;
+  pinConfig.lvl = BMA4_ACTIVE_HIGH;
+  pinConfig.od = BMA4_PUSH_PULL;
+  pinConfig.output_en = BMA4_OUTPUT_ENABLE;
+  pinConfig.input_en = BMA4_INPUT_DISABLE;
+  if (bma4_set_int_pin_config(&pinConfig, BMA4_INTR1_MAP, &bma) != BMA4_OK)
+    return false;
+
+  // The FIFO is enabled by SetFifoWatermark()
+  return bma4_set_fifo_config(BMA4_FIFO_ACCEL, 0, &bma) == BMA4_OK;
+}
+
+/// Wrist tilt and any-motion detection run in the feature engine of the sensor, so that the MCU does not need to
+/// process any sample while the watch is sleeping. Some BMA421 parts do not report a feature configuration : the
+/// software detectors of MotionController are used for them.
+bool Bma421::InitWakeUpFeatures() {
+  uint16_t configMajor = 0;
+  uint16_t configMinor = 0;
+  if (bma423_get_version_config(&configMajor, &configMinor, &bma) != BMA4_OK || configMajor == 0)
+    return false;
+
+  if (bma423_feature_enable(BMA423_WRIST_WEAR, 1, &bma) != BMA4_OK)
+    return false;
+
+  // The any-motion detector is only enabled (all axes) when its interrupt is needed
+  struct bma423_any_no_mot_config anyMotion;
+  anyMotion.duration = anyMotionDuration;
+  anyMotion.threshold = anyMotionThreshold;
+  anyMotion.axes_en = BMA423_DIS_ALL_AXIS;
+  return bma423_set_any_mot_config(&anyMotion, &bma) == BMA4_OK;
+}
+
+void Bma421::SetFifoWatermark(uint8_t nbSamples) {
+  if (not isFifoOk or nbSamples == fifoWatermark)
+    return;
+
+  if (nbSamples == 0) {
+    // Nobody reads the samples : stop storing them
+    bma4_set_fifo_config(BMA4_FIFO_ACCEL, 0, &bma);
+  } else {
+    bma4_set_fifo_wm(nbSamples * Bma421Fifo::frameSize, &bma);
+    if (fifoWatermark == 0) {
+      // Discard the samples from the last time the FIFO was enabled
+      FlushFifo();
+      bma4_set_fifo_config(BMA4_FIFO_ACCEL, 1, &bma);
+    }
+  }
+  fifoWatermark = nbSamples;
+  UpdateInterruptMapping();
+}
+
+void Bma421::SetFifoDownsampling(uint8_t downsampling) {
+  if (downsampling > maxFifoDownsampling)
+    downsampling = maxFifoDownsampling;
+  if (not isFifoOk or downsampling == fifoDownsampling)
+    return;
+
+  fifoDownsampling = downsampling;
+  bma4_set_fifo_down_accel(fifoDownsampling - std::min(fifoDownsampling, OdrShift()), &bma);
+  // The timestamps of the samples are computed from the rate : the samples stored at the previous rate are dropped
+  if (fifoWatermark != 0) {
+    FlushFifo();
+  }
+}
+
+bool Bma421::ApplyAccelConfig() {
   struct bma4_accel_config accel_conf;
-  accel_conf.odr = BMA4_OUTPUT_DATA_RATE_100HZ;
   accel_conf.range = BMA4_ACCEL_RANGE_2G;
-  accel_conf.bandwidth = BMA4_ACCEL_NORMAL_AVG4;
-  accel_conf.perf_mode = BMA4_CIC_AVG_MODE;
-  ret = bma4_set_accel_config(&accel_conf, &bma);
-  if (ret != BMA4_OK)
+  switch (powerMode) {
+    case PowerModes::LowPower:
+      accel_conf.odr = BMA4_OUTPUT_DATA_RATE_50HZ;
+      accel_conf.bandwidth = BMA4_ACCEL_OSR2_AVG2;
+      accel_conf.perf_mode = BMA4_CIC_AVG_MODE;
+      break;
+    case PowerModes::Normal:
+      accel_conf.odr = BMA4_OUTPUT_DATA_RATE_100HZ;
+      accel_conf.bandwidth = BMA4_ACCEL_NORMAL_AVG4;
+      accel_conf.perf_mode = BMA4_CIC_AVG_MODE;
+      break;
+    case PowerModes::Performance:
+      accel_conf.odr = BMA4_OUTPUT_DATA_RATE_100HZ;
+      accel_conf.bandwidth = BMA4_ACCEL_NORMAL_AVG4;
+      accel_conf.perf_mode = BMA4_CONTINUOUS_MODE;
+      break;
+  }
+  return bma4_set_accel_config(&accel_conf, &bma) == BMA4_OK;
+}
+
+/// The FIFO rate is kept : its downsampling is adjusted to the new output data rate
+void Bma421::SetPowerMode(PowerModes mode) {
+  if (not isOk or mode == powerMode)
     return;
 
-  isOk = true;
+  auto previousPeriod = FifoSamplePeriodMs();
+  powerMode = mode;
+  ApplyAccelConfig();
+  if (isFifoOk) {
+    bma4_set_fifo_down_accel(fifoDownsampling - std::min(fifoDownsampling, OdrShift()), &bma);
+    if (fifoWatermark != 0 && FifoSamplePeriodMs() != previousPeriod) {
+      FlushFifo();
+    }
+  }
+}
+
+void Bma421::FlushFifo() {
+  uint8_t data = 0xb0;
+  Write(BMA4_CMD_ADDR, &data, 1);
+}
+
+void Bma421::SetWakeUpInterrupts(bool wristTilt, bool anyMotion) {
+  if (not isWakeUpFeaturesOk or (wristTilt == wristTiltInterrupt and anyMotion == anyMotionInterrupt))
+    return;
+
+  if (anyMotion != anyMotionInterrupt) {
+    struct bma423_any_no_mot_config config;
+    config.duration = anyMotionDuration;
+    config.threshold = anyMotionThreshold;
+    config.axes_en = anyMotion ? BMA423_EN_ALL_AXIS : BMA423_DIS_ALL_AXIS;
+    bma423_set_any_mot_config(&config, &bma);
+  }
+  wristTiltInterrupt = wristTilt;
+  anyMotionInterrupt = anyMotion;
+  UpdateInterruptMapping();
+}
+
+/// bma4_map_interrupt() overwrites the feature mapping when it maps a hardware interrupt (and vice versa) : both
+/// registers are written from the current configuration instead.
+void Bma421::UpdateInterruptMapping() {
+  uint8_t featureMap = (wristTiltInterrupt ? BMA423_WRIST_WEAR_INT : 0) | (anyMotionInterrupt ? BMA423_ANY_MOT_INT : 0);
+  uint8_t hardwareMap = (fifoWatermark != 0) ? static_cast<uint8_t>(BMA4_FIFO_WM_INT >> 8) : 0;
+  Write(BMA4_INT_MAP_1_ADDR, &featureMap, 1);
+  Write(BMA4_INT_MAP_DATA_ADDR, &hardwareMap, 1);
 }
 
 void Bma421::Reset() {
@@ -93,25 +252,136 @@ void Bma421::Write(uint8_t registerAddress, const uint8_t* data, size_t size) {
   twiMaster.Write(deviceAddress, registerAddress, data, size);
 }
 
-Bma421::Values Bma421::Process() {
+namespace {
+  struct Field {
+    Bma421::Fields field;
+    uint8_t firstRegister;
+    uint8_t size;
+  };
+
+  // Sorted by register address
+  constexpr Field fields[] = {
+    {Bma421::Fields::Acceleration, BMA4_DATA_8_ADDR, 6},
+    {Bma421::Fields::Steps, BMA4_STEP_CNT_OUT_0_ADDR, 4},
+    {Bma421::Fields::Temperature, BMA4_TEMPERATURE_ADDR, 1},
+    {Bma421::Fields::Activity, BMA4_ACTIVITY_OUT_ADDR, 1},
+  };
+
+  // Reading a few unused registers costs less than the addressing phase (START, address, register, repeated
+  // START, address) of another transaction
+  constexpr uint8_t maxMergedGap = 3;
+
+  bool IsSet(uint8_t mask, Bma421::Fields field) {
+    return (mask & static_cast<uint8_t>(field)) != 0;
+  }
+
+  uint32_t ElapsedUs(uint32_t startTimestamp) {
+    return Pinetime::Drivers::RtcCounter::ToUs(Pinetime::Drivers::RtcCounter::Now() - startTimestamp);
+  }
+}
+
+/// Reads the requested fields, merging the fields whose registers are close into a single burst
+void Bma421::ReadFields(uint8_t requested) {
+  uint8_t buffer[BMA4_ACTIVITY_OUT_ADDR - BMA4_STEP_CNT_OUT_0_ADDR + 1];
+  size_t first = 0;
+  constexpr size_t nbFields = sizeof(fields) / sizeof(fields[0]);
+
+  while (first < nbFields) {
+    if (!IsSet(requested, fields[first].field)) {
+      first++;
+      continue;
+    }
+
+    // Extend the burst to the next requested fields
+    size_t last = first;
+    for (size_t next = first + 1; next < nbFields; next++) {
+      if (!IsSet(requested, fields[next].field))
+        continue;
+      auto end = fields[last].firstRegister + fields[last].size;
+      if (fields[next].firstRegister - end > maxMergedGap ||
+          static_cast<size_t>(fields[next].firstRegister + fields[next].size - fields[first].firstRegister) > sizeof(buffer))
+        break;
+      last = next;
+    }
+
+    auto burstStart = fields[first].firstRegister;
+    Read(burstStart, buffer, fields[last].firstRegister + fields[last].size - burstStart);
+    auto now = xTaskGetTickCount();
+
+    for (size_t i = first; i <= last; i++) {
+      if (!IsSet(requested, fields[i].field))
+        continue;
+      const uint8_t* data = buffer + (fields[i].firstRegister - burstStart);
+      switch (fields[i].field) {
+        case Fields::Acceleration:
+          // X and Y axis are swapped because of the way the sensor is mounted in the PineTime
+          // 12 bits data, left aligned (same conversion as bma4_read_accel_xyz())
+          values.y = static_cast<int16_t>((data[1] << 8) | data[0]) / 0x10;
+          values.x = static_cast<int16_t>((data[3] << 8) | data[2]) / 0x10;
+          values.z = static_cast<int16_t>((data[5] << 8) | data[4]) / 0x10;
+          values.accelerationTimestamp = now;
+          break;
+        case Fields::Steps:
+          values.steps = data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+          values.stepsTimestamp = now;
+          break;
+        case Fields::Temperature:
+          // 0 = 23degC
+          values.temperature = static_cast<int8_t>(static_cast<int8_t>(data[0]) + 23);
+          values.temperatureTimestamp = now;
+          break;
+        case Fields::Activity:
+          values.activity = data[0];
+          values.activityTimestamp = now;
+          break;
+      }
+    }
+    first = last + 1;
+  }
+}
+
+const Bma421::Values& Bma421::Process() {
+  Pinetime::Profiling::Zone zone(Pinetime::Profiling::Zones::MotionProcess);
   if (not isOk)
-    return {};
-  struct bma4_accel data;
-  bma4_read_accel_xyz(&data, &bma);
+    return values;
 
-  uint32_t steps = 0;
-  bma423_step_counter_output(&steps, &bma);
+  TwiMaster::Session session {twiMaster};
+  auto startTimestamp = RtcCounter::Now();
+  ReadFields(subscriptions);
+  busTime = ElapsedUs(startTimestamp);
+  return values;
+}
 
-  int32_t temperature;
-  bma4_get_temperature(&temperature, BMA4_DEG, &bma);
-  temperature = temperature / 1000;
+Bma421::InterruptData Bma421::ProcessInterrupt() {
+  // Same zone as Process() : the FIFO drain replaces the polling when the FIFO is available
+  Pinetime::Profiling::Zone zone(Pinetime::Profiling::Zones::MotionProcess);
+  if (not isFifoOk)
+    return {nullptr, 0, false, false};
 
-  uint8_t activity = 0;
-  bma423_activity_output(&activity, &bma);
+  TwiMaster::Session session {twiMaster};
+  auto startTimestamp = RtcCounter::Now();
+  // Reading the status clears the latched interrupt
+  uint16_t status = 0;
+  bma423_read_int_status(&status, &bma);
 
-  // X and Y axis are swapped because of the way the sensor is mounted in the PineTime
-  return {steps, data.y, data.x, data.z};
+  size_t nbSamples = (fifoWatermark != 0) ? fifo.Drain() : 0;
+  auto* samples = fifo.Samples();
+  for (size_t i = 0; i < nbSamples; i++) {
+    // X and Y axis are swapped because of the way the sensor is mounted in the PineTime
+    std::swap(samples[i].x, samples[i].y);
+  }
+
+  ReadFields(subscriptions & ~static_cast<uint8_t>(Fields::Acceleration));
+  if (nbSamples > 0) {
+    values.x = samples[nbSamples - 1].x;
+    values.y = samples[nbSamples - 1].y;
+    values.z = samples[nbSamples - 1].z;
+    values.accelerationTimestamp = xTaskGetTickCount();
+  }
+  busTime = ElapsedUs(startTimestamp);
+  return {samples, nbSamples, (status & BMA423_WRIST_WEAR_INT) != 0, (status & BMA423_ANY_MOT_INT) != 0};
 }
+
 bool Bma421::IsOk() const {
   return isOk;
 }
@@ -1,5 +1,8 @@
 #pragma once
+#include <algorithm>
+#include <FreeRTOS.h>
 #include <drivers/Bma421_C/bma4_defs.h>
+#include "drivers/Bma421Fifo.h"
 
 namespace Pinetime {
   namespace Drivers {
@@ -11,12 +14,38 @@ namespace Pinetime {
         BMA421,
         BMA425
       };
+      /// LowPower : 50Hz (the minimum for the feature engine), averaging of 2 samples
+      /// Normal : 100Hz, averaging of 4 samples
+      /// Performance : 100Hz, continuous filtering (lowest noise)
+      enum class PowerModes : uint8_t { LowPower, Normal, Performance };
+      /// Fields that can be read from the sensor. Combine them into a subscription mask.
+      enum class Fields : uint8_t { Acceleration = 0x01, Steps = 0x02, Temperature = 0x04, Activity = 0x08 };
+      /// Last values read from the sensor, with the time (in ticks) at which each of them was read
       struct Values {
-        uint32_t steps;
-        int16_t x;
-        int16_t y;
-        int16_t z;
+        uint32_t steps = 0;
+        int16_t x = 0;
+        int16_t y = 0;
+        int16_t z = 0;
+        int8_t temperature = 0; // degC
+        uint8_t activity = 0;
+        TickType_t accelerationTimestamp = 0;
+        TickType_t stepsTimestamp = 0;
+        TickType_t temperatureTimestamp = 0;
+        TickType_t activityTimestamp = 0;
       };
+      /// Data read when the interrupt pin is asserted : samples read from the FIFO (the last one being the most
+      /// recent) and feature engine events
+      struct InterruptData {
+        const Bma421Fifo::Sample* samples;
+        size_t nbSamples;
+        bool wristTilt;
+        bool anyMotion;
+      };
+      /// The rate of the FIFO is 100Hz / 2^downsampling, independently of the power mode (it is capped to the output
+      /// data rate of the sensor). The default downsampling (12.5Hz) is enough for the wake-up detectors.
+      static constexpr uint8_t defaultFifoDownsampling = 3;
+      static constexpr uint8_t maxFifoDownsampling = 7;
+
       Bma421(TwiMaster& twiMaster, uint8_t twiAddress);
       Bma421(const Bma421&) = delete;
       Bma421& operator=(const Bma421&) = delete;
@@ -27,7 +56,49 @@ namespace Pinetime {
       /// Init() method to allow the caller to uninit and then reinit the TWI device after the softreset.
       void SoftReset();
       void Init();
-      Values Process();
+      /// Sets the fields read by Process() and ProcessInterrupt() (combination of Fields)
+      void Subscribe(uint8_t fields) {
+        subscriptions = fields;
+      }
+      /// Reads the subscribed fields
+      const Values& Process();
+      /// Clears the (latched) interrupt, drains the FIFO and reads the subscribed fields (except the acceleration, which
+      /// is provided by the FIFO). Must be called when the interrupt pin is asserted.
+      InterruptData ProcessInterrupt();
+      const Values& LastValues() const {
+        return values;
+      }
+      /// Time spent on the bus by the last call to Process() or ProcessInterrupt(), in us
+      uint32_t BusTime() const {
+        return busTime;
+      }
+      /// True if the FIFO and its watermark interrupt are configured. If not, the sensor must be polled with Process().
+      bool IsFifoEnabled() const {
+        return isFifoOk;
+      }
+      /// Number of samples stored in the FIFO before the interrupt is asserted, 0 to disable the interrupt
+      void SetFifoWatermark(uint8_t nbSamples);
+      /// Sets the rate of the FIFO to 100Hz / 2^downsampling, the samples already in the FIFO are discarded
+      void SetFifoDownsampling(uint8_t downsampling);
+      uint8_t FifoDownsampling() const {
+        return fifoDownsampling;
+      }
+      uint32_t FifoSamplePeriodMs() const {
+        return 10 << std::max(fifoDownsampling, OdrShift());
+      }
+      void SetPowerMode(PowerModes mode);
+      PowerModes PowerMode() const {
+        return powerMode;
+      }
+      /// True if the feature engine provides the wrist tilt and any-motion interrupts
+      bool HasWakeUpFeatures() const {
+        return isWakeUpFeaturesOk;
+      }
+      /// Routes the wrist tilt and any-motion interrupts of the feature engine to the interrupt pin
+      void SetWakeUpInterrupts(bool wristTilt, bool anyMotion);
+      uint32_t DroppedSamples() const {
+        return fifo.DroppedSamples();
+      }
       void ResetStepCounter();
 
       void Read(uint8_t registerAddress, uint8_t* buffer, size_t size);
@@ -38,12 +109,36 @@ namespace Pinetime {
 
     private:
       void Reset();
+      bool InitFifo();
+      bool InitWakeUpFeatures();
+      void UpdateInterruptMapping();
+      void FlushFifo();
+      bool ApplyAccelConfig();
+      /// Output data rate of the sensor : 100Hz / 2^OdrShift()
+      uint8_t OdrShift() const {
+        return (powerMode == PowerModes::LowPower) ? 1 : 0;
+      }
+      void ReadFields(uint8_t fields);
 
       TwiMaster& twiMaster;
       uint8_t deviceAddress = 0x18;
       struct bma4_dev bma;
       bool isOk = false;
       bool isResetOk = false;
+      bool isFifoOk = false;
+      uint8_t fifoWatermark = 0;
+      uint8_t fifoDownsampling = defaultFifoDownsampling;
+      PowerModes powerMode = PowerModes::Normal;
+      bool isWakeUpFeaturesOk = false;
+      bool wristTiltInterrupt = false;
+      bool anyMotionInterrupt = false;
+      // Any-motion : slope above ~0.1g (5.11g format) for 4 samples at 50Hz
+      static constexpr uint16_t anyMotionThreshold = 205;
+      static constexpr uint16_t anyMotionDuration = 4;
+      Bma421Fifo fifo;
+      uint8_t subscriptions = static_cast<uint8_t>(Fields::Acceleration) | static_cast<uint8_t>(Fields::Steps);
+      Values values;
+      uint32_t busTime = 0;
       DeviceTypes deviceType = DeviceTypes::Unknown;
     };
   }
@@ -0,0 +1,56 @@
+#include "drivers/Bma421Fifo.h"
+#include <algorithm>
+
+using namespace Pinetime::Drivers;
+
+constexpr size_t Bma421Fifo::maxSamples;
+constexpr size_t Bma421Fifo::maxBurstFrames;
+
+namespace {
+  int16_t ToInt16(const uint8_t* data) {
+    return static_cast<int16_t>((data[1] << 8) | data[0]);
+  }
+}
+
+Bma421Fifo::Bma421Fifo(ReadFunction read, void* context) : read {read}, context {context} {
+}
+
+size_t Bma421Fifo::Drain() {
+  uint8_t length[2];
+  read(fifoLengthRegister, length, 2, context);
+  size_t nbFrames = (length[0] | ((length[1] & 0x3f) << 8)) / frameSize;
+
+  // The FIFO can only be read sequentially : the oldest frames that do not fit in the buffer are read and dropped
+  while (nbFrames > maxSamples) {
+    auto count = std::min(nbFrames - maxSamples, maxBurstFrames);
+    droppedSamples += ReadFrames(count, 0);
+    nbFrames -= count;
+  }
+  nbSamples = 0;
+  while (nbFrames > 0) {
+    auto count = std::min(nbFrames, maxBurstFrames);
+    auto nbDecoded = ReadFrames(count, nbSamples);
+    nbSamples += nbDecoded;
+    nbFrames -= count;
+    // An empty frame : the FIFO is empty
+    if (nbDecoded < count)
+      break;
+  }
+  return nbSamples;
+}
+
+size_t Bma421Fifo::ReadFrames(size_t nbFrames, size_t first) {
+  read(fifoDataRegister, buffer.data(), nbFrames * frameSize, context);
+
+  size_t count = 0;
+  for (size_t i = 0; i < nbFrames; i++) {
+    const auto* frame = buffer.data() + (i * frameSize);
+    if (static_cast<uint16_t>(ToInt16(frame)) == emptyFrame)
+      break;
+    // 12 bits data, left aligned (same conversion as bma4_read_accel_xyz())
+    samples[first + count++] = {static_cast<int16_t>(ToInt16(frame) / 0x10),
+                                static_cast<int16_t>(ToInt16(frame + 2) / 0x10),
+                                static_cast<int16_t>(ToInt16(frame + 4) / 0x10)};
+  }
+  return count;
+}
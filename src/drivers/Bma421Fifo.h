@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Pinetime {
+  namespace Drivers {
+    /// Drains the accelerometer FIFO of the BMA421/BMA425 (headerless mode, accelerometer data only, 12 bits).
+    /// The registers are accessed through a callback so that this logic does not depend on the TWI driver and can be
+    /// run against a register model.
+    class Bma421Fifo {
+    public:
+      struct Sample {
+        int16_t x;
+        int16_t y;
+        int16_t z;
+      };
+      using ReadFunction = void (*)(uint8_t registerAddress, uint8_t* buffer, size_t size, void* context);
+
+      static constexpr size_t frameSize = 6;
+      // ~0.5s of samples at the highest rate (100Hz) used for the streaming over BLE
+      static constexpr size_t maxSamples = 48;
+      // RXD.MAXCNT of the TWIM of the nRF52832 is 8 bits : a read transfers at most 255 bytes
+      static constexpr size_t maxBurstFrames = 255 / frameSize;
+
+      Bma421Fifo(ReadFunction read, void* context);
+
+      /// Reads all the complete frames currently stored in the FIFO, in bursts of at most maxBurstFrames frames.
+      /// If the FIFO contains more than maxSamples frames, only the most recent ones are kept.
+      /// Returns the number of samples available in Samples().
+      size_t Drain();
+
+      Sample* Samples() {
+        return samples.data();
+      }
+      size_t NbSamples() const {
+        return nbSamples;
+      }
+      /// Number of samples that were read but could not be kept since the start
+      uint32_t DroppedSamples() const {
+        return droppedSamples;
+      }
+
+    private:
+      static constexpr uint8_t fifoLengthRegister = 0x24;
+      static constexpr uint8_t fifoDataRegister = 0x26;
+      // Value of the X axis of an empty frame
+      static constexpr uint16_t emptyFrame = 0x8000;
+
+      /// Reads nbFrames frames and decodes them to Samples() from index first. Returns the number of frames decoded
+      /// before the first empty frame.
+      size_t ReadFrames(size_t nbFrames, size_t first);
+
+      ReadFunction read;
+      void* context;
+      std::array<uint8_t, maxBurstFrames * frameSize> buffer;
+      std::array<Sample, maxSamples> samples;
+      size_t nbSamples = 0;
+      uint32_t droppedSamples = 0;
+    };
+  }
+}
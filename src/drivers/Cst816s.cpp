@@ -19,6 +19,8 @@ Cst816S::Cst816S(TwiMaster& twiMaster, uint8_t twiAddress) : twiMaster {twiMaste
 }
 
 bool Cst816S::Init() {
+  // Touch reads preempt the other sensors so that the UI stays responsive
+  twiMaster.RegisterDevice(twiAddress, TwiMaster::Priorities::High, "touch");
   nrf_gpio_cfg_output(PinMap::Cst816sReset);
   nrf_gpio_pin_clear(PinMap::Cst816sReset);
   vTaskDelay(5);
@@ -20,6 +20,7 @@ Hrs3300::Hrs3300(TwiMaster& twiMaster, uint8_t twiAddress) : twiMaster {twiMaste
 }
 
 void Hrs3300::Init() {
+  twiMaster.RegisterDevice(twiAddress, TwiMaster::Priorities::Low, "hrs");
   nrf_gpio_cfg_input(30, NRF_GPIO_PIN_NOPULL);
 
   Disable();
@@ -55,6 +56,7 @@ void Hrs3300::Disable() {
 }
 
 uint32_t Hrs3300::ReadHrs() {
+  TwiMaster::Session session {twiMaster};
   auto m = ReadRegister(static_cast<uint8_t>(Registers::C0DataM));
   auto h = ReadRegister(static_cast<uint8_t>(Registers::C0DataH));
   auto l = ReadRegister(static_cast<uint8_t>(Registers::C0dataL));
@@ -62,6 +64,7 @@ uint32_t Hrs3300::ReadHrs() {
 }
 
 uint32_t Hrs3300::ReadAls() {
+  TwiMaster::Session session {twiMaster};
   auto m = ReadRegister(static_cast<uint8_t>(Registers::C1dataM));
   auto h = ReadRegister(static_cast<uint8_t>(Registers::C1dataH));
   auto l = ReadRegister(static_cast<uint8_t>(Registers::C1dataL));
@@ -69,16 +72,22 @@ uint32_t Hrs3300::ReadAls() {
 }
 
 void Hrs3300::SetGain(uint8_t gain) {
+  // HGAIN[4:2] : 0 = 1x, 1 = 2x, 2 = 4x, 3 = 8x, 4 = 64x
   constexpr uint8_t maxGain = 64U;
   gain = std::min(gain, maxGain);
   uint8_t hgain = 0;
-  while ((1 << hgain) < gain) {
-    ++hgain;
+  if (gain > 8) {
+    hgain = 4;
+  } else {
+    while ((1 << hgain) < gain) {
+      ++hgain;
+    }
   }
 
   WriteRegister(static_cast<uint8_t>(Registers::Hgain), hgain << 2);
 }
 
+/// drive : 0 = 12.5mA, 1 = 20mA, 2 = 30mA, 3 = 40mA
 void Hrs3300::SetDrive(uint8_t drive) {
   auto en = ReadRegister(static_cast<uint8_t>(Registers::Enable));
   auto pd = ReadRegister(static_cast<uint8_t>(Registers::PDriver));
@@ -0,0 +1,107 @@
+#include "drivers/RtcCounter.h"
+#include <nrfx.h>
+#include <hal/nrf_rtc.h>
+
+using namespace Pinetime::Drivers;
+
+volatile uint32_t RtcCounter::overflows = 0;
+volatile bool RtcCounter::alarmArmed = false;
+uint32_t RtcCounter::alarmDeadline = 0;
+RtcCounter::AlarmCallback RtcCounter::alarmCallback = nullptr;
+void* RtcCounter::alarmContext = nullptr;
+
+namespace {
+  constexpr uint32_t counterBits = 24;
+  constexpr uint32_t counterMask = (1UL << counterBits) - 1;
+  constexpr uint8_t interruptPriority = 7;
+  // The COMPARE event is not generated if CC is set to COUNTER or COUNTER + 1
+  constexpr uint32_t minCompareDistance = 2;
+}
+
+void RtcCounter::Init() {
+  nrf_rtc_task_trigger(NRF_RTC2, NRF_RTC_TASK_STOP);
+  nrf_rtc_prescaler_set(NRF_RTC2, 0);
+  nrf_rtc_event_clear(NRF_RTC2, NRF_RTC_EVENT_OVERFLOW);
+  nrf_rtc_int_enable(NRF_RTC2, NRF_RTC_INT_OVERFLOW_MASK);
+  NRFX_IRQ_PRIORITY_SET(RTC2_IRQn, interruptPriority);
+  NRFX_IRQ_ENABLE(RTC2_IRQn);
+  overflows = 0;
+  nrf_rtc_task_trigger(NRF_RTC2, NRF_RTC_TASK_CLEAR);
+  nrf_rtc_task_trigger(NRF_RTC2, NRF_RTC_TASK_START);
+}
+
+uint32_t RtcCounter::Now() {
+  return static_cast<uint32_t>(Now64());
+}
+
+uint64_t RtcCounter::Now64() {
+  uint64_t high;
+  uint32_t counter;
+  bool pendingOverflow;
+  do {
+    high = overflows;
+    counter = nrf_rtc_counter_get(NRF_RTC2);
+    pendingOverflow = nrf_rtc_event_pending(NRF_RTC2, NRF_RTC_EVENT_OVERFLOW);
+  } while (high != overflows);
+
+  // The counter wrapped, but the interrupt has not been serviced yet (called from a critical section or a higher
+  // priority interrupt)
+  if (pendingOverflow && counter < (counterMask / 2)) {
+    high++;
+  }
+  return (high << counterBits) | counter;
+}
+
+void RtcCounter::OnInterrupt() {
+  if (nrf_rtc_event_pending(NRF_RTC2, NRF_RTC_EVENT_OVERFLOW)) {
+    nrf_rtc_event_clear(NRF_RTC2, NRF_RTC_EVENT_OVERFLOW);
+    overflows = overflows + 1;
+  }
+
+  if (nrf_rtc_event_pending(NRF_RTC2, NRF_RTC_EVENT_COMPARE_0)) {
+    nrf_rtc_event_clear(NRF_RTC2, NRF_RTC_EVENT_COMPARE_0);
+    if (!alarmArmed) {
+      return;
+    }
+    // The comparator only sees the 24 low bits : deadlines further than that match early and are re-armed
+    if (static_cast<int32_t>(Now() - alarmDeadline) < 0) {
+      ArmCompare(alarmDeadline);
+      return;
+    }
+    alarmArmed = false;
+    nrf_rtc_int_disable(NRF_RTC2, NRF_RTC_INT_COMPARE0_MASK);
+    if (alarmCallback != nullptr) {
+      alarmCallback(alarmContext);
+    }
+  }
+}
+
+void RtcCounter::SetAlarm(uint32_t deadline, AlarmCallback callback, void* context) {
+  NRFX_IRQ_DISABLE(RTC2_IRQn);
+  alarmDeadline = deadline;
+  alarmCallback = callback;
+  alarmContext = context;
+  alarmArmed = true;
+  ArmCompare(deadline);
+  NRFX_IRQ_ENABLE(RTC2_IRQn);
+}
+
+void RtcCounter::CancelAlarm() {
+  NRFX_IRQ_DISABLE(RTC2_IRQn);
+  alarmArmed = false;
+  nrf_rtc_int_disable(NRF_RTC2, NRF_RTC_INT_COMPARE0_MASK);
+  NRFX_IRQ_ENABLE(RTC2_IRQn);
+}
+
+void RtcCounter::ArmCompare(uint32_t deadline) {
+  uint32_t target = deadline;
+  // Retry if the counter got too close to the target while it was being written
+  do {
+    uint32_t now = Now();
+    if (static_cast<int32_t>(target - now) < static_cast<int32_t>(minCompareDistance)) {
+      target = now + minCompareDistance;
+    }
+    nrf_rtc_cc_set(NRF_RTC2, 0, target & counterMask);
+  } while (static_cast<int32_t>(target - Now()) < static_cast<int32_t>(minCompareDistance));
+  nrf_rtc_int_enable(NRF_RTC2, NRF_RTC_INT_COMPARE0_MASK);
+}
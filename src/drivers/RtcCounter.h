@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+
+namespace Pinetime {
+  namespace Drivers {
+    /// Free-running 32768 Hz time base on RTC2, extended to 32 bits by counting the overflows of the 24-bit counter.
+    /// Unlike DWT->CYCCNT, it keeps running while the CPU sleeps, so it measures wall-clock durations (latencies, bus
+    /// occupation...) with a resolution of ~30.5us. The 32-bit value wraps after ~36 hours: only use differences.
+    class RtcCounter {
+    public:
+      static constexpr uint32_t frequency = 32768;
+      using AlarmCallback = void (*)(void* context);
+
+      static void Init();
+      static uint32_t Now();
+      /// Same time base, without the wrap-around (for the deadlines that can be days away)
+      static uint64_t Now64();
+      static void OnInterrupt();
+
+      /// Calls the callback from the RTC2 interrupt (lowest priority) once Now() reaches the deadline. There is a single
+      /// alarm : setting it replaces the previous one. Deadlines in the past fire as soon as possible.
+      static void SetAlarm(uint32_t deadline, AlarmCallback callback, void* context);
+      static void CancelAlarm();
+
+      static uint32_t ToUs(uint32_t ticks) {
+        return (static_cast<uint64_t>(ticks) * 1000000) / frequency;
+      }
+
+    private:
+      static void ArmCompare(uint32_t deadline);
+
+      static volatile uint32_t overflows;
+      static volatile bool alarmArmed;
+      static uint32_t alarmDeadline;
+      static AlarmCallback alarmCallback;
+      static void* alarmContext;
+    };
+  }
+}
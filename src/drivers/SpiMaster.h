@@ -5,6 +5,7 @@
 #include <FreeRTOS.h>
 #include <semphr.h>
 #include <task.h>
+#include "memory/KernelObjects.h"
 
 namespace Pinetime {
   namespace Drivers {
@@ -60,6 +61,7 @@ namespace Pinetime {
       volatile size_t currentBufferSize = 0;
       volatile TaskHandle_t taskToNotify;
       SemaphoreHandle_t mutex = nullptr;
+      Memory::StaticBinarySemaphore mutexStorage;
     };
   }
 }
@@ -1,15 +1,17 @@
 #include "drivers/TwiMaster.h"
+#include "drivers/RtcCounter.h"
+#include "trace/Trace.h"
 #include <cstring>
 #include <hal/nrf_gpio.h>
 #include <nrfx_log.h>
 
 using namespace Pinetime::Drivers;
 
-// TODO use shortcut to automatically send STOP when receive LastTX, for example
-// TODO use DMA/IRQ
-
 TwiMaster::TwiMaster(NRF_TWIM_Type* module, uint32_t frequency, uint8_t pinSda, uint8_t pinScl)
-  : module {module}, frequency {frequency}, pinSda {pinSda}, pinScl {pinScl} {
+  : module {module}, frequency {frequency}, pinSda {pinSda}, pinScl {pinScl}, transactionSemaphore {transactionSemaphoreStorage.Create()} {
+  for (uint8_t i = 0; i < maxWaiters; i++) {
+    grantSemaphores[i] = grantSemaphoreStorage[i].Create();
+  }
 }
 
 void TwiMaster::ConfigurePins() const {
@@ -29,10 +31,6 @@ void TwiMaster::ConfigurePins() const {
 }
 
 void TwiMaster::Init() {
-  if (mutex == nullptr) {
-    mutex = xSemaphoreCreateBinary();
-  }
-
   ConfigurePins();
 
   twiBaseAddress = module;
@@ -49,127 +47,323 @@ void TwiMaster::Init() {
   twiBaseAddress->EVENTS_SUSPENDED = 0;
   twiBaseAddress->EVENTS_TXSTARTED = 0;
 
-  twiBaseAddress->ENABLE = (TWIM_ENABLE_ENABLE_Enabled << TWIM_ENABLE_ENABLE_Pos);
+  twiBaseAddress->SHORTS = 0;
+  twiBaseAddress->INTENCLR = 0xFFFFFFFF;
+
+  // Toggling ENABLE resets the peripheral, the first transaction wakes it up again
+  Wakeup();
+  Sleep();
+
+  // The cycle counter measures the CPU time of the transactions and detects the frozen peripheral
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  NRFX_IRQ_PRIORITY_SET(nrfx_get_irq_number(twiBaseAddress), interruptPriority);
+  NRFX_IRQ_ENABLE(nrfx_get_irq_number(twiBaseAddress));
 
-  xSemaphoreGive(mutex);
+  windowStart = RtcCounter::Now();
+  windowBusyUs = 0;
+}
+
+void TwiMaster::RegisterDevice(uint8_t deviceAddress, Priorities priority, const char* name) {
+  auto& device = Device(deviceAddress);
+  device.priority = priority;
+  device.name = name;
+}
+
+TwiMaster::DeviceStatistics& TwiMaster::Device(uint8_t deviceAddress) {
+  taskENTER_CRITICAL();
+  uint8_t index = 0;
+  while (index < nbDevices && devices[index].address != deviceAddress) {
+    index++;
+  }
+  if (index == nbDevices) {
+    if (nbDevices < maxDevices) {
+      devices[index].address = deviceAddress;
+      devices[index].name = "?";
+      nbDevices++;
+    } else {
+      // Unknown devices share the last entry
+      index = maxDevices - 1;
+    }
+  }
+  taskEXIT_CRITICAL();
+  return devices[index];
 }
 
 TwiMaster::ErrorCodes TwiMaster::Read(uint8_t deviceAddress, uint8_t registerAddress, uint8_t* data, size_t size) {
-  xSemaphoreTake(mutex, portMAX_DELAY);
-  Wakeup();
-  auto ret = Write(deviceAddress, &registerAddress, 1, false);
-  ret = Read(deviceAddress, data, size, true);
-  Sleep();
-  xSemaphoreGive(mutex);
+  ASSERT(size <= maxReadSize);
+  auto& device = Device(deviceAddress);
+  auto grantedTimestamp = Acquire(device);
+  auto ret = Transfer(device, deviceAddress, &registerAddress, 1, data, size);
+  Release(device, grantedTimestamp, ret);
   return ret;
 }
 
 TwiMaster::ErrorCodes TwiMaster::Write(uint8_t deviceAddress, uint8_t registerAddress, const uint8_t* data, size_t size) {
   ASSERT(size <= maxDataSize);
-  xSemaphoreTake(mutex, portMAX_DELAY);
-  Wakeup();
+  auto& device = Device(deviceAddress);
+  auto grantedTimestamp = Acquire(device);
   internalBuffer[0] = registerAddress;
   std::memcpy(internalBuffer + 1, data, size);
-  auto ret = Write(deviceAddress, internalBuffer, size + 1, true);
-  Sleep();
-  xSemaphoreGive(mutex);
+  auto ret = Transfer(device, deviceAddress, internalBuffer, size + 1, nullptr, 0);
+  Release(device, grantedTimestamp, ret);
   return ret;
 }
 
-TwiMaster::ErrorCodes TwiMaster::Read(uint8_t deviceAddress, uint8_t* buffer, size_t size, bool stop) {
-  twiBaseAddress->ADDRESS = deviceAddress;
-  twiBaseAddress->TASKS_RESUME = 0x1UL;
-  twiBaseAddress->RXD.PTR = (uint32_t) buffer;
-  twiBaseAddress->RXD.MAXCNT = size;
-
-  twiBaseAddress->TASKS_STARTRX = 1;
-
-  while (!twiBaseAddress->EVENTS_RXSTARTED && !twiBaseAddress->EVENTS_ERROR)
-    ;
-  twiBaseAddress->EVENTS_RXSTARTED = 0x0UL;
-
-  txStartedCycleCount = DWT->CYCCNT;
-  uint32_t currentCycleCount;
-  while (!twiBaseAddress->EVENTS_LASTRX && !twiBaseAddress->EVENTS_ERROR) {
-    currentCycleCount = DWT->CYCCNT;
-    if ((currentCycleCount - txStartedCycleCount) > HwFreezedDelay) {
-      FixHwFreezed();
-      return ErrorCodes::TransactionFailed;
+/// Waits until the bus is granted to the calling task, and wakes the peripheral up if needed.
+/// Returns the time at which the bus was granted.
+uint32_t TwiMaster::Acquire(DeviceStatistics& device) {
+  auto requestTimestamp = RtcCounter::Now();
+  Waiter waiter {device.priority, 0};
+
+  taskENTER_CRITICAL();
+  bool granted = !busy;
+  if (granted) {
+    busy = true;
+  } else {
+    ASSERT(nbWaiters < maxWaiters);
+    while ((freeGrantSemaphores & (1 << waiter.slot)) == 0) {
+      waiter.slot++;
     }
+    freeGrantSemaphores &= ~(1 << waiter.slot);
+    waiters[nbWaiters++] = &waiter;
+  }
+  taskEXIT_CRITICAL();
+
+  if (!granted) {
+    // Release() gives the semaphore exactly once, when it hands the bus over to this task
+    xSemaphoreTake(grantSemaphores[waiter.slot], portMAX_DELAY);
+    taskENTER_CRITICAL();
+    freeGrantSemaphores |= 1 << waiter.slot;
+    taskEXIT_CRITICAL();
+  }
+
+  auto grantedTimestamp = RtcCounter::Now();
+  auto latency = RtcCounter::ToUs(grantedTimestamp - requestTimestamp);
+  device.totalLatencyUs += latency;
+  if (latency > device.maxLatencyUs) {
+    device.maxLatencyUs = latency;
   }
-  twiBaseAddress->EVENTS_LASTRX = 0x0UL;
 
-  if (stop || twiBaseAddress->EVENTS_ERROR) {
-    twiBaseAddress->TASKS_STOP = 0x1UL;
-    while (!twiBaseAddress->EVENTS_STOPPED)
-      ;
-    twiBaseAddress->EVENTS_STOPPED = 0x0UL;
+  if (awake) {
+    statistics.mergedTransactions++;
   } else {
-    twiBaseAddress->TASKS_SUSPEND = 0x1UL;
-    while (!twiBaseAddress->EVENTS_SUSPENDED)
-      ;
-    twiBaseAddress->EVENTS_SUSPENDED = 0x0UL;
+    Wakeup();
+    statistics.wakeups++;
+  }
+  return grantedTimestamp;
+}
+
+/// Hands the bus over to the highest priority waiting task. The peripheral is put to sleep only if nobody is
+/// waiting and no session is open.
+void TwiMaster::Release(DeviceStatistics& device, uint32_t grantedTimestamp, ErrorCodes result) {
+  auto now = RtcCounter::Now();
+  auto busyTime = RtcCounter::ToUs(now - grantedTimestamp);
+  device.transactions++;
+  if (result != ErrorCodes::NoError) {
+    device.failures++;
+  }
+  device.busyTimeUs += busyTime;
+  statistics.busyTimeUs += busyTime;
+  windowBusyUs += busyTime;
+  auto windowDuration = RtcCounter::ToUs(now - windowStart);
+  if (windowDuration >= utilisationWindowUs) {
+    statistics.utilisationPermille = (static_cast<uint64_t>(windowBusyUs) * 1000) / windowDuration;
+    windowStart = now;
+    windowBusyUs = 0;
   }
 
-  if (twiBaseAddress->EVENTS_ERROR) {
-    twiBaseAddress->EVENTS_ERROR = 0x0UL;
+  SemaphoreHandle_t next = nullptr;
+  taskENTER_CRITICAL();
+  if (nbWaiters > 0) {
+    uint8_t selected = 0;
+    for (uint8_t i = 1; i < nbWaiters; i++) {
+      if (waiters[i]->priority > waiters[selected]->priority) {
+        selected = i;
+      }
+    }
+    auto* waiter = waiters[selected];
+    for (uint8_t i = selected; i + 1 < nbWaiters; i++) {
+      waiters[i] = waiters[i + 1];
+    }
+    nbWaiters--;
+    // The waiter lives on the stack of its task, it must not be accessed anymore once granted
+    next = grantSemaphores[waiter->slot];
+  } else {
+    busy = false;
+    if (sessions == 0) {
+      Sleep();
+    }
+  }
+  taskEXIT_CRITICAL();
+
+  if (next != nullptr) {
+    xSemaphoreGive(next);
+  }
+}
+
+TwiMaster::Session::Session(TwiMaster& twiMaster) : twiMaster {twiMaster} {
+  taskENTER_CRITICAL();
+  twiMaster.sessions++;
+  taskEXIT_CRITICAL();
+}
+
+TwiMaster::Session::~Session() {
+  taskENTER_CRITICAL();
+  twiMaster.sessions--;
+  if (twiMaster.sessions == 0 && !twiMaster.busy && twiMaster.awake) {
+    twiMaster.Sleep();
   }
-  return ErrorCodes::NoError;
+  taskEXIT_CRITICAL();
 }
 
-TwiMaster::ErrorCodes TwiMaster::Write(uint8_t deviceAddress, const uint8_t* data, size_t size, bool stop) {
+TwiMaster::ErrorCodes TwiMaster::Transfer(DeviceStatistics& device,
+                                          uint8_t deviceAddress,
+                                          const uint8_t* txData,
+                                          size_t txSize,
+                                          uint8_t* rxData,
+                                          size_t rxSize) {
+  Pinetime::Trace::Span span(Pinetime::Trace::UserEvents::TwiTransaction, deviceAddress);
+  auto startCycleCount = DWT->CYCCNT;
   twiBaseAddress->ADDRESS = deviceAddress;
-  twiBaseAddress->TASKS_RESUME = 0x1UL;
-  twiBaseAddress->TXD.PTR = (uint32_t) data;
-  twiBaseAddress->TXD.MAXCNT = size;
+  twiBaseAddress->TXD.PTR = (uint32_t) txData;
+  twiBaseAddress->TXD.MAXCNT = txSize;
+  if (rxSize > 0) {
+    // Repeated START after the register address, and STOP after the last byte, without any CPU intervention
+    twiBaseAddress->RXD.PTR = (uint32_t) rxData;
+    twiBaseAddress->RXD.MAXCNT = rxSize;
+    twiBaseAddress->SHORTS = TWIM_SHORTS_LASTTX_STARTRX_Msk | TWIM_SHORTS_LASTRX_STOP_Msk;
+  } else {
+    twiBaseAddress->SHORTS = TWIM_SHORTS_LASTTX_STOP_Msk;
+  }
+  twiBaseAddress->EVENTS_STOPPED = 0;
+  twiBaseAddress->EVENTS_ERROR = 0;
+  transactionDone = false;
+  transactionError = false;
+  interruptCycles = 0;
+
+  // Init() may be called before the scheduler is started, nobody can be notified then
+  bool useInterrupt = xTaskGetSchedulerState() == taskSCHEDULER_RUNNING;
+  if (useInterrupt) {
+    // A transaction that froze may have completed late
+    xSemaphoreTake(transactionSemaphore, 0);
+    notifyCompletion = true;
+    twiBaseAddress->INTENSET = TWIM_INTENSET_STOPPED_Msk | TWIM_INTENSET_ERROR_Msk;
+  }
 
   twiBaseAddress->TASKS_STARTTX = 1;
 
-  while (!twiBaseAddress->EVENTS_TXSTARTED && !twiBaseAddress->EVENTS_ERROR)
-    ;
-  twiBaseAddress->EVENTS_TXSTARTED = 0x0UL;
-
-  txStartedCycleCount = DWT->CYCCNT;
-  uint32_t currentCycleCount;
-  while (!twiBaseAddress->EVENTS_LASTTX && !twiBaseAddress->EVENTS_ERROR) {
-    currentCycleCount = DWT->CYCCNT;
-    if ((currentCycleCount - txStartedCycleCount) > HwFreezedDelay) {
-      FixHwFreezed();
-      return ErrorCodes::TransactionFailed;
-    }
+  uint32_t cpuCycles = DWT->CYCCNT - startCycleCount;
+  const size_t nbBytes = txSize + rxSize;
+  const bool stopped = useInterrupt ? WaitForInterrupt(nbBytes) : PollStopped(nbBytes);
+  auto completionCycleCount = DWT->CYCCNT;
+
+  twiBaseAddress->INTENCLR = TWIM_INTENCLR_STOPPED_Msk | TWIM_INTENCLR_ERROR_Msk;
+  twiBaseAddress->SHORTS = 0;
+  notifyCompletion = false;
+
+  auto ret = ErrorCodes::NoError;
+  if (!stopped) {
+    FixHwFreezed();
+    statistics.freezes++;
+    ret = ErrorCodes::TransactionFailed;
+  } else if (transactionError) {
+    uint32_t error = twiBaseAddress->ERRORSRC;
+    twiBaseAddress->ERRORSRC = error;
+    ret = ErrorCodes::TransactionFailed;
   }
-  twiBaseAddress->EVENTS_LASTTX = 0x0UL;
 
-  if (stop || twiBaseAddress->EVENTS_ERROR) {
-    twiBaseAddress->TASKS_STOP = 0x1UL;
-    while (!twiBaseAddress->EVENTS_STOPPED)
-      ;
-    twiBaseAddress->EVENTS_STOPPED = 0x0UL;
+  if (useInterrupt) {
+    cpuCycles += interruptCycles + (DWT->CYCCNT - completionCycleCount);
   } else {
-    twiBaseAddress->TASKS_SUSPEND = 0x1UL;
-    while (!twiBaseAddress->EVENTS_SUSPENDED)
-      ;
-    twiBaseAddress->EVENTS_SUSPENDED = 0x0UL;
+    cpuCycles = DWT->CYCCNT - startCycleCount;
+  }
+  statistics.transactions++;
+  if (ret != ErrorCodes::NoError) {
+    statistics.failures++;
   }
+  statistics.lastCpuCycles = cpuCycles;
+  if (cpuCycles > statistics.maxCpuCycles) {
+    statistics.maxCpuCycles = cpuCycles;
+  }
+  statistics.totalCpuCycles += cpuCycles;
+  statistics.totalBytes += nbBytes;
+  device.cpuCycles += cpuCycles;
+  return ret;
+}
 
+/// Blocks the calling task until the interrupt handler reports the STOPPED event, or until the transaction
+/// takes so long that the peripheral must be frozen
+bool TwiMaster::WaitForInterrupt(size_t nbBytes) {
+  const TickType_t timeout = (HwFreezedDelay + nbBytes * HwFreezedDelayPerByte) / (SystemCoreClock / configTICK_RATE_HZ) + 2;
+  const TickType_t start = xTaskGetTickCount();
+  while (!transactionDone) {
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    if (elapsed >= timeout) {
+      return false;
+    }
+    xSemaphoreTake(transactionSemaphore, timeout - elapsed);
+  }
+  return true;
+}
+
+bool TwiMaster::PollStopped(size_t nbBytes) {
+  const uint32_t timeout = HwFreezedDelay + nbBytes * HwFreezedDelayPerByte;
+  auto startCycleCount = DWT->CYCCNT;
+  while (!twiBaseAddress->EVENTS_STOPPED) {
+    if (twiBaseAddress->EVENTS_ERROR) {
+      twiBaseAddress->EVENTS_ERROR = 0;
+      transactionError = true;
+      twiBaseAddress->TASKS_RESUME = 1;
+      twiBaseAddress->TASKS_STOP = 1;
+    }
+    if ((DWT->CYCCNT - startCycleCount) > timeout) {
+      return false;
+    }
+  }
+  twiBaseAddress->EVENTS_STOPPED = 0;
+  return true;
+}
+
+void TwiMaster::OnInterrupt() {
+  auto startCycleCount = DWT->CYCCNT;
   if (twiBaseAddress->EVENTS_ERROR) {
-    twiBaseAddress->EVENTS_ERROR = 0x0UL;
-    uint32_t error = twiBaseAddress->ERRORSRC;
-    twiBaseAddress->ERRORSRC = error;
+    twiBaseAddress->EVENTS_ERROR = 0;
+    transactionError = true;
+    // The shortcuts do not release the bus after a NACK
+    twiBaseAddress->TASKS_RESUME = 1;
+    twiBaseAddress->TASKS_STOP = 1;
   }
 
-  return ErrorCodes::NoError;
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+  if (twiBaseAddress->EVENTS_STOPPED) {
+    twiBaseAddress->EVENTS_STOPPED = 0;
+    twiBaseAddress->INTENCLR = TWIM_INTENCLR_STOPPED_Msk | TWIM_INTENCLR_ERROR_Msk;
+    transactionDone = true;
+    if (notifyCompletion) {
+      xSemaphoreGiveFromISR(transactionSemaphore, &xHigherPriorityTaskWoken);
+    }
+  }
+  interruptCycles += DWT->CYCCNT - startCycleCount;
+  portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+uint32_t TwiMaster::CyclesToUs(uint64_t cycles) {
+  return cycles / (SystemCoreClock / 1000000);
 }
 
 void TwiMaster::Sleep() {
   twiBaseAddress->ENABLE = (TWIM_ENABLE_ENABLE_Disabled << TWIM_ENABLE_ENABLE_Pos);
+  awake = false;
 }
 
 void TwiMaster::Wakeup() {
   twiBaseAddress->ENABLE = (TWIM_ENABLE_ENABLE_Enabled << TWIM_ENABLE_ENABLE_Pos);
+  awake = true;
 }
 
-/* Sometimes, the TWIM device just freeze and never set the event EVENTS_LASTTX.
+/* Sometimes, the TWIM device just freeze and never set the event EVENTS_STOPPED.
  * This method disable and re-enable the peripheral so that it works again.
  * This is just a workaround, and it would be better if we could find a way to prevent
  * this issue from happening.
@@ -177,9 +371,6 @@ void TwiMaster::Wakeup() {
 void TwiMaster::FixHwFreezed() {
   NRF_LOG_INFO("I2C device frozen, reinitializing it!");
 
-  uint32_t twi_state = NRF_TWI1->ENABLE;
-
   Sleep();
-
-  twiBaseAddress->ENABLE = twi_state;
+  Wakeup();
 }
@@ -1,41 +1,149 @@
 #pragma once
 #include <FreeRTOS.h>
+#include <task.h>
 #include <semphr.h>
 #include <drivers/include/nrfx_twi.h> // NRF_TWIM_Type
 #include <cstdint>
+#include "memory/KernelObjects.h"
 
 namespace Pinetime {
   namespace Drivers {
+    /// Shared TWI bus. The tasks that request the bus at the same time are served by priority (FIFO within a
+    /// priority), and the peripheral stays awake as long as transactions are queued back-to-back.
     class TwiMaster {
     public:
       enum class ErrorCodes { NoError, TransactionFailed };
+      enum class Priorities : uint8_t { Low, Normal, High };
+
+      /// CPU cost of the bus transactions, in DWT cycles. Only the time the calling task actually runs (setup,
+      /// completion) and the time spent in the interrupt handler are counted, the time blocked waiting for the
+      /// peripheral is not.
+      struct Statistics {
+        uint32_t transactions = 0;
+        uint32_t failures = 0;
+        uint32_t freezes = 0;
+        uint32_t lastCpuCycles = 0;
+        uint32_t maxCpuCycles = 0;
+        uint64_t totalCpuCycles = 0;
+        uint64_t totalBytes = 0;
+        /// Number of times the peripheral was enabled, and number of transactions that found it already enabled
+        uint32_t wakeups = 0;
+        uint32_t mergedTransactions = 0;
+        uint64_t busyTimeUs = 0;
+        /// Share of the wall-clock time the bus was owned, over the last complete window
+        uint16_t utilisationPermille = 0;
+      };
+
+      struct DeviceStatistics {
+        const char* name = nullptr;
+        uint8_t address = 0;
+        Priorities priority = Priorities::Normal;
+        uint32_t transactions = 0;
+        uint32_t failures = 0;
+        /// Time between the request and the moment the bus is granted
+        uint32_t maxLatencyUs = 0;
+        uint64_t totalLatencyUs = 0;
+        uint64_t busyTimeUs = 0;
+        uint64_t cpuCycles = 0;
+      };
+
+      /// Keeps the peripheral awake between the transactions of a burst (a sensor reading several registers),
+      /// without holding the bus: higher priority transactions can still be interleaved.
+      class Session {
+      public:
+        explicit Session(TwiMaster& twiMaster);
+        ~Session();
+        Session(const Session&) = delete;
+        Session& operator=(const Session&) = delete;
+
+      private:
+        TwiMaster& twiMaster;
+      };
 
       TwiMaster(NRF_TWIM_Type* module, uint32_t frequency, uint8_t pinSda, uint8_t pinScl);
 
       void Init();
+      void RegisterDevice(uint8_t deviceAddress, Priorities priority, const char* name);
+      /// RXD.MAXCNT is 8 bits on the nRF52832 : size must not exceed maxReadSize
       ErrorCodes Read(uint8_t deviceAddress, uint8_t registerAddress, uint8_t* buffer, size_t size);
       ErrorCodes Write(uint8_t deviceAddress, uint8_t registerAddress, const uint8_t* data, size_t size);
 
       void Sleep();
       void Wakeup();
 
+      void OnInterrupt();
+
+      const Statistics& GetStatistics() const {
+        return statistics;
+      }
+      uint8_t NbDevices() const {
+        return nbDevices;
+      }
+      const DeviceStatistics& GetDeviceStatistics(uint8_t index) const {
+        return devices[index];
+      }
+      static uint32_t CyclesToUs(uint64_t cycles);
+
     private:
-      ErrorCodes Read(uint8_t deviceAddress, uint8_t* buffer, size_t size, bool stop);
-      ErrorCodes Write(uint8_t deviceAddress, const uint8_t* data, size_t size, bool stop);
+      struct Waiter {
+        Priorities priority;
+        uint8_t slot; // Index of the semaphore given to the waiter when the bus is granted
+      };
+
+      DeviceStatistics& Device(uint8_t deviceAddress);
+      uint32_t Acquire(DeviceStatistics& device);
+      void Release(DeviceStatistics& device, uint32_t grantedTimestamp, ErrorCodes result);
+      ErrorCodes Transfer(DeviceStatistics& device,
+                          uint8_t deviceAddress,
+                          const uint8_t* txData,
+                          size_t txSize,
+                          uint8_t* rxData,
+                          size_t rxSize);
+      bool WaitForInterrupt(size_t nbBytes);
+      bool PollStopped(size_t nbBytes);
       void FixHwFreezed();
       void ConfigurePins() const;
 
       NRF_TWIM_Type* twiBaseAddress;
-      SemaphoreHandle_t mutex = nullptr;
       NRF_TWIM_Type* module;
       uint32_t frequency;
       uint8_t pinSda;
       uint8_t pinScl;
       static constexpr uint8_t maxDataSize {16};
+      static constexpr size_t maxReadSize {255};
       static constexpr uint8_t registerSize {1};
       uint8_t internalBuffer[maxDataSize + registerSize];
-      uint32_t txStartedCycleCount = 0;
       static constexpr uint32_t HwFreezedDelay {161000};
+      static constexpr uint32_t HwFreezedDelayPerByte {2560};
+      static constexpr uint8_t interruptPriority {3};
+
+      static constexpr uint8_t maxWaiters {4};
+      Waiter* waiters[maxWaiters];
+      uint8_t nbWaiters = 0;
+      // One semaphore per waiting task, so that the hand-over does not use the task notifications either
+      Memory::StaticBinarySemaphore grantSemaphoreStorage[maxWaiters];
+      SemaphoreHandle_t grantSemaphores[maxWaiters];
+      uint8_t freeGrantSemaphores = (1 << maxWaiters) - 1;
+      bool busy = false;
+      bool awake = false;
+      uint8_t sessions = 0;
+
+      // Given by the interrupt handler at the end of the transaction. The task notifications are left to the
+      // tasks, which use them for their own events (touch interrupt...).
+      Memory::StaticBinarySemaphore transactionSemaphoreStorage;
+      SemaphoreHandle_t transactionSemaphore;
+      volatile bool notifyCompletion = false;
+      volatile bool transactionDone = false;
+      volatile bool transactionError = false;
+      volatile uint32_t interruptCycles = 0;
+
+      static constexpr uint8_t maxDevices {4};
+      DeviceStatistics devices[maxDevices];
+      uint8_t nbDevices = 0;
+      Statistics statistics;
+      static constexpr uint32_t utilisationWindowUs {10000000};
+      uint32_t windowStart = 0;
+      uint32_t windowBusyUs = 0;
     };
   }
 }
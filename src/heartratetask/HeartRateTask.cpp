@@ -1,20 +1,32 @@
 #include "heartratetask/HeartRateTask.h"
+#include <algorithm>
 #include <drivers/Hrs3300.h>
 #include <components/heartrate/HeartRateController.h>
+#include <components/heartrate/HeartRateHistory.h>
+#include <components/motion/MotionController.h>
+#include <components/settings/Settings.h>
 #include <nrf_log.h>
 
 using namespace Pinetime::Applications;
 
-HeartRateTask::HeartRateTask(Drivers::Hrs3300& heartRateSensor, Controllers::HeartRateController& controller)
-  : heartRateSensor {heartRateSensor}, controller {controller}, ppg{} {
+HeartRateTask::HeartRateTask(Drivers::Hrs3300& heartRateSensor,
+                             Controllers::HeartRateController& controller,
+                             Controllers::MotionController& motionController,
+                             Controllers::Settings& settingsController,
+                             Controllers::HeartRateHistory& history)
+  : heartRateSensor {heartRateSensor},
+    controller {controller},
+    motionController {motionController},
+    settingsController {settingsController},
+    history {history},
+    ppg {} {
 }
 
 void HeartRateTask::Start() {
-  messageQueue = xQueueCreate(10, 1);
+  messageQueue = messageQueueStorage.Create();
   controller.SetHeartRateTask(this);
 
-  if (pdPASS != xTaskCreate(HeartRateTask::Process, "Heartrate", 500, this, 0, &taskHandle))
-    APP_ERROR_HANDLER(NRF_ERROR_NO_MEM);
+  taskHandle = task.Create(HeartRateTask::Process, "Heartrate", 0, this);
 }
 
 void HeartRateTask::Process(void* instance) {
@@ -26,24 +38,30 @@ void HeartRateTask::Work() {
   int lastBpm = 0;
   while (true) {
     Messages msg;
-    uint32_t delay;
-    if (state == States::Running) {
-      if (measurementStarted)
-        delay = 40;
-      else
-        delay = 100;
-    } else
+    TickType_t delay;
+    if (IsForegroundMeasurementRunning() || backgroundMeasurementStarted)
+      delay = 40;
+    else if (state == States::Running)
+      delay = 100;
+    else
       delay = portMAX_DELAY;
 
+    if (!IsForegroundMeasurementRunning() && !backgroundMeasurementStarted) {
+      delay = std::min(delay, BackgroundMeasurementDelay());
+    }
+
     if (xQueueReceive(messageQueue, &msg, delay)) {
       switch (msg) {
         case Messages::GoToSleep:
-          StopMeasurement();
+          // A background measurement is allowed to complete while sleeping
+          if (!backgroundMeasurementStarted)
+            StopMeasurement();
           state = States::Idle;
           break;
         case Messages::WakeUp:
           state = States::Running;
           if (measurementStarted) {
+            AbortBackgroundMeasurement();
             lastBpm = 0;
             StartMeasurement();
           }
@@ -51,6 +69,7 @@ void HeartRateTask::Work() {
         case Messages::StartMeasurement:
           if (measurementStarted)
             break;
+          AbortBackgroundMeasurement();
           lastBpm = 0;
           StartMeasurement();
           measurementStarted = true;
@@ -58,24 +77,66 @@ void HeartRateTask::Work() {
         case Messages::StopMeasurement:
           if (!measurementStarted)
             break;
-          StopMeasurement();
+          if (!backgroundMeasurementStarted)
+            StopMeasurement();
           measurementStarted = false;
           break;
       }
     }
 
-    if (measurementStarted) {
-      ppg.Preprocess(static_cast<float>(heartRateSensor.ReadHrs()));
-      auto bpm = ppg.HeartRate();
+    if (IsForegroundMeasurementRunning()) {
+      auto bpm = ProcessSample();
 
       if (lastBpm == 0 && bpm == 0)
-        controller.Update(Controllers::HeartRateController::States::NotEnoughData, 0);
+        controller.Update(Controllers::HeartRateController::States::NotEnoughData, 0, 0);
       if (bpm != 0) {
         lastBpm = bpm;
-        controller.Update(Controllers::HeartRateController::States::Running, lastBpm);
+        controller.Update(Controllers::HeartRateController::States::Running, lastBpm, ppg.Confidence());
       }
+    } else if (backgroundMeasurementStarted) {
+      auto bpm = ProcessSample();
+      if (bpm != 0 && ppg.Confidence() >= backgroundConfidence) {
+        backgroundHeartRate = bpm;
+        backgroundConfidence = ppg.Confidence();
+      }
+
+      if (backgroundConfidence >= backgroundTargetConfidence ||
+          (xTaskGetTickCount() - backgroundMeasurementStart) >= backgroundMaxDuration) {
+        StopBackgroundMeasurement();
+      }
+    } else if (BackgroundMeasurementDelay() == 0) {
+      StartBackgroundMeasurement();
+    }
+  }
+}
+
+int HeartRateTask::ProcessSample() {
+  auto hrs = static_cast<float>(heartRateSensor.ReadHrs());
+  auto als = static_cast<float>(heartRateSensor.ReadAls());
+  ledAgc.Step();
+  if (ledSettingsChanged) {
+    // The DC level changed with the new LED settings, restart the measurement from this sample
+    ppg.SetOffset(hrs, als);
+    hrv.Invalidate();
+    ledSettingsChanged = false;
+    return 0;
+  }
+
+  ppg.SetMotion(motionController.X(), motionController.Y(), motionController.Z());
+  ppg.Preprocess(hrs, als);
+  if (ppg.IsMoving()) {
+    hrv.Invalidate();
+  } else if (hrv.Step(ppg.Pulse(), (static_cast<uint64_t>(xTaskGetTickCount()) * 1000) / configTICK_RATE_HZ)) {
+    controller.UpdateRrInterval(hrv.RrInterval(), hrv.Rmssd(), hrv.Sdnn());
+  }
+  if (ppg.Statistics().count >= ledAgcPeriod) {
+    if (ledAgc.Update(ppg.Statistics())) {
+      ApplyLedSettings();
     }
+    ppg.ResetStatistics();
+    controller.SetAverageLedCurrent(ledAgc.AverageCurrent());
   }
+  return ppg.HeartRate();
 }
 
 void HeartRateTask::PushMessage(HeartRateTask::Messages msg) {
@@ -89,12 +150,75 @@ void HeartRateTask::PushMessage(HeartRateTask::Messages msg) {
 }
 
 void HeartRateTask::StartMeasurement() {
+  ledAgc.Reset();
+  hrv.Reset();
+  ApplyLedSettings();
+  ledSettingsChanged = false;
   heartRateSensor.Enable();
   vTaskDelay(100);
-  ppg.SetOffset(static_cast<float>(heartRateSensor.ReadHrs()));
+  ppg.SetOffset(static_cast<float>(heartRateSensor.ReadHrs()), static_cast<float>(heartRateSensor.ReadAls()));
 }
 
 void HeartRateTask::StopMeasurement() {
   heartRateSensor.Disable();
   vTaskDelay(100);
 }
+
+void HeartRateTask::ApplyLedSettings() {
+  heartRateSensor.SetDrive(ledAgc.Drive());
+  heartRateSensor.SetGain(ledAgc.Gain());
+  ledSettingsChanged = true;
+}
+
+/// Returns the number of ticks until the next background measurement, portMAX_DELAY if they are disabled
+TickType_t HeartRateTask::BackgroundMeasurementDelay() {
+  auto period = settingsController.GetHeartRateBackgroundPeriod();
+  auto now = xTaskGetTickCount();
+  if (period != backgroundPeriod) {
+    backgroundPeriod = period;
+    nextBackgroundMeasurement = now + (period * 60 * configTICK_RATE_HZ);
+  }
+  if (backgroundPeriod == 0)
+    return portMAX_DELAY;
+
+  auto remaining = static_cast<int32_t>(nextBackgroundMeasurement - now);
+  return (remaining > 0) ? static_cast<TickType_t>(remaining) : 0;
+}
+
+void HeartRateTask::StartBackgroundMeasurement() {
+  NRF_LOG_INFO("[HeartRateTask] Background measurement started");
+  backgroundMeasurementStart = xTaskGetTickCount();
+  nextBackgroundMeasurement = backgroundMeasurementStart + (backgroundPeriod * 60 * configTICK_RATE_HZ);
+  backgroundHeartRate = 0;
+  backgroundConfidence = 0;
+  backgroundMeasurementStarted = true;
+  StartMeasurement();
+}
+
+void HeartRateTask::StopBackgroundMeasurement() {
+  auto duration = xTaskGetTickCount() - backgroundMeasurementStart;
+  StopMeasurement();
+  backgroundMeasurementStarted = false;
+
+  Controllers::HeartRateController::BackgroundMeasurement measurement;
+  measurement.heartRate = backgroundHeartRate;
+  measurement.confidence = backgroundConfidence;
+  measurement.duration = (duration * 1000) / configTICK_RATE_HZ;
+  // uAh = 0.1mA * ms / 36000
+  measurement.ledCharge = (static_cast<uint32_t>(ledAgc.AverageCurrent()) * measurement.duration) / 36000;
+  controller.UpdateBackgroundMeasurement(measurement);
+  NRF_LOG_INFO("[HeartRateTask] Background measurement : %d bpm (%d%%), %d ms, %d uAh",
+               measurement.heartRate,
+               measurement.confidence,
+               measurement.duration,
+               measurement.ledCharge);
+
+  if (backgroundHeartRate != 0) {
+    history.Append(backgroundHeartRate, backgroundConfidence);
+  }
+}
+
+/// The foreground measurement takes over the sensor, the background measurement is discarded
+void HeartRateTask::AbortBackgroundMeasurement() {
+  backgroundMeasurementStarted = false;
+}
@@ -3,6 +3,9 @@
 #include <task.h>
 #include <queue.h>
 #include <components/heartrate/Ppg.h>
+#include <components/heartrate/LedAgc.h>
+#include <components/heartrate/Hrv.h>
+#include "memory/KernelObjects.h"
 
 namespace Pinetime {
   namespace Drivers {
@@ -10,6 +13,9 @@ namespace Pinetime {
   }
   namespace Controllers {
     class HeartRateController;
+    class HeartRateHistory;
+    class MotionController;
+    class Settings;
   }
   namespace Applications {
     class HeartRateTask {
@@ -17,7 +23,11 @@ namespace Pinetime {
       enum class Messages : uint8_t { GoToSleep, WakeUp, StartMeasurement, StopMeasurement };
       enum class States { Idle, Running };
 
-      explicit HeartRateTask(Drivers::Hrs3300& heartRateSensor, Controllers::HeartRateController& controller);
+      explicit HeartRateTask(Drivers::Hrs3300& heartRateSensor,
+                             Controllers::HeartRateController& controller,
+                             Controllers::MotionController& motionController,
+                             Controllers::Settings& settingsController,
+                             Controllers::HeartRateHistory& history);
       void Start();
       void Work();
       void PushMessage(Messages msg);
@@ -26,14 +36,46 @@ namespace Pinetime {
       static void Process(void* instance);
       void StartMeasurement();
       void StopMeasurement();
+      void ApplyLedSettings();
+      int ProcessSample();
+
+      bool IsForegroundMeasurementRunning() const {
+        return measurementStarted && state == States::Running;
+      }
+      TickType_t BackgroundMeasurementDelay();
+      void StartBackgroundMeasurement();
+      void StopBackgroundMeasurement();
+      void AbortBackgroundMeasurement();
 
       TaskHandle_t taskHandle;
+      Memory::StaticTask<500> task;
       QueueHandle_t messageQueue;
+      Memory::StaticQueue<Messages, 10> messageQueueStorage;
       States state = States::Running;
       Drivers::Hrs3300& heartRateSensor;
       Controllers::HeartRateController& controller;
+      Controllers::MotionController& motionController;
+      Controllers::Settings& settingsController;
+      Controllers::HeartRateHistory& history;
       Controllers::Ppg ppg;
+      Controllers::LedAgc ledAgc;
+      Controllers::Hrv hrv;
       bool measurementStarted = false;
+      bool ledSettingsChanged = false;
+      // Number of samples (~1s) between 2 evaluations of the LED settings
+      static constexpr uint16_t ledAgcPeriod = 25;
+
+      // Background measurements : the sensor is enabled for a short burst every N minutes (see Settings)
+      bool backgroundMeasurementStarted = false;
+      uint16_t backgroundPeriod = 0; // minutes
+      TickType_t backgroundMeasurementStart = 0;
+      TickType_t nextBackgroundMeasurement = 0;
+      uint8_t backgroundHeartRate = 0;
+      uint8_t backgroundConfidence = 0;
+      // The burst is stopped as soon as a value with this confidence is available...
+      static constexpr uint8_t backgroundTargetConfidence = 60;
+      // ... or after this delay (the first PPG window needs ~8s)
+      static constexpr TickType_t backgroundMaxDuration = pdMS_TO_TICKS(30 * 1000);
     };
 
   }
@@ -47,22 +47,31 @@ struct ble_npl_event {
     void *arg;
 };
 
+#define BLE_NPL_EVENTQ_LENGTH   32
+
+/* The kernel objects are stored in the structures, they are not allocated from
+ * the FreeRTOS heap (configSUPPORT_STATIC_ALLOCATION) */
 struct ble_npl_eventq {
     QueueHandle_t q;
+    StaticQueue_t q_buffer;
+    uint8_t q_storage[BLE_NPL_EVENTQ_LENGTH * sizeof(struct ble_npl_eventq *)];
 };
 
 struct ble_npl_callout {
     TimerHandle_t handle;
+    StaticTimer_t timer_buffer;
     struct ble_npl_eventq *evq;
     struct ble_npl_event ev;
 };
 
 struct ble_npl_mutex {
     SemaphoreHandle_t handle;
+    StaticSemaphore_t buffer;
 };
 
 struct ble_npl_sem {
     SemaphoreHandle_t handle;
+    StaticSemaphore_t buffer;
 };
 
 /*
@@ -88,7 +97,8 @@ ble_npl_get_current_task_id(void)
 static inline void
 ble_npl_eventq_init(struct ble_npl_eventq *evq)
 {
-    evq->q = xQueueCreate(32, sizeof(struct ble_npl_eventq *));
+    evq->q = xQueueCreateStatic(BLE_NPL_EVENTQ_LENGTH, sizeof(struct ble_npl_eventq *),
+                                evq->q_storage, &evq->q_buffer);
 }
 
 static inline struct ble_npl_event *
@@ -22,10 +22,17 @@
 #include "task.h"
 #include "nimble/nimble_port.h"
 
+#define NIMBLE_LL_STACK_SIZE    (configMINIMAL_STACK_SIZE + 200)
+#define NIMBLE_HOST_STACK_SIZE  (configMINIMAL_STACK_SIZE + 600)
+
 #if NIMBLE_CFG_CONTROLLER
 static TaskHandle_t ll_task_h;
+static StackType_t ll_task_stack[NIMBLE_LL_STACK_SIZE];
+static StaticTask_t ll_task_buffer;
 #endif
 static TaskHandle_t host_task_h;
+static StackType_t host_task_stack[NIMBLE_HOST_STACK_SIZE];
+static StaticTask_t host_task_buffer;
 
 void
 nimble_port_freertos_init(TaskFunction_t host_task_fn)
@@ -37,8 +44,8 @@ nimble_port_freertos_init(TaskFunction_t host_task_fn)
      * provided by NimBLE and in case of FreeRTOS it does not need to be wrapped
      * since it has compatible prototype.
      */
-    xTaskCreate(nimble_port_ll_task_func, "ll", configMINIMAL_STACK_SIZE + 200,
-                NULL, 2, &ll_task_h);
+    ll_task_h = xTaskCreateStatic(nimble_port_ll_task_func, "ll", NIMBLE_LL_STACK_SIZE,
+                                  NULL, 2, ll_task_stack, &ll_task_buffer);
 #endif
 
     /*
@@ -46,6 +53,6 @@ nimble_port_freertos_init(TaskFunction_t host_task_fn)
      * have separate task for NimBLE host, but since something needs to handle
      * default queue it is just easier to make separate task which does this.
      */
-    xTaskCreate(host_task_fn, "ble", configMINIMAL_STACK_SIZE + 600,
-                NULL, 1, &host_task_h);
+    host_task_h = xTaskCreateStatic(host_task_fn, "ble", NIMBLE_HOST_STACK_SIZE,
+                                    NULL, 1, host_task_stack, &host_task_buffer);
 }
@@ -143,7 +143,7 @@ npl_freertos_mutex_init(struct ble_npl_mutex *mu)
         return BLE_NPL_INVALID_PARAM;
     }
 
-    mu->handle = xSemaphoreCreateRecursiveMutex();
+    mu->handle = xSemaphoreCreateRecursiveMutexStatic(&mu->buffer);
     assert(mu->handle);
 
     return BLE_NPL_OK;
@@ -197,7 +197,7 @@ npl_freertos_sem_init(struct ble_npl_sem *sem, uint16_t tokens)
         return BLE_NPL_INVALID_PARAM;
     }
 
-    sem->handle = xSemaphoreCreateCounting(128, tokens);
+    sem->handle = xSemaphoreCreateCountingStatic(128, tokens, &sem->buffer);
     assert(sem->handle);
 
     return BLE_NPL_OK;
@@ -270,7 +270,8 @@ npl_freertos_callout_init(struct ble_npl_callout *co, struct ble_npl_eventq *evq
 {
   if(co->handle == NULL) {
     memset(co, 0, sizeof(*co));
-    co->handle = xTimerCreate("co", 1, pdFALSE, co, os_callout_timer_cb);
+    co->handle = xTimerCreateStatic("co", 1, pdFALSE, co, os_callout_timer_cb,
+                                    &co->timer_buffer);
   }
     co->evq = evq;
     ble_npl_event_init(&co->ev, ev_cb, ev_arg);
@@ -0,0 +1,135 @@
+#include "logging/BinaryLog.h"
+#include <atomic>
+#include "drivers/RtcCounter.h"
+
+using namespace Pinetime::Logging;
+
+namespace {
+  static_assert((BinaryLog::capacity & (BinaryLog::capacity - 1)) == 0, "The capacity must be a power of 2");
+
+  // The high byte of the header : a reserved record is not visible until its header is written
+  constexpr uint32_t committedMarker = 0xB1;
+  constexpr uint32_t headerSize = 2;
+
+  uint32_t words[BinaryLog::capacity];
+  // The writers reserve [head, head + size) with a compare and swap, the host frees the records up to tail
+  std::atomic<uint32_t> head {0};
+  std::atomic<uint32_t> tail {0};
+  std::atomic<uint32_t> written {0};
+  std::atomic<uint32_t> dropped {0};
+  std::atomic<uint32_t> flushes {0};
+  std::atomic<bool> flushRequested {false};
+
+  BinaryLog::FlushHandler flushHandler = nullptr;
+  void* flushContext = nullptr;
+
+  uint32_t& At(uint32_t position) {
+    return words[position & (BinaryLog::capacity - 1)];
+  }
+
+  uint32_t Header(uint16_t format, uint8_t nbArguments) {
+    return (committedMarker << 24) | (static_cast<uint32_t>(nbArguments) << 16) | format;
+  }
+
+  bool IsCommitted(uint32_t header) {
+    return (header >> 24) == committedMarker;
+  }
+
+  uint32_t SizeOf(uint32_t header) {
+    return headerSize + ((header >> 16) & 0xff);
+  }
+}
+
+void BinaryLog::Write(uint16_t format, const uint32_t* arguments, uint8_t nbArguments) {
+  const uint32_t size = headerSize + nbArguments;
+  uint32_t start = head.load(std::memory_order_relaxed);
+  do {
+    if (start + size - tail.load(std::memory_order_acquire) > capacity) {
+      dropped++;
+      RequestFlush();
+      return;
+    }
+  } while (!head.compare_exchange_weak(start, start + size, std::memory_order_relaxed));
+
+  At(start + 1) = Pinetime::Drivers::RtcCounter::Now();
+  for (uint8_t i = 0; i < nbArguments; i++) {
+    At(start + headerSize + i) = arguments[i];
+  }
+  // The header is written last : it publishes the record
+  std::atomic_thread_fence(std::memory_order_release);
+  At(start) = Header(format, nbArguments);
+  written++;
+
+  if (start + size - tail.load(std::memory_order_relaxed) >= capacity / 2) {
+    RequestFlush();
+  }
+}
+
+void BinaryLog::SetFlushHandler(FlushHandler handler, void* context) {
+  flushHandler = nullptr;
+  flushContext = context;
+  flushHandler = handler;
+}
+
+void BinaryLog::Flush() {
+  flushRequested = true;
+  flushes++;
+  if (flushHandler != nullptr) {
+    flushHandler(flushContext);
+  }
+}
+
+// Only the first request calls the handler, until the host releases some records
+void BinaryLog::RequestFlush() {
+  if (!flushRequested.exchange(true)) {
+    flushes++;
+    if (flushHandler != nullptr) {
+      flushHandler(flushContext);
+    }
+  }
+}
+
+uint32_t BinaryLog::Tail() {
+  return tail;
+}
+
+uint32_t BinaryLog::Head() {
+  return head;
+}
+
+size_t BinaryLog::RecordSize(uint32_t position) {
+  const uint32_t first = tail;
+  if (position - first >= head - first) {
+    return 0;
+  }
+  const uint32_t header = At(position);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return IsCommitted(header) ? SizeOf(header) : 0;
+}
+
+uint32_t BinaryLog::Word(uint32_t position) {
+  return At(position);
+}
+
+bool BinaryLog::Release(uint32_t position) {
+  uint32_t first = tail;
+  if (position - first > head - first) {
+    return false;
+  }
+  while (first != position) {
+    const uint32_t header = At(first);
+    if (!IsCommitted(header) || position - first < SizeOf(header)) {
+      break;
+    }
+    // The space is reused by the writers : it must not look like a committed record
+    At(first) = 0;
+    first += SizeOf(header);
+  }
+  tail.store(first, std::memory_order_release);
+  flushRequested = false;
+  return first == position;
+}
+
+BinaryLog::Statistics BinaryLog::GetStatistics() {
+  return {written, dropped, flushes};
+}
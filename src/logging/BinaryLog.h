@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+/// Writes a record in the binary log. The format string (printf syntax, integer conversions only) is kept in the
+/// .binlog_strings section of the ELF file, which is not loaded in the flash : the record only contains the address of
+/// the string in this section and the raw arguments. tools/binlog-decoder formats the records with the ELF file.
+/// Only use it in the functions of the .cpp files : GCC rejects the same named section in inline functions and templates.
+#define BINLOG(format, ...)                                                                                                    \
+  do {                                                                                                                         \
+    static const char binlogFormat[] __attribute__((section(".binlog_strings"), used)) = format;                              \
+    Pinetime::Logging::BinaryLog::Write(binlogFormat, ##__VA_ARGS__);                                                          \
+  } while (0)
+
+namespace Pinetime {
+  namespace Logging {
+    /// Deferred logger : the records (format, RTC2 timestamp, arguments) are written in a RAM ring buffer without
+    /// formatting and without masking the interrupts, and the host retrieves them over BLE (see
+    /// doc/DiagnosticsService.md). Unlike the trace recorder, the records are kept until the host releases them : when
+    /// the buffer is full, the new records are dropped and counted.
+    ///
+    /// The positions are free-running word counters. A record is a header word (format, number of arguments and a
+    /// marker that commits the record), the timestamp and the arguments.
+    class BinaryLog {
+    public:
+      /// In 32-bit words
+      static constexpr size_t capacity = 256;
+      static constexpr uint8_t maxArguments = 6;
+      using FlushHandler = void (*)(void* context);
+
+      struct Statistics {
+        uint32_t written;
+        uint32_t dropped;
+        uint32_t flushes;
+      };
+
+      template <typename... Arguments>
+      static void Write(const char* format, Arguments... arguments) {
+        static_assert(sizeof...(Arguments) <= maxArguments, "Too many arguments for a binary log record");
+        // The first element avoids an empty array when there is no argument
+        const uint32_t words[] = {0, ToWord(arguments)...};
+        Write(static_cast<uint16_t>(reinterpret_cast<uintptr_t>(format)), words + 1, sizeof...(Arguments));
+      }
+
+      /// The handler is called in the context of the writer (task or interrupt) when the buffer gets half full, or
+      /// when Flush() is called : it should make the host retrieve the records. It is called again once the host
+      /// released some records.
+      static void SetFlushHandler(FlushHandler handler, void* context);
+      static void Flush();
+
+      /// Position of the oldest record that was not released
+      static uint32_t Tail();
+      /// End of the reserved space : the records before it may not be committed yet
+      static uint32_t Head();
+      /// Size in words of the committed record at this position, 0 if there is none
+      static size_t RecordSize(uint32_t position);
+      static uint32_t Word(uint32_t position);
+      /// Releases the records before the position, which must be the start of a record (or the end of the last one)
+      static bool Release(uint32_t position);
+      static Statistics GetStatistics();
+
+    private:
+      template <typename T>
+      static uint32_t ToWord(T value) {
+        static_assert((std::is_integral<T>::value || std::is_enum<T>::value) && sizeof(T) <= sizeof(uint32_t),
+                      "The binary log only records integers of 32 bits at most");
+        return static_cast<uint32_t>(value);
+      }
+
+      template <typename T>
+      static uint32_t ToWord(T* value) {
+        return reinterpret_cast<uintptr_t>(value);
+      }
+
+      static void Write(uint16_t format, const uint32_t* arguments, uint8_t nbArguments);
+      static void RequestFlush();
+    };
+  }
+}
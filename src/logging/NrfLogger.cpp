@@ -3,18 +3,22 @@
 #include <libraries/log/nrf_log.h>
 #include <libraries/log/nrf_log_ctrl.h>
 #include <libraries/log/nrf_log_default_backends.h>
+#include <nrf.h>
 
 using namespace Pinetime::Logging;
 
+namespace {
+  NrfLogger* instance = nullptr;
+}
+
 void NrfLogger::Init() {
   auto result = NRF_LOG_INIT(nullptr);
   APP_ERROR_CHECK(result);
 
   NRF_LOG_DEFAULT_BACKENDS_INIT();
 
-  if (pdPASS != xTaskCreate(NrfLogger::Process, "LOGGER", 200, this, 0, &m_logger_thread)) {
-    APP_ERROR_HANDLER(NRF_ERROR_NO_MEM);
-  }
+  m_logger_thread = task.Create(NrfLogger::Process, "LOGGER", 0, this);
+  instance = this;
 }
 
 void NrfLogger::Process(void*) {
@@ -24,11 +28,30 @@ void NrfLogger::Process(void*) {
 #pragma ide diagnostic ignored "EndlessLoop"
   while (true) {
     NRF_LOG_FLUSH();
-    vTaskDelay(100); // Not good for power consumption, it will wake up every 100ms...
+    // The notifications sent while flushing are counted : no message is left behind
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
   }
 #pragma clang diagnostic pop
 }
 
 void NrfLogger::Resume() {
-  vTaskResume(m_logger_thread);
+  if (m_logger_thread == nullptr) {
+    return;
+  }
+  if (__get_IPSR() != 0) {
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(m_logger_thread, &higherPriorityTaskWoken);
+    portYIELD_FROM_ISR(higherPriorityTaskWoken);
+  } else {
+    xTaskNotifyGive(m_logger_thread);
+  }
+}
+
+// Called by the log frontend each time a message is queued in deferred mode
+extern "C" {
+void log_pending_hook(void) {
+  if (instance != nullptr) {
+    instance->Resume();
+  }
+}
 }
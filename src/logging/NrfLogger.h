@@ -3,17 +3,21 @@
 
 #include <FreeRTOS.h>
 #include <task.h>
+#include "memory/KernelObjects.h"
 
 namespace Pinetime {
   namespace Logging {
+    /// The logger task sleeps until the log frontend has pending messages (log_pending_hook), then flushes them
     class NrfLogger : public Logger {
     public:
       void Init() override;
+      /// Wakes the logger task up, also from an interrupt
       void Resume() override;
 
     private:
       static void Process(void*);
-      TaskHandle_t m_logger_thread;
+      TaskHandle_t m_logger_thread = nullptr;
+      Memory::StaticTask<200> task;
     };
   }
 }
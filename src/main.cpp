@@ -3,7 +3,6 @@
 #include <hal/nrf_wdt.h>
 #include <legacy/nrf_drv_clock.h>
 #include <libraries/gpiote/app_gpiote.h>
-#include <libraries/timer/app_timer.h>
 #include <softdevice/common/nrf_sdh.h>
 #include <nrf_delay.h>
 
@@ -37,18 +36,25 @@
 #include "components/motor/MotorController.h"
 #include "components/datetime/DateTimeController.h"
 #include "components/heartrate/HeartRateController.h"
+#include "components/heartrate/HeartRateHistory.h"
+#include "components/motion/StepHistory.h"
+#include "components/motion/SleepTracker.h"
 #include "components/fs/FS.h"
 #include "drivers/Spi.h"
 #include "drivers/SpiMaster.h"
 #include "drivers/SpiNorFlash.h"
 #include "drivers/St7789.h"
 #include "drivers/TwiMaster.h"
+#include "drivers/RtcCounter.h"
 #include "drivers/Cst816s.h"
 #include "drivers/PinMap.h"
 #include "systemtask/SystemTask.h"
+#include "main.h"
 #include "drivers/PinMap.h"
 #include "touchhandler/TouchHandler.h"
 #include "buttonhandler/ButtonHandler.h"
+#include "trace/Trace.h"
+#include "profiling/Profiler.h"
 
 #if NRF_LOG_ENABLED
   #include "logging/NrfLogger.h"
@@ -89,37 +95,46 @@ Pinetime::Drivers::Cst816S touchPanel {twiMaster, touchPanelTwiAddress};
   #include "displayapp/LittleVgl.h"
   #include "displayapp/DisplayApp.h"
 #endif
-Pinetime::Components::LittleVgl lvgl {lcd, touchPanel};
+Pinetime::Controllers::TouchHandler touchHandler(touchPanel);
+Pinetime::Components::LittleVgl lvgl {lcd, touchHandler};
 
 Pinetime::Drivers::Bma421 motionSensor {twiMaster, motionSensorTwiAddress};
 Pinetime::Drivers::Hrs3300 heartRateSensor {twiMaster, heartRateSensorTwiAddress};
 
-TimerHandle_t debounceTimer;
-TimerHandle_t debounceChargeTimer;
+Pinetime::System::Timer debounceTimer {"debounce", Pinetime::System::Timer::Modes::SingleShot, DebounceTimerCallback, nullptr};
+Pinetime::System::Timer debounceChargeTimer {"debounceCharge",
+                                             Pinetime::System::Timer::Modes::SingleShot,
+                                             DebounceTimerChargeCallback,
+                                             nullptr};
 Pinetime::Controllers::Battery batteryController;
 Pinetime::Controllers::Ble bleController;
 
 Pinetime::Controllers::HeartRateController heartRateController;
-Pinetime::Applications::HeartRateTask heartRateApp(heartRateSensor, heartRateController);
+Pinetime::Controllers::MotionController motionController;
 
 Pinetime::Controllers::FS fs {spiNorFlash};
 Pinetime::Controllers::Settings settingsController {fs};
 Pinetime::Controllers::MotorController motorController {};
 
 Pinetime::Controllers::DateTime dateTimeController {settingsController};
+// In the noinit SRAM (see NoInit_MagicValue below) : the entries not written to the flash yet survive a reset
+Pinetime::Controllers::HeartRateHistory::Buffer NoInit_HeartRateHistory __attribute__((section(".noinit")));
+Pinetime::Controllers::HeartRateHistory heartRateHistory {fs, dateTimeController, NoInit_HeartRateHistory};
+Pinetime::Controllers::StepHistory stepHistory {fs, dateTimeController};
+Pinetime::Controllers::SleepTracker sleepTracker {fs, dateTimeController};
+Pinetime::Applications::HeartRateTask heartRateApp(heartRateSensor, heartRateController, motionController, settingsController, heartRateHistory);
 Pinetime::Drivers::Watchdog watchdog;
 Pinetime::Drivers::WatchdogView watchdogView(watchdog);
 Pinetime::Controllers::NotificationManager notificationManager;
-Pinetime::Controllers::MotionController motionController;
 Pinetime::Controllers::TimerController timerController;
 Pinetime::Controllers::AlarmController alarmController {dateTimeController};
-Pinetime::Controllers::TouchHandler touchHandler(touchPanel, lvgl);
 Pinetime::Controllers::ButtonHandler buttonHandler;
 Pinetime::Controllers::BrightnessController brightnessController {};
 
 Pinetime::Applications::DisplayApp displayApp(lcd,
                                               lvgl,
                                               touchPanel,
+                                              twiMaster,
                                               batteryController,
                                               bleController,
                                               dateTimeController,
@@ -150,6 +165,9 @@ Pinetime::System::SystemTask systemTask(spi,
                                         motorController,
                                         heartRateSensor,
                                         motionController,
+                                        stepHistory,
+                                        heartRateHistory,
+                                        sleepTracker,
                                         motionSensor,
                                         settingsController,
                                         heartRateController,
@@ -164,38 +182,40 @@ Pinetime::System::SystemTask systemTask(spi,
 */
 extern uint32_t __start_noinit_data;
 extern uint32_t __stop_noinit_data;
-static constexpr uint32_t NoInit_MagicValue = 0xDEAD0000;
+static constexpr uint32_t NoInit_MagicValue = 0xDEAD0001;
 uint32_t NoInit_MagicWord __attribute__((section(".noinit")));
 std::chrono::time_point<std::chrono::system_clock, std::chrono::nanoseconds> NoInit_BackUpTime __attribute__((section(".noinit")));
 
 
 void nrfx_gpiote_evt_handler(nrfx_gpiote_pin_t pin, nrf_gpiote_polarity_t action) {
+  Pinetime::Trace::IsrScope isrScope;
   if (pin == Pinetime::PinMap::Cst816sIrq) {
     systemTask.OnTouchEvent();
     return;
   }
 
-  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+  if (pin == Pinetime::PinMap::Bma421Irq) {
+    systemTask.OnMotionInterrupt();
+    return;
+  }
 
   if (pin == Pinetime::PinMap::PowerPresent and action == NRF_GPIOTE_POLARITY_TOGGLE) {
-    xTimerStartFromISR(debounceChargeTimer, &xHigherPriorityTaskWoken);
-    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    debounceChargeTimer.Start(200);
   } else if (pin == Pinetime::PinMap::Button) {
-    xTimerStartFromISR(debounceTimer, &xHigherPriorityTaskWoken);
-    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    debounceTimer.Start(10);
   }
 }
 
-void DebounceTimerChargeCallback(TimerHandle_t xTimer) {
-  xTimerStop(xTimer, 0);
+void DebounceTimerChargeCallback(void* /*unused*/) {
   systemTask.PushMessage(Pinetime::System::Messages::OnChargingEvent);
 }
 
-void DebounceTimerCallback(TimerHandle_t /*unused*/) {
+void DebounceTimerCallback(void* /*unused*/) {
   systemTask.PushMessage(Pinetime::System::Messages::HandleButtonEvent);
 }
 
 void SPIM0_SPIS0_TWIM0_TWIS0_SPI0_TWI0_IRQHandler(void) {
+  Pinetime::Trace::IsrScope isrScope;
   if (((NRF_SPIM0->INTENSET & (1 << 6)) != 0) && NRF_SPIM0->EVENTS_END == 1) {
     NRF_SPIM0->EVENTS_END = 0;
     spi.OnEndEvent();
@@ -218,14 +238,17 @@ static void (*rtc0_isr_addr)(void);
 /* Some interrupt handlers required for NimBLE radio driver */
 extern "C" {
 void RADIO_IRQHandler(void) {
+  Pinetime::Trace::IsrScope isrScope;
   ((void (*)(void)) radio_isr_addr)();
 }
 
 void RNG_IRQHandler(void) {
+  Pinetime::Trace::IsrScope isrScope;
   ((void (*)(void)) rng_isr_addr)();
 }
 
 void RTC0_IRQHandler(void) {
+  Pinetime::Trace::IsrScope isrScope;
   ((void (*)(void)) rtc0_isr_addr)();
 }
 
@@ -233,6 +256,27 @@ void WDT_IRQHandler(void) {
   nrf_wdt_event_clear(NRF_WDT_EVENT_TIMEOUT);
 }
 
+void SPIM1_SPIS1_TWIM1_TWIS1_SPI1_TWI1_IRQHandler(void) {
+  Pinetime::Trace::IsrScope isrScope;
+  twiMaster.OnInterrupt();
+}
+
+void RTC2_IRQHandler(void) {
+  Pinetime::Trace::IsrScope isrScope;
+  Pinetime::Drivers::RtcCounter::OnInterrupt();
+}
+
+// The PC sampler needs the stack frame of the interrupted code : on the process stack (PSP) for a task, on the main
+// stack (MSP) for an interrupt, depending on bit 2 of EXC_RETURN
+void PcSamplerOnInterrupt(const uint32_t* stackFrame);
+__attribute__((naked)) void TIMER1_IRQHandler(void) {
+  __asm volatile("tst lr, #4\n"
+                 "ite eq\n"
+                 "mrseq r0, msp\n"
+                 "mrsne r0, psp\n"
+                 "b PcSamplerOnInterrupt\n");
+}
+
 void npl_freertos_hw_set_isr(int irqn, void (*addr)(void)) {
   switch (irqn) {
     case RADIO_IRQn:
@@ -307,6 +351,9 @@ int main(void) {
 
   nrf_drv_clock_init();
 
+  Pinetime::Drivers::RtcCounter::Init();
+  Pinetime::Profiling::Profiler::Init();
+
   // Unblock i2c?
   nrf_gpio_cfg(Pinetime::PinMap::TwiScl,
                NRF_GPIO_PIN_DIR_OUTPUT,
@@ -321,9 +368,6 @@ int main(void) {
   }
   nrf_gpio_cfg_default(Pinetime::PinMap::TwiScl);
 
-  debounceTimer = xTimerCreate("debounceTimer", 10, pdFALSE, nullptr, DebounceTimerCallback);
-  debounceChargeTimer = xTimerCreate("debounceTimerCharge", 200, pdFALSE, nullptr, DebounceTimerChargeCallback);
-
   // retrieve version stored by bootloader
   Pinetime::BootloaderVersion::SetVersion(NRF_TIMER2->CC[0]);
 
@@ -1,8 +1,8 @@
 #pragma once
 
 #include <FreeRTOS.h>
-#include <timers.h>
 #include <nrfx_gpiote.h>
 
 void nrfx_gpiote_evt_handler(nrfx_gpiote_pin_t pin, nrf_gpiote_polarity_t action);
-void DebounceTimerCallback(TimerHandle_t xTimer);
\ No newline at end of file
+void DebounceTimerCallback(void* context);
+void DebounceTimerChargeCallback(void* context);
\ No newline at end of file
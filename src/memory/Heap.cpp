@@ -0,0 +1,456 @@
+#include "memory/Heap.h"
+#include "memory/LvglHeap.h"
+#include <cstring>
+#include <task.h>
+
+using namespace Pinetime::Memory;
+
+namespace {
+  // The sizes and the positions of the blocks are counted in granules of 8 bytes : a block is a header (1 granule)
+  // followed by the data. The free blocks store the links of their list in their first data granule.
+  constexpr uint32_t granule = Heap::alignment;
+  constexpr uint16_t nbGranules = Heap::size / granule;
+  constexpr uint16_t minimumBlockSize = 2;
+  constexpr uint16_t none = UINT16_MAX;
+
+  // Second level : each power of 2 is split in 4 lists. First level 0 holds the sizes below 4 granules.
+  constexpr uint8_t slLog2 = 2;
+  constexpr uint8_t slCount = 1 << slLog2;
+  constexpr uint8_t flCount = 14;
+  static_assert(nbGranules < (1u << (flCount + slLog2 - 1)), "The first level must cover the whole heap");
+
+  struct Block {
+    uint16_t size;
+    /// Size of the previous block in memory, 0 for the first one
+    uint16_t previousSize;
+    uint8_t owner;
+    uint8_t isFree;
+    uint16_t reserved;
+  };
+  static_assert(sizeof(Block) == granule, "The header of a block is a granule");
+
+  struct Links {
+    uint16_t next;
+    uint16_t previous;
+  };
+
+  struct LowMemoryHandlerEntry {
+    Heap::LowMemoryHandler handler;
+    void* context;
+  };
+
+  alignas(Heap::alignment) uint8_t pool[nbGranules * granule];
+  bool initialized = false;
+  uint16_t flBitmap = 0;
+  uint8_t slBitmaps[flCount] = {};
+  uint16_t heads[flCount][slCount];
+
+  uint32_t freeGranules = 0;
+  uint32_t minimumFreeGranules = 0;
+  Heap::OwnerStatistics ownerStatistics[Heap::nbOwners] = {};
+
+  LowMemoryHandlerEntry lowMemoryHandlers[Heap::maxLowMemoryHandlers] = {};
+  uint8_t nbLowMemoryHandlers = 0;
+  // Set when the handlers were called, until the free memory goes back above the threshold (with some hysteresis)
+  bool lowMemorySignalled = false;
+
+  Block& BlockAt(uint16_t index) {
+    return *reinterpret_cast<Block*>(pool + index * granule);
+  }
+
+  Links& LinksOf(uint16_t index) {
+    return *reinterpret_cast<Links*>(pool + (index + 1) * granule);
+  }
+
+  uint16_t IndexOf(void* pointer) {
+    return static_cast<uint16_t>((static_cast<uint8_t*>(pointer) - pool) / granule - 1);
+  }
+
+  void* DataOf(uint16_t index) {
+    return pool + (index + 1) * granule;
+  }
+
+  uint8_t Log2(uint32_t value) {
+    return static_cast<uint8_t>(31 - __builtin_clz(value));
+  }
+
+  void Mapping(uint16_t size, uint8_t& fl, uint8_t& sl) {
+    if (size < slCount) {
+      fl = 0;
+      sl = static_cast<uint8_t>(size);
+    } else {
+      const uint8_t log2 = Log2(size);
+      sl = static_cast<uint8_t>((size >> (log2 - slLog2)) & (slCount - 1));
+      fl = static_cast<uint8_t>(log2 - slLog2 + 1);
+    }
+  }
+
+  void Insert(uint16_t index) {
+    uint8_t fl, sl;
+    Mapping(BlockAt(index).size, fl, sl);
+    LinksOf(index) = {heads[fl][sl], none};
+    if (heads[fl][sl] != none) {
+      LinksOf(heads[fl][sl]).previous = index;
+    }
+    heads[fl][sl] = index;
+    slBitmaps[fl] |= (1 << sl);
+    flBitmap |= (1 << fl);
+    BlockAt(index).isFree = 1;
+  }
+
+  void Remove(uint16_t index) {
+    uint8_t fl, sl;
+    Mapping(BlockAt(index).size, fl, sl);
+    const Links links = LinksOf(index);
+    if (links.previous != none) {
+      LinksOf(links.previous).next = links.next;
+    } else {
+      heads[fl][sl] = links.next;
+      if (links.next == none) {
+        slBitmaps[fl] &= ~(1 << sl);
+        if (slBitmaps[fl] == 0) {
+          flBitmap &= ~(1 << fl);
+        }
+      }
+    }
+    if (links.next != none) {
+      LinksOf(links.next).previous = links.previous;
+    }
+    BlockAt(index).isFree = 0;
+  }
+
+  // Good fit : the size is rounded up to the next list, so that any block of the list found is large enough. When there
+  // is none, the list of the size itself is searched : its blocks may be large enough too.
+  uint16_t FindFreeBlock(uint16_t size) {
+    uint8_t fl, sl;
+    Mapping(static_cast<uint16_t>((size >= slCount) ? size + (1 << (Log2(size) - slLog2)) - 1 : size), fl, sl);
+    if (fl < flCount) {
+      uint32_t slMap = slBitmaps[fl] & (~0u << sl);
+      if (slMap == 0) {
+        const uint32_t flMap = flBitmap & (~0u << (fl + 1));
+        if (flMap != 0) {
+          fl = static_cast<uint8_t>(__builtin_ctz(flMap));
+          slMap = slBitmaps[fl];
+        }
+      }
+      if (slMap != 0) {
+        return heads[fl][__builtin_ctz(slMap)];
+      }
+    }
+    Mapping(size, fl, sl);
+    for (uint16_t index = heads[fl][sl]; index != none; index = LinksOf(index).next) {
+      if (BlockAt(index).size >= size) {
+        return index;
+      }
+    }
+    return none;
+  }
+
+  void SetPreviousSizeOfNext(uint16_t index) {
+    BlockAt(index + BlockAt(index).size).previousSize = BlockAt(index).size;
+  }
+
+  // Keeps the first granules of the block, and puts the rest back in the free lists
+  void Split(uint16_t index, uint16_t size) {
+    Block& block = BlockAt(index);
+    if (block.size - size < minimumBlockSize) {
+      return;
+    }
+    const auto remainder = static_cast<uint16_t>(index + size);
+    BlockAt(remainder) = {static_cast<uint16_t>(block.size - size), size, 0, 0, 0};
+    block.size = size;
+    SetPreviousSizeOfNext(remainder);
+    // The remainder can be merged with the next block
+    const auto next = static_cast<uint16_t>(remainder + BlockAt(remainder).size);
+    if (BlockAt(next).isFree) {
+      Remove(next);
+      BlockAt(remainder).size += BlockAt(next).size;
+      SetPreviousSizeOfNext(remainder);
+    }
+    Insert(remainder);
+  }
+
+  void Init() {
+    for (auto& flHeads : heads) {
+      for (auto& head : flHeads) {
+        head = none;
+      }
+    }
+    // The last granule is a used block : the merges stop there
+    BlockAt(0) = {static_cast<uint16_t>(nbGranules - 1), 0, 0, 0, 0};
+    BlockAt(nbGranules - 1) = {1, static_cast<uint16_t>(nbGranules - 1), static_cast<uint8_t>(Owners::Count), 0, 0};
+    Insert(0);
+    freeGranules = minimumFreeGranules = nbGranules - 1;
+    initialized = true;
+  }
+
+  uint16_t SizeInGranules(size_t size) {
+    const size_t dataGranules = (size + granule - 1) / granule;
+    const size_t blockSize = 1 + ((dataGranules > 0) ? dataGranules : 1);
+    return (blockSize < nbGranules) ? static_cast<uint16_t>(blockSize) : none;
+  }
+
+  // Positive when the owner takes granules, negative when it gives them back
+  void Account(uint8_t owner, int32_t granules) {
+    auto& statistics = ownerStatistics[owner];
+    statistics.usedBytes += granules * static_cast<int32_t>(granule);
+    if (statistics.usedBytes > statistics.peakBytes) {
+      statistics.peakBytes = statistics.usedBytes;
+    }
+    freeGranules -= granules;
+    if (freeGranules < minimumFreeGranules) {
+      minimumFreeGranules = freeGranules;
+    }
+  }
+
+  void* AllocateLocked(uint16_t size, Owners owner) {
+    const uint16_t index = (size != none) ? FindFreeBlock(size) : none;
+    if (index == none) {
+      ownerStatistics[static_cast<uint8_t>(owner)].failures++;
+      return nullptr;
+    }
+    Remove(index);
+    Split(index, size);
+    BlockAt(index).owner = static_cast<uint8_t>(owner);
+    ownerStatistics[BlockAt(index).owner].nbBlocks++;
+    Account(BlockAt(index).owner, BlockAt(index).size);
+    return DataOf(index);
+  }
+
+  void FreeLocked(uint16_t index) {
+    ownerStatistics[BlockAt(index).owner].nbBlocks--;
+    Account(BlockAt(index).owner, -static_cast<int32_t>(BlockAt(index).size));
+    const auto next = static_cast<uint16_t>(index + BlockAt(index).size);
+    if (BlockAt(next).isFree) {
+      Remove(next);
+      BlockAt(index).size += BlockAt(next).size;
+    }
+    if (BlockAt(index).previousSize != 0) {
+      const auto previous = static_cast<uint16_t>(index - BlockAt(index).previousSize);
+      if (BlockAt(previous).isFree) {
+        Remove(previous);
+        BlockAt(previous).size += BlockAt(index).size;
+        index = previous;
+      }
+    }
+    SetPreviousSizeOfNext(index);
+    Insert(index);
+  }
+
+  // The scheduler is suspended instead of masking the interrupts, like heap_4 of FreeRTOS
+  void Lock() {
+    vTaskSuspendAll();
+    if (!initialized) {
+      Init();
+    }
+  }
+
+  // Returns true when the low memory handlers must be called
+  bool Unlock(bool failed) {
+    bool signal = false;
+    const uint32_t freeBytes = freeGranules * granule;
+    if (failed || freeBytes < Heap::lowMemoryThreshold) {
+      signal = !lowMemorySignalled;
+      lowMemorySignalled = true;
+    } else if (freeBytes > Heap::lowMemoryThreshold + Heap::lowMemoryThreshold / 2) {
+      lowMemorySignalled = false;
+    }
+    xTaskResumeAll();
+    return signal;
+  }
+
+  void SignalLowMemory() {
+    for (uint8_t i = 0; i < nbLowMemoryHandlers; i++) {
+      lowMemoryHandlers[i].handler(lowMemoryHandlers[i].context);
+    }
+  }
+}
+
+void* Heap::Allocate(size_t size, Owners owner) {
+  const uint16_t granules = SizeInGranules(size);
+  Lock();
+  void* pointer = AllocateLocked(granules, owner);
+  if (Unlock(pointer == nullptr)) {
+    SignalLowMemory();
+  }
+  return pointer;
+}
+
+void* Heap::Reallocate(void* pointer, size_t size, Owners owner) {
+  if (pointer == nullptr) {
+    return Allocate(size, owner);
+  }
+  if (size == 0) {
+    Free(pointer);
+    return nullptr;
+  }
+  const uint16_t granules = SizeInGranules(size);
+  uint16_t index = IndexOf(pointer);
+  Lock();
+  void* result = pointer;
+  Block& block = BlockAt(index);
+  const uint16_t oldSize = block.size;
+  const auto next = static_cast<uint16_t>(index + block.size);
+  if (granules == none) {
+    ownerStatistics[block.owner].failures++;
+    result = nullptr;
+  } else if (granules <= block.size) {
+    Split(index, granules);
+  } else if (BlockAt(next).isFree && block.size + BlockAt(next).size >= granules) {
+    // Grows in place over the next block
+    Remove(next);
+    block.size += BlockAt(next).size;
+    SetPreviousSizeOfNext(index);
+    Split(index, granules);
+  } else {
+    result = AllocateLocked(granules, static_cast<Owners>(block.owner));
+    if (result != nullptr) {
+      std::memcpy(result, pointer, (oldSize - 1) * granule);
+      FreeLocked(index);
+    }
+  }
+  if (result == pointer) {
+    Account(block.owner, static_cast<int32_t>(block.size) - oldSize);
+  }
+  if (Unlock(result == nullptr)) {
+    SignalLowMemory();
+  }
+  return result;
+}
+
+void Heap::Free(void* pointer) {
+  if (pointer == nullptr) {
+    return;
+  }
+  Lock();
+  FreeLocked(IndexOf(pointer));
+  Unlock(false);
+}
+
+Heap::Statistics Heap::GetStatistics() {
+  Lock();
+  uint16_t largest = 0;
+  uint16_t nbFreeBlocks = 0;
+  for (uint8_t fl = 0; fl < flCount; fl++) {
+    for (uint8_t sl = 0; sl < slCount; sl++) {
+      for (uint16_t index = heads[fl][sl]; index != none; index = LinksOf(index).next) {
+        nbFreeBlocks++;
+        if (BlockAt(index).size > largest) {
+          largest = BlockAt(index).size;
+        }
+      }
+    }
+  }
+  Statistics statistics {freeGranules * granule, minimumFreeGranules * granule, 0, nbFreeBlocks, 0};
+  Unlock(false);
+
+  // The header of the largest block is not available to the allocation
+  statistics.largestFreeBlock = (largest > 0) ? (largest - 1) * granule : 0;
+  if (statistics.freeBytes > 0) {
+    statistics.fragmentationPercent = static_cast<uint8_t>(100 - (largest * granule * 100) / statistics.freeBytes);
+  }
+  return statistics;
+}
+
+Heap::OwnerStatistics Heap::GetOwnerStatistics(Owners owner) {
+  Lock();
+  OwnerStatistics statistics = ownerStatistics[static_cast<uint8_t>(owner)];
+  Unlock(false);
+  return statistics;
+}
+
+bool Heap::IsLow() {
+  return freeGranules * granule < lowMemoryThreshold;
+}
+
+bool Heap::AddLowMemoryHandler(LowMemoryHandler handler, void* context) {
+  if (nbLowMemoryHandlers == maxLowMemoryHandlers) {
+    return false;
+  }
+  lowMemoryHandlers[nbLowMemoryHandlers] = {handler, context};
+  nbLowMemoryHandlers++;
+  return true;
+}
+
+const char* Heap::Name(Owners owner) {
+  switch (owner) {
+    case Owners::Kernel:
+      return "kernel";
+    case Owners::Lvgl:
+      return "lvgl";
+    case Owners::Libc:
+      return "libc";
+    default:
+      return "";
+  }
+}
+
+extern "C" {
+// FreeRTOS (replaces heap_4.c)
+void* pvPortMalloc(size_t size) {
+  return Heap::Allocate(size, Owners::Kernel);
+}
+
+void vPortFree(void* pointer) {
+  Heap::Free(pointer);
+}
+
+size_t xPortGetFreeHeapSize(void) {
+  return Heap::GetStatistics().freeBytes;
+}
+
+size_t xPortGetMinimumEverFreeHeapSize(void) {
+  return Heap::GetStatistics().minimumFreeBytes;
+}
+
+// LVGL (see lv_conf.h)
+void* HeapLvglAllocate(size_t size) {
+  return Heap::Allocate(size, Owners::Lvgl);
+}
+
+void HeapLvglFree(void* pointer) {
+  Heap::Free(pointer);
+}
+
+// newlib : the allocation functions are wrapped by the linker (--wrap, see src/CMakeLists.txt)
+struct _reent;
+
+void* __wrap_malloc(size_t size) {
+  return Heap::Allocate(size, Owners::Libc);
+}
+
+void* __wrap__malloc_r(struct _reent* /*reent*/, size_t size) {
+  return Heap::Allocate(size, Owners::Libc);
+}
+
+void __wrap_free(void* pointer) {
+  Heap::Free(pointer);
+}
+
+void __wrap__free_r(struct _reent* /*reent*/, void* pointer) {
+  Heap::Free(pointer);
+}
+
+void* __wrap_realloc(void* pointer, size_t size) {
+  return Heap::Reallocate(pointer, size, Owners::Libc);
+}
+
+void* __wrap__realloc_r(struct _reent* /*reent*/, void* pointer, size_t size) {
+  return Heap::Reallocate(pointer, size, Owners::Libc);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  if (size != 0 && count > SIZE_MAX / size) {
+    return nullptr;
+  }
+  void* pointer = Heap::Allocate(count * size, Owners::Libc);
+  if (pointer != nullptr) {
+    std::memset(pointer, 0, count * size);
+  }
+  return pointer;
+}
+
+void* __wrap__calloc_r(struct _reent* /*reent*/, size_t count, size_t size) {
+  return __wrap_calloc(count, size);
+}
+}
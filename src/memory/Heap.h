@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <FreeRTOS.h>
+
+namespace Pinetime {
+  namespace Memory {
+    /// Values shared with the diagnostics service (see doc/DiagnosticsService.md)
+    enum class Owners : uint8_t {
+      /// pvPortMalloc() : the kernel objects are allocated statically (configSUPPORT_DYNAMIC_ALLOCATION is 0), this
+      /// is the memory allocated by the direct calls of pvPortMalloc()
+      Kernel,
+      /// lv_mem_alloc() : screens and widgets
+      Lvgl,
+      /// malloc() and new : the containers and the objects of the firmware
+      Libc,
+      Count
+    };
+
+    /// Single heap shared by FreeRTOS, LVGL and newlib, so that none of them needs its own headroom. Two-level
+    /// segregated fit (TLSF) allocator : the free blocks are sorted by size in lists indexed by bitmaps, allocations
+    /// and frees are O(1), and the adjacent free blocks are merged immediately.
+    ///
+    /// The allocations are accounted per owner. When the free memory drops below lowMemoryThreshold, or when an
+    /// allocation fails, the low memory handlers are called so that the screens and the services can drop their caches.
+    /// The heap can't be used from an interrupt.
+    class Heap {
+    public:
+      static constexpr size_t size = configTOTAL_HEAP_SIZE;
+      static constexpr size_t alignment = 8;
+      static constexpr size_t lowMemoryThreshold = 2048;
+      static constexpr uint8_t maxLowMemoryHandlers = 4;
+      static constexpr uint8_t nbOwners = static_cast<uint8_t>(Owners::Count);
+      using LowMemoryHandler = void (*)(void* context);
+
+      struct Statistics {
+        uint32_t freeBytes;
+        uint32_t minimumFreeBytes;
+        uint32_t largestFreeBlock;
+        uint16_t nbFreeBlocks;
+        /// 100 - largestFreeBlock * 100 / freeBytes : the share of the free memory that can't serve the largest allocation
+        uint8_t fragmentationPercent;
+      };
+
+      /// The blocks include a header of 8 bytes
+      struct OwnerStatistics {
+        uint32_t usedBytes;
+        uint32_t peakBytes;
+        uint32_t nbBlocks;
+        uint32_t failures;
+      };
+
+      static void* Allocate(size_t size, Owners owner);
+      static void* Reallocate(void* pointer, size_t size, Owners owner);
+      static void Free(void* pointer);
+
+      static Statistics GetStatistics();
+      static OwnerStatistics GetOwnerStatistics(Owners owner);
+      static bool IsLow();
+      /// The handlers are called by the task that allocated or freed the memory, outside of the heap lock
+      static bool AddLowMemoryHandler(LowMemoryHandler handler, void* context);
+      static const char* Name(Owners owner);
+    };
+  }
+}
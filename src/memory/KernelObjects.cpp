@@ -0,0 +1,25 @@
+#include "memory/KernelObjects.h"
+#include <timers.h>
+
+// Storage of the tasks created by the kernel, required by configSUPPORT_STATIC_ALLOCATION
+
+namespace {
+  StackType_t idleTaskStack[configMINIMAL_STACK_SIZE];
+  StaticTask_t idleTaskBuffer;
+  StackType_t timerTaskStack[configTIMER_TASK_STACK_DEPTH];
+  StaticTask_t timerTaskBuffer;
+}
+
+extern "C" {
+void vApplicationGetIdleTaskMemory(StaticTask_t** taskBuffer, StackType_t** stack, uint32_t* stackDepth) {
+  *taskBuffer = &idleTaskBuffer;
+  *stack = idleTaskStack;
+  *stackDepth = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationGetTimerTaskMemory(StaticTask_t** taskBuffer, StackType_t** stack, uint32_t* stackDepth) {
+  *taskBuffer = &timerTaskBuffer;
+  *stack = timerTaskStack;
+  *stackDepth = configTIMER_TASK_STACK_DEPTH;
+}
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+#include <semphr.h>
+
+namespace Pinetime {
+  namespace Memory {
+    /// Stack and control block of a task, sized at compile time : the task is not allocated from the heap, and its RAM
+    /// is accounted to the object that owns it by the linker (see tools/ram-budget)
+    template <uint32_t stackDepth>
+    class StaticTask {
+    public:
+      static constexpr uint32_t stackBytes = stackDepth * sizeof(StackType_t);
+
+      /// Can't fail, the task is created once per storage
+      TaskHandle_t Create(TaskFunction_t function, const char* name, UBaseType_t priority, void* parameter) {
+        return xTaskCreateStatic(function, name, stackDepth, parameter, priority, stack, &buffer);
+      }
+
+    private:
+      StackType_t stack[stackDepth];
+      StaticTask_t buffer;
+    };
+
+    /// Storage of a queue of length items
+    template <typename Item, UBaseType_t length>
+    class StaticQueue {
+    public:
+      QueueHandle_t Create() {
+        return xQueueCreateStatic(length, sizeof(Item), storage, &buffer);
+      }
+
+    private:
+      uint8_t storage[length * sizeof(Item)];
+      StaticQueue_t buffer;
+    };
+
+    class StaticBinarySemaphore {
+    public:
+      SemaphoreHandle_t Create() {
+        return xSemaphoreCreateBinaryStatic(&buffer);
+      }
+
+    private:
+      StaticSemaphore_t buffer;
+    };
+
+    /// Mutex with priority inheritance
+    class StaticMutex {
+    public:
+      SemaphoreHandle_t Create() {
+        return xSemaphoreCreateMutexStatic(&buffer);
+      }
+
+    private:
+      StaticSemaphore_t buffer;
+    };
+  }
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <stddef.h>
+
+/* Allocator of LVGL (LV_MEM_CUSTOM_ALLOC and LV_MEM_CUSTOM_FREE in lv_conf.h), included by the C sources of LVGL */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void* HeapLvglAllocate(size_t size);
+void HeapLvglFree(void* pointer);
+
+#ifdef __cplusplus
+}
+#endif
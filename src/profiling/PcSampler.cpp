@@ -0,0 +1,129 @@
+#include "profiling/PcSampler.h"
+#include <nrfx.h>
+#include <hal/nrf_timer.h>
+
+using namespace Pinetime::Profiling;
+
+namespace {
+  // Above the kernel (tick, PendSV) and RTC2, which are sampled too, but below all the other interrupts
+  constexpr uint8_t interruptPriority = 6;
+  constexpr uint32_t flashSize = 0x80000;
+  constexpr uint8_t capacityLog2 = 8;
+  constexpr uint8_t maxProbes = 8;
+  static_assert(PcSampler::capacity == (1 << capacityLog2), "The hash of the buckets needs a power of 2");
+  static_assert((flashSize >> PcSampler::bucketShift) <= 0x10000, "The buckets of the flash must fit in 16 bits");
+
+  NRF_TIMER_Type* const timer = NRF_TIMER1;
+
+  PcSampler::Entry entries[PcSampler::capacity];
+  PcSampler::Statistics statistics;
+  volatile bool running = false;
+  uint16_t periodUs = PcSampler::defaultPeriodUs;
+
+  // Fibonacci hashing : the high bits of the product depend on all the bits of the bucket
+  uint8_t Hash(uint16_t bucket) {
+    return static_cast<uint8_t>(static_cast<uint16_t>(bucket * 40503u) >> (16 - capacityLog2));
+  }
+
+  // Keeps the ratios between the buckets instead of saturating the hottest one
+  void Halve() {
+    for (auto& entry : entries) {
+      entry.count /= 2;
+    }
+    statistics.halvings++;
+  }
+}
+
+void PcSampler::Start(uint16_t period) {
+  Stop();
+  periodUs = (period > 0) ? period : defaultPeriodUs;
+  nrf_timer_mode_set(timer, NRF_TIMER_MODE_TIMER);
+  nrf_timer_bit_width_set(timer, NRF_TIMER_BIT_WIDTH_32);
+  nrf_timer_frequency_set(timer, NRF_TIMER_FREQ_1MHz);
+  nrf_timer_cc_write(timer, NRF_TIMER_CC_CHANNEL0, periodUs);
+  nrf_timer_shorts_enable(timer, NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK);
+  nrf_timer_event_clear(timer, NRF_TIMER_EVENT_COMPARE0);
+  nrf_timer_int_enable(timer, NRF_TIMER_INT_COMPARE0_MASK);
+  NRFX_IRQ_PRIORITY_SET(TIMER1_IRQn, interruptPriority);
+  NRFX_IRQ_ENABLE(TIMER1_IRQn);
+  running = true;
+  nrf_timer_task_trigger(timer, NRF_TIMER_TASK_CLEAR);
+  nrf_timer_task_trigger(timer, NRF_TIMER_TASK_START);
+}
+
+void PcSampler::Stop() {
+  // SHUTDOWN releases the 16 MHz clock
+  nrf_timer_task_trigger(timer, NRF_TIMER_TASK_SHUTDOWN);
+  nrf_timer_int_disable(timer, NRF_TIMER_INT_COMPARE0_MASK);
+  NRFX_IRQ_DISABLE(TIMER1_IRQn);
+  running = false;
+}
+
+void PcSampler::Clear() {
+  NRFX_IRQ_DISABLE(TIMER1_IRQn);
+  for (auto& entry : entries) {
+    entry = {};
+  }
+  statistics = {};
+  if (running) {
+    NRFX_IRQ_ENABLE(TIMER1_IRQn);
+  }
+}
+
+bool PcSampler::IsRunning() {
+  return running;
+}
+
+uint16_t PcSampler::PeriodUs() {
+  return periodUs;
+}
+
+PcSampler::Statistics PcSampler::GetStatistics() {
+  NRFX_IRQ_DISABLE(TIMER1_IRQn);
+  Statistics copy = statistics;
+  if (running) {
+    NRFX_IRQ_ENABLE(TIMER1_IRQn);
+  }
+  return copy;
+}
+
+PcSampler::Entry PcSampler::GetEntry(size_t index) {
+  return entries[index];
+}
+
+void PcSampler::OnInterrupt(uint32_t pc) {
+  nrf_timer_event_clear(timer, NRF_TIMER_EVENT_COMPARE0);
+  // Make sure that the event is cleared before the end of the interrupt, or it would fire again
+  (void) nrf_timer_event_check(timer, NRF_TIMER_EVENT_COMPARE0);
+
+  statistics.samples++;
+  const uint16_t bucket = static_cast<uint16_t>(pc >> bucketShift);
+  if (pc >= flashSize || bucket == 0) {
+    statistics.outside++;
+    return;
+  }
+
+  const uint8_t index = Hash(bucket);
+  for (uint8_t probe = 0; probe < maxProbes; probe++) {
+    Entry& entry = entries[(index + probe) % capacity];
+    if (entry.bucket == bucket) {
+      if (entry.count == UINT16_MAX) {
+        Halve();
+      }
+      entry.count++;
+      return;
+    }
+    if (entry.bucket == 0) {
+      entry = {bucket, 1};
+      return;
+    }
+  }
+  statistics.lost++;
+}
+
+extern "C" {
+// Called by TIMER1_IRQHandler (see main.cpp) with the exception stack frame : r0-r3, r12, lr, pc, xPSR
+void PcSamplerOnInterrupt(const uint32_t* stackFrame) {
+  PcSampler::OnInterrupt(stackFrame[6]);
+}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace Pinetime {
+  namespace Profiling {
+    /// Statistical profiler : a timer interrupt samples the PC of the code it interrupted, and counts the samples per
+    /// bucket of 2^bucketShift bytes of flash in a hash table. The host symbolises the buckets with the ELF file of the
+    /// firmware (see tools/pc-sampler). Off by default : the timer keeps the 16 MHz clock running while sampling.
+    class PcSampler {
+    public:
+      static constexpr size_t capacity = 256;
+      static constexpr uint8_t bucketShift = 3;
+      /// A prime number of us, so that the sampling does not lock on the 1024 Hz tick of FreeRTOS
+      static constexpr uint16_t defaultPeriodUs = 1009;
+
+      /// Address of the bucket : bucket << bucketShift. Bucket 0 is an empty entry.
+      struct Entry {
+        uint16_t bucket;
+        uint16_t count;
+      };
+
+      struct Statistics {
+        uint32_t samples = 0;
+        /// Samples outside of the internal flash (code in RAM)
+        uint32_t outside = 0;
+        /// Samples dropped because the hash table was full around their bucket
+        uint32_t lost = 0;
+        /// Number of times all the counts were halved because one of them saturated
+        uint32_t halvings = 0;
+      };
+
+      static void Start(uint16_t periodUs = defaultPeriodUs);
+      static void Stop();
+      static void Clear();
+      static bool IsRunning();
+      static uint16_t PeriodUs();
+      static Statistics GetStatistics();
+      static Entry GetEntry(size_t index);
+
+      /// Called by the timer interrupt (TIMER1_IRQHandler), with the PC saved in the exception stack frame
+      static void OnInterrupt(uint32_t pc);
+    };
+  }
+}
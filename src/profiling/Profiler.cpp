@@ -0,0 +1,115 @@
+#include "profiling/Profiler.h"
+#include <FreeRTOS.h>
+#include <task.h>
+
+using namespace Pinetime::Profiling;
+
+const char* Profiler::Name(Zones zone) {
+  switch (zone) {
+    case Zones::LvglTaskHandler:
+      return "lvTask";
+    case Zones::DisplayFlush:
+      return "flush";
+    case Zones::HeartRate:
+      return "ppg";
+    case Zones::MotionProcess:
+      return "bma421";
+    case Zones::FlashRead:
+      return "fsRead";
+    case Zones::FlashProg:
+      return "fsProg";
+    case Zones::GattAlertNotification:
+      return "gattAns";
+    case Zones::GattBattery:
+      return "gattBas";
+    case Zones::GattCurrentTime:
+      return "gattCts";
+    case Zones::GattDeviceInformation:
+      return "gattDis";
+    case Zones::GattDfu:
+      return "gattDfu";
+    case Zones::GattDiagnostics:
+      return "gattDiag";
+    case Zones::GattFs:
+      return "gattFs";
+    case Zones::GattHeartRate:
+      return "gattHrs";
+    case Zones::GattImmediateAlert:
+      return "gattIas";
+    case Zones::GattMotion:
+      return "gattMot";
+    case Zones::GattMusic:
+      return "gattMus";
+    case Zones::GattNavigation:
+      return "gattNav";
+    case Zones::GattWeather:
+      return "gattWea";
+    default:
+      return "";
+  }
+}
+
+#ifdef ENABLE_PROFILING
+namespace {
+  Profiler::Statistics statistics[Profiler::nbZones];
+
+  uint8_t BucketOf(uint32_t cycles) {
+    // 31 - clz is the position of the highest bit
+    int log2 = (cycles > 0) ? (31 - __builtin_clz(cycles)) : 0;
+    int bucket = log2 - Profiler::firstBucketLog2;
+    return (bucket < 0) ? 0 : (bucket >= Profiler::nbBuckets) ? (Profiler::nbBuckets - 1) : static_cast<uint8_t>(bucket);
+  }
+}
+
+void Profiler::Init() {
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+// The zones are used by several tasks (flash, GATT...), the statistics are updated with the interrupts masked
+void Profiler::Add(Zones zone, uint32_t cycles) {
+  const uint8_t bucket = BucketOf(cycles);
+  UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+  Statistics& zoneStatistics = statistics[static_cast<uint8_t>(zone)];
+  if (zoneStatistics.count == 0 || cycles < zoneStatistics.minCycles) {
+    zoneStatistics.minCycles = cycles;
+  }
+  if (cycles > zoneStatistics.maxCycles) {
+    zoneStatistics.maxCycles = cycles;
+  }
+  zoneStatistics.count++;
+  zoneStatistics.totalCycles += cycles;
+  if (zoneStatistics.histogram[bucket] < UINT16_MAX) {
+    zoneStatistics.histogram[bucket]++;
+  }
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+Profiler::Statistics Profiler::GetStatistics(Zones zone) {
+  UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+  Statistics copy = statistics[static_cast<uint8_t>(zone)];
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+  return copy;
+}
+
+void Profiler::Reset() {
+  UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+  for (auto& zoneStatistics : statistics) {
+    zoneStatistics = {};
+  }
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+#else
+void Profiler::Init() {
+}
+
+void Profiler::Add(Zones /*zone*/, uint32_t /*cycles*/) {
+}
+
+Profiler::Statistics Profiler::GetStatistics(Zones /*zone*/) {
+  return {};
+}
+
+void Profiler::Reset() {
+}
+#endif
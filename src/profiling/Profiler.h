@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#ifdef ENABLE_PROFILING
+  #include <nrf.h>
+#endif
+
+namespace Pinetime {
+  namespace Profiling {
+    /// Values shared with the diagnostics service (see doc/DiagnosticsService.md)
+    enum class Zones : uint8_t {
+      LvglTaskHandler,
+      DisplayFlush,
+      HeartRate,
+      MotionProcess,
+      FlashRead,
+      FlashProg,
+      GattAlertNotification,
+      GattBattery,
+      GattCurrentTime,
+      GattDeviceInformation,
+      GattDfu,
+      GattDiagnostics,
+      GattFs,
+      GattHeartRate,
+      GattImmediateAlert,
+      GattMotion,
+      GattMusic,
+      GattNavigation,
+      GattWeather,
+      Count
+    };
+
+    /// Duration of the zones, in CPU cycles (DWT->CYCCNT, 64 per us). The duration of a zone includes the time spent
+    /// in the tasks and the interrupts that preempted it, but not the time the CPU was asleep.
+    class Profiler {
+    public:
+      static constexpr uint8_t nbZones = static_cast<uint8_t>(Zones::Count);
+      static constexpr uint8_t nbBuckets = 16;
+      /// Bucket 0 counts the durations below 2^(firstBucketLog2 + 1) cycles, bucket i the durations in
+      /// [2^(firstBucketLog2 + i), 2^(firstBucketLog2 + i + 1)), and the last bucket all the longer ones
+      static constexpr uint8_t firstBucketLog2 = 8;
+      static constexpr uint32_t cyclesPerUs = 64;
+#ifdef ENABLE_PROFILING
+      static constexpr bool enabled = true;
+#else
+      static constexpr bool enabled = false;
+#endif
+
+      struct Statistics {
+        uint32_t count = 0;
+        uint32_t minCycles = 0;
+        uint32_t maxCycles = 0;
+        uint64_t totalCycles = 0;
+        uint16_t histogram[nbBuckets] = {};
+      };
+
+      /// Starts the cycle counter, must be called before the first zone
+      static void Init();
+      static void Add(Zones zone, uint32_t cycles);
+      /// Copy of the statistics of a zone (all zero when the profiling is disabled)
+      static Statistics GetStatistics(Zones zone);
+      static void Reset();
+      static const char* Name(Zones zone);
+    };
+
+#ifdef ENABLE_PROFILING
+    /// Measures the lifetime of the object and adds it to the statistics of the zone
+    class Zone {
+    public:
+      explicit Zone(Zones zone) : zone {zone}, start {DWT->CYCCNT} {
+      }
+      ~Zone() {
+        Profiler::Add(zone, DWT->CYCCNT - start);
+      }
+
+    private:
+      Zones zone;
+      uint32_t start;
+    };
+#else
+    class Zone {
+    public:
+      explicit Zone(Zones /*zone*/) {
+      }
+    };
+#endif
+  }
+}
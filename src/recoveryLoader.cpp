@@ -19,6 +19,7 @@
 
 #include "displayapp/icons/infinitime/infinitime-nb.c"
 #include "components/rle/RleDecoder.h"
+#include "memory/KernelObjects.h"
 
 #if NRF_LOG_ENABLED
   #include "logging/NrfLogger.h"
@@ -29,6 +30,8 @@ Pinetime::Logging::DummyLogger logger;
 #endif
 
 
+Pinetime::Memory::StaticTask<512> mainTask;
+
 static constexpr uint8_t displayWidth = 240;
 static constexpr uint8_t displayHeight = 240;
 static constexpr uint8_t bytesPerPixel = 2;
@@ -140,13 +143,11 @@ void DisplayProgressBar(uint8_t percent, uint16_t color) {
 }
 
 int main(void) {
-  TaskHandle_t taskHandle;
   RefreshWatchdog();
   logger.Init();
   nrf_drv_clock_init();
 
-  if (pdPASS != xTaskCreate(Process, "MAIN", 512, nullptr, 0, &taskHandle))
-    APP_ERROR_HANDLER(NRF_ERROR_NO_MEM);
+  mainTask.Create(Process, "MAIN", 0, nullptr);
 
   vTaskStartScheduler();
 
@@ -0,0 +1,35 @@
+#include "systemtask/MessageBus.h"
+#include <nrf.h>
+
+using namespace Pinetime::System;
+
+MessageBusBase* MessageBusBase::registered = nullptr;
+
+MessageBusBase::MessageBusBase(const char* name, uint8_t laneSize) : name {name}, laneSize {laneSize} {
+  nextRegistered = registered;
+  registered = this;
+}
+
+void MessageBusBase::CreateSemaphore() {
+  semaphore = semaphoreStorage.Create();
+}
+
+void MessageBusBase::Signal(bool fromIsr) {
+  if (fromIsr) {
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    xSemaphoreGiveFromISR(semaphore, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+  } else {
+    xSemaphoreGive(semaphore);
+  }
+}
+
+/// The semaphore is given once for any number of messages : the receiver empties the lanes before waiting on it, and a
+/// wake-up may find the lanes empty when the messages were already received
+bool MessageBusBase::Wait(TickType_t timeout) {
+  return xSemaphoreTake(semaphore, timeout) == pdTRUE;
+}
+
+bool MessageBusBase::InIsr() {
+  return (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) != 0;
+}
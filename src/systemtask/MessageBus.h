@@ -0,0 +1,174 @@
+#pragma once
+
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <task.h>
+#include <cstdint>
+#include "memory/KernelObjects.h"
+
+namespace Pinetime {
+  namespace System {
+    /// Untyped part of the message buses : wake-up of the receiving task and statistics
+    class MessageBusBase {
+    public:
+      static constexpr uint8_t nbLanes = 2;
+
+      struct Statistics {
+        uint32_t sent = 0;
+        /// Messages merged into an identical message that was still pending
+        uint32_t coalesced = 0;
+        /// Messages sent from an interrupt while their lane was full
+        uint32_t dropped = 0;
+        /// Highest number of pending messages, per lane
+        uint8_t highWater[nbLanes] = {};
+      };
+
+      MessageBusBase(const MessageBusBase&) = delete;
+      MessageBusBase& operator=(const MessageBusBase&) = delete;
+
+      const char* Name() const {
+        return name;
+      }
+      uint8_t LaneSize() const {
+        return laneSize;
+      }
+      const Statistics& GetStatistics() const {
+        return statistics;
+      }
+      const MessageBusBase* NextRegistered() const {
+        return nextRegistered;
+      }
+      static const MessageBusBase* FirstRegistered() {
+        return registered;
+      }
+
+    protected:
+      MessageBusBase(const char* name, uint8_t laneSize);
+      void CreateSemaphore();
+      void Signal(bool fromIsr);
+      bool Wait(TickType_t timeout);
+      static bool InIsr();
+
+      // Masks the interrupts that may send messages, can be entered from a task or an interrupt
+      class CriticalSection {
+      public:
+        CriticalSection() : mask {taskENTER_CRITICAL_FROM_ISR()} {
+        }
+        ~CriticalSection() {
+          taskEXIT_CRITICAL_FROM_ISR(mask);
+        }
+
+      private:
+        UBaseType_t mask;
+      };
+
+      Statistics statistics;
+
+    private:
+      const char* name;
+      uint8_t laneSize;
+      SemaphoreHandle_t semaphore = nullptr;
+      Memory::StaticBinarySemaphore semaphoreStorage;
+      MessageBusBase* nextRegistered = nullptr;
+      static MessageBusBase* registered;
+    };
+
+    /// Message queue of a task. Each message carries a small inline payload, and goes into one of 2 lanes : the urgent
+    /// lane (input and alerts) is always emptied before the housekeeping lane. The lane of a message and whether it may
+    /// be coalesced are given by IsUrgent(Message), IsCoalescable(Message) and CarriesValue(Message), found next to the
+    /// definition of Message.
+    ///
+    /// A coalescable message is dropped when an identical message (same payload) is still pending. If it carries a value,
+    /// it is dropped when the same message is pending, whose payload is replaced by the latest value. Sending never blocks
+    /// in an interrupt : the message is dropped when its lane is full. A task waits until there is room in the lane.
+    template <typename Message, uint8_t slotsPerLane>
+    class MessageBus : public MessageBusBase {
+    public:
+      struct Envelope {
+        Message message;
+        uint32_t payload;
+      };
+
+      explicit MessageBus(const char* name) : MessageBusBase(name, slotsPerLane) {
+      }
+
+      /// Must be called before the first message is sent
+      void Init() {
+        CreateSemaphore();
+      }
+
+      bool Push(Message message, uint32_t payload = 0) {
+        bool fromIsr = InIsr();
+        Results result;
+        while ((result = TryPush({message, payload}, fromIsr)) == Results::Full && !fromIsr) {
+          vTaskDelay(1);
+        }
+        if (result == Results::Queued) {
+          Signal(fromIsr);
+        }
+        return result != Results::Full;
+      }
+
+      bool Receive(Envelope& envelope, TickType_t timeout) {
+        if (Pop(envelope)) {
+          return true;
+        }
+        return Wait(timeout) && Pop(envelope);
+      }
+
+    private:
+      enum class Results : uint8_t { Queued, Coalesced, Full };
+
+      struct Lane {
+        Envelope envelopes[slotsPerLane];
+        uint8_t first = 0;
+        uint8_t count = 0;
+      };
+
+      Results TryPush(const Envelope& envelope, bool fromIsr) {
+        CriticalSection criticalSection;
+        const uint8_t laneIndex = IsUrgent(envelope.message) ? 0 : 1;
+        Lane& lane = lanes[laneIndex];
+        if (IsCoalescable(envelope.message)) {
+          const bool carriesValue = CarriesValue(envelope.message);
+          for (uint8_t i = 0; i < lane.count; i++) {
+            Envelope& pending = lane.envelopes[(lane.first + i) % slotsPerLane];
+            if (pending.message == envelope.message && (carriesValue || pending.payload == envelope.payload)) {
+              pending.payload = envelope.payload;
+              statistics.coalesced++;
+              return Results::Coalesced;
+            }
+          }
+        }
+        if (lane.count == slotsPerLane) {
+          if (fromIsr) {
+            statistics.dropped++;
+          }
+          return Results::Full;
+        }
+        lane.envelopes[(lane.first + lane.count) % slotsPerLane] = envelope;
+        lane.count++;
+        statistics.sent++;
+        if (lane.count > statistics.highWater[laneIndex]) {
+          statistics.highWater[laneIndex] = lane.count;
+        }
+        return Results::Queued;
+      }
+
+      bool Pop(Envelope& envelope) {
+        CriticalSection criticalSection;
+        for (auto& lane : lanes) {
+          if (lane.count > 0) {
+            envelope = lane.envelopes[lane.first];
+            lane.first = (lane.first + 1) % slotsPerLane;
+            lane.count--;
+            return true;
+          }
+        }
+        return false;
+      }
+
+      Lane lanes[nbLanes];
+    };
+  }
+}
@@ -1,8 +1,9 @@
 #pragma once
+#include <cstdint>
 
 namespace Pinetime {
   namespace System {
-      enum class Messages {
+      enum class Messages : uint8_t {
         GoToSleep,
         GoToRunning,
         TouchWakeUp,
@@ -15,6 +16,7 @@ namespace Pinetime {
         BleFirmwareUpdateStarted,
         BleFirmwareUpdateFinished,
         OnTouchEvent,
+        OnMotionInterrupt,
         HandleButtonEvent,
         HandleButtonTimerEvent,
         OnDisplayTaskSleeping,
@@ -31,7 +33,60 @@ namespace Pinetime {
         BatteryPercentageUpdated,
         StartFileTransfer,
         StopFileTransfer,
-        BleRadioEnableToggle
+        BleRadioEnableToggle,
+        MotionStreamingChanged,
+        ClockTick,
+        StartBleDiscovery,
+        BinaryLogFlushRequested
       };
+
+      /// Input and alerts, handled before the housekeeping messages. The steps of the sleep transition share the lane of
+      /// the input : an input received after the display went to sleep must be handled after the transition ends.
+      inline bool IsUrgent(Messages message) {
+        switch (message) {
+          case Messages::GoToSleep:
+          case Messages::GoToRunning:
+          case Messages::OnDisplayTaskSleeping:
+          case Messages::TouchWakeUp:
+          case Messages::OnNewNotification:
+          case Messages::OnTimerDone:
+          case Messages::OnNewCall:
+          case Messages::BleFirmwareUpdateStarted:
+          case Messages::OnTouchEvent:
+          case Messages::HandleButtonEvent:
+          case Messages::HandleButtonTimerEvent:
+          case Messages::EnableSleeping:
+          case Messages::DisableSleeping:
+          case Messages::OnPairing:
+          case Messages::SetOffAlarm:
+          case Messages::StopRinging:
+            return true;
+          default:
+            return false;
+        }
+      }
+
+      /// Messages that only ask to refresh a state : an identical message still pending is enough
+      inline bool IsCoalescable(Messages message) {
+        switch (message) {
+          case Messages::OnNewTime:
+          case Messages::OnTouchEvent:
+          case Messages::OnMotionInterrupt:
+          case Messages::OnChargingEvent:
+          case Messages::MeasureBatteryTimerExpired:
+          case Messages::BatteryPercentageUpdated:
+          case Messages::MotionStreamingChanged:
+          case Messages::ClockTick:
+          case Messages::BinaryLogFlushRequested:
+            return true;
+          default:
+            return false;
+        }
+      }
+
+      /// Coalescable messages whose payload is a value : the pending message takes the payload of the latest one
+      inline bool CarriesValue(Messages message) {
+        return message == Messages::BatteryPercentageUpdated;
+      }
     }
 }
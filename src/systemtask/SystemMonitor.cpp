@@ -1,15 +1,52 @@
-#include "systemtask/SystemTask.h"
+#include "systemtask/SystemMonitor.h"
+#include "drivers/RtcCounter.h"
+
+using Pinetime::Drivers::RtcCounter;
+
+namespace {
+  // Time spent asleep in the tickless idle, in RTC ticks
+  volatile uint32_t sleepTime = 0;
+  uint32_t sleepStart = 0;
+}
+
+// The run time stats of FreeRTOS use RTC2 : unlike DWT->CYCCNT it keeps counting while the CPU sleeps, so the idle
+// task is charged for the sleep and the percentages add up to the wall-clock time
+extern "C" {
+uint32_t SystemMonitorRunTimeCounter() {
+  return RtcCounter::Now();
+}
+
+// Called with the interrupts disabled, around the sleep of vPortSuppressTicksAndSleep()
+void SystemMonitorEnterSleep() {
+  sleepStart = RtcCounter::Now();
+}
+
+void SystemMonitorExitSleep() {
+  sleepTime = sleepTime + (RtcCounter::Now() - sleepStart);
+}
+}
+
 #if configUSE_TRACE_FACILITY == 1
 // FreeRtosMonitor
-#include <FreeRTOS.h>
-#include <task.h>
+#include <algorithm>
 #include <nrf_log.h>
 
+namespace {
+  constexpr uint32_t snapshotPeriod = 15 * RtcCounter::frequency;
+
+  uint16_t ToPermille(uint32_t ticks, uint32_t window) {
+    return (window > 0) ? static_cast<uint16_t>((static_cast<uint64_t>(ticks) * 1000) / window) : 0;
+  }
+}
+
 void Pinetime::System::SystemMonitor::Process() {
   if (xTaskGetTickCount() - lastTick > 10000) {
     NRF_LOG_INFO("---------------------------------------\nFree heap : %d", xPortGetFreeHeapSize());
-    TaskStatus_t tasksStatus[10];
-    auto nb = uxTaskGetSystemState(tasksStatus, 10, nullptr);
+    xSemaphoreTake(tasksStatusMutex, portMAX_DELAY);
+    auto nb = ReadTasksStatus();
+    if (nb == 0) {
+      NRF_LOG_INFO("WARNING!!! %d tasks, only %d can be monitored", uxTaskGetNumberOfTasks(), maxTasks);
+    }
     for (uint32_t i = 0; i < nb; i++) {
       NRF_LOG_INFO("Task [%s] - %d", tasksStatus[i].pcTaskName, tasksStatus[i].usStackHighWaterMark);
       if (tasksStatus[i].usStackHighWaterMark < 20)
@@ -17,10 +54,79 @@ void Pinetime::System::SystemMonitor::Process() {
                       tasksStatus[i].pcTaskName,
                       tasksStatus[i].usStackHighWaterMark * 4);
     }
+    xSemaphoreGive(tasksStatusMutex);
     lastTick = xTaskGetTickCount();
   }
+
+  if (RtcCounter::Now() - snapshots[lastSnapshot].timestamp >= snapshotPeriod) {
+    auto snapshot = TakeSnapshot();
+    // Without the run time of the tasks, the load would be computed from the start of their run time counters
+    if (snapshot.nbTasks == 0) {
+      return;
+    }
+    taskENTER_CRITICAL();
+    lastSnapshot = (lastSnapshot + 1) % nbSnapshots;
+    snapshots[lastSnapshot] = snapshot;
+    taskEXIT_CRITICAL();
+  }
+}
+
+UBaseType_t Pinetime::System::SystemMonitor::ReadTasksStatus() const {
+  return uxTaskGetSystemState(tasksStatus, maxTasks, nullptr);
+}
+
+Pinetime::System::SystemMonitor::Snapshot Pinetime::System::SystemMonitor::TakeSnapshot() const {
+  Snapshot snapshot;
+  xSemaphoreTake(tasksStatusMutex, portMAX_DELAY);
+  snapshot.nbTasks = ReadTasksStatus();
+  snapshot.timestamp = RtcCounter::Now();
+  snapshot.sleepTime = sleepTime;
+  for (uint8_t i = 0; i < snapshot.nbTasks; i++) {
+    snapshot.taskNumbers[i] = static_cast<uint8_t>(tasksStatus[i].xTaskNumber);
+    snapshot.runTimes[i] = tasksStatus[i].ulRunTimeCounter;
+  }
+  xSemaphoreGive(tasksStatusMutex);
+  return snapshot;
+}
+
+Pinetime::System::SystemMonitor::CpuLoad Pinetime::System::SystemMonitor::GetCpuLoad() const {
+  taskENTER_CRITICAL();
+  Snapshot start = snapshots[(lastSnapshot + 1) % nbSnapshots];
+  taskEXIT_CRITICAL();
+
+  xSemaphoreTake(tasksStatusMutex, portMAX_DELAY);
+  auto nb = ReadTasksStatus();
+  const uint32_t window = RtcCounter::Now() - start.timestamp;
+
+  CpuLoad load;
+  load.windowMs = static_cast<uint32_t>((static_cast<uint64_t>(window) * 1000) / RtcCounter::frequency);
+  load.sleepPermille = ToPermille(sleepTime - start.sleepTime, window);
+  load.nbTasks = nb;
+  const TaskHandle_t idleTask = xTaskGetIdleTaskHandle();
+  for (uint8_t i = 0; i < nb; i++) {
+    // The tasks created after the start of the window have no previous value
+    uint32_t previous = 0;
+    for (uint8_t j = 0; j < start.nbTasks; j++) {
+      if (start.taskNumbers[j] == tasksStatus[i].xTaskNumber) {
+        previous = start.runTimes[j];
+        break;
+      }
+    }
+    load.tasks[i] = {tasksStatus[i].pcTaskName, ToPermille(tasksStatus[i].ulRunTimeCounter - previous, window)};
+    if (tasksStatus[i].xHandle == idleTask) {
+      load.idlePermille = load.tasks[i].permille;
+    }
+  }
+  xSemaphoreGive(tasksStatusMutex);
+  std::sort(load.tasks, load.tasks + load.nbTasks, [](const TaskLoad& lhs, const TaskLoad& rhs) {
+    return lhs.permille > rhs.permille;
+  });
+  return load;
 }
 #else
 // DummyMonitor
 void Pinetime::System::SystemMonitor::Process() {}
+Pinetime::System::SystemMonitor::CpuLoad Pinetime::System::SystemMonitor::GetCpuLoad() const {
+  return {};
+}
 #endif
@@ -1,15 +1,77 @@
 #pragma once
 #include <FreeRTOS.h> // declares configUSE_TRACE_FACILITY
 #include <task.h>
+#include <semphr.h>
+#include <cstdint>
+#include "memory/KernelObjects.h"
 
 namespace Pinetime {
   namespace System {
     class SystemMonitor {
     public:
+      /// uxTaskGetSystemState() fails when there are more tasks than that
+      static constexpr uint8_t maxTasks = 16;
+
+      struct TaskLoad {
+        const char* name;
+        uint16_t permille;
+      };
+
+      /// CPU time of each task over the window. The idle task includes the time the CPU is asleep, the interrupts are
+      /// accounted to the task they interrupted.
+      struct CpuLoad {
+        uint32_t windowMs = 0;
+        uint16_t idlePermille = 0;
+        uint16_t sleepPermille = 0;
+        uint8_t nbTasks = 0;
+        TaskLoad tasks[maxTasks] = {};
+      };
+
       void Process();
+      /// Load over the last minute or so, the tasks sorted by decreasing load
+      CpuLoad GetCpuLoad() const;
+
 #if configUSE_TRACE_FACILITY == 1
+      /// Calls visitor(const TaskStatus_t&) for each task, from the status buffer of the monitor (no array on the stack
+      /// of the caller). Returns the number of tasks visited, 0 if there are more than maxTasks tasks.
+      template <typename Visitor>
+      uint8_t VisitTasks(Visitor visitor) const {
+        xSemaphoreTake(tasksStatusMutex, portMAX_DELAY);
+        auto nb = static_cast<uint8_t>(ReadTasksStatus());
+        for (uint8_t i = 0; i < nb; i++) {
+          visitor(tasksStatus[i]);
+        }
+        xSemaphoreGive(tasksStatusMutex);
+        return nb;
+      }
+
     private:
+      struct Snapshot {
+        uint32_t timestamp;
+        uint32_t sleepTime;
+        uint8_t nbTasks;
+        uint8_t taskNumbers[maxTasks];
+        uint32_t runTimes[maxTasks];
+      };
+      static constexpr uint8_t nbSnapshots = 4;
+
+      /// Fills tasksStatus, with tasksStatusMutex taken. Returns 0 if there are more than maxTasks tasks.
+      UBaseType_t ReadTasksStatus() const;
+      Snapshot TakeSnapshot() const;
+
       mutable TickType_t lastTick = 0;
+      // Not allocated on the stack of the callers (system task, display and BLE host)
+      mutable TaskStatus_t tasksStatus[maxTasks];
+      Memory::StaticMutex tasksStatusMutexStorage;
+      SemaphoreHandle_t tasksStatusMutex {tasksStatusMutexStorage.Create()};
+      // The window goes from the oldest snapshot to now
+      Snapshot snapshots[nbSnapshots] = {};
+      uint8_t lastSnapshot = 0;
+#else
+      template <typename Visitor>
+      uint8_t VisitTasks(Visitor /*visitor*/) const {
+        return 0;
+      }
 #endif
     };
   }
@@ -2,7 +2,6 @@
 #include <hal/nrf_rtc.h>
 #include <libraries/gpiote/app_gpiote.h>
 #include <libraries/log/nrf_log.h>
-#include <app_timer.h>
 #include "BootloaderVersion.h"
 #include "components/battery/BatteryController.h"
 #include "components/ble/BleController.h"
@@ -15,38 +14,73 @@
 #include "drivers/TwiMaster.h"
 #include "drivers/Hrs3300.h"
 #include "drivers/PinMap.h"
+#include "drivers/RtcCounter.h"
+#include "trace/Trace.h"
+#include "logging/BinaryLog.h"
 #include "main.h"
 #include "BootErrors.h"
 
+#include <algorithm>
 #include <memory>
 
 using namespace Pinetime::System;
 
 namespace {
-  static inline bool in_isr(void) {
-    return (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) != 0;
-  }
+  using Pinetime::Drivers::RtcCounter;
+
+  // The clock tick updates the time on the boundaries that must be noticed : the displayed seconds while running, the
+  // chimes (and the hour and day changes) while sleeping
+  constexpr std::chrono::seconds clockPeriodRunning {1};
+  constexpr std::chrono::seconds clockPeriodSleeping {30 * 60};
+  // The watchdog resets the watch after 7s
+  constexpr uint32_t watchdogKickPeriod = 5 * RtcCounter::frequency;
+  constexpr uint32_t wakeupStatisticsWindow = 60 * 60 * RtcCounter::frequency;
+  constexpr uint32_t bleDiscoveryDelayMs = 500;
+  constexpr uint32_t motionPollPeriodMs = 100;
+  constexpr uint32_t idleDelayMs = 2000;
+  constexpr uint32_t batteryMeasurementPeriodMs = 10 * 60 * 1000;
 }
 
-void DimTimerCallback(TimerHandle_t xTimer) {
+void DimTimerCallback(void* context) {
 
   NRF_LOG_INFO("DimTimerCallback");
-  auto sysTask = static_cast<SystemTask*>(pvTimerGetTimerID(xTimer));
+  auto sysTask = static_cast<SystemTask*>(context);
   sysTask->OnDim();
 }
 
-void IdleTimerCallback(TimerHandle_t xTimer) {
+void IdleTimerCallback(void* context) {
 
   NRF_LOG_INFO("IdleTimerCallback");
-  auto sysTask = static_cast<SystemTask*>(pvTimerGetTimerID(xTimer));
+  auto sysTask = static_cast<SystemTask*>(context);
   sysTask->OnIdle();
 }
 
-void MeasureBatteryTimerCallback(TimerHandle_t xTimer) {
-  auto* sysTask = static_cast<SystemTask*>(pvTimerGetTimerID(xTimer));
+void MeasureBatteryTimerCallback(void* context) {
+  auto* sysTask = static_cast<SystemTask*>(context);
   sysTask->PushMessage(Pinetime::System::Messages::MeasureBatteryTimerExpired);
 }
 
+// Called by the writer of the binary log, maybe from an interrupt
+void OnBinaryLogFlushRequested(void* context) {
+  auto* sysTask = static_cast<SystemTask*>(context);
+  sysTask->PushMessage(Pinetime::System::Messages::BinaryLogFlushRequested);
+}
+
+void BleDiscoveryTimerCallback(void* context) {
+  auto* sysTask = static_cast<SystemTask*>(context);
+  sysTask->PushMessage(Pinetime::System::Messages::StartBleDiscovery);
+}
+
+void MotionPollTimerCallback(void* context) {
+  auto* sysTask = static_cast<SystemTask*>(context);
+  sysTask->PushMessage(Pinetime::System::Messages::OnMotionInterrupt);
+}
+
+void ClockTickCallback(void* context) {
+  auto* sysTask = static_cast<SystemTask*>(context);
+  sysTask->PushMessage(Pinetime::System::Messages::ClockTick);
+}
+
 SystemTask::SystemTask(Drivers::SpiMaster& spi,
                        Drivers::St7789& lcd,
                        Pinetime::Drivers::SpiNorFlash& spiNorFlash,
@@ -63,6 +97,9 @@ SystemTask::SystemTask(Drivers::SpiMaster& spi,
                        Pinetime::Controllers::MotorController& motorController,
                        Pinetime::Drivers::Hrs3300& heartRateSensor,
                        Pinetime::Controllers::MotionController& motionController,
+                       Pinetime::Controllers::StepHistory& stepHistory,
+                       Pinetime::Controllers::HeartRateHistory& heartRateHistory,
+                       Pinetime::Controllers::SleepTracker& sleepTracker,
                        Pinetime::Drivers::Bma421& motionSensor,
                        Controllers::Settings& settingsController,
                        Pinetime::Controllers::HeartRateController& heartRateController,
@@ -82,6 +119,7 @@ SystemTask::SystemTask(Drivers::SpiMaster& spi,
     dateTimeController {dateTimeController},
     timerController {timerController},
     alarmController {alarmController},
+    messageBus {"system"},
     watchdog {watchdog},
     notificationManager {notificationManager},
     motorController {motorController},
@@ -90,6 +128,9 @@ SystemTask::SystemTask(Drivers::SpiMaster& spi,
     settingsController {settingsController},
     heartRateController {heartRateController},
     motionController {motionController},
+    stepHistory {stepHistory},
+    heartRateHistory {heartRateHistory},
+    sleepTracker {sleepTracker},
     displayApp {displayApp},
     heartRateApp(heartRateApp),
     fs {fs},
@@ -101,16 +142,24 @@ SystemTask::SystemTask(Drivers::SpiMaster& spi,
                      notificationManager,
                      batteryController,
                      spiNorFlash,
+                     twiMaster,
+                     touchHandler,
                      heartRateController,
                      motionController,
-                     fs) {
+                     stepHistory,
+                     fs),
+    // The slack lets the timers that do not need to be precise expire together with the others
+    clockTickTimer {"clockTick", Timer::Modes::SingleShot, ClockTickCallback, this},
+    bleDiscoveryTimer {"bleDiscovery", Timer::Modes::SingleShot, BleDiscoveryTimerCallback, this, bleDiscoveryDelayMs},
+    motionPollTimer {"motionPoll", Timer::Modes::Repeated, MotionPollTimerCallback, this, 40},
+    dimTimer {"dim", Timer::Modes::SingleShot, DimTimerCallback, this, 500},
+    idleTimer {"idle", Timer::Modes::SingleShot, IdleTimerCallback, this, 500},
+    measureBatteryTimer {"battery", Timer::Modes::Repeated, MeasureBatteryTimerCallback, this, 60 * 1000} {
 }
 
 void SystemTask::Start() {
-  systemTasksMsgQueue = xQueueCreate(10, 1);
-  if (pdPASS != xTaskCreate(SystemTask::Process, "MAIN", 350, this, 1, &taskHandle)) {
-    APP_ERROR_HANDLER(NRF_ERROR_NO_MEM);
-  }
+  messageBus.Init();
+  taskHandle = task.Create(SystemTask::Process, "MAIN", 1, this);
 }
 
 void SystemTask::Process(void* instance) {
@@ -127,8 +176,6 @@ void SystemTask::Work() {
   NRF_LOG_INFO("Last reset reason : %s", Pinetime::Drivers::Watchdog::ResetReasonToString(watchdog.ResetReason()));
   APP_GPIOTE_INIT(2);
 
-  app_timer_init();
-
   spi.Init();
   spiNorFlash.Init();
   spiNorFlash.Wakeup();
@@ -136,6 +183,7 @@ void SystemTask::Work() {
   fs.Init();
 
   nimbleController.Init();
+  Pinetime::Logging::BinaryLog::SetFlushHandler(OnBinaryLogFlushRequested, this);
   lcd.Init();
 
   twiMaster.Init();
@@ -166,6 +214,9 @@ void SystemTask::Work() {
   displayApp.Register(this);
   displayApp.Start(bootError);
 
+  touchHandler.Register(this);
+  touchHandler.Start();
+
   heartRateSensor.Init();
   heartRateSensor.Disable();
   heartRateApp.Start();
@@ -208,23 +259,41 @@ void SystemTask::Work() {
   nrfx_gpiote_in_init(PinMap::PowerPresent, &pinConfig, nrfx_gpiote_evt_handler);
   nrfx_gpiote_in_event_enable(PinMap::PowerPresent, true);
 
+  // Motion sensor (FIFO watermark and wake-up features, latched until the status is read)
+  if (motionSensor.IsFifoEnabled()) {
+    pinConfig.sense = NRF_GPIOTE_POLARITY_LOTOHI;
+    pinConfig.pull = NRF_GPIO_PIN_NOPULL;
+    pinConfig.is_watcher = false;
+    pinConfig.hi_accuracy = false;
+    pinConfig.skip_gpio_setup = false;
+    nrfx_gpiote_in_init(PinMap::Bma421Irq, &pinConfig, nrfx_gpiote_evt_handler);
+    nrfx_gpiote_in_event_enable(PinMap::Bma421Irq, true);
+    sleepTracker.Update();
+    UpdateMotionInterrupts();
+  }
+
   batteryController.MeasureVoltage();
 
-  idleTimer = xTimerCreate("idleTimer", pdMS_TO_TICKS(2000), pdFALSE, this, IdleTimerCallback);
-  dimTimer = xTimerCreate("dimTimer", pdMS_TO_TICKS(settingsController.GetScreenTimeOut() - 2000), pdFALSE, this, DimTimerCallback);
-  measureBatteryTimer = xTimerCreate("measureBattery", batteryMeasurementPeriod, pdTRUE, this, MeasureBatteryTimerCallback);
-  xTimerStart(dimTimer, 0);
-  xTimerStart(measureBatteryTimer, portMAX_DELAY);
+  // When the FIFO is enabled, the motion sensor is processed when its interrupt fires. Otherwise, it is polled.
+  if (!motionSensor.IsFifoEnabled()) {
+    motionPollTimer.Start(motionPollPeriodMs);
+  }
+  dimTimer.Start(settingsController.GetScreenTimeOut() - idleDelayMs);
+  measureBatteryTimer.Start(batteryMeasurementPeriodMs);
+
+  wakeupStatistics.windowStart = RtcCounter::Now();
+  KickWatchdog();
+  UpdateTime();
 
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "EndlessLoop"
   while (true) {
-    UpdateMotion();
-
-    uint8_t msg;
-    if (xQueueReceive(systemTasksMsgQueue, &msg, 100)) {
-      Messages message = static_cast<Messages>(msg);
-      switch (message) {
+    // Every event source (interrupts, timers, clock tick) sends a message : nothing needs to be polled
+    decltype(messageBus)::Envelope envelope;
+    if (messageBus.Receive(envelope, portMAX_DELAY)) {
+      CountWakeup();
+      Trace::Mark(Trace::UserEvents::SystemTaskMessage, static_cast<uint16_t>(envelope.message));
+      switch (envelope.message) {
         case Messages::EnableSleeping:
           // Make sure that exiting an app doesn't enable sleeping,
           // if the exiting was caused by a firmware update
@@ -237,7 +306,7 @@ void SystemTask::Work() {
           doNotGoToSleep = true;
           break;
         case Messages::UpdateTimeOut:
-          xTimerChangePeriod(dimTimer, pdMS_TO_TICKS(settingsController.GetScreenTimeOut() - 2000), 0);
+          dimTimer.Start(settingsController.GetScreenTimeOut() - idleDelayMs);
           break;
         case Messages::GoToRunning:
           spi.Wakeup();
@@ -247,7 +316,7 @@ void SystemTask::Work() {
             touchPanel.Wakeup();
           }
 
-          xTimerStart(dimTimer, 0);
+          dimTimer.Restart();
           spiNorFlash.Wakeup();
           lcd.Wakeup();
 
@@ -261,17 +330,19 @@ void SystemTask::Work() {
           isSleeping = false;
           isWakingUp = false;
           isDimmed = false;
+          motionController.ResumeScreenSubscriptions();
+          UpdateMotionInterrupts();
+          // After the display is woken up : the flash is shared with it
+          FlushHistories();
           break;
         case Messages::TouchWakeUp: {
-          if (touchHandler.GetNewTouchInfo()) {
-            auto gesture = touchHandler.GestureGet();
-            if (gesture != Pinetime::Applications::TouchEvents::None and
-                ((gesture == Pinetime::Applications::TouchEvents::DoubleTap and
-                  settingsController.isWakeUpModeOn(Pinetime::Controllers::Settings::WakeUpMode::DoubleTap)) or
-                 (gesture == Pinetime::Applications::TouchEvents::Tap and
-                  settingsController.isWakeUpModeOn(Pinetime::Controllers::Settings::WakeUpMode::SingleTap)))) {
-              GoToRunning();
-            }
+          // The touch task read the panel and sent the gesture
+          auto gesture = static_cast<Pinetime::Applications::TouchEvents>(envelope.payload);
+          if ((gesture == Pinetime::Applications::TouchEvents::DoubleTap and
+               settingsController.isWakeUpModeOn(Pinetime::Controllers::Settings::WakeUpMode::DoubleTap)) or
+              (gesture == Pinetime::Applications::TouchEvents::Tap and
+               settingsController.isWakeUpModeOn(Pinetime::Controllers::Settings::WakeUpMode::SingleTap))) {
+            GoToRunning();
           }
         } break;
         case Messages::GoToSleep:
@@ -280,8 +351,8 @@ void SystemTask::Work() {
           }
           isGoingToSleep = true;
           NRF_LOG_INFO("[systemtask] Going to sleep");
-          xTimerStop(idleTimer, 0);
-          xTimerStop(dimTimer, 0);
+          idleTimer.Stop();
+          dimTimer.Stop();
           displayApp.PushMessage(Pinetime::Applications::Display::Messages::GoToSleep);
           heartRateApp.PushMessage(Pinetime::Applications::HeartRateTask::Messages::GoToSleep);
           break;
@@ -321,8 +392,15 @@ void SystemTask::Work() {
           break;
         case Messages::BleConnected:
           ReloadIdleTimer();
-          isBleDiscoveryTimerRunning = true;
-          bleDiscoveryTimer = 5;
+          bleDiscoveryTimer.Start(bleDiscoveryDelayMs);
+          break;
+        case Messages::StartBleDiscovery:
+          // Services discovery is deffered from 3 seconds to avoid the conflicts between the host communicating with the
+          // target and vice-versa. I'm not sure if this is the right way to handle this...
+          nimbleController.StartDiscovery();
+          break;
+        case Messages::ClockTick:
+          // The time is updated below, after any message
           break;
         case Messages::BleFirmwareUpdateStarted:
           doNotGoToSleep = true;
@@ -333,10 +411,11 @@ void SystemTask::Work() {
           break;
         case Messages::BleFirmwareUpdateFinished:
           if (bleController.State() == Pinetime::Controllers::Ble::FirmwareUpdateStates::Validated) {
+            FlushHistories();
             NVIC_SystemReset();
           }
           doNotGoToSleep = false;
-          xTimerStart(dimTimer, 0);
+          dimTimer.Restart();
           break;
         case Messages::StartFileTransfer:
           NRF_LOG_INFO("[systemtask] FS Started");
@@ -348,15 +427,18 @@ void SystemTask::Work() {
         case Messages::StopFileTransfer:
           NRF_LOG_INFO("[systemtask] FS Stopped");
           doNotGoToSleep = false;
-          xTimerStart(dimTimer, 0);
+          dimTimer.Restart();
           // TODO add intent of fs access icon or something
           break;
         case Messages::OnTouchEvent:
-          if (touchHandler.GetNewTouchInfo()) {
-            touchHandler.UpdateLvglTouchPoint();
-          }
+          // The points go straight from the touch task to LVGL, only the activity and the gestures come through here
           ReloadIdleTimer();
-          displayApp.PushMessage(Pinetime::Applications::Display::Messages::TouchEvent);
+          if (static_cast<Pinetime::Applications::TouchEvents>(envelope.payload) != Pinetime::Applications::TouchEvents::None) {
+            displayApp.PushMessage(Pinetime::Applications::Display::Messages::TouchEvent, envelope.payload);
+          }
+          break;
+        case Messages::OnMotionInterrupt:
+          UpdateMotion();
           break;
         case Messages::HandleButtonEvent: {
           Controllers::ButtonActions action;
@@ -364,6 +446,8 @@ void SystemTask::Work() {
             action = buttonHandler.HandleEvent(Controllers::ButtonHandler::Events::Release);
           } else {
             action = buttonHandler.HandleEvent(Controllers::ButtonHandler::Events::Press);
+            // Holding the button resets the watch 7s after the press, when the watchdog is not kicked anymore
+            KickWatchdog();
             // This is for faster wakeup, sacrificing special longpress and doubleclick handling while sleeping
             if (IsSleeping()) {
               fastWakeUpDone = true;
@@ -393,6 +477,9 @@ void SystemTask::Work() {
 
           isSleeping = true;
           isGoingToSleep = false;
+          // The watch face stays loaded while the display sleeps, the step count it subscribed to is not displayed
+          motionController.SuspendScreenSubscriptions();
+          UpdateMotionInterrupts();
           break;
         case Messages::OnNewDay:
           // We might be sleeping (with TWI device disabled.
@@ -400,6 +487,13 @@ void SystemTask::Work() {
           stepCounterMustBeReset = true;
           break;
         case Messages::OnNewHour:
+          UpdateStepHistory();
+          if (sleepTracker.Update()) {
+            UpdateMotionInterrupts();
+          }
+          if (!isSleeping) {
+            FlushHistories();
+          }
           using Pinetime::Controllers::AlarmController;
           if (settingsController.GetChimeOption() == Controllers::Settings::ChimesOption::Hours && alarmController.State() != AlarmController::AlarmState::Alerting) {
             if (isSleeping && !isWakingUp) {
@@ -431,7 +525,7 @@ void SystemTask::Work() {
           batteryController.MeasureVoltage();
           break;
         case Messages::BatteryPercentageUpdated:
-          nimbleController.NotifyBatteryLevel(batteryController.PercentRemaining());
+          nimbleController.NotifyBatteryLevel(static_cast<uint8_t>(envelope.payload));
           break;
         case Messages::OnPairing:
           if (isSleeping && !isWakingUp) {
@@ -440,6 +534,12 @@ void SystemTask::Work() {
           motorController.RunForDuration(35);
           displayApp.PushMessage(Pinetime::Applications::Display::Messages::ShowPairingKey);
           break;
+        case Messages::MotionStreamingChanged:
+          UpdateMotionInterrupts();
+          break;
+        case Messages::BinaryLogFlushRequested:
+          nimbleController.NotifyBinaryLog();
+          break;
         case Messages::BleRadioEnableToggle:
           if(settingsController.GetBleRadioEnabled()) {
             nimbleController.EnableRadio();
@@ -452,29 +552,112 @@ void SystemTask::Work() {
       }
     }
 
-    if (isBleDiscoveryTimerRunning) {
-      if (bleDiscoveryTimer == 0) {
-        isBleDiscoveryTimerRunning = false;
-        // Services discovery is deffered from 3 seconds to avoid the conflicts between the host communicating with the
-        // target and vice-versa. I'm not sure if this is the right way to handle this...
-        nimbleController.StartDiscovery();
-      } else {
-        bleDiscoveryTimer--;
-      }
-    }
-
     monitor.Process();
-    uint32_t systick_counter = nrf_rtc_counter_get(portNRF_RTC_REG);
-    dateTimeController.UpdateTime(systick_counter);
-    NoInit_BackUpTime = dateTimeController.CurrentDateTime();
     if (!nrf_gpio_pin_read(PinMap::Button)) {
-      watchdog.Kick();
+      KickWatchdog();
     }
+    UpdateTime();
   }
 #pragma clang diagnostic pop
 }
 
+/// Updates the time and schedules the next clock tick, at the next time boundary or when the watchdog must be kicked
+void SystemTask::UpdateTime() {
+  uint32_t systickCounter = nrf_rtc_counter_get(portNRF_RTC_REG);
+  dateTimeController.UpdateTime(systickCounter);
+  NoInit_BackUpTime = dateTimeController.CurrentDateTime();
+
+  auto period = isSleeping ? clockPeriodSleeping : clockPeriodRunning;
+  // The delay is rounded up to the next ms : the tick always comes after the boundary
+  uint32_t delayMs =
+    (dateTimeController.SysticksToNextBoundary(systickCounter, period) * 1000 + configTICK_RATE_HZ - 1) / configTICK_RATE_HZ;
+  uint32_t sinceKick = RtcCounter::Now() - lastWatchdogKick;
+  uint32_t watchdogDelayMs = (sinceKick < watchdogKickPeriod) ? RtcCounter::ToUs(watchdogKickPeriod - sinceKick) / 1000 : 0;
+  clockTickTimer.Start(std::min(delayMs, watchdogDelayMs));
+}
+
+void SystemTask::KickWatchdog() {
+  watchdog.Kick();
+  lastWatchdogKick = RtcCounter::Now();
+}
+
+void SystemTask::CountWakeup() {
+  auto now = RtcCounter::Now();
+  if (now - wakeupStatistics.windowStart >= wakeupStatisticsWindow) {
+    wakeupStatistics.lastHour = wakeupStatistics.currentHour;
+    wakeupStatistics.currentHour = 0;
+    wakeupStatistics.windowStart = now;
+  }
+  wakeupStatistics.total++;
+  wakeupStatistics.currentHour++;
+}
+
 void SystemTask::UpdateMotion() {
+  // Applies the requests of the screens
+  UpdateMotionPowerMode();
+  if (motionSensor.IsFifoEnabled()) {
+    bool stepCounterReset = false;
+    if (stepCounterMustBeReset) {
+      motionSensor.ResetStepCounter();
+      stepCounterMustBeReset = false;
+      stepCounterReset = true;
+    }
+    UpdateMotionSubscriptions(stepCounterReset);
+    // The interrupt is latched until the status is read : it must be processed even if the values are not used
+    auto data = motionSensor.ProcessInterrupt();
+    motionController.SetBusTime(motionSensor.BusTime());
+    const auto& values = motionSensor.LastValues();
+    if (isGoingToSleep or isWakingUp) {
+      return;
+    }
+
+    auto now = xTaskGetTickCount();
+    if (isSleeping) {
+      if (data.wristTilt && settingsController.isWakeUpModeOn(Pinetime::Controllers::Settings::WakeUpMode::RaiseWrist)) {
+        GoToRunning();
+        return;
+      }
+      if (data.anyMotion) {
+        // The shake detector needs the samples : read the FIFO for a short time after the motion started
+        shakeDetectionEnd = now + shakeDetectionDuration;
+        isShakeDetectionRunning = true;
+        UpdateMotionInterrupts();
+      } else if (isShakeDetectionRunning && static_cast<int32_t>(now - shakeDetectionEnd) >= 0) {
+        isShakeDetectionRunning = false;
+        UpdateMotionInterrupts();
+      }
+    }
+
+    motionController.IsSensorOk(motionSensor.IsOk());
+    auto samplePeriod = pdMS_TO_TICKS(motionSensor.FifoSamplePeriodMs());
+    if (data.nbSamples > 0) {
+      uint32_t dropped = motionSensor.DroppedSamples() - motionDroppedSamples;
+      motionDroppedSamples += dropped;
+      motionController.StreamSamples(data.samples, data.nbSamples, now - ((data.nbSamples - 1) * samplePeriod), dropped);
+      sleepTracker.AddSamples(data.samples, data.nbSamples, motionSensor.FifoDownsampling(), now);
+    }
+
+    // The wake-up detectors expect the default rate : the samples are decimated while streaming at a higher rate
+    auto downsampling = motionSensor.FifoDownsampling();
+    auto decimation = (downsampling < Drivers::Bma421::defaultFifoDownsampling)
+                        ? 1U << (Drivers::Bma421::defaultFifoDownsampling - downsampling)
+                        : 1U;
+    bool runDetectors = !isSleeping || !motionSensor.HasWakeUpFeatures() || isShakeDetectionRunning;
+    for (size_t i = 0; i < data.nbSamples; i++) {
+      if ((motionSampleCounter++ % decimation) != 0) {
+        continue;
+      }
+      const auto& sample = data.samples[i];
+      auto timestamp = now - ((data.nbSamples - 1 - i) * samplePeriod);
+      motionController.Update(sample.x, sample.y, sample.z, values.steps, timestamp);
+      if (runDetectors && CheckMotionWakeUp()) {
+        GoToRunning();
+        break;
+      }
+    }
+    return;
+  }
+
   if (isGoingToSleep or isWakingUp) {
     return;
   }
@@ -483,23 +666,121 @@ void SystemTask::UpdateMotion() {
                       settingsController.isWakeUpModeOn(Pinetime::Controllers::Settings::WakeUpMode::Shake))) {
     return;
   }
+  bool stepCounterReset = false;
   if (stepCounterMustBeReset) {
     motionSensor.ResetStepCounter();
     stepCounterMustBeReset = false;
+    stepCounterReset = true;
   }
 
-  auto motionValues = motionSensor.Process();
+  UpdateMotionSubscriptions(stepCounterReset);
+  const auto& motionValues = motionSensor.Process();
 
+  motionController.SetBusTime(motionSensor.BusTime());
   motionController.IsSensorOk(motionSensor.IsOk());
-  motionController.Update(motionValues.x, motionValues.y, motionValues.z, motionValues.steps);
+  motionController.Update(motionValues.x, motionValues.y, motionValues.z, motionValues.steps, xTaskGetTickCount());
+  // Without the FIFO, the polled values are streamed at the rate of the main loop
+  Drivers::Bma421Fifo::Sample sample {motionValues.x, motionValues.y, motionValues.z};
+  motionController.StreamSamples(&sample, 1, xTaskGetTickCount(), 0);
+
+  if (CheckMotionWakeUp()) {
+    GoToRunning();
+  }
+}
+
+/// The acceleration is always needed (wake-up detectors, heart rate motion rejection). The step count is only read
+/// when it is displayed, and at least once a minute otherwise.
+void SystemTask::UpdateMotionSubscriptions(bool stepCountChanged) {
+  uint8_t fields = static_cast<uint8_t>(Drivers::Bma421::Fields::Acceleration);
+  auto stepCountAge = xTaskGetTickCount() - motionSensor.LastValues().stepsTimestamp;
+  if (stepCountChanged || motionController.IsStepCountNeeded() || stepCountAge >= stepCountMaxAge) {
+    fields |= static_cast<uint8_t>(Drivers::Bma421::Fields::Steps);
+  }
+  motionSensor.Subscribe(fields);
+}
+
+/// The step count is not read while nothing displays it : it is refreshed before closing the bucket of the hour
+void SystemTask::UpdateStepHistory() {
+  motionSensor.Subscribe(static_cast<uint8_t>(Drivers::Bma421::Fields::Steps));
+  const auto& values = motionSensor.Process();
+  motionController.UpdateSteps(values.steps);
+  stepHistory.Append(motionController.TakeHourSteps());
+}
 
+/// Writes the entries buffered by the histories to their files. The SPI NOR flash is powered down while sleeping :
+/// this is only called when it is awake, the entries wait in RAM until then.
+void SystemTask::FlushHistories() {
+  stepHistory.Flush();
+  heartRateHistory.Flush();
+  sleepTracker.Flush();
+}
+
+bool SystemTask::CheckMotionWakeUp() {
   if (settingsController.isWakeUpModeOn(Pinetime::Controllers::Settings::WakeUpMode::RaiseWrist) &&
       motionController.Should_RaiseWake(isSleeping)) {
-    GoToRunning();
+    return true;
   }
-  if (settingsController.isWakeUpModeOn(Pinetime::Controllers::Settings::WakeUpMode::Shake) &&
-      motionController.Should_ShakeWake(settingsController.GetShakeThreshold())) {
-    GoToRunning();
+  return settingsController.isWakeUpModeOn(Pinetime::Controllers::Settings::WakeUpMode::Shake) &&
+         motionController.Should_ShakeWake(settingsController.GetShakeThreshold());
+}
+
+/// The sensor runs at a lower rate while sleeping, unless the samples are streamed at a higher rate.
+/// The performance mode is only used while a screen displaying the raw values is opened.
+void SystemTask::UpdateMotionPowerMode() {
+  using PowerModes = Drivers::Bma421::PowerModes;
+  auto mode = PowerModes::Normal;
+  if (isSleeping) {
+    if (!motionController.IsStreaming() || motionController.StreamingDownsampling() > 0) {
+      mode = PowerModes::LowPower;
+    }
+  } else if (motionController.IsPerformanceModeRequested()) {
+    mode = PowerModes::Performance;
+  }
+  motionSensor.SetPowerMode(mode);
+  motionController.SetPowerMode(motionSensor.PowerMode());
+}
+
+/// While sleeping, the motion sensor only needs to wake the MCU up if a motion wake-up mode is enabled.
+/// If the sensor provides the wrist tilt and any-motion interrupts, the MCU is not woken up at all while the wrist
+/// is still. Otherwise, the software detectors are run on the FIFO samples.
+/// The step counter keeps running in the sensor in any case.
+void SystemTask::UpdateMotionInterrupts() {
+  UpdateMotionPowerMode();
+  bool raiseWrist = settingsController.isWakeUpModeOn(Pinetime::Controllers::Settings::WakeUpMode::RaiseWrist);
+  bool shake = settingsController.isWakeUpModeOn(Pinetime::Controllers::Settings::WakeUpMode::Shake);
+
+  uint8_t watermark = 0;
+  if (!isSleeping) {
+    isShakeDetectionRunning = false;
+    motionSensor.SetWakeUpInterrupts(false, false);
+    watermark = motionFifoWatermarkRunning;
+  } else if (motionSensor.HasWakeUpFeatures()) {
+    motionSensor.SetWakeUpInterrupts(raiseWrist, shake);
+    watermark = (shake && isShakeDetectionRunning) ? motionFifoWatermarkRunning : 0;
+  } else if (raiseWrist || shake) {
+    watermark = motionFifoWatermarkSleeping;
+  }
+
+  // The wake-up detectors need the default rate, the other consumers decimate the samples
+  uint8_t downsampling = Drivers::Bma421::defaultFifoDownsampling;
+  if (motionController.IsStreaming()) {
+    downsampling = motionController.StreamingDownsampling();
+    watermark = motionController.StreamingWatermark();
+  } else if (watermark == 0 && sleepTracker.IsTracking()) {
+    // Only the sleep tracker needs the samples : they are read at its low rate, a few times per minute
+    downsampling = Controllers::SleepTracker::fifoDownsampling;
+    watermark = motionFifoWatermarkSleepTracking;
+  }
+  motionSensor.SetFifoDownsampling(downsampling);
+  motionSensor.SetFifoWatermark(watermark);
+
+  // Without the FIFO, the sensor is only polled while its values are used
+  if (!motionSensor.IsFifoEnabled()) {
+    if (!isSleeping || raiseWrist || shake) {
+      motionPollTimer.Start(motionPollPeriodMs);
+    } else {
+      motionPollTimer.Stop();
+    }
   }
 }
 
@@ -543,36 +824,29 @@ void SystemTask::GoToRunning() {
   PushMessage(Messages::GoToRunning);
 }
 
+void SystemTask::OnMotionInterrupt() {
+  PushMessage(Messages::OnMotionInterrupt);
+}
+
 void SystemTask::OnTouchEvent() {
   if (isGoingToSleep) {
     return;
   }
   if (!isSleeping) {
-    PushMessage(Messages::OnTouchEvent);
+    touchHandler.OnInterrupt();
   } else if (!isWakingUp) {
     if (settingsController.isWakeUpModeOn(Pinetime::Controllers::Settings::WakeUpMode::SingleTap) or
         settingsController.isWakeUpModeOn(Pinetime::Controllers::Settings::WakeUpMode::DoubleTap)) {
-      PushMessage(Messages::TouchWakeUp);
+      touchHandler.OnInterrupt(true);
     }
   }
 }
 
-void SystemTask::PushMessage(System::Messages msg) {
+void SystemTask::PushMessage(System::Messages msg, uint32_t payload) {
   if (msg == Messages::GoToSleep && !doNotGoToSleep) {
     isGoingToSleep = true;
   }
-
-  if (in_isr()) {
-    BaseType_t xHigherPriorityTaskWoken;
-    xHigherPriorityTaskWoken = pdFALSE;
-    xQueueSendFromISR(systemTasksMsgQueue, &msg, &xHigherPriorityTaskWoken);
-    if (xHigherPriorityTaskWoken) {
-      /* Actual macro used here is port specific. */
-      portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
-    }
-  } else {
-    xQueueSend(systemTasksMsgQueue, &msg, portMAX_DELAY);
-  }
+  messageBus.Push(msg, payload);
 }
 
 void SystemTask::OnDim() {
@@ -581,7 +855,7 @@ void SystemTask::OnDim() {
   }
   NRF_LOG_INFO("Dim timeout -> Dim screen")
   displayApp.PushMessage(Pinetime::Applications::Display::Messages::DimScreen);
-  xTimerStart(idleTimer, 0);
+  idleTimer.Start(idleDelayMs);
   isDimmed = true;
 }
 
@@ -601,6 +875,6 @@ void SystemTask::ReloadIdleTimer() {
     displayApp.PushMessage(Pinetime::Applications::Display::Messages::RestoreBrightness);
     isDimmed = false;
   }
-  xTimerReset(dimTimer, 0);
-  xTimerStop(idleTimer, 0);
+  dimTimer.Restart();
+  idleTimer.Stop();
 }
@@ -11,8 +11,13 @@
 #include <drivers/Bma421.h>
 #include <drivers/PinMap.h>
 #include <components/motion/MotionController.h>
+#include <components/motion/StepHistory.h>
+#include <components/heartrate/HeartRateHistory.h>
+#include <components/motion/SleepTracker.h>
 
 #include "systemtask/SystemMonitor.h"
+#include "systemtask/TimerService.h"
+#include "systemtask/MessageBus.h"
 #include "components/ble/NimbleController.h"
 #include "components/ble/NotificationManager.h"
 #include "components/motor/MotorController.h"
@@ -34,6 +39,7 @@
 
 #include "drivers/Watchdog.h"
 #include "systemtask/Messages.h"
+#include "memory/KernelObjects.h"
 
 extern std::chrono::time_point<std::chrono::system_clock, std::chrono::nanoseconds> NoInit_BackUpTime;
 namespace Pinetime {
@@ -69,6 +75,9 @@ namespace Pinetime {
                  Pinetime::Controllers::MotorController& motorController,
                  Pinetime::Drivers::Hrs3300& heartRateSensor,
                  Pinetime::Controllers::MotionController& motionController,
+                 Pinetime::Controllers::StepHistory& stepHistory,
+                 Pinetime::Controllers::HeartRateHistory& heartRateHistory,
+                 Pinetime::Controllers::SleepTracker& sleepTracker,
                  Pinetime::Drivers::Bma421& motionSensor,
                  Controllers::Settings& settingsController,
                  Pinetime::Controllers::HeartRateController& heartRateController,
@@ -79,13 +88,33 @@ namespace Pinetime {
                  Pinetime::Controllers::ButtonHandler& buttonHandler);
 
       void Start();
-      void PushMessage(Messages msg);
+      void PushMessage(Messages msg, uint32_t payload = 0);
 
       void OnTouchEvent();
+      void OnMotionInterrupt();
 
       void OnIdle();
       void OnDim();
 
+      /// Number of times the task woke up to process a message, the previous full hour is the reference figure
+      struct WakeupStatistics {
+        uint32_t total = 0;
+        uint32_t lastHour = 0;
+        uint32_t currentHour = 0;
+        uint32_t windowStart = 0;
+      };
+
+      const WakeupStatistics& GetWakeupStatistics() const {
+        return wakeupStatistics;
+      }
+
+      SystemMonitor::CpuLoad GetCpuLoad() const {
+        return monitor.GetCpuLoad();
+      }
+      const SystemMonitor& Monitor() const {
+        return monitor;
+      }
+
       Pinetime::Controllers::NimbleController& nimble() {
         return nimbleController;
       };
@@ -96,6 +125,7 @@ namespace Pinetime {
 
     private:
       TaskHandle_t taskHandle;
+      Memory::StaticTask<350> task;
 
       Pinetime::Drivers::SpiMaster& spi;
       Pinetime::Drivers::St7789& lcd;
@@ -109,7 +139,7 @@ namespace Pinetime {
       Pinetime::Controllers::DateTime& dateTimeController;
       Pinetime::Controllers::TimerController& timerController;
       Pinetime::Controllers::AlarmController& alarmController;
-      QueueHandle_t systemTasksMsgQueue;
+      MessageBus<Messages, 8> messageBus;
       std::atomic<bool> isSleeping {false};
       std::atomic<bool> isGoingToSleep {false};
       std::atomic<bool> isWakingUp {false};
@@ -122,6 +152,9 @@ namespace Pinetime {
       Pinetime::Controllers::Settings& settingsController;
       Pinetime::Controllers::HeartRateController& heartRateController;
       Pinetime::Controllers::MotionController& motionController;
+      Pinetime::Controllers::StepHistory& stepHistory;
+      Pinetime::Controllers::HeartRateHistory& heartRateHistory;
+      Pinetime::Controllers::SleepTracker& sleepTracker;
 
       Pinetime::Applications::DisplayApp& displayApp;
       Pinetime::Applications::HeartRateTask& heartRateApp;
@@ -133,11 +166,17 @@ namespace Pinetime {
       static void Process(void* instance);
       void Work();
       void ReloadIdleTimer();
-      bool isBleDiscoveryTimerRunning = false;
-      uint8_t bleDiscoveryTimer = 0;
-      TimerHandle_t dimTimer;
-      TimerHandle_t idleTimer;
-      TimerHandle_t measureBatteryTimer;
+      void UpdateTime();
+      void KickWatchdog();
+      void CountWakeup();
+      Timer clockTickTimer;
+      Timer bleDiscoveryTimer;
+      Timer motionPollTimer;
+      Timer dimTimer;
+      Timer idleTimer;
+      Timer measureBatteryTimer;
+      uint32_t lastWatchdogKick = 0;
+      WakeupStatistics wakeupStatistics;
       bool doNotGoToSleep = false;
 
       void HandleButtonAction(Controllers::ButtonActions action);
@@ -145,8 +184,26 @@ namespace Pinetime {
 
       void GoToRunning();
       void UpdateMotion();
+      void UpdateMotionSubscriptions(bool stepCountChanged);
+      void UpdateStepHistory();
+      void FlushHistories();
+      bool CheckMotionWakeUp();
+      void UpdateMotionInterrupts();
+      void UpdateMotionPowerMode();
       bool stepCounterMustBeReset = false;
-      static constexpr TickType_t batteryMeasurementPeriod = pdMS_TO_TICKS(10 * 60 * 1000);
+      static constexpr TickType_t stepCountMaxAge = pdMS_TO_TICKS(60 * 1000);
+      // Number of FIFO samples (12.5Hz) per accelerometer interrupt while running and while sleeping with motion wake-up :
+      // ~1 interrupt per second, instead of the 10 reads per second of the former polling
+      static constexpr uint8_t motionFifoWatermarkRunning = 12;
+      static constexpr uint8_t motionFifoWatermarkSleeping = 12;
+      // ~10s at the rate of the sleep tracker
+      static constexpr uint8_t motionFifoWatermarkSleepTracking = 32;
+      // Time during which the FIFO is read after an any-motion interrupt, to run the shake detector
+      static constexpr TickType_t shakeDetectionDuration = pdMS_TO_TICKS(2000);
+      bool isShakeDetectionRunning = false;
+      TickType_t shakeDetectionEnd = 0;
+      uint32_t motionSampleCounter = 0;
+      uint32_t motionDroppedSamples = 0;
 
       SystemMonitor monitor;
     };
@@ -0,0 +1,193 @@
+#include "systemtask/TimerService.h"
+#include <FreeRTOS.h>
+#include <task.h>
+#include <timers.h>
+#include "drivers/RtcCounter.h"
+
+using namespace Pinetime::System;
+using Pinetime::Drivers::RtcCounter;
+
+Timer* TimerService::lists[TimerService::nbLevels] = {};
+Timer* TimerService::registered = nullptr;
+TimerService::Statistics TimerService::statistics;
+
+namespace {
+  // Resolution of each level, in RTC ticks : exact, 1/32s, 1s, 32s
+  constexpr uint64_t resolutions[TimerService::nbLevels] = {1,
+                                                            RtcCounter::frequency / 32,
+                                                            RtcCounter::frequency,
+                                                            32 * RtcCounter::frequency};
+  // The alarm compares 32-bit values : the timers further than that are programmed in several steps
+  constexpr uint64_t maxAlarmDistance = 1UL << 30;
+  constexpr uint32_t alarmRetryDelay = RtcCounter::frequency / 32;
+
+  uint8_t LevelForSlack(uint64_t slack) {
+    uint8_t level = 0;
+    while (level + 1 < TimerService::nbLevels && resolutions[level + 1] <= slack) {
+      level++;
+    }
+    return level;
+  }
+
+  // The critical section masks the RTC2 interrupt, and can be entered from a task or an interrupt
+  class CriticalSection {
+  public:
+    CriticalSection() : mask {taskENTER_CRITICAL_FROM_ISR()} {
+    }
+    ~CriticalSection() {
+      taskEXIT_CRITICAL_FROM_ISR(mask);
+    }
+
+  private:
+    UBaseType_t mask;
+  };
+}
+
+Timer::Timer(const char* name, Modes mode, Callback callback, void* context, uint32_t slackMs)
+  : name {name}, mode {mode}, callback {callback}, context {context}, level {LevelForSlack(TimerService::MsToTicks(slackMs))} {
+  TimerService::Register(*this);
+}
+
+void Timer::Start(uint32_t periodMs) {
+  CriticalSection criticalSection;
+  period = TimerService::MsToTicks(periodMs);
+  TimerService::Insert(*this, RtcCounter::Now64() + period);
+}
+
+void Timer::Restart() {
+  CriticalSection criticalSection;
+  TimerService::Insert(*this, RtcCounter::Now64() + period);
+}
+
+void Timer::Stop() {
+  CriticalSection criticalSection;
+  if (running) {
+    TimerService::Remove(*this);
+    TimerService::Reprogram(RtcCounter::Now64());
+  }
+}
+
+uint32_t Timer::RemainingMs() const {
+  CriticalSection criticalSection;
+  auto now = RtcCounter::Now64();
+  if (!running || deadline <= now) {
+    return 0;
+  }
+  return ((deadline - now) * 1000) / RtcCounter::frequency;
+}
+
+void TimerService::Register(Timer& timer) {
+  timer.nextRegistered = registered;
+  registered = &timer;
+}
+
+uint64_t TimerService::MsToTicks(uint32_t ms) {
+  return (static_cast<uint64_t>(ms) * RtcCounter::frequency + 999) / 1000;
+}
+
+void TimerService::Insert(Timer& timer, uint64_t deadline) {
+  if (timer.running) {
+    Remove(timer);
+  }
+  auto resolution = resolutions[timer.level];
+  timer.deadline = deadline;
+  timer.expiry = ((deadline + resolution - 1) / resolution) * resolution;
+  timer.running = true;
+
+  Timer** position = &lists[timer.level];
+  while (*position != nullptr && (*position)->expiry <= timer.expiry) {
+    position = &(*position)->next;
+  }
+  timer.next = *position;
+  *position = &timer;
+  Reprogram(RtcCounter::Now64());
+}
+
+void TimerService::Remove(Timer& timer) {
+  Timer** position = &lists[timer.level];
+  while (*position != nullptr && *position != &timer) {
+    position = &(*position)->next;
+  }
+  if (*position != nullptr) {
+    *position = timer.next;
+  }
+  timer.next = nullptr;
+  timer.running = false;
+}
+
+void TimerService::Reprogram(uint64_t now) {
+  const Timer* earliest = nullptr;
+  for (auto* head : lists) {
+    if (head != nullptr && (earliest == nullptr || head->expiry < earliest->expiry)) {
+      earliest = head;
+    }
+  }
+  if (earliest == nullptr) {
+    RtcCounter::CancelAlarm();
+    return;
+  }
+  uint64_t target = earliest->expiry;
+  if (target > now + maxAlarmDistance) {
+    target = now + maxAlarmDistance;
+  }
+  RtcCounter::SetAlarm(static_cast<uint32_t>(target), OnAlarm, nullptr);
+}
+
+/// Returns a timer whose deadline is passed. The timers of a level are sorted by expiry, and the expiry is at most
+/// one resolution after the deadline : only the beginning of each list has to be checked.
+Timer* TimerService::PopExpired(uint64_t now, bool& causedWakeup) {
+  for (uint8_t level = 0; level < nbLevels; level++) {
+    for (auto* timer = lists[level]; timer != nullptr && timer->expiry < now + resolutions[level]; timer = timer->next) {
+      if (timer->deadline > now) {
+        continue;
+      }
+      causedWakeup = timer->expiry <= now;
+      Remove(*timer);
+      if (timer->mode == Timer::Modes::Repeated) {
+        // Keep the phase, unless several periods were missed
+        auto deadline = timer->deadline + timer->period;
+        Insert(*timer, (deadline > now) ? deadline : now + timer->period);
+      }
+      return timer;
+    }
+  }
+  return nullptr;
+}
+
+void TimerService::OnAlarm(void* /*context*/) {
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+  if (xTimerPendFunctionCallFromISR(ProcessExpired, nullptr, 0, &xHigherPriorityTaskWoken) != pdPASS) {
+    // The queue of the timer task is full : the expired timers would never be processed
+    RtcCounter::SetAlarm(RtcCounter::Now() + alarmRetryDelay, OnAlarm, nullptr);
+    return;
+  }
+  portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/// Runs in the timer task. The callbacks are called outside of the critical section, and may restart their timer.
+void TimerService::ProcessExpired(void* /*parameter1*/, uint32_t /*parameter2*/) {
+  statistics.wakeups++;
+  // The wake-up is attributed to the first timer that could not wait any longer
+  bool wakeupAttributed = false;
+  while (true) {
+    Timer* timer;
+    {
+      CriticalSection criticalSection;
+      bool causedWakeup = false;
+      timer = PopExpired(RtcCounter::Now64(), causedWakeup);
+      if (timer == nullptr) {
+        Reprogram(RtcCounter::Now64());
+        return;
+      }
+      timer->expirations++;
+      statistics.expirations++;
+      if (causedWakeup && !wakeupAttributed) {
+        timer->wakeups++;
+        wakeupAttributed = true;
+      } else {
+        statistics.coalesced++;
+      }
+    }
+    timer->callback(timer->context);
+  }
+}
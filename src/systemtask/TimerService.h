@@ -0,0 +1,103 @@
+#pragma once
+#include <cstdint>
+
+namespace Pinetime {
+  namespace System {
+    class TimerService;
+
+    /// Software timer driven by the RTC2 compare interrupt. The callbacks are called from the FreeRTOS timer task, like
+    /// the callbacks of the FreeRTOS timers and of app_timer. The timers can be started and stopped from any task or
+    /// interrupt.
+    ///
+    /// The slack is how late the timer is allowed to expire : the expiry is aligned on a grid whose resolution is the
+    /// largest one below the slack (exact, 1/32s, 1s or 32s), so that the timers of the same resolution expire on the
+    /// same wake-up. A timer also expires early (but never before its deadline) when another timer wakes the CPU up.
+    class Timer {
+    public:
+      using Callback = void (*)(void* context);
+      enum class Modes : uint8_t { SingleShot, Repeated };
+
+      Timer(const char* name, Modes mode, Callback callback, void* context, uint32_t slackMs = 0);
+      Timer(const Timer&) = delete;
+      Timer& operator=(const Timer&) = delete;
+
+      /// (Re)starts the timer with a new period
+      void Start(uint32_t periodMs);
+      /// (Re)starts the timer with its current period
+      void Restart();
+      void Stop();
+      bool IsRunning() const {
+        return running;
+      }
+      uint32_t RemainingMs() const;
+
+      const char* Name() const {
+        return name;
+      }
+      /// Number of times the callback was called
+      uint32_t Expirations() const {
+        return expirations;
+      }
+      /// Number of times this timer woke the CPU up (the other expirations were coalesced with another wake-up)
+      uint32_t Wakeups() const {
+        return wakeups;
+      }
+      const Timer* NextRegistered() const {
+        return nextRegistered;
+      }
+
+    private:
+      friend class TimerService;
+
+      const char* name;
+      Modes mode;
+      Callback callback;
+      void* context;
+      uint8_t level;
+      bool running = false;
+      uint64_t period = 0;
+      uint64_t deadline = 0;
+      uint64_t expiry = 0;
+      Timer* next = nullptr;
+      Timer* nextRegistered = nullptr;
+      uint32_t expirations = 0;
+      uint32_t wakeups = 0;
+    };
+
+    /// Keeps the running timers in one list per resolution (sorted by expiry), and programs the RTC2 alarm for the
+    /// earliest expiry of all the lists.
+    class TimerService {
+    public:
+      struct Statistics {
+        uint32_t wakeups = 0;
+        uint32_t expirations = 0;
+        uint32_t coalesced = 0;
+      };
+
+      static const Statistics& GetStatistics() {
+        return statistics;
+      }
+      static const Timer* FirstRegistered() {
+        return registered;
+      }
+
+      static constexpr uint8_t nbLevels = 4;
+
+    private:
+      friend class Timer;
+
+      static void Register(Timer& timer);
+      static void Insert(Timer& timer, uint64_t deadline);
+      static void Remove(Timer& timer);
+      static void Reprogram(uint64_t now);
+      static Timer* PopExpired(uint64_t now, bool& causedWakeup);
+      static void OnAlarm(void* context);
+      static void ProcessExpired(void* parameter1, uint32_t parameter2);
+      static uint64_t MsToTicks(uint32_t ms);
+
+      static Timer* lists[nbLevels];
+      static Timer* registered;
+      static Statistics statistics;
+    };
+  }
+}
@@ -1,9 +1,8 @@
 #include "touchhandler/TouchHandler.h"
-#ifdef PINETIME_IS_RECOVERY
-  #include "displayapp/DummyLittleVgl.h"
-#else
-  #include "displayapp/LittleVgl.h"
-#endif
+#include "drivers/RtcCounter.h"
+#include "systemtask/SystemTask.h"
+#include "trace/Trace.h"
+#include <nrf_log.h>
 
 using namespace Pinetime::Controllers;
 using namespace Pinetime::Applications;
@@ -30,22 +29,151 @@ namespace {
         return TouchEvents::None;
     }
   }
+
+  // SystemTask only needs to know that the user is active (idle timer), not every single point
+  constexpr uint32_t activityReportPeriod = Pinetime::Drivers::RtcCounter::frequency;
+  // A display flush that comes later than that was not caused by the touch
+  constexpr uint32_t maxPixelLatencyUs = 250000;
+}
+
+TouchHandler::TouchHandler(Drivers::Cst816S& touchPanel)
+  : touchPanel {touchPanel}, interruptSemaphore {interruptSemaphoreStorage.Create()} {
+}
+
+void TouchHandler::Start() {
+  taskHandle = task.Create(TouchHandler::Process, "Touch", 2, this);
+}
+
+void TouchHandler::Register(Pinetime::System::SystemTask* systemTask) {
+  this->systemTask = systemTask;
 }
 
-TouchHandler::TouchHandler(Drivers::Cst816S& touchPanel, Components::LittleVgl& lvgl) : touchPanel {touchPanel}, lvgl {lvgl} {
+void TouchHandler::Process(void* instance) {
+  auto* app = static_cast<TouchHandler*>(instance);
+  NRF_LOG_INFO("touch task started!");
+  app->Work();
+}
+
+void TouchHandler::OnInterrupt(bool wakeUp) {
+  if (taskHandle == nullptr) {
+    return;
+  }
+  interruptTimestamp = Pinetime::Drivers::RtcCounter::Now();
+  wakeUpPending = wakeUp;
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+  xSemaphoreGiveFromISR(interruptSemaphore, &xHigherPriorityTaskWoken);
+  portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+void TouchHandler::Work() {
+  while (true) {
+    xSemaphoreTake(interruptSemaphore, portMAX_DELAY);
+    auto timestamp = interruptTimestamp;
+    bool wakeUp = wakeUpPending;
+    bool wasTouching = info.touching;
+    bool newTouchInfo;
+    {
+      Pinetime::Trace::Span span(Pinetime::Trace::UserEvents::TouchRead);
+      newTouchInfo = GetNewTouchInfo();
+    }
+    if (!newTouchInfo) {
+      continue;
+    }
+
+    if (wakeUp) {
+      // The screen is off : nothing goes to LVGL, SystemTask decides whether the gesture wakes the watch up
+      auto wakeUpGesture = GestureGet();
+      if (systemTask != nullptr && wakeUpGesture != Pinetime::Applications::TouchEvents::None) {
+        systemTask->PushMessage(Pinetime::System::Messages::TouchWakeUp, static_cast<uint32_t>(wakeUpGesture));
+      }
+      continue;
+    }
+
+    if (isCancelled) {
+      PushPoint(-1, -1, info.touching, timestamp);
+      if (!info.touching) {
+        isCancelled = false;
+      }
+    } else {
+      PushPoint(info.x, info.y, info.touching, timestamp);
+    }
+
+    bool newTouch = info.touching && !wasTouching;
+    auto newGesture = GestureGet();
+    bool hasGesture = newGesture != Pinetime::Applications::TouchEvents::None;
+    if (systemTask != nullptr && (newTouch || hasGesture || (timestamp - lastActivityReport) >= activityReportPeriod)) {
+      lastActivityReport = timestamp;
+      // The gesture travels with the message, up to DisplayApp
+      systemTask->PushMessage(Pinetime::System::Messages::OnTouchEvent, static_cast<uint32_t>(newGesture));
+    }
+  }
+}
+
+void TouchHandler::PushPoint(int16_t x, int16_t y, bool touching, uint32_t timestamp) {
+  uint8_t currentHead = head.load(std::memory_order_relaxed);
+  uint8_t next = (currentHead + 1) % bufferSize;
+  if (next == tail.load(std::memory_order_acquire)) {
+    statistics.overruns++;
+    return;
+  }
+  buffer[currentHead] = {x, y, touching, timestamp};
+  head.store(next, std::memory_order_release);
+}
+
+bool TouchHandler::PopPoint(Point& point) {
+  if (cancelPending.exchange(false)) {
+    // Drop the points of the cancelled touch, and move the LVGL pointer out of the screen right away
+    tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+    point = {-1, -1, true, 0};
+    return true;
+  }
+
+  uint8_t currentTail = tail.load(std::memory_order_relaxed);
+  if (currentTail == head.load(std::memory_order_acquire)) {
+    return false;
+  }
+  point = buffer[currentTail];
+  tail.store((currentTail + 1) % bufferSize, std::memory_order_release);
+
+  auto latency = Pinetime::Drivers::RtcCounter::ToUs(Pinetime::Drivers::RtcCounter::Now() - point.timestamp);
+  statistics.samples++;
+  statistics.totalReadLatencyUs += latency;
+  if (latency > statistics.maxReadLatencyUs) {
+    statistics.maxReadLatencyUs = latency;
+  }
+  if (!pixelLatencyPending) {
+    pixelLatencyPending = true;
+    pixelLatencyTimestamp = point.timestamp;
+  }
+  return true;
+}
+
+void TouchHandler::OnDisplayFlushed() {
+  if (!pixelLatencyPending) {
+    return;
+  }
+  pixelLatencyPending = false;
+  auto latency = Pinetime::Drivers::RtcCounter::ToUs(Pinetime::Drivers::RtcCounter::Now() - pixelLatencyTimestamp);
+  if (latency > maxPixelLatencyUs) {
+    return;
+  }
+  statistics.frames++;
+  statistics.lastPixelLatencyUs = latency;
+  statistics.totalPixelLatencyUs += latency;
+  if (latency > statistics.maxPixelLatencyUs) {
+    statistics.maxPixelLatencyUs = latency;
+  }
 }
 
 void TouchHandler::CancelTap() {
-  if (info.touching) {
+  if (IsTouching()) {
     isCancelled = true;
-    lvgl.SetNewTouchPoint(-1, -1, true);
+    cancelPending = true;
   }
 }
 
 Pinetime::Applications::TouchEvents TouchHandler::GestureGet() {
-  auto returnGesture = gesture;
-  gesture = Pinetime::Applications::TouchEvents::None;
-  return returnGesture;
+  return gesture.exchange(Pinetime::Applications::TouchEvents::None);
 }
 
 bool TouchHandler::GetNewTouchInfo() {
@@ -55,6 +183,14 @@ bool TouchHandler::GetNewTouchInfo() {
     return false;
   }
 
+  auto point = lastPoint.load(std::memory_order_relaxed);
+  if (info.touching) {
+    point = touchingFlag | (static_cast<uint32_t>(info.x) << 8) | info.y;
+  } else {
+    point &= ~touchingFlag;
+  }
+  lastPoint.store(point);
+
   if (info.gesture != Pinetime::Drivers::Cst816S::Gestures::None) {
     if (gestureReleased) {
       if (info.gesture == Pinetime::Drivers::Cst816S::Gestures::SlideDown ||
@@ -78,18 +214,3 @@ bool TouchHandler::GetNewTouchInfo() {
 
   return true;
 }
-
-void TouchHandler::UpdateLvglTouchPoint() {
-  if (info.touching) {
-    if (!isCancelled) {
-      lvgl.SetNewTouchPoint(info.x, info.y, true);
-    }
-  } else {
-    if (isCancelled) {
-      lvgl.SetNewTouchPoint(-1, -1, false);
-      isCancelled = false;
-    } else {
-      lvgl.SetNewTouchPoint(info.x, info.y, false);
-    }
-  }
-}
@@ -1,40 +1,111 @@
 #pragma once
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+#include <atomic>
 #include "drivers/Cst816s.h"
 #include "displayapp/TouchEvents.h"
+#include "memory/KernelObjects.h"
 
 namespace Pinetime {
-  namespace Components {
-    class LittleVgl;
-  }
   namespace Drivers {
     class Cst816S;
   }
+  namespace System {
+    class SystemTask;
+  }
   namespace Controllers {
+    /// Samples the touch panel from its own task as soon as the panel raises its interrupt, and publishes the points
+    /// in a single-producer/single-consumer buffer that LVGL reads directly from its input device callback.
     class TouchHandler {
       public:
-        explicit TouchHandler(Drivers::Cst816S&, Components::LittleVgl&);
+        struct Point {
+          int16_t x;
+          int16_t y;
+          bool touching;
+          /// RtcCounter timestamp of the interrupt that triggered the sampling
+          uint32_t timestamp;
+        };
+
+        /// Latency of the touch pipeline, from the panel interrupt to the moment LVGL reads the point, and to the end
+        /// of the first display flush that follows
+        struct LatencyStatistics {
+          uint32_t samples = 0;
+          uint32_t overruns = 0;
+          uint32_t maxReadLatencyUs = 0;
+          uint64_t totalReadLatencyUs = 0;
+          uint32_t frames = 0;
+          uint32_t lastPixelLatencyUs = 0;
+          uint32_t maxPixelLatencyUs = 0;
+          uint64_t totalPixelLatencyUs = 0;
+        };
+
+        explicit TouchHandler(Drivers::Cst816S&);
+        void Start();
+        void Register(Pinetime::System::SystemTask* systemTask);
+        /// Called from the interrupt of the panel. While the watch sleeps (wakeUp), the task only looks for the wake-up
+        /// gesture and sends it to SystemTask with Messages::TouchWakeUp.
+        void OnInterrupt(bool wakeUp = false);
+
         void CancelTap();
-        bool GetNewTouchInfo();
-        void UpdateLvglTouchPoint();
 
-        bool IsTouching() const {
-          return info.touching;
+        /// Consumer side, called from the LVGL input device callback
+        bool PopPoint(Point& point);
+        bool HasPoints() const {
+          return head.load() != tail.load();
+        }
+        /// Called by LVGL at the end of the last flush of a refresh
+        void OnDisplayFlushed();
+
+        /// Last point read by the touch task, x and y are only written when the panel is touched
+        bool GetTouchPoint(uint8_t& x, uint8_t& y) const {
+          auto point = lastPoint.load();
+          x = static_cast<uint8_t>(point >> 8);
+          y = static_cast<uint8_t>(point);
+          return (point & touchingFlag) != 0;
         }
-        uint8_t GetX() const {
-          return info.x;
+        bool IsTouching() const {
+          return (lastPoint.load() & touchingFlag) != 0;
         }
-        uint8_t GetY() const {
-          return info.y;
+
+        const LatencyStatistics& GetLatencyStatistics() const {
+          return statistics;
         }
-        Pinetime::Applications::TouchEvents GestureGet();
+
       private:
+        static void Process(void* instance);
+        void Work();
+        void PushPoint(int16_t x, int16_t y, bool touching, uint32_t timestamp);
+        bool GetNewTouchInfo();
+        Pinetime::Applications::TouchEvents GestureGet();
 
         Pinetime::Drivers::Cst816S::TouchInfos info;
         Pinetime::Drivers::Cst816S& touchPanel;
-        Pinetime::Components::LittleVgl& lvgl;
-        Pinetime::Applications::TouchEvents gesture;
-        bool isCancelled = false;
+        Pinetime::System::SystemTask* systemTask = nullptr;
+        TaskHandle_t taskHandle = nullptr;
+        Memory::StaticTask<200> task;
+        Memory::StaticBinarySemaphore interruptSemaphoreStorage;
+        SemaphoreHandle_t interruptSemaphore;
+        volatile uint32_t interruptTimestamp = 0;
+        volatile bool wakeUpPending = false;
+        std::atomic<Pinetime::Applications::TouchEvents> gesture {Pinetime::Applications::TouchEvents::None};
+        std::atomic<bool> isCancelled {false};
+        std::atomic<bool> cancelPending {false};
         bool gestureReleased = true;
+        uint32_t lastActivityReport = 0;
+
+        static constexpr uint8_t bufferSize = 8;
+        Point buffer[bufferSize];
+        std::atomic<uint8_t> head {0};
+        std::atomic<uint8_t> tail {0};
+
+        // info belongs to the touch task, the other tasks read this copy : touching flag, x and y packed in one word
+        static constexpr uint32_t touchingFlag = 1 << 16;
+        std::atomic<uint32_t> lastPoint {0};
+
+        LatencyStatistics statistics;
+        bool pixelLatencyPending = false;
+        uint32_t pixelLatencyTimestamp = 0;
     };
   }
 }
@@ -0,0 +1,65 @@
+#include "trace/Trace.h"
+#include <atomic>
+#include <nrf.h>
+#include "drivers/RtcCounter.h"
+
+using namespace Pinetime::Trace;
+
+namespace {
+  static_assert(static_cast<uint8_t>(Events::QueueSend) == 1 && static_cast<uint8_t>(Events::QueueBlocked) == 5,
+                "The event codes are hard-coded in the trace macros of FreeRTOSConfig.h");
+  static_assert((Recorder::capacity & (Recorder::capacity - 1)) == 0, "The capacity must be a power of 2");
+
+  Record records[Recorder::capacity];
+  // Number of records since the start : the slots are reserved with an atomic increment, no interrupt is masked
+  std::atomic<uint32_t> head {0};
+}
+
+volatile uint8_t Recorder::categories = Categories::All;
+
+void Recorder::Write(Events event, uint8_t id, uint16_t argument) {
+  uint32_t index = head.fetch_add(1, std::memory_order_relaxed);
+  records[index & (capacity - 1)] = {Pinetime::Drivers::RtcCounter::Now(), event, id, argument};
+}
+
+void Recorder::Freeze() {
+  categories = 0;
+}
+
+void Recorder::Start(uint8_t categories) {
+  Recorder::categories = 0;
+  head = 0;
+  Recorder::categories = categories;
+}
+
+uint32_t Recorder::NbRecorded() {
+  return head;
+}
+
+size_t Recorder::NbRecords() {
+  uint32_t nbRecorded = head;
+  return (nbRecorded < capacity) ? nbRecorded : capacity;
+}
+
+const Record& Recorder::GetRecord(size_t index) {
+  return records[(head - NbRecords() + index) & (capacity - 1)];
+}
+
+IsrScope::IsrScope() : exception {static_cast<uint8_t>(__get_IPSR())} {
+  Recorder::Add(Events::IsrEnter, exception);
+}
+
+IsrScope::~IsrScope() {
+  Recorder::Add(Events::IsrExit, exception);
+}
+
+// Called by the trace macros of FreeRTOS, see FreeRTOSConfig.h
+extern "C" {
+void TraceTaskSwitchedIn(uint32_t taskNumber) {
+  Recorder::Add(Events::TaskSwitchedIn, static_cast<uint8_t>(taskNumber));
+}
+
+void TraceQueueEvent(uint8_t event, const void* queue, uint32_t nbMessages) {
+  Recorder::Add(static_cast<Events>(event), static_cast<uint8_t>(nbMessages), static_cast<uint16_t>(reinterpret_cast<uintptr_t>(queue)));
+}
+}
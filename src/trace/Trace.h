@@ -0,0 +1,116 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace Pinetime {
+  namespace Trace {
+    /// Values shared with the C trace hooks of FreeRTOS (see FreeRTOSConfig.h) and with tools/trace-decoder
+    enum class Events : uint8_t {
+      TaskSwitchedIn = 0,
+      QueueSend = 1,
+      QueueSendFailed = 2,
+      QueueReceive = 3,
+      QueueReceiveFailed = 4,
+      QueueBlocked = 5,
+      IsrEnter = 6,
+      IsrExit = 7,
+      UserBegin = 8,
+      UserEnd = 9,
+      UserMark = 10,
+    };
+
+    enum class UserEvents : uint8_t {
+      SystemTaskMessage = 0,
+      DisplayAppMessage = 1,
+      LvglTaskHandler = 2,
+      DisplayFlush = 3,
+      TwiTransaction = 4,
+      TouchRead = 5,
+    };
+
+    namespace Categories {
+      constexpr uint8_t Tasks = 1 << 0;
+      constexpr uint8_t Queues = 1 << 1;
+      constexpr uint8_t Interrupts = 1 << 2;
+      constexpr uint8_t User = 1 << 3;
+      constexpr uint8_t All = Tasks | Queues | Interrupts | User;
+    }
+
+    /// The id is the task number, the exception number, the user event or the number of messages in the queue. The
+    /// argument is the low half of the queue address (all the RAM fits in 16 bits) or the argument of the user event.
+    struct __attribute__((packed)) Record {
+      uint32_t timestamp;
+      Events event;
+      uint8_t id;
+      uint16_t argument;
+    };
+    static_assert(sizeof(Record) == 8, "The records are part of the BLE protocol");
+
+    /// Records timestamped events (RTC2 ticks) into a RAM ring buffer that overwrites the oldest records. Recording
+    /// is lock-free and costs a few dozen cycles : it is enabled by default, also in release builds.
+    class Recorder {
+    public:
+      static constexpr size_t capacity = 256;
+
+      static void Add(Events event, uint8_t id, uint16_t argument = 0) {
+        if ((categories & CategoryOf(event)) != 0) {
+          Write(event, id, argument);
+        }
+      }
+
+      /// Stops the recording so that the buffer can be read
+      static void Freeze();
+      /// Clears the buffer and records the given categories
+      static void Start(uint8_t categories = Categories::All);
+
+      static uint8_t RecordedCategories() {
+        return categories;
+      }
+      /// Number of records since the last start, including the overwritten ones
+      static uint32_t NbRecorded();
+      /// Number of records available, the oldest one is at index 0
+      static size_t NbRecords();
+      static const Record& GetRecord(size_t index);
+
+    private:
+      static constexpr uint8_t CategoryOf(Events event) {
+        return (event == Events::TaskSwitchedIn) ? Categories::Tasks
+               : (event <= Events::QueueBlocked) ? Categories::Queues
+               : (event <= Events::IsrExit)      ? Categories::Interrupts
+                                                 : Categories::User;
+      }
+      static void Write(Events event, uint8_t id, uint16_t argument);
+
+      static volatile uint8_t categories;
+    };
+
+    /// Records the entry and the exit of the interrupt handler it is declared in
+    class IsrScope {
+    public:
+      IsrScope();
+      ~IsrScope();
+
+    private:
+      uint8_t exception;
+    };
+
+    /// Records the beginning and the end of a user event
+    class Span {
+    public:
+      explicit Span(UserEvents event, uint16_t argument = 0) : event {event}, argument {argument} {
+        Recorder::Add(Events::UserBegin, static_cast<uint8_t>(event), argument);
+      }
+      ~Span() {
+        Recorder::Add(Events::UserEnd, static_cast<uint8_t>(event), argument);
+      }
+
+    private:
+      UserEvents event;
+      uint16_t argument;
+    };
+
+    inline void Mark(UserEvents event, uint16_t argument = 0) {
+      Recorder::Add(Events::UserMark, static_cast<uint8_t>(event), argument);
+    }
+  }
+}
@@ -0,0 +1,349 @@
+/*
+  Offline replay of recorded accelerometer traces through the sleep classification of the firmware (Actigraphy).
+
+  Usage : actigraphy-replay [--json output.json] [--epochs output.csv] trace.csv...
+
+  Each trace is a CSV file with the header "t,x,y,z,state" and one line per sample :
+   - t : time of the sample, in ms
+   - x, y, z : accelerometer values (as sent by the streaming of the motion service)
+   - state : reference state at this sample, 1 for sleep, 0 for wake, -1 if unknown
+  The samples are decimated to the rate of the sleep tracker (Actigraphy::samplePeriodMs) like SleepTracker does.
+  Lines starting with '#' are comments. A comment "# expect agreement>=P tst-error<=M" sets the minimum percentage of
+  epochs classified like the reference and the maximum difference (minutes) between the total sleep time and the
+  reference one : actigraphy-replay returns 1 if a trace does not meet them.
+*/
+
+#include <components/motion/Actigraphy.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+  using Actigraphy = Pinetime::Controllers::Actigraphy;
+  constexpr uint32_t epochDuration = 60000;
+
+  struct Sample {
+    uint32_t t;
+    int16_t x;
+    int16_t y;
+    int16_t z;
+    int state;
+  };
+
+  struct Epoch {
+    uint16_t count = 0;
+    Actigraphy::States state = Actigraphy::States::Unknown;
+    // Number of samples labelled as sleep and wake
+    uint32_t sleepLabels = 0;
+    uint32_t wakeLabels = 0;
+  };
+
+  /// Bounds set by the "# expect" comment of a trace, negative if not set
+  struct Expectations {
+    double minAgreement = -1;
+    double maxSleepError = -1;
+  };
+
+  struct Result {
+    std::string name;
+    size_t samples = 0;
+    std::vector<Epoch> epochs;
+    Actigraphy::Summary summary;
+    size_t scored = 0;
+    size_t agreements = 0;
+    size_t referenceSleep = 0;
+    size_t detectedSleep = 0;
+    size_t referenceWake = 0;
+    size_t detectedWake = 0;
+    double nsPerSample = 0;
+  };
+
+  bool Load(const std::string& path, std::vector<Sample>& samples, Expectations& expectations) {
+    std::ifstream file(path);
+    if (!file) {
+      fprintf(stderr, "%s : cannot open file\n", path.c_str());
+      return false;
+    }
+    std::string line;
+    size_t lineNumber = 0;
+    bool header = true;
+    while (std::getline(file, line)) {
+      lineNumber++;
+      if (line.compare(0, 9, "# expect ") == 0) {
+        std::istringstream bounds(line.substr(9));
+        std::string bound;
+        while (bounds >> bound) {
+          if (bound.compare(0, 11, "agreement>=") == 0) {
+            expectations.minAgreement = std::atof(bound.c_str() + 11);
+          } else if (bound.compare(0, 11, "tst-error<=") == 0) {
+            expectations.maxSleepError = std::atof(bound.c_str() + 11);
+          } else {
+            fprintf(stderr, "%s:%zu : unknown expectation '%s'\n", path.c_str(), lineNumber, bound.c_str());
+            return false;
+          }
+        }
+        continue;
+      }
+      if (line.empty() || line[0] == '#')
+        continue;
+      if (header) {
+        header = false;
+        if (line.compare(0, 1, "t") == 0)
+          continue;
+      }
+      std::istringstream fields(line);
+      std::string field;
+      double values[5] = {0, 0, 0, 0, -1};
+      size_t count = 0;
+      while (count < 5 && std::getline(fields, field, ',')) {
+        values[count++] = std::atof(field.c_str());
+      }
+      if (count < 4) {
+        fprintf(stderr, "%s:%zu : invalid line\n", path.c_str(), lineNumber);
+        return false;
+      }
+      samples.push_back({static_cast<uint32_t>(values[0]),
+                         static_cast<int16_t>(values[1]),
+                         static_cast<int16_t>(values[2]),
+                         static_cast<int16_t>(values[3]),
+                         static_cast<int>(values[4])});
+    }
+    return true;
+  }
+
+  /// Same sequence of calls as SleepTracker::AddSamples() and SleepTracker::Stop()
+  Result Replay(const std::string& name, const std::vector<Sample>& samples) {
+    Result result;
+    result.name = name;
+    result.samples = samples.size();
+    if (samples.empty())
+      return result;
+
+    Actigraphy actigraphy;
+    actigraphy.Reset();
+    result.epochs.emplace_back();
+    uint32_t epochStart = samples[0].t;
+    uint32_t nextSample = samples[0].t;
+    std::chrono::nanoseconds elapsed {0};
+
+    for (const auto& sample : samples) {
+      if (sample.t < nextSample)
+        continue;
+      nextSample += Actigraphy::samplePeriodMs;
+
+      auto start = std::chrono::steady_clock::now();
+      while (sample.t - epochStart >= epochDuration) {
+        auto state = actigraphy.EndEpoch();
+        result.epochs.back().count = actigraphy.LastCount();
+        // The classification is delayed by 2 epochs
+        if (state != Actigraphy::States::Unknown)
+          result.epochs[result.epochs.size() - 3].state = state;
+        result.epochs.emplace_back();
+        epochStart += epochDuration;
+      }
+      actigraphy.AddSample(sample.x, sample.y, sample.z);
+      elapsed += std::chrono::steady_clock::now() - start;
+
+      if (sample.state == 1)
+        result.epochs.back().sleepLabels++;
+      else if (sample.state == 0)
+        result.epochs.back().wakeLabels++;
+    }
+    // The last epoch is incomplete : it is dropped, like SleepTracker does when the tracking stops
+    result.epochs.pop_back();
+    actigraphy.Finish();
+    result.summary = actigraphy.GetSummary();
+    result.nsPerSample = static_cast<double>(elapsed.count()) / samples.size();
+
+    // The 2 last epochs are classified by Finish(), which does not return their state : they are not scored
+    for (const auto& epoch : result.epochs) {
+      if (epoch.state == Actigraphy::States::Unknown || epoch.sleepLabels + epoch.wakeLabels == 0)
+        continue;
+      bool referenceSleep = epoch.sleepLabels > epoch.wakeLabels;
+      bool detectedSleep = epoch.state == Actigraphy::States::Sleep;
+      result.scored++;
+      if (referenceSleep == detectedSleep)
+        result.agreements++;
+      if (referenceSleep) {
+        result.referenceSleep++;
+        if (detectedSleep)
+          result.detectedSleep++;
+      } else {
+        result.referenceWake++;
+        if (!detectedSleep)
+          result.detectedWake++;
+      }
+    }
+    return result;
+  }
+
+  double Percent(size_t value, size_t total) {
+    return (total == 0) ? -1 : (100.0 * value) / total;
+  }
+
+  void PrintPercent(double value) {
+    if (value < 0)
+      printf(" %6s", "-");
+    else
+      printf(" %5.1f%%", value);
+  }
+
+  void Print(const Result& r) {
+    const auto& s = r.summary;
+    printf("%-28s %6zu", r.name.c_str(), r.epochs.size());
+    PrintPercent(Percent(r.agreements, r.scored));
+    PrintPercent(Percent(r.detectedSleep, r.referenceSleep));
+    PrintPercent(Percent(r.detectedWake, r.referenceWake));
+    if (s.hasSlept)
+      printf(" %6u %6u", s.sleepOnset, s.wakeUp);
+    else
+      printf(" %6s %6s", "-", "-");
+    printf(" %6u %6zu %5u %5u %7.0f\n", s.totalSleep, r.referenceSleep, s.wakeAfterSleepOnset, s.awakenings, r.nsPerSample);
+  }
+
+  void PrintJsonNumber(FILE* file, const char* key, double value, bool last = false) {
+    // JSON has no representation for "unknown" numbers
+    if (value < 0)
+      fprintf(file, "      \"%s\": null%s\n", key, last ? "" : ",");
+    else
+      fprintf(file, "      \"%s\": %g%s\n", key, value, last ? "" : ",");
+  }
+
+  bool WriteJson(const char* path, const std::vector<Result>& results) {
+    auto* file = std::fopen(path, "w");
+    if (file == nullptr) {
+      fprintf(stderr, "%s : cannot write file\n", path);
+      return false;
+    }
+    fprintf(file, "{\n  \"traces\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+      const auto& r = results[i];
+      const auto& s = r.summary;
+      fprintf(file, "    {\n      \"name\": \"%s\",\n", r.name.c_str());
+      PrintJsonNumber(file, "samples", r.samples);
+      PrintJsonNumber(file, "epochs", r.epochs.size());
+      PrintJsonNumber(file, "agreement_percent", Percent(r.agreements, r.scored));
+      PrintJsonNumber(file, "sleep_sensitivity_percent", Percent(r.detectedSleep, r.referenceSleep));
+      PrintJsonNumber(file, "wake_specificity_percent", Percent(r.detectedWake, r.referenceWake));
+      PrintJsonNumber(file, "sleep_onset_min", s.hasSlept ? s.sleepOnset : -1);
+      PrintJsonNumber(file, "wake_up_min", s.hasSlept ? s.wakeUp : -1);
+      PrintJsonNumber(file, "total_sleep_min", s.totalSleep);
+      PrintJsonNumber(file, "reference_sleep_min", r.referenceSleep);
+      PrintJsonNumber(file, "wake_after_sleep_onset_min", s.wakeAfterSleepOnset);
+      PrintJsonNumber(file, "awakenings", s.awakenings);
+      PrintJsonNumber(file, "ns_per_sample", r.nsPerSample, true);
+      fprintf(file, "    }%s\n", (i + 1 < results.size()) ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    std::fclose(file);
+    return true;
+  }
+
+  /// One line per epoch, to plot the counts and the hypnogram
+  bool WriteEpochs(const char* path, const std::vector<Result>& results) {
+    auto* file = std::fopen(path, "w");
+    if (file == nullptr) {
+      fprintf(stderr, "%s : cannot write file\n", path);
+      return false;
+    }
+    fprintf(file, "trace,minute,count,state,reference\n");
+    for (const auto& r : results) {
+      for (size_t i = 0; i < r.epochs.size(); i++) {
+        const auto& epoch = r.epochs[i];
+        int state = (epoch.state == Actigraphy::States::Unknown) ? -1 : (epoch.state == Actigraphy::States::Sleep);
+        int reference = (epoch.sleepLabels + epoch.wakeLabels == 0) ? -1 : (epoch.sleepLabels > epoch.wakeLabels);
+        fprintf(file, "%s,%zu,%u,%d,%d\n", r.name.c_str(), i, epoch.count, state, reference);
+      }
+    }
+    std::fclose(file);
+    return true;
+  }
+
+  /// Prints the bounds that the result does not meet, and returns true if it meets all of them
+  bool Check(const Result& r, const Expectations& expectations) {
+    bool passed = true;
+    auto agreement = Percent(r.agreements, r.scored);
+    if (expectations.minAgreement >= 0 && agreement < expectations.minAgreement) {
+      fprintf(stderr, "%s : agreement %.1f%%, expected >= %.1f%%\n", r.name.c_str(), agreement, expectations.minAgreement);
+      passed = false;
+    }
+    // Both are counted in epochs of one minute
+    auto sleepError = std::abs(static_cast<double>(r.summary.totalSleep) - static_cast<double>(r.referenceSleep));
+    if (expectations.maxSleepError >= 0 && (r.scored == 0 || sleepError > expectations.maxSleepError)) {
+      fprintf(stderr,
+              "%s : total sleep time %u min for %zu min of reference, expected a difference <= %.0f min\n",
+              r.name.c_str(),
+              r.summary.totalSleep,
+              r.referenceSleep,
+              expectations.maxSleepError);
+      passed = false;
+    }
+    return passed;
+  }
+
+  std::string BaseName(const std::string& path) {
+    auto slash = path.find_last_of('/');
+    return (slash == std::string::npos) ? path : path.substr(slash + 1);
+  }
+
+  int Usage(const char* name) {
+    fprintf(stderr, "Usage : %s [--json output.json] [--epochs output.csv] trace.csv...\n", name);
+    return 1;
+  }
+}
+
+int main(int argc, char** argv) {
+  const char* jsonPath = nullptr;
+  const char* epochsPath = nullptr;
+  std::vector<std::string> traces;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+      jsonPath = argv[++i];
+    } else if (std::strcmp(argv[i], "--epochs") == 0 && i + 1 < argc) {
+      epochsPath = argv[++i];
+    } else if (argv[i][0] == '-') {
+      return Usage(argv[0]);
+    } else {
+      traces.emplace_back(argv[i]);
+    }
+  }
+  if (traces.empty())
+    return Usage(argv[0]);
+
+  std::vector<Result> results;
+  printf("%-28s %6s %7s %7s %7s %6s %6s %6s %6s %5s %5s %7s\n",
+         "trace",
+         "min",
+         "agree",
+         "sens",
+         "spec",
+         "onset",
+         "wakeup",
+         "tst",
+         "ref",
+         "waso",
+         "awak",
+         "ns/spl");
+  bool passed = true;
+  for (const auto& path : traces) {
+    std::vector<Sample> samples;
+    Expectations expectations;
+    if (!Load(path, samples, expectations))
+      return 1;
+    results.push_back(Replay(BaseName(path), samples));
+    Print(results.back());
+    passed &= Check(results.back(), expectations);
+  }
+
+  if (jsonPath != nullptr && !WriteJson(jsonPath, results))
+    return 1;
+  if (epochsPath != nullptr && !WriteEpochs(epochsPath, results))
+    return 1;
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+"""Generates the synthetic night traces of actigraphy-replay.
+
+These traces are NOT recordings : they model the wrist as a gravity vector
+with sensor noise, small movements while awake, position changes and twitches
+while asleep. They are deterministic (fixed seed) and labelled with the state
+used to generate them, so they are suitable to detect regressions of the
+classification, not to assess its accuracy on real sleepers. Recordings
+(streamed by the motion service, see main.cpp for the format) with a reference
+hypnogram should be added next to them.
+
+Usage : generate.py [output directory], the traces are written next to this
+script by default.
+"""
+
+import math
+import os
+import random
+import sys
+
+SAMPLE_PERIOD_MS = 320
+ONE_G = 1024
+
+
+def orientation(rng):
+    """Random gravity vector, mostly wrist flat or on the side"""
+    theta = rng.uniform(0, math.pi / 2)
+    phi = rng.uniform(0, 2 * math.pi)
+    return [ONE_G * math.sin(theta) * math.cos(phi), ONE_G * math.sin(theta) * math.sin(phi), -ONE_G * math.cos(theta)]
+
+
+def generate(directory, name, description, expect, hypnogram, seed):
+    """hypnogram : list of (minutes, state), state being 'wake', 'sleep' or 'active'"""
+    rng = random.Random(seed)
+    path = os.path.join(directory, name + ".csv")
+    gravity = orientation(rng)
+    target = gravity
+    t = 0
+    with open(path, "w") as f:
+        f.write("# SYNTHETIC trace generated by generate.py : %s\n" % description)
+        f.write("# expect %s\n" % expect)
+        f.write("t,x,y,z,state\n")
+        for minutes, state in hypnogram:
+            end = t + minutes * 60000
+            while t < end:
+                if state == "sleep":
+                    # Position change every ~30 minutes, twitch every ~5 minutes
+                    if rng.random() < SAMPLE_PERIOD_MS / (30 * 60000.0):
+                        target = orientation(rng)
+                    twitch = 60 if rng.random() < SAMPLE_PERIOD_MS / (5 * 60000.0) else 0
+                    moving = 0
+                else:
+                    if rng.random() < SAMPLE_PERIOD_MS / (3 * 60000.0):
+                        target = orientation(rng)
+                    twitch = 0
+                    moving = 40 if state == "wake" else 250
+                    if rng.random() < 0.6:
+                        moving = 0
+                gravity = [g + 0.3 * (c - g) for g, c in zip(gravity, target)]
+                values = [g + rng.gauss(0, 3) + rng.gauss(0, moving) + rng.choice((-1, 1)) * twitch for g in gravity]
+                label = 1 if state == "sleep" else 0
+                f.write("%d,%d,%d,%d,%d\n" % (t, values[0], values[1], values[2], label))
+                t += SAMPLE_PERIOD_MS
+
+
+if __name__ == "__main__":
+    # The bounds are set a little below the current results, to detect regressions
+    output = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__))
+    os.makedirs(output, exist_ok=True)
+    generate(output, "synthetic-night-8h", "8h night, 20 min to fall asleep, one 15 min awakening",
+             "agreement>=90 tst-error<=40",
+             [(20, "wake"), (180, "sleep"), (15, "wake"), (245, "sleep"), (20, "active")], seed=1)
+    generate(output, "synthetic-restless-night", "restless night with many awakenings",
+             "agreement>=85 tst-error<=50",
+             [(40, "wake"), (60, "sleep"), (10, "wake"), (45, "sleep"), (25, "wake"), (90, "sleep"), (6, "wake"),
+              (120, "sleep"), (30, "active")], seed=2)
+    generate(output, "synthetic-awake-evening", "evening on the couch, not sleeping",
+             "agreement>=95 tst-error<=10",
+             [(120, "wake"), (30, "active"), (90, "wake")], seed=3)
@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+
+# SPDX-License-Identifier: GPL-3.0-or-later
+
+"""Downloads the binary log of InfiniTime and formats it with the ELF file of the firmware.
+
+The records are read from the binary log characteristic of the diagnostics
+service (see doc/DiagnosticsService.md). A dump is the concatenation of the
+pages returned by the watch, exactly as they were read.
+"""
+
+import argparse
+import asyncio
+import re
+import struct
+import sys
+
+BINARY_LOG_UUID = '0005000a-78fc-48fe-8e23-433b3a1942d0'
+HEADER = struct.Struct('<IIIIIIH')
+RECORD_HEADER = struct.Struct('<HBBI')
+COMMITTED_MARKER = 0xB1
+
+SELECT = 0x01
+RELEASE = 0x02
+
+CONVERSION = re.compile(r'%([-+ #0]*)(\d*)(?:\.(\d+))?(?:hh|h|ll|l|z|j|t)?([diouxXcsp%])')
+
+
+def parse_header(data, offset):
+    fields = HEADER.unpack_from(data, offset)
+    return dict(zip(('frequency', 'tail', 'head', 'written', 'dropped', 'page_start', 'nb_page_words'), fields))
+
+
+def parse_pages(data):
+    """Returns the header of the last page and the records : (format identifier, timestamp, arguments)"""
+    header = None
+    records = []
+    offset = 0
+    while offset < len(data):
+        header = parse_header(data, offset)
+        offset += HEADER.size
+        end = offset + 4 * header['nb_page_words']
+        while offset < end:
+            identifier, nb_arguments, marker, timestamp = RECORD_HEADER.unpack_from(data, offset)
+            if marker != COMMITTED_MARKER:
+                raise ValueError('corrupted record at offset %d' % offset)
+            offset += RECORD_HEADER.size
+            arguments = struct.unpack_from('<%dI' % nb_arguments, data, offset)
+            offset += 4 * nb_arguments
+            records.append((identifier, timestamp, arguments))
+    return header, records
+
+
+def read_section(elf, name):
+    """Returns the content of a section of a 32-bit little-endian ELF file"""
+    with open(elf, 'rb') as f:
+        data = f.read()
+    if data[:4] != b'\x7fELF' or data[4] != 1 or data[5] != 1:
+        sys.exit('%s is not a 32-bit little-endian ELF file' % elf)
+    section_offset, = struct.unpack_from('<I', data, 0x20)
+    section_size, nb_sections, names_index = struct.unpack_from('<HHH', data, 0x2e)
+    sections = [struct.unpack_from('<IIIIII', data, section_offset + i * section_size) for i in range(nb_sections)]
+    names_offset = sections[names_index][4]
+    for section in sections:
+        name_start = names_offset + section[0]
+        if data[name_start:data.index(b'\0', name_start)].decode() == name:
+            return data[section[4]:section[4] + section[5]]
+    sys.exit('%s has no %s section : the firmware does not use the binary log' % (elf, name))
+
+
+def format_record(strings, identifier, arguments):
+    end = strings.find(b'\0', identifier)
+    if identifier >= len(strings) or end < 0:
+        return '<unknown format 0x%04x> %s' % (identifier, ' '.join('0x%08x' % argument for argument in arguments))
+    remaining = list(arguments)
+
+    def convert(match):
+        flags, width, precision, conversion = match.groups()
+        if conversion == '%':
+            return '%'
+        if not remaining:
+            return match.group(0)
+        argument = remaining.pop(0)
+        if conversion in 'di':
+            # The arguments are recorded as 32-bit words
+            argument = argument - (1 << 32) if argument & 0x80000000 else argument
+            conversion = 'd'
+        elif conversion == 'c':
+            argument = chr(argument & 0xff)
+        elif conversion in 'sp':
+            # The strings are not recorded : print their address
+            return '0x%08x' % argument
+        spec = '%' + flags + width + ('.' + precision if precision else '') + conversion
+        return spec % argument
+
+    return CONVERSION.sub(convert, strings[identifier:end].decode(errors='replace'))
+
+
+async def pull(address, follow, pages):
+    """Appends the pages to the bytearray, as they are downloaded"""
+    from bleak import BleakClient
+
+    pending = asyncio.Event()
+    async with BleakClient(address) as client:
+        if follow:
+            await client.start_notify(BINARY_LOG_UUID, lambda _, __: pending.set())
+        while True:
+            header = parse_header(await client.read_gatt_char(BINARY_LOG_UUID), 0)
+            position = header['tail']
+            while True:
+                await client.write_gatt_char(BINARY_LOG_UUID, struct.pack('<BI', SELECT, position), response=True)
+                page = bytes(await client.read_gatt_char(BINARY_LOG_UUID))
+                header = parse_header(page, 0)
+                if header['nb_page_words'] == 0:
+                    break
+                pages += page
+                position = header['page_start'] + header['nb_page_words']
+                await client.write_gatt_char(BINARY_LOG_UUID, struct.pack('<BI', RELEASE, position), response=True)
+            print('%d records written, %d dropped' % (header['written'], header['dropped']), file=sys.stderr)
+            if not follow:
+                break
+            await pending.wait()
+            pending.clear()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    subparsers = parser.add_subparsers(dest='command', required=True)
+    pull_parser = subparsers.add_parser('pull', help='download and release the records of a watch (requires bleak)')
+    pull_parser.add_argument('address', help='Bluetooth address of the watch')
+    pull_parser.add_argument('-o', '--output', required=True, help='dump file')
+    pull_parser.add_argument('--follow', action='store_true',
+                             help='keep downloading the records each time the watch flushes its log, until Ctrl+C')
+    decode_parser = subparsers.add_parser('decode', help='print the records of a dump')
+    decode_parser.add_argument('dump', help='dump file')
+    decode_parser.add_argument('--elf', required=True, help='ELF file of the firmware running on the watch')
+    args = parser.parse_args()
+
+    if args.command == 'pull':
+        pages = bytearray()
+        try:
+            asyncio.run(pull(args.address, args.follow, pages))
+        except KeyboardInterrupt:
+            pass
+        finally:
+            with open(args.output, 'wb') as f:
+                f.write(pages)
+        return
+
+    with open(args.dump, 'rb') as f:
+        header, records = parse_pages(f.read())
+    if header is None:
+        sys.exit('empty dump')
+    strings = read_section(args.elf, '.binlog_strings')
+    for identifier, timestamp, arguments in records:
+        print('%12.6f  %s' % (timestamp / header['frequency'], format_record(strings, identifier, arguments)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,196 @@
+/*
+  Checks the FIFO drain of Bma421Fifo against a register model of the FIFO of the BMA421.
+
+  Usage : bma421-fifo-test
+  Returns 0 if all the checks pass.
+*/
+
+#include <drivers/Bma421Fifo.h>
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+namespace {
+  int failures = 0;
+
+  void Check(const char* test, const char* what, long value, long expected) {
+    if (value != expected) {
+      fprintf(stderr, "%s : %s is %ld, expected %ld\n", test, what, value, expected);
+      failures++;
+    }
+  }
+
+  /// FIFO of the BMA421 in headerless mode, with only the accelerometer enabled
+  class FifoModel {
+  public:
+    static constexpr size_t capacity = 1024;
+    static constexpr uint8_t lengthRegister = 0x24;
+    static constexpr uint8_t dataRegister = 0x26;
+    // RXD.MAXCNT of the TWIM of the nRF52832 is 8 bits
+    static constexpr size_t maxTransferSize = 255;
+
+    /// Stores a sample the way the sensor does : 12 bits, left aligned, little endian. Frames that do not fit are lost.
+    void Push(Pinetime::Drivers::Bma421Fifo::Sample sample) {
+      if (data.size() + Pinetime::Drivers::Bma421Fifo::frameSize > capacity) {
+        return;
+      }
+      for (auto value : {sample.x, sample.y, sample.z}) {
+        auto raw = static_cast<uint16_t>(value * 0x10);
+        data.push_back(static_cast<uint8_t>(raw));
+        data.push_back(static_cast<uint8_t>(raw >> 8));
+      }
+    }
+
+    static void Read(uint8_t registerAddress, uint8_t* buffer, size_t size, void* context) {
+      auto* model = static_cast<FifoModel*>(context);
+      model->nbTransfers++;
+      model->largestTransfer = std::max(model->largestTransfer, size);
+      if (size > maxTransferSize) {
+        fprintf(stderr, "read of %zu bytes at 0x%02x, the TWIM transfers at most %zu bytes\n", size, registerAddress, maxTransferSize);
+        failures++;
+        return;
+      }
+      if (registerAddress == lengthRegister && size == 2) {
+        auto length = std::min(static_cast<size_t>(static_cast<int>(model->data.size()) + model->lengthOffset), capacity);
+        buffer[0] = static_cast<uint8_t>(length);
+        buffer[1] = static_cast<uint8_t>(length >> 8);
+      } else if (registerAddress == dataRegister) {
+        // Past the end of the FIFO, the sensor returns empty frames (0x8000)
+        for (size_t i = 0; i < size; i++) {
+          if (model->data.empty()) {
+            buffer[i] = (i % 2 == 0) ? 0x00 : 0x80;
+          } else {
+            buffer[i] = model->data.front();
+            model->data.pop_front();
+          }
+        }
+      } else {
+        fprintf(stderr, "unexpected read of %zu bytes at 0x%02x\n", size, registerAddress);
+        failures++;
+      }
+    }
+
+    std::deque<uint8_t> data;
+    /// Added to the length register, to model a length that does not match the data
+    int lengthOffset = 0;
+    size_t nbTransfers = 0;
+    size_t largestTransfer = 0;
+  };
+
+  Pinetime::Drivers::Bma421Fifo::Sample TestSample(int i) {
+    // Covers the 12 bits range, negative values included. -2048 on the X axis would read as an empty frame (0x8000).
+    return {static_cast<int16_t>((i * 37) % 4095 - 2047), static_cast<int16_t>(2047 - (i * 11) % 4096), static_cast<int16_t>(i - 24)};
+  }
+
+  void CheckSamples(const char* test, Pinetime::Drivers::Bma421Fifo& fifo, size_t nbSamples, int first) {
+    Check(test, "number of samples", fifo.NbSamples(), nbSamples);
+    for (size_t i = 0; i < std::min(nbSamples, fifo.NbSamples()); i++) {
+      auto expected = TestSample(first + static_cast<int>(i));
+      auto sample = fifo.Samples()[i];
+      Check(test, "x", sample.x, expected.x);
+      Check(test, "y", sample.y, expected.y);
+      Check(test, "z", sample.z, expected.z);
+    }
+  }
+
+  /// A watermark batch is read in 2 transfers : the length, then all the frames at once
+  void TestBatch() {
+    const char* test = "batch";
+    FifoModel model;
+    Pinetime::Drivers::Bma421Fifo fifo(FifoModel::Read, &model);
+    for (int i = 0; i < 12; i++) {
+      model.Push(TestSample(i));
+    }
+    Check(test, "drained samples", fifo.Drain(), 12);
+    CheckSamples(test, fifo, 12, 0);
+    Check(test, "number of transfers", model.nbTransfers, 2);
+    Check(test, "bytes left in the FIFO", model.data.size(), 0);
+    Check(test, "dropped samples", fifo.DroppedSamples(), 0);
+  }
+
+  /// The sleep tracking watermark (32) plus some delay : more frames than a single TWI transfer can read
+  void TestLargeBatch() {
+    const char* test = "large batch";
+    FifoModel model;
+    Pinetime::Drivers::Bma421Fifo fifo(FifoModel::Read, &model);
+    for (int i = 0; i < 45; i++) {
+      model.Push(TestSample(i));
+    }
+    Check(test, "drained samples", fifo.Drain(), 45);
+    CheckSamples(test, fifo, 45, 0);
+    Check(test, "number of transfers", model.nbTransfers, 3);
+    Check(test, "bytes left in the FIFO", model.data.size(), 0);
+    Check(test, "dropped samples", fifo.DroppedSamples(), 0);
+  }
+
+  void TestEmpty() {
+    const char* test = "empty";
+    FifoModel model;
+    Pinetime::Drivers::Bma421Fifo fifo(FifoModel::Read, &model);
+    Check(test, "drained samples", fifo.Drain(), 0);
+    Check(test, "number of transfers", model.nbTransfers, 1);
+  }
+
+  /// A full FIFO holds more frames than the buffer : the oldest ones are read and dropped, in bursts that fit
+  void TestOverflow() {
+    const char* test = "overflow";
+    FifoModel model;
+    Pinetime::Drivers::Bma421Fifo fifo(FifoModel::Read, &model);
+    for (int i = 0; i < 200; i++) {
+      model.Push(TestSample(i));
+    }
+    auto nbFrames = static_cast<int>(FifoModel::capacity / Pinetime::Drivers::Bma421Fifo::frameSize);
+    auto maxSamples = static_cast<int>(Pinetime::Drivers::Bma421Fifo::maxSamples);
+    Check(test, "drained samples", fifo.Drain(), maxSamples);
+    CheckSamples(test, fifo, maxSamples, nbFrames - maxSamples);
+    Check(test, "dropped samples", fifo.DroppedSamples(), nbFrames - maxSamples);
+    Check(test, "largest transfer", model.largestTransfer, Pinetime::Drivers::Bma421Fifo::maxBurstFrames * Pinetime::Drivers::Bma421Fifo::frameSize);
+    Check(test, "bytes left in the FIFO", model.data.size(), 0);
+  }
+
+  /// The sensor may be writing a frame while the FIFO is read : the incomplete frame is read by the next drain
+  void TestIncompleteFrame() {
+    const char* test = "incomplete frame";
+    FifoModel model;
+    Pinetime::Drivers::Bma421Fifo fifo(FifoModel::Read, &model);
+    for (int i = 0; i < 3; i++) {
+      model.Push(TestSample(i));
+    }
+    model.lengthOffset = -4;
+    Check(test, "drained samples", fifo.Drain(), 2);
+    CheckSamples(test, fifo, 2, 0);
+    model.lengthOffset = 0;
+    Check(test, "drained samples of the next drain", fifo.Drain(), 1);
+    CheckSamples(test, fifo, 1, 2);
+  }
+
+  /// A length larger than the data (frames dropped by the sensor) : the drain stops at the first empty frame
+  void TestEmptyFrame() {
+    const char* test = "empty frame";
+    FifoModel model;
+    Pinetime::Drivers::Bma421Fifo fifo(FifoModel::Read, &model);
+    for (int i = 0; i < 2; i++) {
+      model.Push(TestSample(i));
+    }
+    model.lengthOffset = 2 * Pinetime::Drivers::Bma421Fifo::frameSize;
+    Check(test, "drained samples", fifo.Drain(), 2);
+    CheckSamples(test, fifo, 2, 0);
+    Check(test, "dropped samples", fifo.DroppedSamples(), 0);
+  }
+}
+
+int main() {
+  TestBatch();
+  TestLargeBatch();
+  TestEmpty();
+  TestOverflow();
+  TestIncompleteFrame();
+  TestEmptyFrame();
+  if (failures > 0) {
+    fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+  printf("All checks passed\n");
+  return 0;
+}
@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+
+# SPDX-License-Identifier: GPL-3.0-or-later
+
+"""Drives the PC sampler of InfiniTime and symbolises its histogram.
+
+The histogram is read from the PC samples characteristic of the diagnostics
+service (see doc/DiagnosticsService.md). A dump is the concatenation of the
+pages returned by the watch, exactly as they were read.
+"""
+
+import argparse
+import asyncio
+import bisect
+import collections
+import struct
+import subprocess
+import sys
+
+PC_SAMPLES_UUID = '00050009-78fc-48fe-8e23-433b3a1942d0'
+HEADER = struct.Struct('<BBHIIIIHHB')
+ENTRY = struct.Struct('<HH')
+
+START = 0x01
+STOP = 0x02
+CLEAR = 0x03
+SELECT = 0x04
+
+
+def parse_pages(data):
+    """Returns the header of the last page and the samples per bucket address"""
+    header = None
+    samples = {}
+    offset = 0
+    while offset < len(data):
+        fields = HEADER.unpack_from(data, offset)
+        header = dict(zip(('running', 'bucket_shift', 'period_us', 'samples', 'outside', 'lost', 'halvings',
+                           'nb_entries', 'first_entry', 'nb_page_entries'), fields))
+        offset += HEADER.size
+        for _ in range(header['nb_page_entries']):
+            bucket, count = ENTRY.unpack_from(data, offset)
+            offset += ENTRY.size
+            if bucket != 0 and count != 0:
+                samples[bucket << header['bucket_shift']] = count
+    return header, samples
+
+
+def read_symbols(elf, nm):
+    """Returns the functions of the ELF file, sorted by address : (address, size, name)"""
+    output = subprocess.run([nm, '--demangle', '--numeric-sort', '--print-size', '--defined-only', elf],
+                            check=True, capture_output=True, text=True).stdout
+    symbols = []
+    for line in output.splitlines():
+        fields = line.split(maxsplit=3)
+        if len(fields) == 4 and fields[2] in 'tTwW':
+            # Clear the Thumb bit of the functions
+            symbols.append((int(fields[0], 16) & ~1, int(fields[1], 16), fields[3]))
+    return sorted(symbols)
+
+
+def symbolise(samples, symbols, bucket_size):
+    """Samples per function. A bucket that overlaps several functions is charged to the first one"""
+    addresses = [symbol[0] for symbol in symbols]
+    functions = collections.Counter()
+    for address, count in samples.items():
+        name = '0x%05x (unknown)' % address
+        # The function that contains the start of the bucket, or else the first one that starts in the bucket
+        index = bisect.bisect_right(addresses, address) - 1
+        if index >= 0 and address < symbols[index][0] + max(symbols[index][1], 1):
+            name = symbols[index][2]
+        elif index + 1 < len(symbols) and symbols[index + 1][0] < address + bucket_size:
+            name = symbols[index + 1][2]
+        functions[name] += count
+    return functions
+
+
+async def pull(address, period, duration):
+    from bleak import BleakClient
+
+    pages = bytearray()
+    async with BleakClient(address) as client:
+        if duration > 0:
+            await client.write_gatt_char(PC_SAMPLES_UUID, bytes([CLEAR]), response=True)
+            await client.write_gatt_char(PC_SAMPLES_UUID, struct.pack('<BH', START, period), response=True)
+            print('Sampling for %d s...' % duration, file=sys.stderr)
+            await asyncio.sleep(duration)
+            await client.write_gatt_char(PC_SAMPLES_UUID, bytes([STOP]), response=True)
+        first = 0
+        while True:
+            await client.write_gatt_char(PC_SAMPLES_UUID, struct.pack('<BH', SELECT, first), response=True)
+            page = bytes(await client.read_gatt_char(PC_SAMPLES_UUID))
+            pages += page
+            header, _ = parse_pages(page)
+            first += header['nb_page_entries']
+            if header['nb_page_entries'] == 0 or first >= header['nb_entries']:
+                break
+    return bytes(pages)
+
+
+def report(header, samples, symbols, top):
+    total = sum(samples.values())
+    print('%d samples every %d us, %d outside of the flash, %d lost, counts halved %d times' %
+          (header['samples'], header['period_us'], header['outside'], header['lost'], header['halvings']))
+    if total == 0:
+        return
+    functions = symbolise(samples, symbols, 1 << header['bucket_shift'])
+    print('%8s %7s  %s' % ('samples', '%', 'function'))
+    for name, count in functions.most_common(top):
+        print('%8d %6.2f%%  %s' % (count, 100.0 * count / total, name))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    subparsers = parser.add_subparsers(dest='command', required=True)
+    pull_parser = subparsers.add_parser('pull', help='download the histogram of a watch (requires bleak)')
+    pull_parser.add_argument('address', help='Bluetooth address of the watch')
+    pull_parser.add_argument('-o', '--output', required=True, help='dump file')
+    pull_parser.add_argument('--duration', type=int, default=0,
+                             help='clear the histogram and sample for this number of seconds before downloading it')
+    pull_parser.add_argument('--period', type=int, default=1009, help='sampling period, in us (default: 1009)')
+    report_parser = subparsers.add_parser('report', help='print the functions with the most samples')
+    report_parser.add_argument('dump', help='dump file')
+    report_parser.add_argument('--elf', required=True, help='ELF file of the firmware running on the watch')
+    report_parser.add_argument('--nm', default='arm-none-eabi-nm', help='nm of the toolchain')
+    report_parser.add_argument('--top', type=int, default=30, help='number of functions to print')
+    args = parser.parse_args()
+
+    if args.command == 'pull':
+        data = asyncio.run(pull(args.address, args.period, args.duration))
+        with open(args.output, 'wb') as f:
+            f.write(data)
+        return
+
+    with open(args.dump, 'rb') as f:
+        header, samples = parse_pages(f.read())
+    if header is None:
+        sys.exit('empty dump')
+    report(header, samples, read_symbols(args.elf, args.nm), args.top)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,170 @@
+/*
+  Checks the beat detection and the HRV metrics of Hrv against synthetic pulse waves built from known RR series.
+
+  Usage : hrv-test
+  Returns 0 if all the checks pass.
+*/
+
+#include <components/heartrate/Hrv.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+  // Sampling period of HeartRateTask : 40 ticks at 1024Hz
+  constexpr double samplePeriod = 40.0 / 1024.0;
+
+  int failures = 0;
+
+  void Check(bool condition, const char* test, const char* format, double value, double expected) {
+    if (!condition) {
+      fprintf(stderr, "%s : ", test);
+      fprintf(stderr, format, value, expected);
+      fprintf(stderr, "\n");
+      failures++;
+    }
+  }
+
+  void CheckNear(const char* test, const char* what, double value, double expected, double tolerance) {
+    char format[64];
+    snprintf(format, sizeof(format), "%s is %%.1f, expected %%.1f", what);
+    Check(std::abs(value - expected) <= tolerance, test, format, value, expected);
+  }
+
+  /// RMSSD and SDNN of a RR series, as defined by the Task Force of the ESC/NASPE (1996)
+  void Reference(const std::vector<double>& rr, double& rmssd, double& sdnn) {
+    double sumDifferences = 0;
+    for (size_t i = 1; i < rr.size(); i++) {
+      sumDifferences += (rr[i] - rr[i - 1]) * (rr[i] - rr[i - 1]);
+    }
+    rmssd = std::sqrt(sumDifferences / (rr.size() - 1));
+    double mean = 0;
+    for (auto interval : rr) {
+      mean += interval / rr.size();
+    }
+    double variance = 0;
+    for (auto interval : rr) {
+      variance += (interval - mean) * (interval - mean) / rr.size();
+    }
+    sdnn = std::sqrt(variance);
+  }
+
+  /// Band-passed PPG pulse wave (as returned by Ppg::Pulse()) with a beat at each of the given times (in s) :
+  /// systolic dip followed by the smaller dicrotic one, plus some noise.
+  std::vector<float> PulseWave(const std::vector<double>& beats, double duration, double noise) {
+    std::vector<float> wave(static_cast<size_t>(duration / samplePeriod));
+    srand(42);
+    for (size_t i = 0; i < wave.size(); i++) {
+      auto t = i * samplePeriod;
+      double value = 0;
+      for (auto beat : beats) {
+        auto systolic = (t - beat) / 0.07;
+        auto dicrotic = (t - beat - 0.3) / 0.1;
+        value -= 100 * (std::exp(-systolic * systolic / 2) + 0.4 * std::exp(-dicrotic * dicrotic / 2));
+      }
+      wave[i] = static_cast<float>(value + noise * (2.0 * rand() / RAND_MAX - 1.0));
+    }
+    return wave;
+  }
+
+  std::vector<double> Beats(const std::vector<double>& rr) {
+    std::vector<double> beats {0.5};
+    for (auto interval : rr) {
+      beats.push_back(beats.back() + interval / 1000);
+    }
+    return beats;
+  }
+
+  /// Feeds the wave to hrv, and returns the accepted intervals
+  std::vector<uint16_t> Run(Pinetime::Controllers::Hrv& hrv, const std::vector<float>& wave) {
+    std::vector<uint16_t> intervals;
+    for (size_t i = 0; i < wave.size(); i++) {
+      if (hrv.Step(wave[i], static_cast<uint32_t>(i * samplePeriod * 1000))) {
+        intervals.push_back(hrv.RrInterval());
+      }
+    }
+    return intervals;
+  }
+
+  /// Respiratory sinus arrhythmia : the RR intervals follow the breathing (~15 breaths/min)
+  void TestSinusArrhythmia() {
+    const char* test = "sinus arrhythmia";
+    std::vector<double> rr;
+    for (int i = 0; i < 30; i++) {
+      rr.push_back(950 + 40 * std::sin(2 * M_PI * i / 4.0) + ((i * 37) % 11 - 5) * 3);
+    }
+    double rmssd, sdnn;
+    Reference(rr, rmssd, sdnn);
+
+    Pinetime::Controllers::Hrv hrv;
+    auto intervals = Run(hrv, PulseWave(Beats(rr), 0.5 + 30, 2));
+    CheckNear(test, "number of intervals", intervals.size(), rr.size(), 1);
+    for (size_t i = 0; i < intervals.size() && i + 1 < rr.size(); i++) {
+      // The first interval starts at the first detected beat
+      CheckNear(test, "interval", intervals[i], rr[i + 1], 8);
+    }
+    CheckNear(test, "RMSSD", hrv.Rmssd(), rmssd, 3);
+    CheckNear(test, "SDNN", hrv.Sdnn(), sdnn, 3);
+  }
+
+  /// A missed beat (double interval) must be dropped without corrupting the metrics
+  void TestMissedBeat() {
+    const char* test = "missed beat";
+    std::vector<double> rr(20, 800);
+    for (size_t i = 0; i < rr.size(); i++) {
+      rr[i] += (i % 2 == 0) ? 20 : -20;
+    }
+    auto beats = Beats(rr);
+    beats.erase(beats.begin() + 10);
+
+    Pinetime::Controllers::Hrv hrv;
+    auto intervals = Run(hrv, PulseWave(beats, 0.5 + 17, 2));
+    for (auto interval : intervals) {
+      CheckNear(test, "interval", interval, 800, 30);
+    }
+    CheckNear(test, "RMSSD", hrv.Rmssd(), 40, 4);
+    CheckNear(test, "SDNN", hrv.Sdnn(), 20, 3);
+  }
+
+  /// After Invalidate() (motion), the detection must restart even if the artifacts raised the envelope
+  void TestInvalidate() {
+    const char* test = "invalidate";
+    std::vector<double> rr(30, 750);
+    auto wave = PulseWave(Beats(rr), 0.5 + 23, 2);
+    auto motionStart = static_cast<size_t>(8 / samplePeriod);
+    auto motionEnd = static_cast<size_t>(12 / samplePeriod);
+    for (size_t i = motionStart; i < motionEnd; i++) {
+      wave[i] += static_cast<float>(2000 * std::sin(2 * M_PI * 2.3 * i * samplePeriod));
+    }
+
+    // The motion is only detected after 1s : the artifacts reach the detection until then
+    auto motionDetected = motionStart + static_cast<size_t>(1 / samplePeriod);
+
+    Pinetime::Controllers::Hrv hrv;
+    std::vector<uint16_t> intervals;
+    for (size_t i = 0; i < wave.size(); i++) {
+      if (i >= motionDetected && i < motionEnd) {
+        hrv.Invalidate();
+      } else if (hrv.Step(wave[i], static_cast<uint32_t>(i * samplePeriod * 1000)) && i >= motionEnd) {
+        intervals.push_back(hrv.RrInterval());
+      }
+    }
+    CheckNear(test, "number of intervals after the motion", intervals.size(), 14, 2);
+    for (auto interval : intervals) {
+      CheckNear(test, "interval", interval, 750, 8);
+    }
+  }
+}
+
+int main() {
+  TestSinusArrhythmia();
+  TestMissedBeat();
+  TestInvalidate();
+  if (failures > 0) {
+    fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+  printf("All checks passed\n");
+  return 0;
+}
@@ -0,0 +1,317 @@
+/*
+  Offline replay of recorded PPG traces through the firmware heart rate pipeline (Ppg, Biquad, Ptagc, Hrv).
+
+  Usage : ppg-replay [--json output.json] trace.csv...
+
+  Each trace is a CSV file with the header "hrs,als,x,y,z,bpm" and one line per sample, sampled like the
+  firmware does (one sample every 40 ticks of 1/1024s) :
+   - hrs, als : raw values returned by Hrs3300::ReadHrs() and Hrs3300::ReadAls()
+   - x, y, z : accelerometer values from MotionController (0 if not recorded)
+   - bpm : reference heart rate at this sample (chest strap, ...), 0 if unknown
+  Lines starting with '#' are comments. A comment "# expect accuracy>=P mae<=E" sets the minimum percentage of
+  accurate readings and the maximum mean absolute error (bpm) of the trace : ppg-replay returns 1 if a trace does
+  not meet them.
+*/
+
+#include <components/heartrate/Hrv.h>
+#include <components/heartrate/Ppg.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+#endif
+
+namespace {
+  // Sampling period of HeartRateTask : 40 ticks at 1024Hz
+  constexpr double samplePeriod = 40.0 / 1024.0;
+  // A reading is considered accurate if it is within this distance of the reference
+  constexpr int accuracyTolerance = 5;
+
+  struct Sample {
+    float hrs;
+    float als;
+    int16_t x;
+    int16_t y;
+    int16_t z;
+    int bpm;
+  };
+
+  /// Bounds set by the "# expect" comment of a trace, negative if not set
+  struct Expectations {
+    double minAccuracy = -1;
+    double maxError = -1;
+  };
+
+  struct Result {
+    std::string name;
+    size_t samples = 0;
+    size_t readings = 0;
+    size_t referencedReadings = 0;
+    size_t accurateReadings = 0;
+    double absoluteError = 0;
+    double timeToFirstReading = -1;
+    double confidence = 0;
+    size_t rrIntervals = 0;
+    uint16_t rmssd = 0;
+    uint16_t sdnn = 0;
+    double nsPerSample = 0;
+    double cyclesPerSample = -1;
+  };
+
+  uint64_t Cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+  }
+
+  bool Load(const std::string& path, std::vector<Sample>& samples, Expectations& expectations) {
+    std::ifstream file(path);
+    if (!file) {
+      fprintf(stderr, "%s : cannot open file\n", path.c_str());
+      return false;
+    }
+    std::string line;
+    size_t lineNumber = 0;
+    bool header = true;
+    while (std::getline(file, line)) {
+      lineNumber++;
+      if (line.compare(0, 9, "# expect ") == 0) {
+        std::istringstream bounds(line.substr(9));
+        std::string bound;
+        while (bounds >> bound) {
+          if (bound.compare(0, 10, "accuracy>=") == 0) {
+            expectations.minAccuracy = std::atof(bound.c_str() + 10);
+          } else if (bound.compare(0, 5, "mae<=") == 0) {
+            expectations.maxError = std::atof(bound.c_str() + 5);
+          } else {
+            fprintf(stderr, "%s:%zu : unknown expectation '%s'\n", path.c_str(), lineNumber, bound.c_str());
+            return false;
+          }
+        }
+        continue;
+      }
+      if (line.empty() || line[0] == '#')
+        continue;
+      if (header) {
+        header = false;
+        if (line.compare(0, 3, "hrs") == 0)
+          continue;
+      }
+      std::istringstream fields(line);
+      std::string field;
+      double values[6] = {0};
+      size_t count = 0;
+      while (count < 6 && std::getline(fields, field, ',')) {
+        values[count++] = std::atof(field.c_str());
+      }
+      if (count < 1) {
+        fprintf(stderr, "%s:%zu : invalid line\n", path.c_str(), lineNumber);
+        return false;
+      }
+      samples.push_back({static_cast<float>(values[0]),
+                         static_cast<float>(values[1]),
+                         static_cast<int16_t>(values[2]),
+                         static_cast<int16_t>(values[3]),
+                         static_cast<int16_t>(values[4]),
+                         static_cast<int>(values[5])});
+    }
+    return true;
+  }
+
+  /// Same sequence of calls as HeartRateTask::StartMeasurement() and HeartRateTask::ProcessSample().
+  /// The LED AGC is not replayed : it changes the sensor settings, which a recording cannot reproduce.
+  Result Replay(const std::string& name, const std::vector<Sample>& samples) {
+    Result result;
+    result.name = name;
+    result.samples = samples.size();
+    if (samples.empty())
+      return result;
+
+    Pinetime::Controllers::Ppg ppg;
+    Pinetime::Controllers::Hrv hrv;
+    ppg.SetOffset(samples[0].hrs, samples[0].als);
+
+    std::chrono::nanoseconds elapsed {0};
+    uint64_t cycles = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+      const auto& sample = samples[i];
+      auto timestamp = static_cast<uint32_t>(i * samplePeriod * 1000);
+
+      auto start = std::chrono::steady_clock::now();
+      auto startCycles = Cycles();
+      ppg.SetMotion(sample.x, sample.y, sample.z);
+      ppg.Preprocess(sample.hrs, sample.als);
+      bool newInterval = false;
+      if (ppg.IsMoving())
+        hrv.Invalidate();
+      else
+        newInterval = hrv.Step(ppg.Pulse(), timestamp);
+      auto bpm = static_cast<int>(ppg.HeartRate());
+      cycles += Cycles() - startCycles;
+      elapsed += std::chrono::steady_clock::now() - start;
+
+      if (newInterval)
+        result.rrIntervals++;
+      if (bpm == 0)
+        continue;
+
+      result.readings++;
+      result.confidence += ppg.Confidence();
+      if (result.timeToFirstReading < 0)
+        result.timeToFirstReading = (i + 1) * samplePeriod;
+      if (sample.bpm != 0) {
+        auto error = std::abs(bpm - sample.bpm);
+        result.referencedReadings++;
+        result.absoluteError += error;
+        if (error <= accuracyTolerance)
+          result.accurateReadings++;
+      }
+    }
+
+    if (result.readings > 0)
+      result.confidence /= result.readings;
+    if (result.referencedReadings > 0)
+      result.absoluteError /= result.referencedReadings;
+    result.rmssd = hrv.Rmssd();
+    result.sdnn = hrv.Sdnn();
+    result.nsPerSample = static_cast<double>(elapsed.count()) / samples.size();
+    if (cycles != 0)
+      result.cyclesPerSample = static_cast<double>(cycles) / samples.size();
+    return result;
+  }
+
+  double AccuracyPercent(const Result& result) {
+    if (result.referencedReadings == 0)
+      return -1;
+    return (100.0 * result.accurateReadings) / result.referencedReadings;
+  }
+
+  void Print(const Result& r) {
+    printf("%-32s %7zu %5zu", r.name.c_str(), r.samples, r.readings);
+    if (r.referencedReadings > 0)
+      printf(" %7.1f %6.1f%%", r.absoluteError, AccuracyPercent(r));
+    else
+      printf(" %7s %7s", "-", "-");
+    if (r.timeToFirstReading >= 0)
+      printf(" %7.1fs", r.timeToFirstReading);
+    else
+      printf(" %8s", "-");
+    printf(" %5.0f%% %5zu %5u %5u %8.0f", r.confidence, r.rrIntervals, r.rmssd, r.sdnn, r.nsPerSample);
+    if (r.cyclesPerSample >= 0)
+      printf(" %8.0f", r.cyclesPerSample);
+    printf("\n");
+  }
+
+  void PrintJsonNumber(FILE* file, const char* key, double value, bool last = false) {
+    // JSON has no representation for "unknown" numbers
+    if (value < 0)
+      fprintf(file, "      \"%s\": null%s\n", key, last ? "" : ",");
+    else
+      fprintf(file, "      \"%s\": %g%s\n", key, value, last ? "" : ",");
+  }
+
+  bool WriteJson(const char* path, const std::vector<Result>& results) {
+    auto* file = std::fopen(path, "w");
+    if (file == nullptr) {
+      fprintf(stderr, "%s : cannot write file\n", path);
+      return false;
+    }
+    fprintf(file, "{\n  \"traces\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+      const auto& r = results[i];
+      fprintf(file, "    {\n      \"name\": \"%s\",\n", r.name.c_str());
+      PrintJsonNumber(file, "samples", r.samples);
+      PrintJsonNumber(file, "readings", r.readings);
+      PrintJsonNumber(file, "mean_absolute_error_bpm", r.referencedReadings > 0 ? r.absoluteError : -1);
+      PrintJsonNumber(file, "accuracy_percent", AccuracyPercent(r));
+      PrintJsonNumber(file, "time_to_first_reading_s", r.timeToFirstReading);
+      PrintJsonNumber(file, "mean_confidence", r.confidence);
+      PrintJsonNumber(file, "rr_intervals", r.rrIntervals);
+      PrintJsonNumber(file, "rmssd_ms", r.rmssd);
+      PrintJsonNumber(file, "sdnn_ms", r.sdnn);
+      PrintJsonNumber(file, "ns_per_sample", r.nsPerSample);
+      PrintJsonNumber(file, "host_cycles_per_sample", r.cyclesPerSample, true);
+      fprintf(file, "    }%s\n", (i + 1 < results.size()) ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    std::fclose(file);
+    return true;
+  }
+
+  /// Prints the bounds that the result does not meet, and returns true if it meets all of them
+  bool Check(const Result& r, const Expectations& expectations) {
+    bool passed = true;
+    if (expectations.minAccuracy >= 0 && AccuracyPercent(r) < expectations.minAccuracy) {
+      fprintf(stderr, "%s : accuracy %.1f%%, expected >= %.1f%%\n", r.name.c_str(), AccuracyPercent(r), expectations.minAccuracy);
+      passed = false;
+    }
+    if (expectations.maxError >= 0 && (r.referencedReadings == 0 || r.absoluteError > expectations.maxError)) {
+      fprintf(stderr, "%s : mean absolute error %.1f bpm, expected <= %.1f bpm\n", r.name.c_str(), r.absoluteError, expectations.maxError);
+      passed = false;
+    }
+    return passed;
+  }
+
+  std::string BaseName(const std::string& path) {
+    auto slash = path.find_last_of('/');
+    return (slash == std::string::npos) ? path : path.substr(slash + 1);
+  }
+}
+
+int main(int argc, char** argv) {
+  const char* jsonPath = nullptr;
+  std::vector<std::string> traces;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+      jsonPath = argv[++i];
+    } else if (argv[i][0] == '-') {
+      fprintf(stderr, "Usage : %s [--json output.json] trace.csv...\n", argv[0]);
+      return 1;
+    } else {
+      traces.emplace_back(argv[i]);
+    }
+  }
+  if (traces.empty()) {
+    fprintf(stderr, "Usage : %s [--json output.json] trace.csv...\n", argv[0]);
+    return 1;
+  }
+
+  std::vector<Result> results;
+  printf("%-32s %7s %5s %7s %7s %8s %6s %5s %5s %5s %8s %8s\n",
+         "trace",
+         "samples",
+         "bpms",
+         "mae",
+         "acc",
+         "first",
+         "conf",
+         "rr",
+         "rmssd",
+         "sdnn",
+         "ns/spl",
+         "cyc/spl");
+  bool passed = true;
+  for (const auto& path : traces) {
+    std::vector<Sample> samples;
+    Expectations expectations;
+    if (!Load(path, samples, expectations))
+      return 1;
+    results.push_back(Replay(BaseName(path), samples));
+    Print(results.back());
+    passed &= Check(results.back(), expectations);
+  }
+
+  if (jsonPath != nullptr && !WriteJson(jsonPath, results))
+    return 1;
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""Generates the synthetic traces bundled with ppg-replay.
+
+These traces are NOT recordings : they are a DC level plus a pulse waveform
+(systolic peak and dicrotic wave) at a known, slowly varying heart rate, with
+noise, baseline wander and optional motion artifacts. They are deterministic
+(fixed seed), so they are suitable to track regressions of the pipeline, not
+to assess its accuracy on real wrists. Real recordings (raw ReadHrs/ReadAls
+values, see main.cpp for the format) should be added next to them.
+"""
+
+import math
+import os
+import random
+
+SAMPLE_PERIOD = 40.0 / 1024.0
+
+
+def pulse(phase):
+    """One heart beat, phase in [0, 1)"""
+    systolic = math.exp(-((phase - 0.15) / 0.07) ** 2)
+    dicrotic = 0.4 * math.exp(-((phase - 0.45) / 0.1) ** 2)
+    # The sensor measures the absorbed light : the reflected light decreases with the blood volume
+    return -(systolic + dicrotic)
+
+
+def generate(name, description, expect, duration, bpm, amplitude, noise, motion=None, ambient=None, seed=1):
+    rng = random.Random(seed)
+    path = os.path.join(os.path.dirname(os.path.abspath(__file__)), name + ".csv")
+    phase = 0.0
+    with open(path, "w") as f:
+        f.write("# SYNTHETIC trace generated by generate.py : %s\n" % description)
+        f.write("# expect %s\n" % expect)
+        f.write("hrs,als,x,y,z,bpm\n")
+        for i in range(int(duration / SAMPLE_PERIOD)):
+            t = i * SAMPLE_PERIOD
+            rate = bpm(t)
+            phase = (phase + SAMPLE_PERIOD * rate / 60.0) % 1.0
+            wander = 300 * math.sin(2 * math.pi * 0.05 * t)
+            hrs = 15000 + wander + amplitude * pulse(phase) + rng.gauss(0, noise)
+            als = 200 + rng.gauss(0, 2)
+            if ambient is not None:
+                # The ambient light reaches both channels : the HRS one sees it on top of the LED light
+                hrs += ambient(t)
+                als += ambient(t)
+            x, y, z = 0, 0, 1024
+            if motion is not None and motion[0] <= t < motion[1]:
+                shake = math.sin(2 * math.pi * 2.3 * t)
+                x, y = int(400 * shake), int(250 * math.cos(2 * math.pi * 1.7 * t))
+                hrs += 1500 * shake
+            f.write("%d,%d,%d,%d,%d,%d\n" % (hrs, als, x, y, z, round(rate)))
+
+
+if __name__ == "__main__":
+    generate("synthetic-rest-62bpm", "resting, 62 bpm with respiratory variation",
+             "accuracy>=90 mae<=3",
+             60, lambda t: 62 + 3 * math.sin(2 * math.pi * 0.25 * t), 400, 20)
+    generate("synthetic-walk-95-120bpm", "heart rate ramping from 95 to 120 bpm, low perfusion",
+             "accuracy>=40 mae<=30",
+             60, lambda t: 95 + 25 * t / 60, 150, 25, seed=2)
+    generate("synthetic-motion-75bpm", "75 bpm with 15s of arm movement",
+             "accuracy>=60 mae<=6",
+             60, lambda t: 75, 300, 20, motion=(20, 35), seed=3)
+    generate("synthetic-ambient-80bpm", "80 bpm while walking under trees : ambient light flickering at ~1.1Hz",
+             "accuracy>=80 mae<=5",
+             60, lambda t: 80, 300, 20, ambient=lambda t: 1500 * (0.5 + 0.5 * math.sin(2 * math.pi * 1.1 * t)), seed=4)
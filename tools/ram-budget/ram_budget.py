@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+
+# SPDX-License-Identifier: GPL-3.0-or-later
+
+"""Prints the RAM used by each subsystem of InfiniTime, from the map file written by the linker.
+
+The tasks, queues and semaphores are allocated statically, so their stacks and
+control blocks are accounted to the object that owns them. The objects defined
+in main.cpp own most of the firmware : they are listed one by one.
+"""
+
+import argparse
+import re
+import sys
+
+MEMORY_REGION = re.compile(r'^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)')
+# ' .bss.name  0x20001000  0x120 file', the name may be alone on its line when it is long
+INPUT_SECTION = re.compile(r'^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.*)$')
+INPUT_SECTION_NAME = re.compile(r'^ (\S+)$')
+CONTINUATION = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.*)$')
+OUTPUT_SECTION = re.compile(r'^(\.\S+)')
+# The paths and the archive members are compared without the extensions of the source and of the object
+OBJECT_FILE = re.compile(r'CMakeFiles/[^/]+\.dir/(.+)\.(?:c|cpp|S)\.o(?:bj)?$')
+ARCHIVE_MEMBER = re.compile(r'(?:^|/)lib([^/]+)\.a\((.+)\)$')
+OBJECT_EXTENSION = re.compile(r'\.(?:c|cpp|S)\.o(?:bj)?$|\.o$')
+
+FREERTOS_SOURCES = {'tasks', 'queue', 'timers', 'list', 'event_groups', 'stream_buffer', 'croutine'}
+LIBRARIES = {'c_nano': 'libc', 'c': 'libc', 'g_nano': 'libc', 'g': 'libc', 'm': 'libc', 'nosys': 'libc', 'gcc': 'libc',
+             'nrf-sdk': 'nrf-sdk', 'nimble': 'nimble', 'lvgl': 'lvgl', 'littlefs': 'littlefs', 'QCBOR': 'QCBOR'}
+
+
+def demangle(name):
+    """Returns the name of a variable from its section (.bss._ZN8Pinetime3Foo3barE -> Pinetime::Foo::bar)"""
+    name = re.sub(r'^\.(bss|data|noinit)\.', '', name)
+    if not name.startswith('_Z'):
+        return name
+    parts = []
+    position = 3 if name[2] in 'NL' else 2
+    while position < len(name) and name[position].isdigit():
+        length = re.match(r'\d+', name[position:]).group(0)
+        position += len(length)
+        parts.append(name[position:position + int(length)])
+        position += int(length)
+    parts = ['(anonymous)' if part == '_GLOBAL__N_1' else part for part in parts]
+    return '::'.join(parts) if parts else name
+
+
+def subsystem_of(section, source):
+    """Returns the subsystem that owns an input section, and whether its objects are listed one by one"""
+    if section.startswith('.stack'):
+        return 'stack (main and interrupts)', False
+    if section.startswith('.heap'):
+        return 'newlib heap', False
+    member = ARCHIVE_MEMBER.search(source)
+    if member:
+        library, object_name = member.groups()
+        if library == 'nrf-sdk' and OBJECT_EXTENSION.sub('', object_name) in FREERTOS_SOURCES:
+            return 'FreeRTOS', False
+        return LIBRARIES.get(library, 'lib' + library), False
+    path = OBJECT_FILE.search(source)
+    if not path:
+        return 'other', False
+    path = path.group(1)
+    if path.startswith('FreeRTOS/') or path == 'memory/KernelObjects':
+        return 'FreeRTOS', False
+    if path == 'memory/Heap':
+        return 'heap (kernel, lvgl, libc)', False
+    if path.startswith('libs/'):
+        return path.split('/')[1], False
+    if '/' not in path:
+        return path, True
+    directories = path.split('/')[:-1]
+    if directories[0] == 'components' and len(directories) > 1:
+        return '/'.join(directories[:2]), False
+    return directories[0], False
+
+
+def parse_map(lines):
+    """Returns the RAM region (origin, length) and the input sections : (output section, name, address, size, file)"""
+    ram = None
+    sections = []
+    in_memory_map = False
+    output_section = None
+    pending_name = None
+    for line in lines:
+        line = line.rstrip('\n')
+        if not in_memory_map:
+            region = MEMORY_REGION.match(line)
+            if region and region.group(1) == 'RAM':
+                ram = (int(region.group(2), 16), int(region.group(3), 16))
+            in_memory_map = line.startswith('Linker script and memory map')
+            continue
+        if pending_name is not None:
+            continuation = CONTINUATION.match(line)
+            if continuation:
+                address, size, source = continuation.groups()
+                sections.append((output_section, pending_name, int(address, 16), int(size, 16), source.strip()))
+            pending_name = None
+            continue
+        output = OUTPUT_SECTION.match(line)
+        if output:
+            output_section = output.group(1)
+            continue
+        name = INPUT_SECTION_NAME.match(line)
+        if name and not name.group(1).startswith('*('):
+            pending_name = name.group(1)
+            continue
+        section = INPUT_SECTION.match(line)
+        if section and not section.group(1).startswith('*('):
+            name, address, size, source = section.groups()
+            sections.append((output_section, name, int(address, 16), int(size, 16), source.strip()))
+    if ram is None:
+        sys.exit('the map file has no RAM region')
+    return ram, sections
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('map', help='map file of the firmware (pinetime-app-*.map)')
+    parser.add_argument('--objects', type=int, default=12, metavar='N',
+                        help='number of objects of main.cpp to list (default : 12)')
+    parser.add_argument('--limit', action='append', default=[], metavar='SUBSYSTEM=BYTES',
+                        help='fail when a subsystem uses more than BYTES of RAM, can be repeated')
+    args = parser.parse_args()
+
+    with open(args.map) as f:
+        (origin, length), sections = parse_map(f)
+
+    usage = {}
+    objects = {}
+    for output_section, name, address, size, source in sections:
+        if size == 0 or not origin <= address < origin + length:
+            continue
+        if name == '*fill*':
+            subsystem, listed = 'alignment', False
+        else:
+            subsystem, listed = subsystem_of(name, source)
+        data, bss = usage.get(subsystem, (0, 0))
+        if output_section == '.data' or name.startswith('.data'):
+            data += size
+        else:
+            bss += size
+        usage[subsystem] = (data, bss)
+        if listed:
+            key = '%s : %s' % (subsystem, demangle(name))
+            objects[key] = objects.get(key, 0) + size
+
+    used = sum(data + bss for data, bss in usage.values())
+    print('RAM : %d of %d bytes used (%.1f%%)' % (used, length, 100.0 * used / length))
+    print('%-32s %8s %8s %8s %6s' % ('subsystem', '.data', '.bss', 'total', '%'))
+    for subsystem, (data, bss) in sorted(usage.items(), key=lambda item: -sum(item[1])):
+        print('%-32s %8d %8d %8d %5.1f%%' % (subsystem, data, bss, data + bss, 100.0 * (data + bss) / length))
+    if objects and args.objects > 0:
+        print('\nLargest objects of the top-level sources :')
+        for key, size in sorted(objects.items(), key=lambda item: -item[1])[:args.objects]:
+            print('  %-46s %8d' % (key, size))
+
+    exceeded = False
+    for limit in args.limit:
+        subsystem, _, maximum = limit.rpartition('=')
+        if subsystem not in usage:
+            parser.error('unknown subsystem %r in --limit %s (subsystems : %s)' % (subsystem, limit, ', '.join(sorted(usage))))
+        data, bss = usage[subsystem]
+        if data + bss > int(maximum, 0):
+            print('%s uses %d bytes of RAM, its budget is %s bytes' % (subsystem, data + bss, maximum), file=sys.stderr)
+            exceeded = True
+    sys.exit(1 if exceeded else 0)
+
+
+if __name__ == '__main__':
+    main()
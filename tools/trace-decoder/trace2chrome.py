@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+
+# SPDX-License-Identifier: GPL-3.0-or-later
+
+"""Downloads the event trace of InfiniTime and converts it to the Chrome trace
+format (chrome://tracing, https://ui.perfetto.dev).
+
+The trace is read from the event trace characteristic of the diagnostics
+service (see doc/DiagnosticsService.md). A dump is the concatenation of the
+pages returned by the watch, exactly as they were read.
+"""
+
+import argparse
+import asyncio
+import json
+import struct
+import sys
+
+TRACE_UUID = '00050007-78fc-48fe-8e23-433b3a1942d0'
+HEADER = struct.Struct('<4sBBIIHHBB')
+TASK = struct.Struct('<B4s')
+RECORD = struct.Struct('<IBBH')
+
+# Pinetime::Trace::Events
+TASK_SWITCHED_IN = 0
+QUEUE_EVENTS = {1: 'send', 2: 'send failed', 3: 'receive', 4: 'receive failed', 5: 'blocked'}
+ISR_ENTER = 6
+ISR_EXIT = 7
+USER_BEGIN = 8
+USER_END = 9
+USER_MARK = 10
+
+# Pinetime::Trace::UserEvents
+USER_EVENTS = ['SystemTask message', 'DisplayApp message', 'lv_task_handler', 'Display flush', 'TWI transaction',
+               'Touch read']
+
+# Interrupts of the nRF52832, by IRQ number (exception number - 16)
+IRQS = {0: 'POWER_CLOCK', 1: 'RADIO', 2: 'UARTE0', 3: 'SPIM0/TWIM0', 4: 'SPIM1/TWIM1', 5: 'NFCT', 6: 'GPIOTE',
+        7: 'SAADC', 8: 'TIMER0', 9: 'TIMER1', 10: 'TIMER2', 11: 'RTC0', 12: 'TEMP', 13: 'RNG', 14: 'ECB',
+        15: 'CCM_AAR', 16: 'WDT', 17: 'RTC1', 18: 'QDEC', 19: 'COMP', 20: 'SWI0', 21: 'SWI1', 22: 'SWI2',
+        23: 'SWI3', 24: 'SWI4', 25: 'SWI5', 26: 'TIMER3', 27: 'TIMER4', 28: 'PWM0', 29: 'PDM', 32: 'MWU',
+        33: 'PWM1', 34: 'PWM2', 35: 'SPIM2', 36: 'RTC2', 37: 'I2S', 38: 'FPU'}
+
+INTERRUPTS_TID = 0
+
+
+def parse_pages(data):
+    """Returns the frequency, the names of the tasks and the records of a dump"""
+    frequency = None
+    tasks = {}
+    records = {}
+    offset = 0
+    while offset < len(data):
+        magic, version, _, page_frequency, _, _, first, nb_page_records, nb_tasks = HEADER.unpack_from(data, offset)
+        if magic != b'PTTR' or version != 1:
+            raise ValueError('not a trace page at offset %d' % offset)
+        frequency = page_frequency
+        offset += HEADER.size
+        for _ in range(nb_tasks):
+            number, name = TASK.unpack_from(data, offset)
+            tasks[number] = name.rstrip(b'\0').decode('ascii', 'replace')
+            offset += TASK.size
+        for i in range(nb_page_records):
+            records[first + i] = RECORD.unpack_from(data, offset)
+            offset += RECORD.size
+    return frequency, tasks, [records[index] for index in sorted(records)]
+
+
+def to_chrome(frequency, tasks, records):
+    """Task slices on one thread per task, interrupts on their own thread"""
+    events = [{'ph': 'M', 'name': 'process_name', 'pid': 1, 'args': {'name': 'InfiniTime'}},
+              {'ph': 'M', 'name': 'thread_name', 'pid': 1, 'tid': INTERRUPTS_TID, 'args': {'name': 'Interrupts'}}]
+    for number, name in tasks.items():
+        events.append({'ph': 'M', 'name': 'thread_name', 'pid': 1, 'tid': number, 'args': {'name': name}})
+
+    running = None
+    running_since = None
+    high = 0
+    previous = None
+    origin = records[0][0] if records else 0
+    for timestamp, event, identifier, argument in records:
+        # The timestamps are 32 bits, the trace spans at most a few seconds. The times start at the oldest record
+        if previous is not None and timestamp + high < previous - (1 << 31):
+            high += 1 << 32
+        timestamp += high
+        previous = timestamp
+        ts = (timestamp - origin) * 1e6 / frequency
+
+        if event == TASK_SWITCHED_IN:
+            if running is not None:
+                events.append({'ph': 'X', 'name': tasks.get(running, 'task %d' % running), 'cat': 'task', 'pid': 1,
+                               'tid': running, 'ts': running_since, 'dur': ts - running_since})
+            running = identifier
+            running_since = ts
+        elif event in QUEUE_EVENTS:
+            events.append({'ph': 'i', 's': 't', 'name': 'queue ' + QUEUE_EVENTS[event], 'cat': 'queue', 'pid': 1,
+                           'tid': running if running is not None else INTERRUPTS_TID, 'ts': ts,
+                           'args': {'queue': '0x2000%04x' % argument, 'messages': identifier}})
+        elif event in (ISR_ENTER, ISR_EXIT):
+            irq = identifier - 16
+            events.append({'ph': 'B' if event == ISR_ENTER else 'E', 'name': IRQS.get(irq, 'IRQ %d' % irq),
+                           'cat': 'interrupt', 'pid': 1, 'tid': INTERRUPTS_TID, 'ts': ts})
+        elif event in (USER_BEGIN, USER_END, USER_MARK):
+            name = USER_EVENTS[identifier] if identifier < len(USER_EVENTS) else 'user %d' % identifier
+            phase = {USER_BEGIN: 'B', USER_END: 'E', USER_MARK: 'i'}[event]
+            chrome_event = {'ph': phase, 'name': name, 'cat': 'user', 'pid': 1,
+                            'tid': running if running is not None else INTERRUPTS_TID, 'ts': ts,
+                            'args': {'argument': argument}}
+            if phase == 'i':
+                chrome_event['s'] = 't'
+            events.append(chrome_event)
+    return {'traceEvents': events, 'displayTimeUnit': 'ms'}
+
+
+async def pull(address):
+    from bleak import BleakClient
+
+    pages = bytearray()
+    async with BleakClient(address) as client:
+        await client.write_gatt_char(TRACE_UUID, bytes([0x01]), response=True)
+        first = 0
+        while True:
+            await client.write_gatt_char(TRACE_UUID, struct.pack('<BH', 0x03, first), response=True)
+            page = await client.read_gatt_char(TRACE_UUID)
+            _, _, _, _, _, nb_records, _, nb_page_records, _ = HEADER.unpack_from(page)
+            pages += page
+            first += nb_page_records
+            if nb_page_records == 0 or first >= nb_records:
+                break
+        await client.write_gatt_char(TRACE_UUID, bytes([0x02]), response=True)
+    return bytes(pages)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    subparsers = parser.add_subparsers(dest='command', required=True)
+    pull_parser = subparsers.add_parser('pull', help='download the trace of a watch (requires bleak)')
+    pull_parser.add_argument('address', help='Bluetooth address of the watch')
+    pull_parser.add_argument('-o', '--output', required=True, help='dump file')
+    convert_parser = subparsers.add_parser('convert', help='convert a dump to the Chrome trace format')
+    convert_parser.add_argument('dump', help='dump file')
+    convert_parser.add_argument('-o', '--output', help='JSON file (default: standard output)')
+    args = parser.parse_args()
+
+    if args.command == 'pull':
+        data = asyncio.run(pull(args.address))
+        with open(args.output, 'wb') as f:
+            f.write(data)
+        return
+
+    with open(args.dump, 'rb') as f:
+        frequency, tasks, records = parse_pages(f.read())
+    if frequency is None:
+        sys.exit('empty dump')
+    trace = to_chrome(frequency, tasks, records)
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(trace, f)
+    else:
+        json.dump(trace, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()